@@ -19,7 +19,7 @@ extrasources = []
 includepaths = []
 
 obj_sources = [
-  'obj.c', 'mesh.c', 'version.c' ]
+  'obj.c', 'mesh.c', 'inflate.c', 'optimize.c', 'meshlet.c', 'simplify.c', 'normal.c', 'tangent.c', 'bounds.c', 'bvh.c', 'query.c', 'clean.c', 'validate.c', 'transform.c', 'version.c' ]
 
 obj_lib = generator.lib(module = 'obj', sources = obj_sources + extrasources)
 #obj_so = generator.sharedlib(module = 'obj', sources = obj_sources + extrasources)
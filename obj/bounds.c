@@ -0,0 +1,98 @@
+/* bounds.c  -  OBJ library  -  Public Domain  -  2019 Mattias Jansson
+ *
+ * This library provides a cross-platform OBJ I/O library in C11 providing
+ * OBJ ascii reading and writing functionality.
+ *
+ * The latest source code maintained by Mattias Jansson is always available at
+ *
+ * https://github.com/mjansson/obj_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without any
+ * restrictions.
+ *
+ */
+
+#include "bounds.h"
+#include "internal.h"
+
+#include <foundation/array.h>
+#include <foundation/bucketarray.h>
+
+//! Extend bounds by a contiguous range of vertices, written with selects for vectorization
+static void
+bounds_extend_range(obj_bounds_t* bounds, const obj_vertex_t* FOUNDATION_RESTRICT vertex, size_t count) {
+	real min_x = bounds->min.x;
+	real min_y = bounds->min.y;
+	real min_z = bounds->min.z;
+	real max_x = bounds->max.x;
+	real max_y = bounds->max.y;
+	real max_z = bounds->max.z;
+	for (size_t ivertex = 0; ivertex < count; ++ivertex) {
+		real x = vertex[ivertex].x;
+		real y = vertex[ivertex].y;
+		real z = vertex[ivertex].z;
+		min_x = (x < min_x) ? x : min_x;
+		min_y = (y < min_y) ? y : min_y;
+		min_z = (z < min_z) ? z : min_z;
+		max_x = (x > max_x) ? x : max_x;
+		max_y = (y > max_y) ? y : max_y;
+		max_z = (z > max_z) ? z : max_z;
+	}
+	bounds->min.x = min_x;
+	bounds->min.y = min_y;
+	bounds->min.z = min_z;
+	bounds->max.x = max_x;
+	bounds->max.y = max_y;
+	bounds->max.z = max_z;
+}
+
+static void
+bounds_compute_subgroup(void* context, size_t index) {
+	obj_t* obj = context;
+	obj_subgroup_t* subgroup = nullptr;
+	for (size_t igroup = 0, gsize = array_size(obj->group); igroup < gsize; ++igroup) {
+		size_t sgsize = array_size(obj->group[igroup]->subgroup);
+		if (index < sgsize) {
+			subgroup = obj->group[igroup]->subgroup[index];
+			break;
+		}
+		index -= sgsize;
+	}
+	if (!subgroup)
+		return;
+
+	// All corners are created by faces
+	obj_bounds_clear(&subgroup->bounds);
+	for (size_t icorner = 0, csize = subgroup->corner.count; icorner < csize; ++icorner) {
+		const obj_corner_t* corner = bucketarray_get(&subgroup->corner, icorner);
+		obj_bounds_extend(&subgroup->bounds, bucketarray_get(&obj->vertex, corner->vertex - 1));
+	}
+}
+
+bool
+obj_compute_bounds(obj_t* obj) {
+	if (!obj)
+		return false;
+
+	obj_bounds_clear(&obj->bounds);
+	for (size_t offset = 0; offset < obj->vertex.count; offset += obj->vertex.bucket_size) {
+		size_t count = obj->vertex.count - offset;
+		if (count > obj->vertex.bucket_size)
+			count = obj->vertex.bucket_size;
+		bounds_extend_range(&obj->bounds, bucketarray_get(&obj->vertex, offset), count);
+	}
+
+	size_t subgroup_count = 0;
+	for (size_t igroup = 0, gsize = array_size(obj->group); igroup < gsize; ++igroup)
+		subgroup_count += array_size(obj->group[igroup]->subgroup);
+	obj_parallel_for(subgroup_count, bounds_compute_subgroup, obj);
+
+	for (size_t igroup = 0, gsize = array_size(obj->group); igroup < gsize; ++igroup) {
+		obj_group_t* group = obj->group[igroup];
+		obj_bounds_clear(&group->bounds);
+		for (size_t isub = 0, sgsize = array_size(group->subgroup); isub < sgsize; ++isub)
+			obj_bounds_merge(&group->bounds, &group->subgroup[isub]->bounds);
+	}
+
+	return true;
+}
@@ -0,0 +1,29 @@
+/* bounds.h  -  OBJ library  -  Public Domain  -  2019 Mattias Jansson
+ *
+ * This library provides a cross-platform OBJ I/O library in C11 providing
+ * OBJ ascii reading and writing functionality.
+ *
+ * The latest source code maintained by Mattias Jansson is always available at
+ *
+ * https://github.com/mjansson/obj_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without any
+ * restrictions.
+ *
+ */
+
+#pragma once
+
+/*! \file bounds.h
+    Bounding volumes */
+
+#include <obj/types.h>
+#include <obj/hashstrings.h>
+
+/*! Compute bounds of the OBJ data structure from all vertices, and bounds of each subgroup
+and group from the vertices used by their faces. Bounds are tracked while reading, use this
+for OBJ data built or modified by other means. Subgroups are processed in parallel.
+\param obj OBJ data structure
+\return true if success, false if error */
+OBJ_API bool
+obj_compute_bounds(obj_t* obj);
@@ -0,0 +1,609 @@
+/* bvh.c   -  OBJ library  -  Public Domain  -  2019 Mattias Jansson
+ *
+ * This library provides a cross-platform OBJ I/O library in C11 providing
+ * OBJ ascii reading and writing functionality.
+ *
+ * The latest source code maintained by Mattias Jansson is always available at
+ *
+ * https://github.com/mjansson/obj_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without any
+ * restrictions.
+ *
+ */
+
+#include "bvh.h"
+#include "internal.h"
+
+#include <foundation/array.h>
+#include <foundation/bucketarray.h>
+#include <foundation/stream.h>
+#include <foundation/system.h>
+
+#include <float.h>
+#include <math.h>
+
+static unsigned int INVALID_INDEX = 0xFFFFFFFF;
+
+#define OBJ_BVH_MAGIC 0x4f424a42
+#define OBJ_BVH_VERSION 2
+
+//! Maximum number of bins used to evaluate split candidates
+#define BVH_BINS_MAX 64
+
+//! Minimum number of triangles in a subtree built as a separate parallel task
+#define BVH_TASK_TRIANGLES_MIN 4096
+
+//! Bounds and center of a triangle
+typedef struct bvh_item_t {
+	real min[3];
+	real max[3];
+	real center[3];
+} bvh_item_t;
+
+//! Range of items to split into the subtree rooted at a node
+typedef struct bvh_range_t {
+	unsigned int node;
+	unsigned int begin;
+	unsigned int end;
+} bvh_range_t;
+
+//! Subtree built in parallel, rooted at a node of the top levels
+typedef struct bvh_task_t {
+	bvh_range_t range;
+	obj_bvh_node_t* node;
+} bvh_task_t;
+
+//! Subgroup triangles and offset of first triangle in item array
+typedef struct bvh_subgroup_t {
+	unsigned int group;
+	unsigned int subgroup;
+	unsigned int offset;
+} bvh_subgroup_t;
+
+typedef struct bvh_build_t {
+	const obj_t* obj;
+	unsigned int max_leaf;
+	unsigned int bins;
+	real traversal_cost;
+	bvh_subgroup_t* subgroup;
+	obj_bvh_primitive_t* primitive;
+	bvh_item_t* item;
+	unsigned int* index;
+	bvh_task_t* task;
+} bvh_build_t;
+
+void
+obj_bvh_initialize(obj_bvh_t* bvh) {
+	memset(bvh, 0, sizeof(obj_bvh_t));
+	obj_bounds_clear(&bvh->bounds);
+}
+
+void
+obj_bvh_finalize(obj_bvh_t* bvh) {
+	array_deallocate(bvh->node);
+	array_deallocate(bvh->primitive);
+}
+
+static bool
+bvh_face_has_corner(const obj_subgroup_t* subgroup, const obj_face_t* face, unsigned int corner) {
+	for (unsigned int iindex = 0; iindex < face->count; ++iindex) {
+		if (*bucketarray_get_as(unsigned int, &subgroup->index, face->offset + iindex) == corner)
+			return true;
+	}
+	return false;
+}
+
+//! Map triangles to the faces they were triangulated from, the faces using all three corners
+static void
+bvh_triangle_faces(const obj_subgroup_t* subgroup, obj_bvh_primitive_t* primitive) {
+	// Faces using each corner, stored as ranges in a single array
+	unsigned int corner_count = (unsigned int)subgroup->corner.count;
+	unsigned int* offset = nullptr;
+	unsigned int* face_index = nullptr;
+	array_resize(offset, corner_count + 1);
+	memset(offset, 0, sizeof(unsigned int) * (corner_count + 1));
+	array_resize(face_index, subgroup->index.count);
+	for (unsigned int iindex = 0, isize = (unsigned int)subgroup->index.count; iindex < isize; ++iindex)
+		++offset[*bucketarray_get_as(unsigned int, &subgroup->index, iindex) + 1];
+	for (unsigned int icorner = 0; icorner < corner_count; ++icorner)
+		offset[icorner + 1] += offset[icorner];
+	for (unsigned int iface = 0, fsize = (unsigned int)subgroup->face.count; iface < fsize; ++iface) {
+		const obj_face_t* face = bucketarray_get(&subgroup->face, iface);
+		for (unsigned int iindex = 0; iindex < face->count; ++iindex) {
+			unsigned int corner = *bucketarray_get_as(unsigned int, &subgroup->index, face->offset + iindex);
+			face_index[offset[corner]++] = iface;
+		}
+	}
+	// Offsets now point to end of each range
+	for (unsigned int icorner = corner_count; icorner > 0; --icorner)
+		offset[icorner] = offset[icorner - 1];
+	offset[0] = 0;
+
+	for (unsigned int itri = 0, tsize = (unsigned int)subgroup->triangle.count; itri < tsize; ++itri) {
+		const obj_triangle_t* triangle = bucketarray_get(&subgroup->triangle, itri);
+		unsigned int first = triangle->index[0];
+		primitive[itri].face = INVALID_INDEX;
+		for (unsigned int iface = offset[first]; iface < offset[first + 1]; ++iface) {
+			const obj_face_t* face = bucketarray_get(&subgroup->face, face_index[iface]);
+			if (bvh_face_has_corner(subgroup, face, triangle->index[1]) &&
+			    bvh_face_has_corner(subgroup, face, triangle->index[2])) {
+				primitive[itri].face = face_index[iface];
+				break;
+			}
+		}
+	}
+
+	array_deallocate(face_index);
+	array_deallocate(offset);
+}
+
+static void
+bvh_gather_subgroup(void* context, size_t index) {
+	bvh_build_t* build = context;
+	const bvh_subgroup_t* info = build->subgroup + index;
+	const obj_subgroup_t* subgroup = build->obj->group[info->group]->subgroup[info->subgroup];
+	bvh_triangle_faces(subgroup, build->primitive + info->offset);
+	for (unsigned int itri = 0, tsize = (unsigned int)subgroup->triangle.count; itri < tsize; ++itri) {
+		const obj_triangle_t* triangle = bucketarray_get(&subgroup->triangle, itri);
+		obj_bvh_primitive_t* primitive = build->primitive + info->offset + itri;
+		bvh_item_t* item = build->item + info->offset + itri;
+		primitive->group = info->group;
+		primitive->subgroup = info->subgroup;
+		primitive->triangle = itri;
+		for (int icorner = 0; icorner < 3; ++icorner) {
+			const obj_corner_t* corner = bucketarray_get(&subgroup->corner, triangle->index[icorner]);
+			const obj_vertex_t* vertex = bucketarray_get(&build->obj->vertex, corner->vertex - 1);
+			const real coord[3] = {vertex->x, vertex->y, vertex->z};
+			for (int axis = 0; axis < 3; ++axis) {
+				if (!icorner || (coord[axis] < item->min[axis]))
+					item->min[axis] = coord[axis];
+				if (!icorner || (coord[axis] > item->max[axis]))
+					item->max[axis] = coord[axis];
+			}
+		}
+		for (int axis = 0; axis < 3; ++axis)
+			item->center[axis] = (item->min[axis] + item->max[axis]) * REAL_C(0.5);
+	}
+}
+
+static void
+bvh_bounds_clear(real* min, real* max) {
+	min[0] = min[1] = min[2] = REAL_MAX;
+	max[0] = max[1] = max[2] = -REAL_MAX;
+}
+
+static void
+bvh_bounds_extend(real* min, real* max, const real* other_min, const real* other_max) {
+	for (int axis = 0; axis < 3; ++axis) {
+		if (other_min[axis] < min[axis])
+			min[axis] = other_min[axis];
+		if (other_max[axis] > max[axis])
+			max[axis] = other_max[axis];
+	}
+}
+
+//! Half surface area of bounds, zero for empty bounds
+static real
+bvh_area(const real* min, const real* max) {
+	real dx = max[0] - min[0];
+	real dy = max[1] - min[1];
+	real dz = max[2] - min[2];
+	if ((dx < 0) || (dy < 0) || (dz < 0))
+		return 0;
+	return (dx * dy) + (dy * dz) + (dz * dx);
+}
+
+static unsigned int
+bvh_bin(real center, real center_min, real scale, unsigned int bins) {
+	real offset = (center - center_min) * scale;
+	if (offset <= 0)
+		return 0;
+	unsigned int bin = (unsigned int)offset;
+	return (bin < bins) ? bin : bins - 1;
+}
+
+//! Convert node bounds to single precision, rounding outwards
+static void
+bvh_node_set_bounds(obj_bvh_node_t* node, const real* min, const real* max) {
+	for (int axis = 0; axis < 3; ++axis) {
+		node->min[axis] = (float32_t)min[axis];
+		if ((real)node->min[axis] > min[axis])
+			node->min[axis] = nextafterf(node->min[axis], -FLT_MAX);
+		node->max[axis] = (float32_t)max[axis];
+		if ((real)node->max[axis] < max[axis])
+			node->max[axis] = nextafterf(node->max[axis], FLT_MAX);
+	}
+}
+
+/*! Find split of item range with the lowest surface area heuristic cost among binned split
+candidates, and partition the range in place
+\return Split position, begin if range should be a leaf */
+static unsigned int
+bvh_partition(bvh_build_t* build, unsigned int begin, unsigned int end, const real* min, const real* max) {
+	unsigned int count = end - begin;
+	if (count <= 1)
+		return begin;
+
+	real center_min[3];
+	real center_max[3];
+	bvh_bounds_clear(center_min, center_max);
+	for (unsigned int iitem = begin; iitem < end; ++iitem) {
+		const real* center = build->item[build->index[iitem]].center;
+		bvh_bounds_extend(center_min, center_max, center, center);
+	}
+
+	unsigned int bins = build->bins;
+	real best_cost = REAL_MAX;
+	int best_axis = -1;
+	unsigned int best_bin = 0;
+	real best_scale = 0;
+	for (int axis = 0; axis < 3; ++axis) {
+		real extent = center_max[axis] - center_min[axis];
+		if (extent <= 0)
+			continue;
+		real scale = (real)bins / extent;
+
+		unsigned int bin_count[BVH_BINS_MAX] = {0};
+		real bin_min[BVH_BINS_MAX][3];
+		real bin_max[BVH_BINS_MAX][3];
+		for (unsigned int ibin = 0; ibin < bins; ++ibin)
+			bvh_bounds_clear(bin_min[ibin], bin_max[ibin]);
+		for (unsigned int iitem = begin; iitem < end; ++iitem) {
+			const bvh_item_t* item = build->item + build->index[iitem];
+			unsigned int bin = bvh_bin(item->center[axis], center_min[axis], scale, bins);
+			++bin_count[bin];
+			bvh_bounds_extend(bin_min[bin], bin_max[bin], item->min, item->max);
+		}
+
+		// Sweep from the right to get cost of right side of each split candidate
+		real right_area[BVH_BINS_MAX];
+		unsigned int right_count[BVH_BINS_MAX];
+		real side_min[3];
+		real side_max[3];
+		unsigned int side_count = 0;
+		bvh_bounds_clear(side_min, side_max);
+		for (unsigned int ibin = bins - 1; ibin > 0; --ibin) {
+			bvh_bounds_extend(side_min, side_max, bin_min[ibin], bin_max[ibin]);
+			side_count += bin_count[ibin];
+			right_area[ibin] = bvh_area(side_min, side_max);
+			right_count[ibin] = side_count;
+		}
+
+		side_count = 0;
+		bvh_bounds_clear(side_min, side_max);
+		for (unsigned int ibin = 1; ibin < bins; ++ibin) {
+			bvh_bounds_extend(side_min, side_max, bin_min[ibin - 1], bin_max[ibin - 1]);
+			side_count += bin_count[ibin - 1];
+			if (!side_count || !right_count[ibin])
+				continue;
+			real cost =
+			    (bvh_area(side_min, side_max) * (real)side_count) + (right_area[ibin] * (real)right_count[ibin]);
+			if (cost < best_cost) {
+				best_cost = cost;
+				best_axis = axis;
+				best_bin = ibin;
+				best_scale = scale;
+			}
+		}
+	}
+
+	if (best_axis < 0) {
+		// All centers coincide, split by count if range does not fit in a leaf
+		return (count > build->max_leaf) ? begin + (count / 2) : begin;
+	}
+
+	if (count <= build->max_leaf) {
+		real area = bvh_area(min, max);
+		if ((area <= 0) || ((build->traversal_cost + (best_cost / area)) >= (real)count))
+			return begin;
+	}
+
+	unsigned int left = begin;
+	unsigned int right = end;
+	while (left < right) {
+		const bvh_item_t* item = build->item + build->index[left];
+		if (bvh_bin(item->center[best_axis], center_min[best_axis], best_scale, bins) < best_bin) {
+			++left;
+		} else {
+			--right;
+			unsigned int swap = build->index[left];
+			build->index[left] = build->index[right];
+			build->index[right] = swap;
+		}
+	}
+	if ((left == begin) || (left == end))
+		return begin + (count / 2);
+	return left;
+}
+
+/*! Build subtree of item range rooted at a node. If tasks are given, ranges with at most
+the given number of items are not split but added as tasks */
+static void
+bvh_build_node(bvh_build_t* build, obj_bvh_node_t** node, bvh_range_t root, bvh_task_t** task,
+               unsigned int task_items) {
+	bvh_range_t* stack = nullptr;
+	array_push(stack, root);
+	while (array_size(stack)) {
+		bvh_range_t range = stack[array_size(stack) - 1];
+		array_pop(stack);
+
+		real min[3];
+		real max[3];
+		bvh_bounds_clear(min, max);
+		for (unsigned int iitem = range.begin; iitem < range.end; ++iitem) {
+			const bvh_item_t* item = build->item + build->index[iitem];
+			bvh_bounds_extend(min, max, item->min, item->max);
+		}
+		bvh_node_set_bounds(*node + range.node, min, max);
+
+		if (task && ((range.end - range.begin) <= task_items)) {
+			bvh_task_t subtree = {range, nullptr};
+			array_push(*task, subtree);
+			continue;
+		}
+
+		unsigned int split = bvh_partition(build, range.begin, range.end, min, max);
+		if (split == range.begin) {
+			(*node)[range.node].offset = range.begin;
+			(*node)[range.node].count = range.end - range.begin;
+			continue;
+		}
+
+		unsigned int child = array_size(*node);
+		obj_bvh_node_t leaf = {0};
+		array_push(*node, leaf);
+		array_push(*node, leaf);
+		(*node)[range.node].offset = child;
+		(*node)[range.node].count = 0;
+
+		bvh_range_t right = {child + 1, split, range.end};
+		bvh_range_t left = {child, range.begin, split};
+		array_push(stack, right);
+		array_push(stack, left);
+	}
+	array_deallocate(stack);
+}
+
+static void
+bvh_build_task(void* context, size_t index) {
+	bvh_build_t* build = context;
+	bvh_task_t* task = build->task + index;
+	bvh_range_t root = {0, task->range.begin, task->range.end};
+	obj_bvh_node_t node = {0};
+	array_push(task->node, node);
+	bvh_build_node(build, &task->node, root, nullptr, 0);
+}
+
+static int
+bvh_task_compare(const void* lhs, const void* rhs) {
+	const bvh_task_t* lhs_task = lhs;
+	const bvh_task_t* rhs_task = rhs;
+	unsigned int lhs_count = lhs_task->range.end - lhs_task->range.begin;
+	unsigned int rhs_count = rhs_task->range.end - rhs_task->range.begin;
+	return (lhs_count > rhs_count) ? -1 : ((lhs_count < rhs_count) ? 1 : 0);
+}
+
+//! Append subtree nodes, the subtree root replaces the node the task was rooted at
+static void
+bvh_merge_task(obj_bvh_t* bvh, const bvh_task_t* task) {
+	unsigned int base = array_size(bvh->node);
+	for (unsigned int inode = 0, nsize = array_size(task->node); inode < nsize; ++inode) {
+		obj_bvh_node_t node = task->node[inode];
+		if (!node.count)
+			node.offset = base + node.offset - 1;
+		if (inode)
+			array_push(bvh->node, node);
+		else
+			bvh->node[task->range.node] = node;
+	}
+}
+
+bool
+obj_build_bvh(const obj_t* obj, const obj_bvh_options_t* options, obj_bvh_t* bvh) {
+	if (!obj || !bvh)
+		return false;
+
+	obj_bvh_finalize(bvh);
+	obj_bvh_initialize(bvh);
+	bvh->bounds = obj->bounds;
+
+	bvh_build_t build;
+	memset(&build, 0, sizeof(build));
+	build.obj = obj;
+	build.max_leaf = (options && options->max_leaf_triangles) ? options->max_leaf_triangles :
+	                                                            OBJ_BVH_MAX_LEAF_TRIANGLES;
+	build.bins = (options && options->bins) ? options->bins : OBJ_BVH_BINS;
+	if (build.bins < 2)
+		build.bins = 2;
+	if (build.bins > BVH_BINS_MAX)
+		build.bins = BVH_BINS_MAX;
+	build.traversal_cost = (options && (options->traversal_cost > 0)) ? options->traversal_cost :
+	                                                                    OBJ_BVH_TRAVERSAL_COST;
+
+	unsigned int triangle_count = 0;
+	for (unsigned int igroup = 0, gsize = array_size(obj->group); igroup < gsize; ++igroup) {
+		const obj_group_t* group = obj->group[igroup];
+		for (unsigned int isub = 0, sgsize = array_size(group->subgroup); isub < sgsize; ++isub) {
+			if (!group->subgroup[isub]->triangle.count)
+				continue;
+			bvh_subgroup_t info = {igroup, isub, triangle_count};
+			array_push(build.subgroup, info);
+			triangle_count += (unsigned int)group->subgroup[isub]->triangle.count;
+		}
+	}
+	if (!triangle_count) {
+		array_deallocate(build.subgroup);
+		return true;
+	}
+
+	array_resize(build.primitive, triangle_count);
+	array_resize(build.item, triangle_count);
+	array_resize(build.index, triangle_count);
+	for (unsigned int iitem = 0; iitem < triangle_count; ++iitem)
+		build.index[iitem] = iitem;
+	obj_parallel_for(array_size(build.subgroup), bvh_gather_subgroup, &build);
+
+	// Split top levels on the calling thread until ranges are small enough to balance
+	// the subtree builds over the worker threads
+	unsigned int task_items = triangle_count / (unsigned int)(4 * system_hardware_threads());
+	if (task_items < BVH_TASK_TRIANGLES_MIN)
+		task_items = BVH_TASK_TRIANGLES_MIN;
+	bvh_range_t root = {0, 0, triangle_count};
+	obj_bvh_node_t node = {0};
+	array_push(bvh->node, node);
+	bvh_build_node(&build, &bvh->node, root, &build.task, task_items);
+
+	size_t task_count = array_size(build.task);
+	if (task_count > 1)
+		qsort(build.task, task_count, sizeof(bvh_task_t), bvh_task_compare);
+	obj_parallel_for(task_count, bvh_build_task, &build);
+	for (size_t itask = 0; itask < task_count; ++itask) {
+		bvh_merge_task(bvh, build.task + itask);
+		array_deallocate(build.task[itask].node);
+	}
+
+	array_resize(bvh->primitive, triangle_count);
+	for (unsigned int iitem = 0; iitem < triangle_count; ++iitem)
+		bvh->primitive[iitem] = build.primitive[build.index[iitem]];
+
+	array_deallocate(build.task);
+	array_deallocate(build.index);
+	array_deallocate(build.item);
+	array_deallocate(build.primitive);
+	array_deallocate(build.subgroup);
+
+	return true;
+}
+
+bool
+obj_bvh_write(const obj_bvh_t* bvh, stream_t* stream) {
+	if (!bvh || !stream)
+		return false;
+
+	stream_write_uint32(stream, OBJ_BVH_MAGIC);
+	stream_write_uint32(stream, OBJ_BVH_VERSION);
+	stream_write_float32(stream, (float32_t)bvh->bounds.min.x);
+	stream_write_float32(stream, (float32_t)bvh->bounds.min.y);
+	stream_write_float32(stream, (float32_t)bvh->bounds.min.z);
+	stream_write_float32(stream, (float32_t)bvh->bounds.max.x);
+	stream_write_float32(stream, (float32_t)bvh->bounds.max.y);
+	stream_write_float32(stream, (float32_t)bvh->bounds.max.z);
+
+	stream_write_uint32(stream, array_size(bvh->node));
+	for (size_t inode = 0, nsize = array_size(bvh->node); inode < nsize; ++inode) {
+		const obj_bvh_node_t* node = bvh->node + inode;
+		for (int axis = 0; axis < 3; ++axis)
+			stream_write_float32(stream, node->min[axis]);
+		for (int axis = 0; axis < 3; ++axis)
+			stream_write_float32(stream, node->max[axis]);
+		stream_write_uint32(stream, node->offset);
+		stream_write_uint32(stream, node->count);
+	}
+
+	stream_write_uint32(stream, array_size(bvh->primitive));
+	for (size_t iprim = 0, psize = array_size(bvh->primitive); iprim < psize; ++iprim) {
+		const obj_bvh_primitive_t* primitive = bvh->primitive + iprim;
+		stream_write_uint32(stream, primitive->group);
+		stream_write_uint32(stream, primitive->subgroup);
+		stream_write_uint32(stream, primitive->face);
+		stream_write_uint32(stream, primitive->triangle);
+	}
+
+	return true;
+}
+
+//! Check that BVH references valid triangles of all subgroups and forms a tree
+static bool
+bvh_validate(const obj_bvh_t* bvh, const obj_t* obj) {
+	size_t triangle_count = 0;
+	for (size_t igroup = 0, gsize = array_size(obj->group); igroup < gsize; ++igroup) {
+		const obj_group_t* group = obj->group[igroup];
+		for (size_t isub = 0, sgsize = array_size(group->subgroup); isub < sgsize; ++isub)
+			triangle_count += group->subgroup[isub]->triangle.count;
+	}
+	size_t primitive_count = array_size(bvh->primitive);
+	if (triangle_count != primitive_count)
+		return false;
+
+	for (size_t iprim = 0; iprim < primitive_count; ++iprim) {
+		const obj_bvh_primitive_t* primitive = bvh->primitive + iprim;
+		if (primitive->group >= array_size(obj->group))
+			return false;
+		const obj_group_t* group = obj->group[primitive->group];
+		if (primitive->subgroup >= array_size(group->subgroup))
+			return false;
+		const obj_subgroup_t* subgroup = group->subgroup[primitive->subgroup];
+		if ((primitive->triangle >= subgroup->triangle.count) ||
+		    ((primitive->face >= subgroup->face.count) && (primitive->face != INVALID_INDEX)))
+			return false;
+	}
+
+	size_t node_count = array_size(bvh->node);
+	if (!node_count != !primitive_count)
+		return false;
+	for (size_t inode = 0; inode < node_count; ++inode) {
+		const obj_bvh_node_t* node = bvh->node + inode;
+		if (node->count) {
+			if ((node->offset > primitive_count) || (node->count > (primitive_count - node->offset)))
+				return false;
+		} else if ((node->offset <= inode) || ((size_t)node->offset + 1 >= node_count)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool
+obj_bvh_read(obj_bvh_t* bvh, const obj_t* obj, stream_t* stream) {
+	obj_bvh_finalize(bvh);
+	obj_bvh_initialize(bvh);
+	if (!obj || !stream)
+		return false;
+
+	uint32_t magic = stream_read_uint32(stream);
+	uint32_t version = stream_read_uint32(stream);
+	if ((magic != OBJ_BVH_MAGIC) || (version != OBJ_BVH_VERSION))
+		return false;
+
+	float32_t bounds[6];
+	for (int icoord = 0; icoord < 6; ++icoord)
+		bounds[icoord] = stream_read_float32(stream);
+	if ((bounds[0] != (float32_t)obj->bounds.min.x) || (bounds[1] != (float32_t)obj->bounds.min.y) ||
+	    (bounds[2] != (float32_t)obj->bounds.min.z) || (bounds[3] != (float32_t)obj->bounds.max.x) ||
+	    (bounds[4] != (float32_t)obj->bounds.max.y) || (bounds[5] != (float32_t)obj->bounds.max.z))
+		return false;
+
+	uint32_t node_count = stream_read_uint32(stream);
+	for (uint32_t inode = 0; (inode < node_count) && !stream_eos(stream); ++inode) {
+		obj_bvh_node_t node;
+		for (int axis = 0; axis < 3; ++axis)
+			node.min[axis] = stream_read_float32(stream);
+		for (int axis = 0; axis < 3; ++axis)
+			node.max[axis] = stream_read_float32(stream);
+		node.offset = stream_read_uint32(stream);
+		node.count = stream_read_uint32(stream);
+		array_push(bvh->node, node);
+	}
+
+	uint32_t primitive_count = stream_read_uint32(stream);
+	for (uint32_t iprim = 0; (iprim < primitive_count) && !stream_eos(stream); ++iprim) {
+		obj_bvh_primitive_t primitive;
+		primitive.group = stream_read_uint32(stream);
+		primitive.subgroup = stream_read_uint32(stream);
+		primitive.face = stream_read_uint32(stream);
+		primitive.triangle = stream_read_uint32(stream);
+		array_push(bvh->primitive, primitive);
+	}
+
+	if ((array_size(bvh->node) != node_count) || (array_size(bvh->primitive) != primitive_count) ||
+	    !bvh_validate(bvh, obj)) {
+		obj_bvh_finalize(bvh);
+		obj_bvh_initialize(bvh);
+		return false;
+	}
+
+	bvh->bounds = obj->bounds;
+	return true;
+}
@@ -0,0 +1,68 @@
+/* bvh.h   -  OBJ library  -  Public Domain  -  2019 Mattias Jansson
+ *
+ * This library provides a cross-platform OBJ I/O library in C11 providing
+ * OBJ ascii reading and writing functionality.
+ *
+ * The latest source code maintained by Mattias Jansson is always available at
+ *
+ * https://github.com/mjansson/obj_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without any
+ * restrictions.
+ *
+ */
+
+#pragma once
+
+/*! \file bvh.h
+    Bounding volume hierarchy of triangles */
+
+#include <obj/types.h>
+#include <obj/hashstrings.h>
+
+//! Default maximum number of triangles in a BVH leaf
+#define OBJ_BVH_MAX_LEAF_TRIANGLES 4
+
+//! Default number of bins used to evaluate BVH split candidates
+#define OBJ_BVH_BINS 16
+
+//! Default cost of traversing a BVH node relative to intersecting a triangle
+#define OBJ_BVH_TRAVERSAL_COST REAL_C(1.0)
+
+/*! Initialize BVH
+\param bvh BVH */
+OBJ_API void
+obj_bvh_initialize(obj_bvh_t* bvh);
+
+/*! Finalize BVH, releasing all memory
+\param bvh BVH */
+OBJ_API void
+obj_bvh_finalize(obj_bvh_t* bvh);
+
+/*! Build a bounding volume hierarchy over the triangles of all subgroups, splitting nodes with
+the surface area heuristic evaluated at binned split candidates. The top levels are split on
+the calling thread and the resulting subtrees are built in parallel. Subgroups must be
+triangulated by obj_triangulate. Any existing BVH data is discarded.
+\param obj OBJ data structure
+\param options Build options, null for defaults
+\param bvh BVH receiving nodes and primitives
+\return true if success, false if error */
+OBJ_API bool
+obj_build_bvh(const obj_t* obj, const obj_bvh_options_t* options, obj_bvh_t* bvh);
+
+/*! Read BVH previously stored with obj_bvh_write. The BVH is validated against the OBJ data
+structure, which must have the same triangles and bounds as when the BVH was built.
+\param bvh Target BVH
+\param obj OBJ data structure the BVH was built from
+\param stream Source stream, must be binary
+\return true if success, false if error, invalid data or BVH does not match OBJ data */
+OBJ_API bool
+obj_bvh_read(obj_bvh_t* bvh, const obj_t* obj, stream_t* stream);
+
+/*! Write BVH, for example after the index written by obj_index_write to let later loads
+skip building the BVH
+\param bvh Source BVH
+\param stream Target stream, must be binary
+\return true if success, false if error */
+OBJ_API bool
+obj_bvh_write(const obj_bvh_t* bvh, stream_t* stream);
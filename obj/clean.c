@@ -0,0 +1,829 @@
+/* clean.c   -  OBJ library  -  Public Domain  -  2019 Mattias Jansson
+ *
+ * This library provides a cross-platform OBJ I/O library in C11 providing
+ * OBJ ascii reading and writing functionality.
+ *
+ * The latest source code maintained by Mattias Jansson is always available at
+ *
+ * https://github.com/mjansson/obj_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without any
+ * restrictions.
+ *
+ */
+
+#include "clean.h"
+#include "bounds.h"
+#include "internal.h"
+
+#include <foundation/array.h>
+#include <foundation/atomic.h>
+#include <foundation/bucketarray.h>
+#include <foundation/hash.h>
+#include <foundation/hashmap.h>
+#include <foundation/math.h>
+#include <foundation/memory.h>
+
+static unsigned int INVALID_INDEX = 0xFFFFFFFF;
+
+//! Number of vertices in each parallel task
+#define CLEAN_BLOCK_SIZE 16384
+
+//! Number of bits of the cell hash selecting the shard of a cell
+#define CLEAN_SHARD_BITS 8
+#define CLEAN_SHARD_COUNT (1 << CLEAN_SHARD_BITS)
+
+//! Largest scaled coordinate magnitude converted to a cell index, well inside the int64 range
+#define CLEAN_CELL_LIMIT REAL_C(4.0e18)
+
+//! Number of corner attributes, the vertex, normal, UV and tangent indices
+#define CLEAN_ATTRIBUTE_COUNT 4
+
+//! Offset of each attribute index in corners
+static const size_t clean_attribute_offset[CLEAN_ATTRIBUTE_COUNT] = {
+    offsetof(obj_corner_t, vertex), offsetof(obj_corner_t, normal), offsetof(obj_corner_t, uv),
+    offsetof(obj_corner_t, tangent)};
+
+//! Hash key of an element, sorted by key and index in shards selected by the top bits of the key
+typedef struct clean_key_t {
+	hash_t key;
+	unsigned int index;
+} clean_key_t;
+
+typedef struct clean_shards_t {
+	clean_key_t* sorted;
+	size_t offset[CLEAN_SHARD_COUNT + 1];
+} clean_shards_t;
+
+//! Corner tuple and index, sorted to find identical corners
+typedef struct clean_corner_t {
+	unsigned int vertex;
+	unsigned int normal;
+	unsigned int uv;
+	unsigned int tangent;
+	unsigned int index;
+} clean_corner_t;
+
+typedef struct clean_weld_t {
+	const obj_t* obj;
+	real inverse_cell;
+	real epsilon_squared;
+	clean_key_t* cell;
+	clean_shards_t shards;
+	size_t table_offset[CLEAN_SHARD_COUNT + 1];
+	unsigned int* table;
+	unsigned int* remap;
+} clean_weld_t;
+
+typedef struct clean_dedup_t {
+	const bucketarray_t* array;
+	clean_key_t* key;
+	clean_shards_t shards;
+	unsigned int* remap;
+} clean_dedup_t;
+
+typedef struct clean_remap_t {
+	obj_t* obj;
+	//! Maps from old to new index for each corner attribute, null if unchanged
+	const unsigned int* attribute[CLEAN_ATTRIBUTE_COUNT];
+	//! Flag indicating if identical corners should be merged after remapping
+	bool merge;
+} clean_remap_t;
+
+typedef struct clean_unused_t {
+	obj_t* obj;
+	//! Bitsets of elements referenced by kept corners for each corner attribute
+	atomic32_t* used[CLEAN_ATTRIBUTE_COUNT];
+} clean_unused_t;
+
+typedef struct clean_rank_t {
+	const atomic32_t* used;
+	//! Number of used elements in each block, then index of the first used element of the block
+	unsigned int* block;
+	//! Map from old to new element index, INVALID_INDEX for unused elements
+	unsigned int* remap;
+	size_t count;
+} clean_rank_t;
+
+static int
+clean_corner_compare(const void* lhs, const void* rhs) {
+	const clean_corner_t* lhs_corner = lhs;
+	const clean_corner_t* rhs_corner = rhs;
+	if (lhs_corner->vertex != rhs_corner->vertex)
+		return (lhs_corner->vertex < rhs_corner->vertex) ? -1 : 1;
+	if (lhs_corner->normal != rhs_corner->normal)
+		return (lhs_corner->normal < rhs_corner->normal) ? -1 : 1;
+	if (lhs_corner->uv != rhs_corner->uv)
+		return (lhs_corner->uv < rhs_corner->uv) ? -1 : 1;
+	if (lhs_corner->tangent != rhs_corner->tangent)
+		return (lhs_corner->tangent < rhs_corner->tangent) ? -1 : 1;
+	if (lhs_corner->index != rhs_corner->index)
+		return (lhs_corner->index < rhs_corner->index) ? -1 : 1;
+	return 0;
+}
+
+static int
+clean_index_compare(const void* lhs, const void* rhs) {
+	unsigned int lhs_index = *(const unsigned int*)lhs;
+	unsigned int rhs_index = *(const unsigned int*)rhs;
+	return (lhs_index < rhs_index) ? -1 : ((lhs_index > rhs_index) ? 1 : 0);
+}
+
+/*! Turn a map from each element to the lowest indexed element it is merged with into a map
+to new element indices, numbering kept elements in order
+\return Number of kept elements */
+static unsigned int
+clean_remap_resolve(unsigned int* remap, size_t count) {
+	unsigned int next = 0;
+	for (size_t ielement = 0; ielement < count; ++ielement)
+		remap[ielement] = (remap[ielement] == ielement) ? next++ : remap[remap[ielement]];
+	return next;
+}
+
+//! Move kept elements to their new index, kept elements are in order
+static void
+clean_compact(bucketarray_t* array, const unsigned int* remap, unsigned int count) {
+	unsigned int next = 0;
+	for (size_t ielement = 0, esize = array->count; ielement < esize; ++ielement) {
+		if (remap[ielement] != next)
+			continue;
+		if (next != ielement)
+			memcpy(bucketarray_get(array, next), bucketarray_get(array, ielement), array->element_size);
+		++next;
+	}
+	bucketarray_resize(array, count);
+}
+
+/*! Merge identical corners of a subgroup, rewriting face and triangle indices, collapsing face
+corners and dropping faces and triangles with corners sharing a vertex, and rebuilding the chains
+of corners sharing a vertex */
+static void
+clean_subgroup_merge_corners(obj_subgroup_t* subgroup) {
+	size_t corner_count = subgroup->corner.count;
+	if (!corner_count)
+		return;
+
+	clean_corner_t* key = memory_allocate(HASH_OBJ, sizeof(clean_corner_t) * corner_count, 0, MEMORY_PERSISTENT);
+	unsigned int* remap = memory_allocate(HASH_OBJ, sizeof(unsigned int) * corner_count, 0, MEMORY_PERSISTENT);
+	for (size_t icorner = 0; icorner < corner_count; ++icorner) {
+		const obj_corner_t* corner = bucketarray_get(&subgroup->corner, icorner);
+		clean_corner_t corner_key = {corner->vertex, corner->normal, corner->uv, corner->tangent,
+		                             (unsigned int)icorner};
+		key[icorner] = corner_key;
+	}
+	qsort(key, corner_count, sizeof(clean_corner_t), clean_corner_compare);
+
+	// Identical corners are adjacent with the lowest index first
+	size_t first = 0;
+	for (size_t ikey = 0; ikey < corner_count; ++ikey) {
+		if (ikey && ((key[ikey].vertex != key[first].vertex) || (key[ikey].normal != key[first].normal) ||
+		             (key[ikey].uv != key[first].uv) || (key[ikey].tangent != key[first].tangent)))
+			first = ikey;
+		remap[key[ikey].index] = key[first].index;
+	}
+	unsigned int count = clean_remap_resolve(remap, corner_count);
+	clean_compact(&subgroup->corner, remap, count);
+
+	// Link kept corners sharing a vertex in index order
+	unsigned int* chain = nullptr;
+	for (size_t ikey = 0; ikey < corner_count; ++ikey) {
+		if (!ikey || (key[ikey].vertex != key[ikey - 1].vertex)) {
+			if (array_size(chain) > 1)
+				qsort(chain, array_size(chain), sizeof(unsigned int), clean_index_compare);
+			for (size_t ilink = 0, lsize = array_size(chain); ilink < lsize; ++ilink) {
+				obj_corner_t* corner = bucketarray_get(&subgroup->corner, chain[ilink]);
+				corner->next = (ilink + 1 < lsize) ? (int)chain[ilink + 1] : -1;
+			}
+			array_clear(chain);
+		}
+		unsigned int index = remap[key[ikey].index];
+		if (!array_size(chain) || (chain[array_size(chain) - 1] != index))
+			array_push(chain, index);
+	}
+	if (array_size(chain) > 1)
+		qsort(chain, array_size(chain), sizeof(unsigned int), clean_index_compare);
+	for (size_t ilink = 0, lsize = array_size(chain); ilink < lsize; ++ilink) {
+		obj_corner_t* corner = bucketarray_get(&subgroup->corner, chain[ilink]);
+		corner->next = (ilink + 1 < lsize) ? (int)chain[ilink + 1] : -1;
+	}
+	array_deallocate(chain);
+
+	if (count < corner_count) {
+		for (size_t iindex = 0, isize = subgroup->index.count; iindex < isize; ++iindex) {
+			unsigned int* index = bucketarray_get(&subgroup->index, iindex);
+			*index = remap[*index];
+		}
+	}
+
+	// Faces are stored in index order, so indices can be compacted in place. Consecutive corners sharing a vertex
+	// are collapsed and faces left with less than three corners are dropped
+	size_t face_count = 0;
+	size_t index_count = 0;
+	for (size_t iface = 0, fsize = subgroup->face.count; iface < fsize; ++iface) {
+		obj_face_t face = *(obj_face_t*)bucketarray_get(&subgroup->face, iface);
+		size_t offset = index_count;
+		unsigned int first_vertex = 0;
+		unsigned int last_vertex = 0;
+		for (unsigned int icorner = 0; icorner < face.count; ++icorner) {
+			unsigned int index = *bucketarray_get_as(unsigned int, &subgroup->index, face.offset + icorner);
+			unsigned int vertex = bucketarray_get_as(obj_corner_t, &subgroup->corner, index)->vertex;
+			if (index_count == offset)
+				first_vertex = vertex;
+			else if (vertex == last_vertex)
+				continue;
+			last_vertex = vertex;
+			*bucketarray_get_as(unsigned int, &subgroup->index, index_count) = index;
+			++index_count;
+		}
+		if ((index_count - offset > 1) && (last_vertex == first_vertex))
+			--index_count;
+		if (index_count - offset < 3) {
+			index_count = offset;
+			continue;
+		}
+		face.count = (unsigned int)(index_count - offset);
+		face.offset = (unsigned int)offset;
+		*(obj_face_t*)bucketarray_get(&subgroup->face, face_count) = face;
+		++face_count;
+	}
+	bucketarray_resize(&subgroup->face, face_count);
+	bucketarray_resize(&subgroup->index, index_count);
+
+	size_t triangle_count = 0;
+	for (size_t itri = 0, tsize = subgroup->triangle.count; itri < tsize; ++itri) {
+		obj_triangle_t triangle = *(obj_triangle_t*)bucketarray_get(&subgroup->triangle, itri);
+		for (int icorner = 0; icorner < 3; ++icorner)
+			triangle.index[icorner] = remap[triangle.index[icorner]];
+		unsigned int vertex[3];
+		for (int icorner = 0; icorner < 3; ++icorner)
+			vertex[icorner] = bucketarray_get_as(obj_corner_t, &subgroup->corner, triangle.index[icorner])->vertex;
+		if ((vertex[0] == vertex[1]) || (vertex[1] == vertex[2]) || (vertex[2] == vertex[0]))
+			continue;
+		*(obj_triangle_t*)bucketarray_get(&subgroup->triangle, triangle_count) = triangle;
+		++triangle_count;
+	}
+	bucketarray_resize(&subgroup->triangle, triangle_count);
+
+	memory_deallocate(remap);
+	memory_deallocate(key);
+}
+
+//! Get subgroup by index in group and subgroup order
+static obj_subgroup_t*
+clean_subgroup(obj_t* obj, size_t index) {
+	for (size_t igroup = 0, gsize = array_size(obj->group); igroup < gsize; ++igroup) {
+		size_t sgsize = array_size(obj->group[igroup]->subgroup);
+		if (index < sgsize)
+			return obj->group[igroup]->subgroup[index];
+		index -= sgsize;
+	}
+	return nullptr;
+}
+
+static size_t
+clean_subgroup_count(const obj_t* obj) {
+	size_t subgroup_count = 0;
+	for (size_t igroup = 0, gsize = array_size(obj->group); igroup < gsize; ++igroup)
+		subgroup_count += array_size(obj->group[igroup]->subgroup);
+	return subgroup_count;
+}
+
+static void
+clean_remap_subgroup(void* context, size_t index) {
+	clean_remap_t* remap = context;
+	obj_subgroup_t* subgroup = clean_subgroup(remap->obj, index);
+	if (!subgroup)
+		return;
+	for (size_t icorner = 0, csize = subgroup->corner.count; icorner < csize; ++icorner) {
+		obj_corner_t* corner = bucketarray_get(&subgroup->corner, icorner);
+		// Attribute indices are one-based with zero for no attribute
+		for (int iattrib = 0; iattrib < CLEAN_ATTRIBUTE_COUNT; ++iattrib) {
+			unsigned int* value = pointer_offset(corner, clean_attribute_offset[iattrib]);
+			if (remap->attribute[iattrib] && *value)
+				*value = remap->attribute[iattrib][*value - 1] + 1;
+		}
+	}
+	if (remap->merge)
+		clean_subgroup_merge_corners(subgroup);
+}
+
+static int
+clean_key_compare(const void* lhs, const void* rhs) {
+	const clean_key_t* lhs_key = lhs;
+	const clean_key_t* rhs_key = rhs;
+	if (lhs_key->key != rhs_key->key)
+		return (lhs_key->key < rhs_key->key) ? -1 : 1;
+	return (lhs_key->index < rhs_key->index) ? -1 : ((lhs_key->index > rhs_key->index) ? 1 : 0);
+}
+
+static size_t
+clean_shard(hash_t key) {
+	return (size_t)(key >> (64 - CLEAN_SHARD_BITS));
+}
+
+static void
+clean_shards_sort(void* context, size_t index) {
+	clean_shards_t* shards = context;
+	size_t count = shards->offset[index + 1] - shards->offset[index];
+	if (count > 1)
+		qsort(shards->sorted + shards->offset[index], count, sizeof(clean_key_t), clean_key_compare);
+}
+
+//! Distribute keys to shards and sort shards in parallel, elements with equal keys are adjacent
+static void
+clean_shards_initialize(clean_shards_t* shards, const clean_key_t* key, size_t count) {
+	memset(shards->offset, 0, sizeof(shards->offset));
+	shards->sorted = memory_allocate(HASH_OBJ, sizeof(clean_key_t) * count, 0, MEMORY_PERSISTENT);
+	for (size_t ikey = 0; ikey < count; ++ikey)
+		++shards->offset[clean_shard(key[ikey].key) + 1];
+	for (size_t ishard = 0; ishard < CLEAN_SHARD_COUNT; ++ishard)
+		shards->offset[ishard + 1] += shards->offset[ishard];
+	size_t next[CLEAN_SHARD_COUNT];
+	memcpy(next, shards->offset, sizeof(next));
+	for (size_t ikey = 0; ikey < count; ++ikey)
+		shards->sorted[next[clean_shard(key[ikey].key)]++] = key[ikey];
+	obj_parallel_for(CLEAN_SHARD_COUNT, clean_shards_sort, shards);
+}
+
+static void
+clean_shards_finalize(clean_shards_t* shards) {
+	memory_deallocate(shards->sorted);
+}
+
+static hash_t
+clean_cell_hash(const int64_t* cell) {
+	return hash(cell, sizeof(int64_t) * 3);
+}
+
+/*! Get grid cell of vertex, and the direction of the neighboring cell nearest to the vertex
+along each axis. Cells are twice the weld distance, so all vertices within the distance are
+in the cell or in one of the seven neighbors on the near side. Non-finite vertices are never
+within distance of any vertex and are given a cell of their own from the coordinate bits */
+static void
+clean_weld_cell(const clean_weld_t* weld, const obj_vertex_t* vertex, int64_t* cell, int* side) {
+	const real coord[3] = {vertex->x, vertex->y, vertex->z};
+	bool finite = math_real_is_finite(coord[0]) && math_real_is_finite(coord[1]) && math_real_is_finite(coord[2]);
+	if (finite && (weld->inverse_cell > 0)) {
+		for (int axis = 0; axis < 3; ++axis) {
+			// Clamp to keep the conversion defined for huge coordinates with a tiny distance
+			real scaled = coord[axis] * weld->inverse_cell;
+			if (scaled > CLEAN_CELL_LIMIT)
+				scaled = CLEAN_CELL_LIMIT;
+			else if (scaled < -CLEAN_CELL_LIMIT)
+				scaled = -CLEAN_CELL_LIMIT;
+			real floored = math_floor(scaled);
+			cell[axis] = (int64_t)floored;
+			side[axis] = ((scaled - floored) < REAL_C(0.5)) ? -1 : 1;
+		}
+	} else {
+		// Identical positions only, cell is given by the coordinate bits
+		memset(cell, 0, sizeof(int64_t) * 3);
+		for (int axis = 0; axis < 3; ++axis) {
+			memcpy(cell + axis, coord + axis, sizeof(real));
+			side[axis] = 0;
+		}
+	}
+}
+
+static void
+clean_weld_hash_block(void* context, size_t index) {
+	clean_weld_t* weld = context;
+	size_t vertex_count = weld->obj->vertex.count;
+	size_t end = (index + 1) * CLEAN_BLOCK_SIZE;
+	if (end > vertex_count)
+		end = vertex_count;
+	for (size_t ivertex = index * CLEAN_BLOCK_SIZE; ivertex < end; ++ivertex) {
+		int64_t cell[3];
+		int side[3];
+		clean_weld_cell(weld, bucketarray_get(&weld->obj->vertex, ivertex), cell, side);
+		weld->cell[ivertex].key = clean_cell_hash(cell);
+		weld->cell[ivertex].index = (unsigned int)ivertex;
+	}
+}
+
+//! Count cells in shard to size the shard hash table
+static void
+clean_weld_table_size(void* context, size_t index) {
+	clean_weld_t* weld = context;
+	const clean_key_t* cell = weld->shards.sorted + weld->shards.offset[index];
+	size_t count = weld->shards.offset[index + 1] - weld->shards.offset[index];
+	size_t cell_count = 0;
+	for (size_t icell = 0; icell < count; ++icell) {
+		if (!icell || (cell[icell].key != cell[icell - 1].key))
+			++cell_count;
+	}
+	size_t capacity = cell_count ? 2 : 0;
+	while (capacity < (cell_count * 2))
+		capacity <<= 1;
+	weld->table_offset[index + 1] = capacity;
+}
+
+//! Store offset of first vertex of each cell in shard hash table
+static void
+clean_weld_table_fill(void* context, size_t index) {
+	clean_weld_t* weld = context;
+	unsigned int* table = weld->table + weld->table_offset[index];
+	size_t mask = weld->table_offset[index + 1] - weld->table_offset[index] - 1;
+	const clean_key_t* sorted = weld->shards.sorted;
+	for (size_t icell = weld->shards.offset[index], csize = weld->shards.offset[index + 1]; icell < csize; ++icell) {
+		if ((icell != weld->shards.offset[index]) && (sorted[icell].key == sorted[icell - 1].key))
+			continue;
+		size_t slot = (size_t)sorted[icell].key & mask;
+		while (table[slot] != INVALID_INDEX)
+			slot = (slot + 1) & mask;
+		table[slot] = (unsigned int)icell;
+	}
+}
+
+//! Find lowest indexed vertex within distance in the given cell
+static unsigned int
+clean_weld_search(const clean_weld_t* weld, hash_t cell, const obj_vertex_t* vertex, unsigned int lowest) {
+	size_t shard = clean_shard(cell);
+	size_t capacity = weld->table_offset[shard + 1] - weld->table_offset[shard];
+	if (!capacity)
+		return lowest;
+	const clean_key_t* sorted = weld->shards.sorted;
+	const unsigned int* table = weld->table + weld->table_offset[shard];
+	size_t slot = (size_t)cell & (capacity - 1);
+	while ((table[slot] != INVALID_INDEX) && (sorted[table[slot]].key != cell))
+		slot = (slot + 1) & (capacity - 1);
+	if (table[slot] == INVALID_INDEX)
+		return lowest;
+
+	// Vertices in a cell are sorted by index
+	for (size_t icell = table[slot], csize = weld->shards.offset[shard + 1];
+	     (icell < csize) && (sorted[icell].key == cell) && (sorted[icell].index < lowest); ++icell) {
+		const obj_vertex_t* other = bucketarray_get(&weld->obj->vertex, sorted[icell].index);
+		real dx = other->x - vertex->x;
+		real dy = other->y - vertex->y;
+		real dz = other->z - vertex->z;
+		if (((dx * dx) + (dy * dy) + (dz * dz)) <= weld->epsilon_squared)
+			return sorted[icell].index;
+	}
+	return lowest;
+}
+
+static void
+clean_weld_match_block(void* context, size_t index) {
+	clean_weld_t* weld = context;
+	size_t vertex_count = weld->obj->vertex.count;
+	size_t end = (index + 1) * CLEAN_BLOCK_SIZE;
+	if (end > vertex_count)
+		end = vertex_count;
+	for (size_t ivertex = index * CLEAN_BLOCK_SIZE; ivertex < end; ++ivertex) {
+		const obj_vertex_t* vertex = bucketarray_get(&weld->obj->vertex, ivertex);
+		int64_t cell[3];
+		int side[3];
+		clean_weld_cell(weld, vertex, cell, side);
+		unsigned int lowest = (unsigned int)ivertex;
+		for (int dz = 0; dz <= (side[2] ? 1 : 0); ++dz) {
+			for (int dy = 0; dy <= (side[1] ? 1 : 0); ++dy) {
+				for (int dx = 0; dx <= (side[0] ? 1 : 0); ++dx) {
+					int64_t neighbor[3] = {cell[0] + (dx * side[0]), cell[1] + (dy * side[1]),
+					                       cell[2] + (dz * side[2])};
+					lowest = clean_weld_search(weld, clean_cell_hash(neighbor), vertex, lowest);
+				}
+			}
+		}
+		weld->remap[ivertex] = lowest;
+	}
+}
+
+bool
+obj_weld_positions(obj_t* obj, real epsilon) {
+	if (!obj)
+		return false;
+	size_t vertex_count = obj->vertex.count;
+	if (!vertex_count)
+		return true;
+
+	clean_weld_t weld;
+	memset(&weld, 0, sizeof(weld));
+	weld.obj = obj;
+	weld.inverse_cell = (epsilon > 0) ? REAL_C(0.5) / epsilon : 0;
+	// Distance too small for a finite cell size, weld identical positions only
+	if (!math_real_is_finite(weld.inverse_cell))
+		weld.inverse_cell = 0;
+	weld.epsilon_squared = (epsilon > 0) ? epsilon * epsilon : 0;
+	weld.cell = memory_allocate(HASH_OBJ, sizeof(clean_key_t) * vertex_count, 0, MEMORY_PERSISTENT);
+	weld.remap = memory_allocate(HASH_OBJ, sizeof(unsigned int) * vertex_count, 0, MEMORY_PERSISTENT);
+
+	size_t block_count = (vertex_count + CLEAN_BLOCK_SIZE - 1) / CLEAN_BLOCK_SIZE;
+	obj_parallel_for(block_count, clean_weld_hash_block, &weld);
+
+	// Shard cells and build a hash table of the cells in each shard in parallel
+	clean_shards_initialize(&weld.shards, weld.cell, vertex_count);
+	memory_deallocate(weld.cell);
+	obj_parallel_for(CLEAN_SHARD_COUNT, clean_weld_table_size, &weld);
+	for (size_t ishard = 0; ishard < CLEAN_SHARD_COUNT; ++ishard)
+		weld.table_offset[ishard + 1] += weld.table_offset[ishard];
+	weld.table = memory_allocate(HASH_OBJ, sizeof(unsigned int) * weld.table_offset[CLEAN_SHARD_COUNT], 0,
+	                             MEMORY_PERSISTENT);
+	memset(weld.table, 0xFF, sizeof(unsigned int) * weld.table_offset[CLEAN_SHARD_COUNT]);
+	obj_parallel_for(CLEAN_SHARD_COUNT, clean_weld_table_fill, &weld);
+
+	obj_parallel_for(block_count, clean_weld_match_block, &weld);
+
+	unsigned int count = clean_remap_resolve(weld.remap, vertex_count);
+	memory_deallocate(weld.table);
+	clean_shards_finalize(&weld.shards);
+
+	if (count < vertex_count) {
+		clean_compact(&obj->vertex, weld.remap, count);
+		clean_remap_t remap = {obj, {weld.remap, nullptr, nullptr, nullptr}, true};
+		obj_parallel_for(clean_subgroup_count(obj), clean_remap_subgroup, &remap);
+		obj_compute_bounds(obj);
+	}
+
+	memory_deallocate(weld.remap);
+	return true;
+}
+
+static void
+clean_dedup_hash_block(void* context, size_t index) {
+	clean_dedup_t* dedup = context;
+	size_t count = dedup->array->count;
+	size_t end = (index + 1) * CLEAN_BLOCK_SIZE;
+	if (end > count)
+		end = count;
+	for (size_t ielement = index * CLEAN_BLOCK_SIZE; ielement < end; ++ielement) {
+		dedup->key[ielement].key = hash(bucketarray_get(dedup->array, ielement), dedup->array->element_size);
+		dedup->key[ielement].index = (unsigned int)ielement;
+	}
+}
+
+//! Map elements to the lowest indexed element with identical bits, comparing elements with equal hash
+static void
+clean_dedup_match_shard(void* context, size_t index) {
+	clean_dedup_t* dedup = context;
+	const clean_key_t* sorted = dedup->shards.sorted;
+	size_t first = dedup->shards.offset[index];
+	for (size_t ikey = first, ksize = dedup->shards.offset[index + 1]; ikey < ksize; ++ikey) {
+		if (sorted[ikey].key != sorted[first].key)
+			first = ikey;
+		const void* element = bucketarray_get(dedup->array, sorted[ikey].index);
+		unsigned int lowest = sorted[ikey].index;
+		for (size_t iother = first; iother < ikey; ++iother) {
+			if (!memcmp(bucketarray_get(dedup->array, sorted[iother].index), element, dedup->array->element_size)) {
+				lowest = sorted[iother].index;
+				break;
+			}
+		}
+		dedup->remap[sorted[ikey].index] = lowest;
+	}
+}
+
+/*! Find elements with identical bits in array and compact the array
+\return Map from old to new element index, null if no duplicates were found */
+static unsigned int*
+clean_dedup_array(bucketarray_t* array) {
+	size_t count = array->count;
+	if (!count)
+		return nullptr;
+
+	clean_dedup_t dedup;
+	memset(&dedup, 0, sizeof(dedup));
+	dedup.array = array;
+	dedup.key = memory_allocate(HASH_OBJ, sizeof(clean_key_t) * count, 0, MEMORY_PERSISTENT);
+	dedup.remap = memory_allocate(HASH_OBJ, sizeof(unsigned int) * count, 0, MEMORY_PERSISTENT);
+
+	obj_parallel_for((count + CLEAN_BLOCK_SIZE - 1) / CLEAN_BLOCK_SIZE, clean_dedup_hash_block, &dedup);
+	clean_shards_initialize(&dedup.shards, dedup.key, count);
+	memory_deallocate(dedup.key);
+	obj_parallel_for(CLEAN_SHARD_COUNT, clean_dedup_match_shard, &dedup);
+	clean_shards_finalize(&dedup.shards);
+
+	unsigned int unique_count = clean_remap_resolve(dedup.remap, count);
+	if (unique_count == count) {
+		memory_deallocate(dedup.remap);
+		return nullptr;
+	}
+	clean_compact(array, dedup.remap, unique_count);
+	return dedup.remap;
+}
+
+bool
+obj_dedup_attributes(obj_t* obj) {
+	if (!obj)
+		return false;
+
+	unsigned int* vertex = clean_dedup_array(&obj->vertex);
+	unsigned int* normal = clean_dedup_array(&obj->normal);
+	unsigned int* uv = clean_dedup_array(&obj->uv);
+	if (vertex || normal || uv) {
+		clean_remap_t remap = {obj, {vertex, normal, uv, nullptr}, true};
+		obj_parallel_for(clean_subgroup_count(obj), clean_remap_subgroup, &remap);
+	}
+
+	memory_deallocate(uv);
+	memory_deallocate(normal);
+	memory_deallocate(vertex);
+	return true;
+}
+
+//! Set bit in a bitset shared between threads
+static void
+clean_bitset_set(atomic32_t* bitset, unsigned int index) {
+	atomic32_t* word = bitset + (index / 32);
+	int32_t bit = (int32_t)(1U << (index % 32));
+	int32_t value = atomic_load32(word, memory_order_relaxed);
+	while (!(value & bit)) {
+		if (atomic_cas32(word, value | bit, value, memory_order_relaxed, memory_order_relaxed))
+			break;
+		value = atomic_load32(word, memory_order_relaxed);
+	}
+}
+
+static bool
+clean_bitset_test(const atomic32_t* bitset, size_t index) {
+	return (atomic_load32(bitset + (index / 32), memory_order_relaxed) & (int32_t)(1U << (index % 32))) != 0;
+}
+
+/*! Remove corners not referenced by any face or triangle of a subgroup, relinking the chains of
+corners sharing a vertex, and mark the attributes referenced by the kept corners */
+static void
+clean_unused_subgroup(void* context, size_t index) {
+	clean_unused_t* unused = context;
+	obj_subgroup_t* subgroup = clean_subgroup(unused->obj, index);
+	if (!subgroup)
+		return;
+	size_t corner_count = subgroup->corner.count;
+	if (!corner_count)
+		return;
+
+	unsigned int* remap = memory_allocate(HASH_OBJ, sizeof(unsigned int) * corner_count, 0, MEMORY_PERSISTENT);
+	memset(remap, 0xFF, sizeof(unsigned int) * corner_count);
+	for (size_t iindex = 0, isize = subgroup->index.count; iindex < isize; ++iindex)
+		remap[*(unsigned int*)bucketarray_get(&subgroup->index, iindex)] = 0;
+	for (size_t itri = 0, tsize = subgroup->triangle.count; itri < tsize; ++itri) {
+		const obj_triangle_t* triangle = bucketarray_get(&subgroup->triangle, itri);
+		for (int icorner = 0; icorner < 3; ++icorner)
+			remap[triangle->index[icorner]] = 0;
+	}
+	unsigned int count = 0;
+	for (size_t icorner = 0; icorner < corner_count; ++icorner) {
+		if (remap[icorner] != INVALID_INDEX)
+			remap[icorner] = count++;
+	}
+
+	if (count < corner_count) {
+		// Removed corners are never rewritten, so chains can be followed through them
+		for (size_t icorner = 0; icorner < corner_count; ++icorner) {
+			if (remap[icorner] == INVALID_INDEX)
+				continue;
+			obj_corner_t* corner = bucketarray_get(&subgroup->corner, icorner);
+			int next = corner->next;
+			while ((next >= 0) && (remap[next] == INVALID_INDEX))
+				next = bucketarray_get_as(obj_corner_t, &subgroup->corner, (size_t)next)->next;
+			corner->next = (next >= 0) ? (int)remap[next] : -1;
+		}
+		clean_compact(&subgroup->corner, remap, count);
+
+		for (size_t iindex = 0, isize = subgroup->index.count; iindex < isize; ++iindex) {
+			unsigned int* corner_index = bucketarray_get(&subgroup->index, iindex);
+			*corner_index = remap[*corner_index];
+		}
+		for (size_t itri = 0, tsize = subgroup->triangle.count; itri < tsize; ++itri) {
+			obj_triangle_t* triangle = bucketarray_get(&subgroup->triangle, itri);
+			for (int icorner = 0; icorner < 3; ++icorner)
+				triangle->index[icorner] = remap[triangle->index[icorner]];
+		}
+	}
+	memory_deallocate(remap);
+
+	for (size_t icorner = 0; icorner < count; ++icorner) {
+		const obj_corner_t* corner = bucketarray_get(&subgroup->corner, icorner);
+		for (int iattrib = 0; iattrib < CLEAN_ATTRIBUTE_COUNT; ++iattrib) {
+			unsigned int value = *(const unsigned int*)pointer_offset_const(corner, clean_attribute_offset[iattrib]);
+			if (unused->used[iattrib] && value)
+				clean_bitset_set(unused->used[iattrib], value - 1);
+		}
+	}
+}
+
+static void
+clean_rank_count(void* context, size_t index) {
+	clean_rank_t* rank = context;
+	size_t end = (index + 1) * CLEAN_BLOCK_SIZE;
+	if (end > rank->count)
+		end = rank->count;
+	unsigned int used = 0;
+	for (size_t ielement = index * CLEAN_BLOCK_SIZE; ielement < end; ++ielement)
+		used += clean_bitset_test(rank->used, ielement) ? 1 : 0;
+	rank->block[index] = used;
+}
+
+static void
+clean_rank_fill(void* context, size_t index) {
+	clean_rank_t* rank = context;
+	size_t end = (index + 1) * CLEAN_BLOCK_SIZE;
+	if (end > rank->count)
+		end = rank->count;
+	unsigned int next = rank->block[index];
+	for (size_t ielement = index * CLEAN_BLOCK_SIZE; ielement < end; ++ielement)
+		rank->remap[ielement] = clean_bitset_test(rank->used, ielement) ? next++ : INVALID_INDEX;
+}
+
+/*! Number used elements in order with a parallel prefix sum over blocks and compact the array
+\return Map from old to new element index, null if all elements are used */
+static unsigned int*
+clean_rank_array(bucketarray_t* array, const atomic32_t* used) {
+	size_t count = array->count;
+	if (!count || !used)
+		return nullptr;
+
+	clean_rank_t rank;
+	size_t block_count = (count + CLEAN_BLOCK_SIZE - 1) / CLEAN_BLOCK_SIZE;
+	rank.used = used;
+	rank.block = memory_allocate(HASH_OBJ, sizeof(unsigned int) * block_count, 0, MEMORY_PERSISTENT);
+	rank.remap = nullptr;
+	rank.count = count;
+	obj_parallel_for(block_count, clean_rank_count, &rank);
+
+	unsigned int used_count = 0;
+	for (size_t iblock = 0; iblock < block_count; ++iblock) {
+		unsigned int block_used = rank.block[iblock];
+		rank.block[iblock] = used_count;
+		used_count += block_used;
+	}
+
+	if (used_count < count) {
+		rank.remap = memory_allocate(HASH_OBJ, sizeof(unsigned int) * count, 0, MEMORY_PERSISTENT);
+		obj_parallel_for(block_count, clean_rank_fill, &rank);
+		clean_compact(array, rank.remap, used_count);
+	}
+	memory_deallocate(rank.block);
+	return rank.remap;
+}
+
+//! Deallocate subgroups without faces and groups without subgroups, and remap group names
+static void
+clean_drop_empty(obj_t* obj) {
+	size_t group_count = 0;
+	for (size_t igroup = 0, gsize = array_size(obj->group); igroup < gsize; ++igroup) {
+		obj_group_t* group = obj->group[igroup];
+		size_t subgroup_count = 0;
+		for (size_t isub = 0, sgsize = array_size(group->subgroup); isub < sgsize; ++isub) {
+			obj_subgroup_t* subgroup = group->subgroup[isub];
+			if (subgroup->face.count)
+				group->subgroup[subgroup_count++] = subgroup;
+			else
+				obj_subgroup_deallocate(subgroup);
+		}
+		if (subgroup_count) {
+			array_resize(group->subgroup, subgroup_count);
+			obj->group[group_count++] = group;
+		} else {
+			array_deallocate(group->subgroup);
+			memory_deallocate(group);
+		}
+	}
+	if (group_count == array_size(obj->group))
+		return;
+
+	array_resize(obj->group, group_count);
+	if (obj->group_map)
+		hashmap_clear(obj->group_map);
+	for (size_t igroup = 0; igroup < group_count; ++igroup)
+		obj_group_map_insert(obj, obj->group[igroup]);
+}
+
+bool
+obj_compact_unused(obj_t* obj) {
+	if (!obj)
+		return false;
+
+	clean_drop_empty(obj);
+
+	bucketarray_t* array[CLEAN_ATTRIBUTE_COUNT] = {&obj->vertex, &obj->normal, &obj->uv, &obj->tangent};
+	clean_unused_t unused;
+	unused.obj = obj;
+	for (int iattrib = 0; iattrib < CLEAN_ATTRIBUTE_COUNT; ++iattrib) {
+		size_t word_count = (array[iattrib]->count + 31) / 32;
+		unused.used[iattrib] = nullptr;
+		if (word_count)
+			unused.used[iattrib] = memory_allocate(HASH_OBJ, sizeof(atomic32_t) * word_count, 0,
+			                                       MEMORY_PERSISTENT | MEMORY_ZERO_INITIALIZED);
+	}
+	size_t subgroup_count = clean_subgroup_count(obj);
+	obj_parallel_for(subgroup_count, clean_unused_subgroup, &unused);
+
+	clean_remap_t remap;
+	memset(&remap, 0, sizeof(remap));
+	remap.obj = obj;
+	bool changed = false;
+	for (int iattrib = 0; iattrib < CLEAN_ATTRIBUTE_COUNT; ++iattrib) {
+		remap.attribute[iattrib] = clean_rank_array(array[iattrib], unused.used[iattrib]);
+		changed = changed || remap.attribute[iattrib];
+	}
+	if (changed)
+		obj_parallel_for(subgroup_count, clean_remap_subgroup, &remap);
+	if (remap.attribute[0])
+		obj_compute_bounds(obj);
+
+	for (int iattrib = 0; iattrib < CLEAN_ATTRIBUTE_COUNT; ++iattrib) {
+		memory_deallocate((void*)remap.attribute[iattrib]);
+		memory_deallocate(unused.used[iattrib]);
+	}
+	return true;
+}
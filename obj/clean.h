@@ -0,0 +1,56 @@
+/* clean.h   -  OBJ library  -  Public Domain  -  2019 Mattias Jansson
+ *
+ * This library provides a cross-platform OBJ I/O library in C11 providing
+ * OBJ ascii reading and writing functionality.
+ *
+ * The latest source code maintained by Mattias Jansson is always available at
+ *
+ * https://github.com/mjansson/obj_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without any
+ * restrictions.
+ *
+ */
+
+#pragma once
+
+/*! \file clean.h
+    Merging of duplicate data */
+
+#include <obj/types.h>
+#include <obj/hashstrings.h>
+
+/*! Merge vertices with positions within a distance of each other. Each vertex is merged
+with the lowest indexed vertex within the distance, which can chain merges over larger
+distances. The vertex array is compacted and corners are remapped, and corners with
+identical vertex, normal, UV and tangent indices in a subgroup are then merged. Adjacent face
+corners collapsed onto the same vertex are merged, and faces and triangles collapsed below three
+distinct vertices are removed. Vertices are bucketed in a grid with cells twice the
+size of the distance, and cells are sorted and searched in parallel shards. Any BVH built
+from the OBJ data must be rebuilt.
+\param obj OBJ data structure
+\param epsilon Maximum distance between merged positions, 0 to only merge identical positions
+\return true if success, false if error */
+OBJ_API bool
+obj_weld_positions(obj_t* obj, real epsilon);
+
+/*! Merge vertices, normals and UVs with bit identical values. Each attribute array is
+compacted, keeping the first of each set of identical values, and corners are remapped.
+Corners with identical vertex, normal, UV and tangent indices in a subgroup are then merged.
+Adjacent face corners collapsed onto the same vertex are merged, and faces and triangles
+collapsed below three distinct vertices are removed. Values are hashed and sorted in parallel
+shards. Any BVH built from the OBJ data must be rebuilt.
+\param obj OBJ data structure
+\return true if success, false if error */
+OBJ_API bool
+obj_dedup_attributes(obj_t* obj);
+
+/*! Remove vertices, normals, UVs, tangents and corners not referenced by any face or triangle,
+and subgroups without faces and groups without subgroups. References are marked in a bitset
+by subgroups in parallel, and used elements are numbered in order with a parallel prefix
+sum before arrays are compacted and corners remapped in place. Any BVH built from the OBJ
+data must be rebuilt.
+\param obj OBJ data structure
+\return true if success, false if error */
+OBJ_API bool
+obj_compact_unused(obj_t* obj);
@@ -0,0 +1,707 @@
+/* inflate.c  -  OBJ library  -  Public Domain  -  2019 Mattias Jansson
+ *
+ * This library provides a cross-platform OBJ I/O library in C11 providing
+ * OBJ ascii reading and writing functionality.
+ *
+ * The latest source code maintained by Mattias Jansson is always available at
+ *
+ * https://github.com/mjansson/obj_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without any
+ * restrictions.
+ *
+ */
+
+#include "inflate.h"
+#include "internal.h"
+
+#include <foundation/stream.h>
+#include <foundation/thread.h>
+#include <foundation/semaphore.h>
+#include <foundation/atomic.h>
+#include <foundation/log.h>
+
+#define INFLATE_FAST_BITS 10
+#define INFLATE_FAST_MASK ((1 << INFLATE_FAST_BITS) - 1)
+#define INFLATE_WINDOW_SIZE 32768
+#define INFLATE_MAX_MATCH 258
+#define INFLATE_OUTPUT_CAPACITY (INFLATE_WINDOW_SIZE + (256 * 1024))
+#define INFLATE_INPUT_CAPACITY (64 * 1024)
+#define INFLATE_BLOCK_COUNT 4
+
+#define STREAMTYPE_INFLATE 0x1f8b
+
+//! Huffman decoding table, with direct lookup of codes up to INFLATE_FAST_BITS long
+typedef struct inflate_huffman_t {
+	//! Symbol shifted left by four bits, or'ed with code length. Zero if code is longer
+	uint16_t fast[1 << INFLATE_FAST_BITS];
+	//! Number of codes of each length
+	uint16_t count[16];
+	//! Symbols ordered by code
+	uint16_t symbol[288];
+} inflate_huffman_t;
+
+typedef struct inflate_decoder_t {
+	stream_t* source;
+	uint8_t* input;
+	size_t input_size;
+	size_t input_offset;
+	bool input_end;
+	//! Number of zero bytes appended to bit buffer after end of input
+	size_t padding;
+	uint64_t bits;
+	unsigned int bit_count;
+	uint8_t* output;
+	size_t output_offset;
+	size_t output_flushed;
+	uint32_t crc;
+	uint32_t size;
+	bool abort;
+	inflate_huffman_t litlen;
+	inflate_huffman_t distance;
+} inflate_decoder_t;
+
+typedef struct inflate_stream_t {
+	FOUNDATION_DECLARE_STREAM;
+	stream_t* source;
+	bool adopt;
+	size_t total_size;
+	size_t position;
+	thread_t thread;
+	atomic32_t terminate;
+	semaphore_t block_free;
+	semaphore_t block_filled;
+	uint8_t* block[INFLATE_BLOCK_COUNT];
+	size_t block_size[INFLATE_BLOCK_COUNT];
+	unsigned int write_block;
+	unsigned int read_block;
+	size_t read_offset;
+	bool has_block;
+	bool end;
+	bool error;
+	inflate_decoder_t decoder;
+} inflate_stream_t;
+
+static uint32_t inflate_crc_table[256];
+
+static const uint16_t inflate_length_base[29] = {3,  4,  5,  6,  7,  8,  9,  10, 11,  13,  15,  17,  19,  23, 27,
+                                                 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+static const uint8_t inflate_length_extra[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2,
+                                                 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+static const uint16_t inflate_distance_base[30] = {1,    2,    3,    4,    5,    7,     9,     13,    17,  25,
+                                                   33,   49,   65,   97,   129,  193,   257,   385,   513, 769,
+                                                   1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+static const uint8_t inflate_distance_extra[30] = {0, 0, 0, 0, 1, 1, 2, 2,  3,  3,  4,  4,  5,  5,  6,
+                                                   6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+static const uint8_t inflate_length_order[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+void
+obj_inflate_initialize(void) {
+	for (uint32_t ientry = 0; ientry < 256; ++ientry) {
+		uint32_t crc = ientry;
+		for (int ibit = 0; ibit < 8; ++ibit)
+			crc = (crc & 1) ? (0xEDB88320U ^ (crc >> 1)) : (crc >> 1);
+		inflate_crc_table[ientry] = crc;
+	}
+}
+
+static uint32_t
+inflate_crc(uint32_t crc, const uint8_t* data, size_t size) {
+	crc = ~crc;
+	for (size_t ibyte = 0; ibyte < size; ++ibyte)
+		crc = inflate_crc_table[(crc ^ data[ibyte]) & 0xFF] ^ (crc >> 8);
+	return ~crc;
+}
+
+static bool
+inflate_read_input(inflate_decoder_t* decoder) {
+	if (decoder->input_end)
+		return false;
+	decoder->input_size = stream_read(decoder->source, decoder->input, INFLATE_INPUT_CAPACITY);
+	decoder->input_offset = 0;
+	if (!decoder->input_size) {
+		decoder->input_end = true;
+		return false;
+	}
+	return true;
+}
+
+static void
+inflate_refill(inflate_decoder_t* decoder) {
+	while (decoder->bit_count <= 56) {
+		if ((decoder->input_offset == decoder->input_size) && !inflate_read_input(decoder)) {
+			// Pad with zero bytes past end of input, checked by inflate_truncated
+			++decoder->padding;
+			decoder->bit_count += 8;
+			continue;
+		}
+		decoder->bits |= (uint64_t)decoder->input[decoder->input_offset++] << decoder->bit_count;
+		decoder->bit_count += 8;
+	}
+}
+
+//! Check if padding bits past end of input have been consumed
+static bool
+inflate_truncated(inflate_decoder_t* decoder) {
+	return decoder->bit_count < (decoder->padding * 8);
+}
+
+static uint32_t
+inflate_bits(inflate_decoder_t* decoder, unsigned int count) {
+	if (!count)
+		return 0;
+	if (decoder->bit_count < count)
+		inflate_refill(decoder);
+	uint32_t value = (uint32_t)(decoder->bits & ((1ULL << count) - 1));
+	decoder->bits >>= count;
+	decoder->bit_count -= count;
+	return value;
+}
+
+static void
+inflate_align(inflate_decoder_t* decoder) {
+	unsigned int drop = decoder->bit_count & 7;
+	decoder->bits >>= drop;
+	decoder->bit_count -= drop;
+}
+
+//! Check if another gzip member follows in the input
+static bool
+inflate_has_member(inflate_decoder_t* decoder) {
+	inflate_refill(decoder);
+	if ((decoder->bit_count - (decoder->padding * 8)) < 16)
+		return false;
+	return (decoder->bits & 0xFFFF) == 0x8b1f;
+}
+
+static bool
+inflate_build(inflate_huffman_t* huffman, const uint8_t* length, unsigned int count) {
+	memset(huffman->count, 0, sizeof(huffman->count));
+	for (unsigned int isym = 0; isym < count; ++isym)
+		++huffman->count[length[isym]];
+	huffman->count[0] = 0;
+
+	int left = 1;
+	for (unsigned int ilen = 1; ilen < 16; ++ilen) {
+		left <<= 1;
+		left -= huffman->count[ilen];
+		if (left < 0)
+			return false;
+	}
+
+	uint16_t offset[16];
+	uint16_t next_code[16];
+	offset[1] = 0;
+	next_code[1] = 0;
+	for (unsigned int ilen = 1; ilen < 15; ++ilen) {
+		offset[ilen + 1] = (uint16_t)(offset[ilen] + huffman->count[ilen]);
+		next_code[ilen + 1] = (uint16_t)((next_code[ilen] + huffman->count[ilen]) << 1);
+	}
+
+	memset(huffman->fast, 0, sizeof(huffman->fast));
+	for (unsigned int isym = 0; isym < count; ++isym) {
+		unsigned int code_length = length[isym];
+		if (!code_length)
+			continue;
+		huffman->symbol[offset[code_length]++] = (uint16_t)isym;
+		unsigned int code = next_code[code_length]++;
+		if (code_length > INFLATE_FAST_BITS)
+			continue;
+		// Codes are stored most significant bit first, reverse for lookup in bit buffer
+		unsigned int reversed = 0;
+		for (unsigned int ibit = 0; ibit < code_length; ++ibit)
+			reversed |= ((code >> ibit) & 1) << (code_length - ibit - 1);
+		uint16_t entry = (uint16_t)((isym << 4) | code_length);
+		for (unsigned int ifill = reversed; ifill < (1 << INFLATE_FAST_BITS); ifill += (1U << code_length))
+			huffman->fast[ifill] = entry;
+	}
+
+	return true;
+}
+
+static int
+inflate_decode(inflate_decoder_t* decoder, const inflate_huffman_t* huffman) {
+	if (decoder->bit_count < 16)
+		inflate_refill(decoder);
+
+	uint16_t entry = huffman->fast[decoder->bits & INFLATE_FAST_MASK];
+	if (entry) {
+		unsigned int code_length = entry & 15;
+		decoder->bits >>= code_length;
+		decoder->bit_count -= code_length;
+		return entry >> 4;
+	}
+
+	// Canonical decoding of codes longer than the fast lookup
+	int code = 0;
+	int first = 0;
+	int index = 0;
+	for (unsigned int ilen = 1; ilen < 16; ++ilen) {
+		code |= (int)(decoder->bits & 1);
+		decoder->bits >>= 1;
+		--decoder->bit_count;
+		int count = huffman->count[ilen];
+		if ((code - count) < first)
+			return huffman->symbol[index + (code - first)];
+		index += count;
+		first += count;
+		first <<= 1;
+		code <<= 1;
+	}
+	return -1;
+}
+
+static bool
+inflate_flush(inflate_stream_t* stream) {
+	inflate_decoder_t* decoder = &stream->decoder;
+	size_t size = decoder->output_offset - decoder->output_flushed;
+	if (!size)
+		return true;
+
+	const uint8_t* data = decoder->output + decoder->output_flushed;
+	decoder->crc = inflate_crc(decoder->crc, data, size);
+	decoder->size += (uint32_t)size;
+
+	semaphore_wait(&stream->block_free);
+	if (atomic_load32(&stream->terminate, memory_order_acquire)) {
+		decoder->abort = true;
+		return false;
+	}
+	memcpy(stream->block[stream->write_block], data, size);
+	stream->block_size[stream->write_block] = size;
+	stream->write_block = (stream->write_block + 1) % INFLATE_BLOCK_COUNT;
+	semaphore_post(&stream->block_filled);
+
+	// Keep window of history for back references
+	if (decoder->output_offset > INFLATE_WINDOW_SIZE) {
+		memmove(decoder->output, decoder->output + decoder->output_offset - INFLATE_WINDOW_SIZE,
+		        INFLATE_WINDOW_SIZE);
+		decoder->output_offset = INFLATE_WINDOW_SIZE;
+	}
+	decoder->output_flushed = decoder->output_offset;
+	return true;
+}
+
+static bool
+inflate_block_huffman(inflate_stream_t* stream) {
+	inflate_decoder_t* decoder = &stream->decoder;
+	while (true) {
+		if (((decoder->output_offset + INFLATE_MAX_MATCH) > INFLATE_OUTPUT_CAPACITY) && !inflate_flush(stream))
+			return false;
+
+		int symbol = inflate_decode(decoder, &decoder->litlen);
+		if (symbol < 256) {
+			if (symbol < 0)
+				return false;
+			decoder->output[decoder->output_offset++] = (uint8_t)symbol;
+			continue;
+		}
+		if (symbol == 256)
+			return !inflate_truncated(decoder);
+
+		symbol -= 257;
+		if (symbol >= 29)
+			return false;
+		size_t length = inflate_length_base[symbol] + inflate_bits(decoder, inflate_length_extra[symbol]);
+
+		symbol = inflate_decode(decoder, &decoder->distance);
+		if ((symbol < 0) || (symbol >= 30))
+			return false;
+		size_t distance = inflate_distance_base[symbol] + inflate_bits(decoder, inflate_distance_extra[symbol]);
+		if ((distance > decoder->output_offset) || inflate_truncated(decoder))
+			return false;
+
+		uint8_t* dest = decoder->output + decoder->output_offset;
+		const uint8_t* source = dest - distance;
+		if (distance >= length) {
+			memcpy(dest, source, length);
+		} else {
+			for (size_t ibyte = 0; ibyte < length; ++ibyte)
+				dest[ibyte] = source[ibyte];
+		}
+		decoder->output_offset += length;
+	}
+}
+
+static bool
+inflate_block_stored(inflate_stream_t* stream) {
+	inflate_decoder_t* decoder = &stream->decoder;
+	inflate_align(decoder);
+	uint32_t length = inflate_bits(decoder, 16);
+	uint32_t inverse = inflate_bits(decoder, 16);
+	if ((length != (~inverse & 0xFFFF)) || inflate_truncated(decoder))
+		return false;
+	while (length--) {
+		if ((decoder->output_offset == INFLATE_OUTPUT_CAPACITY) && !inflate_flush(stream))
+			return false;
+		decoder->output[decoder->output_offset++] = (uint8_t)inflate_bits(decoder, 8);
+	}
+	return !inflate_truncated(decoder);
+}
+
+static bool
+inflate_block_fixed(inflate_stream_t* stream) {
+	inflate_decoder_t* decoder = &stream->decoder;
+	uint8_t length[288];
+	memset(length, 8, 144);
+	memset(length + 144, 9, 112);
+	memset(length + 256, 7, 24);
+	memset(length + 280, 8, 8);
+	inflate_build(&decoder->litlen, length, 288);
+	memset(length, 5, 30);
+	inflate_build(&decoder->distance, length, 30);
+	return inflate_block_huffman(stream);
+}
+
+static bool
+inflate_block_dynamic(inflate_stream_t* stream) {
+	inflate_decoder_t* decoder = &stream->decoder;
+	unsigned int litlen_count = inflate_bits(decoder, 5) + 257;
+	unsigned int distance_count = inflate_bits(decoder, 5) + 1;
+	unsigned int length_count = inflate_bits(decoder, 4) + 4;
+	if ((litlen_count > 286) || (distance_count > 30))
+		return false;
+
+	uint8_t length[288 + 32];
+	memset(length, 0, 19);
+	for (unsigned int ilen = 0; ilen < length_count; ++ilen)
+		length[inflate_length_order[ilen]] = (uint8_t)inflate_bits(decoder, 3);
+	if (!inflate_build(&decoder->litlen, length, 19))
+		return false;
+
+	unsigned int total_count = litlen_count + distance_count;
+	unsigned int ilen = 0;
+	while (ilen < total_count) {
+		int symbol = inflate_decode(decoder, &decoder->litlen);
+		if (symbol < 0)
+			return false;
+		if (symbol < 16) {
+			length[ilen++] = (uint8_t)symbol;
+			continue;
+		}
+		uint8_t value = 0;
+		unsigned int repeat;
+		if (symbol == 16) {
+			if (!ilen)
+				return false;
+			value = length[ilen - 1];
+			repeat = 3 + inflate_bits(decoder, 2);
+		} else if (symbol == 17) {
+			repeat = 3 + inflate_bits(decoder, 3);
+		} else {
+			repeat = 11 + inflate_bits(decoder, 7);
+		}
+		if ((ilen + repeat) > total_count)
+			return false;
+		while (repeat--)
+			length[ilen++] = value;
+	}
+	if (!length[256] || inflate_truncated(decoder))
+		return false;
+
+	if (!inflate_build(&decoder->litlen, length, litlen_count) ||
+	    !inflate_build(&decoder->distance, length + litlen_count, distance_count))
+		return false;
+	return inflate_block_huffman(stream);
+}
+
+static bool
+inflate_member(inflate_stream_t* stream) {
+	inflate_decoder_t* decoder = &stream->decoder;
+
+	if ((inflate_bits(decoder, 8) != 0x1f) || (inflate_bits(decoder, 8) != 0x8b) || (inflate_bits(decoder, 8) != 8))
+		return false;
+	uint32_t flags = inflate_bits(decoder, 8);
+	inflate_bits(decoder, 32);  // Modification time
+	inflate_bits(decoder, 16);  // Extra flags and operating system
+	if (flags & 4) {
+		uint32_t extra = inflate_bits(decoder, 16);
+		while (extra-- && !inflate_truncated(decoder))
+			inflate_bits(decoder, 8);
+	}
+	if (flags & 8) {
+		while (inflate_bits(decoder, 8) && !inflate_truncated(decoder)) {
+		}
+	}
+	if (flags & 16) {
+		while (inflate_bits(decoder, 8) && !inflate_truncated(decoder)) {
+		}
+	}
+	if (flags & 2)
+		inflate_bits(decoder, 16);
+	if (inflate_truncated(decoder))
+		return false;
+
+	decoder->crc = 0;
+	decoder->size = 0;
+
+	bool last_block = false;
+	while (!last_block) {
+		last_block = (inflate_bits(decoder, 1) != 0);
+		uint32_t type = inflate_bits(decoder, 2);
+		bool result = false;
+		if (type == 0)
+			result = inflate_block_stored(stream);
+		else if (type == 1)
+			result = inflate_block_fixed(stream);
+		else if (type == 2)
+			result = inflate_block_dynamic(stream);
+		if (!result)
+			return false;
+	}
+
+	if (!inflate_flush(stream))
+		return false;
+
+	inflate_align(decoder);
+	uint32_t crc = inflate_bits(decoder, 32);
+	uint32_t size = inflate_bits(decoder, 32);
+	return !inflate_truncated(decoder) && (crc == decoder->crc) && (size == decoder->size);
+}
+
+static void*
+inflate_thread(void* arg) {
+	inflate_stream_t* stream = arg;
+	inflate_decoder_t* decoder = &stream->decoder;
+
+	bool result = true;
+	do {
+		result = inflate_member(stream);
+		// Concatenated gzip members are decompressed as one stream
+	} while (result && inflate_has_member(decoder));
+
+	if (!decoder->abort) {
+		stream->error = !result;
+		if (!result)
+			log_error(HASH_OBJ, ERROR_INVALID_VALUE, STRING_CONST("Invalid or truncated gzip data"));
+
+		// Zero sized block marks end of stream
+		semaphore_wait(&stream->block_free);
+		stream->block_size[stream->write_block] = 0;
+		semaphore_post(&stream->block_filled);
+	}
+
+	return nullptr;
+}
+
+static bool
+inflate_stream_acquire(inflate_stream_t* stream) {
+	if (stream->has_block)
+		return true;
+	if (stream->end)
+		return false;
+	semaphore_wait(&stream->block_filled);
+	if (!stream->block_size[stream->read_block]) {
+		stream->end = true;
+		return false;
+	}
+	stream->has_block = true;
+	stream->read_offset = 0;
+	return true;
+}
+
+static size_t
+inflate_stream_consume(inflate_stream_t* stream, void* buffer, size_t size) {
+	size_t total = 0;
+	while ((total < size) && inflate_stream_acquire(stream)) {
+		size_t available = stream->block_size[stream->read_block] - stream->read_offset;
+		size_t copy = (available < (size - total)) ? available : (size - total);
+		if (buffer)
+			memcpy(pointer_offset(buffer, total), stream->block[stream->read_block] + stream->read_offset, copy);
+		total += copy;
+		stream->read_offset += copy;
+		if (stream->read_offset == stream->block_size[stream->read_block]) {
+			stream->has_block = false;
+			stream->read_block = (stream->read_block + 1) % INFLATE_BLOCK_COUNT;
+			semaphore_post(&stream->block_free);
+		}
+	}
+	stream->position += total;
+	return total;
+}
+
+static size_t
+inflate_stream_read(stream_t* stream, void* buffer, size_t size) {
+	return inflate_stream_consume((inflate_stream_t*)stream, buffer, size);
+}
+
+static size_t
+inflate_stream_write(stream_t* stream, const void* buffer, size_t size) {
+	FOUNDATION_UNUSED(stream);
+	FOUNDATION_UNUSED(buffer);
+	FOUNDATION_UNUSED(size);
+	return 0;
+}
+
+static bool
+inflate_stream_eos(stream_t* stream) {
+	return !inflate_stream_acquire((inflate_stream_t*)stream);
+}
+
+static void
+inflate_stream_flush(stream_t* stream) {
+	FOUNDATION_UNUSED(stream);
+}
+
+static void
+inflate_stream_truncate(stream_t* stream, size_t size) {
+	FOUNDATION_UNUSED(stream);
+	FOUNDATION_UNUSED(size);
+}
+
+static size_t
+inflate_stream_size(stream_t* stream) {
+	return ((inflate_stream_t*)stream)->total_size;
+}
+
+static void
+inflate_stream_seek(stream_t* stream, ssize_t offset, stream_seek_mode_t direction) {
+	inflate_stream_t* inflate_stream = (inflate_stream_t*)stream;
+	size_t target = inflate_stream->position;
+	if (direction == STREAM_SEEK_BEGIN)
+		target = (size_t)offset;
+	else if (direction == STREAM_SEEK_CURRENT)
+		target = (size_t)((ssize_t)inflate_stream->position + offset);
+	else
+		target = (size_t)((ssize_t)inflate_stream->total_size + offset);
+	if (target > inflate_stream->position)
+		inflate_stream_consume(inflate_stream, nullptr, target - inflate_stream->position);
+	else if (target < inflate_stream->position)
+		log_warn(HASH_OBJ, WARNING_UNSUPPORTED, STRING_CONST("Unable to seek backwards in gzip stream"));
+}
+
+static size_t
+inflate_stream_tell(stream_t* stream) {
+	return ((inflate_stream_t*)stream)->position;
+}
+
+static tick_t
+inflate_stream_lastmod(const stream_t* stream) {
+	return stream_last_modified(((const inflate_stream_t*)stream)->source);
+}
+
+static uint128_t
+inflate_stream_digest(stream_t* stream) {
+	FOUNDATION_UNUSED(stream);
+	uint128_t digest;
+	memset(&digest, 0, sizeof(digest));
+	return digest;
+}
+
+static void
+inflate_stream_buffer_read(stream_t* stream) {
+	FOUNDATION_UNUSED(stream);
+}
+
+static size_t
+inflate_stream_available_read(stream_t* stream) {
+	inflate_stream_t* inflate_stream = (inflate_stream_t*)stream;
+	if (!inflate_stream->has_block)
+		return 0;
+	return inflate_stream->block_size[inflate_stream->read_block] - inflate_stream->read_offset;
+}
+
+static void
+inflate_stream_finalize(stream_t* stream) {
+	inflate_stream_t* inflate_stream = (inflate_stream_t*)stream;
+
+	atomic_store32(&inflate_stream->terminate, 1, memory_order_release);
+	semaphore_post(&inflate_stream->block_free);
+	thread_join(&inflate_stream->thread);
+	thread_finalize(&inflate_stream->thread);
+
+	semaphore_finalize(&inflate_stream->block_free);
+	semaphore_finalize(&inflate_stream->block_filled);
+
+	for (unsigned int iblock = 0; iblock < INFLATE_BLOCK_COUNT; ++iblock)
+		memory_deallocate(inflate_stream->block[iblock]);
+	memory_deallocate(inflate_stream->decoder.input);
+	memory_deallocate(inflate_stream->decoder.output);
+
+	if (inflate_stream->adopt)
+		stream_deallocate(inflate_stream->source);
+}
+
+static stream_t*
+inflate_stream_clone(stream_t* stream) {
+	FOUNDATION_UNUSED(stream);
+	return nullptr;
+}
+
+static stream_vtable_t inflate_stream_vtable = {inflate_stream_read,
+                                                inflate_stream_write,
+                                                inflate_stream_eos,
+                                                inflate_stream_flush,
+                                                inflate_stream_truncate,
+                                                inflate_stream_size,
+                                                inflate_stream_seek,
+                                                inflate_stream_tell,
+                                                inflate_stream_lastmod,
+                                                inflate_stream_digest,
+                                                inflate_stream_buffer_read,
+                                                inflate_stream_available_read,
+                                                inflate_stream_finalize,
+                                                inflate_stream_clone};
+
+bool
+obj_stream_is_gzip(stream_t* stream) {
+	if (!stream || stream_is_sequential(stream))
+		return false;
+	uint8_t magic[2] = {0, 0};
+	size_t was_read = stream_read(stream, magic, sizeof(magic));
+	stream_seek(stream, -(ssize_t)was_read, STREAM_SEEK_CURRENT);
+	return (was_read == sizeof(magic)) && (magic[0] == 0x1f) && (magic[1] == 0x8b);
+}
+
+bool
+obj_inflate_stream_failed(stream_t* stream) {
+	inflate_stream_t* inflate_stream = (inflate_stream_t*)stream;
+	// Error flag is set by the decompression thread before the end of stream block is posted
+	return inflate_stream->error;
+}
+
+stream_t*
+obj_inflate_stream_allocate(stream_t* source, bool adopt) {
+	if (!source)
+		return nullptr;
+
+	inflate_stream_t* stream =
+	    memory_allocate(HASH_OBJ, sizeof(inflate_stream_t), 0, MEMORY_PERSISTENT | MEMORY_ZERO_INITIALIZED);
+	stream_initialize((stream_t*)stream, system_byteorder());
+	stream->type = STREAMTYPE_INFLATE;
+	stream->sequential = 1;
+	stream->mode = STREAM_IN | STREAM_BINARY;
+	stream->path = string_clone_string(stream_path(source));
+	stream->vtable = &inflate_stream_vtable;
+	stream->source = source;
+	stream->adopt = adopt;
+
+	// Uncompressed size modulo 2^32 is stored last in gzip data, use as size hint if available
+	if (!stream_is_sequential(source)) {
+		size_t offset = stream_tell(source);
+		size_t source_size = stream_size(source);
+		if (source_size >= (offset + 18)) {
+			uint8_t trailer[4];
+			stream_seek(source, -4, STREAM_SEEK_END);
+			if (stream_read(source, trailer, sizeof(trailer)) == sizeof(trailer))
+				stream->total_size = (size_t)trailer[0] | ((size_t)trailer[1] << 8) | ((size_t)trailer[2] << 16) |
+				                     ((size_t)trailer[3] << 24);
+			stream_seek(source, (ssize_t)offset, STREAM_SEEK_BEGIN);
+		}
+	}
+
+	for (unsigned int iblock = 0; iblock < INFLATE_BLOCK_COUNT; ++iblock)
+		stream->block[iblock] = memory_allocate(HASH_OBJ, INFLATE_OUTPUT_CAPACITY, 0, MEMORY_PERSISTENT);
+	stream->decoder.source = source;
+	stream->decoder.input = memory_allocate(HASH_OBJ, INFLATE_INPUT_CAPACITY, 0, MEMORY_PERSISTENT);
+	stream->decoder.output = memory_allocate(HASH_OBJ, INFLATE_OUTPUT_CAPACITY, 0, MEMORY_PERSISTENT);
+
+	semaphore_initialize(&stream->block_free, INFLATE_BLOCK_COUNT);
+	semaphore_initialize(&stream->block_filled, 0);
+
+	thread_initialize(&stream->thread, inflate_thread, stream, STRING_CONST("obj_inflate"), THREAD_PRIORITY_NORMAL,
+	                  0);
+	thread_start(&stream->thread);
+
+	return (stream_t*)stream;
+}
@@ -0,0 +1,37 @@
+/* inflate.h  -  OBJ library  -  Public Domain  -  2019 Mattias Jansson
+ *
+ * This library provides a cross-platform OBJ I/O library in C11 providing
+ * OBJ ascii reading and writing functionality.
+ *
+ * The latest source code maintained by Mattias Jansson is always available at
+ *
+ * https://github.com/mjansson/obj_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without any
+ * restrictions.
+ *
+ */
+
+#pragma once
+
+/*! \file inflate.h
+    Decompression of gzip compressed OBJ data */
+
+#include <obj/types.h>
+#include <obj/hashstrings.h>
+
+/*! Check if stream data at current position is gzip compressed. The stream position is
+not changed. Only seekable streams can be checked.
+\param stream Stream
+\return true if stream is seekable and data is gzip compressed, false if not */
+OBJ_API bool
+obj_stream_is_gzip(stream_t* stream);
+
+/*! Allocate a stream decompressing gzip data read from the source stream. Decompression
+runs on a separate thread and overlaps with reading from the returned stream. The returned
+stream is sequential, only forward seeks are supported.
+\param source Source stream with gzip data
+\param adopt Flag indicating if source stream should be deallocated with the returned stream
+\return New stream */
+OBJ_API stream_t*
+obj_inflate_stream_allocate(stream_t* source, bool adopt);
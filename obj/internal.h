@@ -0,0 +1,246 @@
+/* internal.h  -  OBJ library  -  Public Domain  -  2019 Mattias Jansson
+ *
+ * This library provides a cross-platform OBJ I/O library in C11 providing
+ * OBJ ascii reading and writing functionality.
+ *
+ * The latest source code maintained by Mattias Jansson is always available at
+ *
+ * https://github.com/mjansson/obj_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without any
+ * restrictions.
+ *
+ */
+
+#pragma once
+
+/*! \file internal.h
+    Internal types and functions */
+
+#include <obj/types.h>
+
+#include <foundation/atomic.h>
+#include <foundation/bucketarray.h>
+#include <foundation/math.h>
+
+//! Default number of work units between progress callbacks
+#define OBJ_PROGRESS_INTERVAL 65536
+
+//! Smallest bucket size of subgroup arrays
+#define OBJ_BUCKET_SIZE_MIN 16
+//! Largest bucket size of subgroup arrays
+#define OBJ_BUCKET_SIZE_MAX 65536
+//! Number of full buckets before a subgroup array is re-bucketed to a larger bucket size, also the growth factor
+#define OBJ_BUCKET_GROWTH 8
+
+static FOUNDATION_FORCEINLINE bool
+obj_progress_cancelled(obj_progress_t* progress) {
+	return progress && (atomic_load32(&progress->cancel, memory_order_acquire) != 0);
+}
+
+/*! Call progress callback if the configured interval of work units passed since last report,
+or if a known nonzero total of work is complete
+\param progress Progress control
+\param phase Current phase
+\param done Work units done
+\param total Total work units
+\param last Work units done at last report, updated if callback is called */
+static FOUNDATION_FORCEINLINE void
+obj_progress_update(obj_progress_t* progress, obj_progress_phase_t phase, size_t done, size_t total,
+                    size_t* last) {
+	if (!progress || !progress->callback)
+		return;
+	size_t interval = progress->interval ? progress->interval : OBJ_PROGRESS_INTERVAL;
+	if (((done - *last) >= interval) || (total && (done >= total) && (done != *last))) {
+		progress->callback(progress->context, phase, done, total);
+		*last = done;
+	}
+}
+
+//! Build lookup tables used by gzip decompression
+void
+obj_inflate_initialize(void);
+
+/*! Check if decompression of a stream allocated by obj_inflate_stream_allocate failed on
+invalid or truncated data, or on a CRC32 or size trailer mismatch. Only valid once the end
+of the stream has been reached.
+\param stream Decompressing stream
+\return true if decompression failed, false if not */
+bool
+obj_inflate_stream_failed(stream_t* stream);
+
+/*! Get bucket size for an array expected to hold the given number of elements
+\param count Expected number of elements
+\param bucket_count Wanted number of buckets
+\return Power of two bucket size clamped to subgroup array limits */
+size_t
+obj_bucket_size(size_t count, size_t bucket_count);
+
+/*! Move array elements to buckets of the given size
+\param array Array
+\param bucket_size New bucket size */
+void
+obj_bucketarray_rebucket(bucketarray_t* array, size_t bucket_size);
+
+/*! Re-bucket array to trim unused storage
+\param array Array */
+void
+obj_bucketarray_shrink(bucketarray_t* array);
+
+/*! Push element to subgroup array, growing the bucket size geometrically when a new bucket
+is needed and the array already holds OBJ_BUCKET_GROWTH full buckets
+\param array Array
+\param element Element to push */
+static FOUNDATION_FORCEINLINE void
+obj_bucketarray_push(bucketarray_t* array, const void* element) {
+	if ((array->count >= (array->bucket_size * OBJ_BUCKET_GROWTH)) &&
+	    (array->count == (array->bucket_count * array->bucket_size)) && (array->bucket_size < OBJ_BUCKET_SIZE_MAX))
+		obj_bucketarray_rebucket(array, array->bucket_size * OBJ_BUCKET_GROWTH);
+	bucketarray_push(array, element);
+}
+
+//! Maximum number of threads used by obj_parallel_for
+#define OBJ_PARALLEL_THREADS_MAX 64
+
+//! Parallel task function, called once for each index
+typedef void (*obj_parallel_fn)(void* context, size_t index);
+
+/*! Call task function for each index in [0, count) on the calling thread and worker threads,
+returning when all calls are done
+\param count Number of indices
+\param fn Task function
+\param context Context passed to task function */
+void
+obj_parallel_for(size_t count, obj_parallel_fn fn, void* context);
+
+//! Triangle adjacency of vertices, with lists of live triangles using each vertex
+typedef struct obj_adjacency_t {
+	//! Number of live triangles using each vertex
+	unsigned int* live;
+	//! Offset of each vertex list in triangle array
+	unsigned int* offset;
+	//! Triangle lists
+	unsigned int* triangle;
+} obj_adjacency_t;
+
+/*! Copy subgroup triangles to a flat index array, three corner indices per triangle
+\param subgroup Subgroup
+\return Index array, deallocate with memory_deallocate */
+unsigned int*
+obj_subgroup_triangle_indices(const obj_subgroup_t* subgroup);
+
+/*! Build triangle adjacency of vertices
+\param adjacency Adjacency to initialize
+\param indices Triangle vertex indices, three per triangle
+\param triangle_count Number of triangles
+\param vertex_count Number of vertices */
+void
+obj_adjacency_initialize(obj_adjacency_t* adjacency, const unsigned int* indices, size_t triangle_count,
+                         size_t vertex_count);
+
+/*! Finalize triangle adjacency
+\param adjacency Adjacency */
+void
+obj_adjacency_finalize(obj_adjacency_t* adjacency);
+
+/*! Remove triangle from lists of its vertices
+\param adjacency Adjacency
+\param triangle Triangle index
+\param index Triangle vertex indices */
+void
+obj_adjacency_remove(obj_adjacency_t* adjacency, unsigned int triangle, const unsigned int* index);
+
+/*! Triangulate all faces of subgroup, replacing any existing triangles
+\param obj OBJ data structure owning the subgroup
+\param subgroup Subgroup
+\param done Optional counter of triangulated faces for progress reporting, null to not report progress
+\param total Total number of faces for progress reporting
+\param last_report Value of done at last progress report
+\return true if success, false if cancelled */
+bool
+obj_triangulate_subgroup(obj_t* obj, obj_subgroup_t* subgroup, size_t* done, size_t total, size_t* last_report);
+
+/*! Finalize subgroup arrays and deallocate subgroup
+\param subgroup Subgroup */
+void
+obj_subgroup_deallocate(obj_subgroup_t* subgroup);
+
+/*! Map group name to group, unless another group with the same name is already mapped
+\param obj OBJ data structure owning the group
+\param group Group */
+void
+obj_group_map_insert(obj_t* obj, obj_group_t* group);
+
+//! Reset bounds to empty
+static FOUNDATION_FORCEINLINE void
+obj_bounds_clear(obj_bounds_t* bounds) {
+	bounds->min.x = bounds->min.y = bounds->min.z = REAL_MAX;
+	bounds->max.x = bounds->max.y = bounds->max.z = -REAL_MAX;
+}
+
+//! Extend bounds to include vertex
+static FOUNDATION_FORCEINLINE void
+obj_bounds_extend(obj_bounds_t* bounds, const obj_vertex_t* vertex) {
+	if (vertex->x < bounds->min.x)
+		bounds->min.x = vertex->x;
+	if (vertex->y < bounds->min.y)
+		bounds->min.y = vertex->y;
+	if (vertex->z < bounds->min.z)
+		bounds->min.z = vertex->z;
+	if (vertex->x > bounds->max.x)
+		bounds->max.x = vertex->x;
+	if (vertex->y > bounds->max.y)
+		bounds->max.y = vertex->y;
+	if (vertex->z > bounds->max.z)
+		bounds->max.z = vertex->z;
+}
+
+//! Extend bounds to include other bounds
+static FOUNDATION_FORCEINLINE void
+obj_bounds_merge(obj_bounds_t* bounds, const obj_bounds_t* other) {
+	if (other->min.x <= other->max.x) {
+		obj_bounds_extend(bounds, &other->min);
+		obj_bounds_extend(bounds, &other->max);
+	}
+}
+
+/*! Compute the matrix transforming normals, the inverse transpose of the linear part of the
+transform, or the cofactor matrix if the linear part is singular
+\param matrix Transform
+\param normal Normal matrix
+\return Determinant of the linear part of the transform */
+real
+obj_matrix_normal(const obj_matrix_t* matrix, real normal[3][3]);
+
+//! Transform vertex by affine transform
+static FOUNDATION_FORCEINLINE void
+obj_matrix_transform_vertex(const obj_matrix_t* FOUNDATION_RESTRICT matrix, obj_vertex_t* FOUNDATION_RESTRICT vertex) {
+	real x = vertex->x;
+	real y = vertex->y;
+	real z = vertex->z;
+	vertex->x = (matrix->row[0][0] * x) + (matrix->row[0][1] * y) + (matrix->row[0][2] * z) + matrix->row[0][3];
+	vertex->y = (matrix->row[1][0] * x) + (matrix->row[1][1] * y) + (matrix->row[1][2] * z) + matrix->row[1][3];
+	vertex->z = (matrix->row[2][0] * x) + (matrix->row[2][1] * y) + (matrix->row[2][2] * z) + matrix->row[2][3];
+}
+
+//! Transform normal by normal matrix, optionally normalizing, zero length normals stay zero
+static FOUNDATION_FORCEINLINE void
+obj_matrix_transform_normal(const real (*FOUNDATION_RESTRICT matrix)[3], obj_normal_t* FOUNDATION_RESTRICT normal,
+                            bool normalize) {
+	real nx = normal->nx;
+	real ny = normal->ny;
+	real nz = normal->nz;
+	real x = (matrix[0][0] * nx) + (matrix[0][1] * ny) + (matrix[0][2] * nz);
+	real y = (matrix[1][0] * nx) + (matrix[1][1] * ny) + (matrix[1][2] * nz);
+	real z = (matrix[2][0] * nx) + (matrix[2][1] * ny) + (matrix[2][2] * nz);
+	if (normalize) {
+		real length_squared = (x * x) + (y * y) + (z * z);
+		real scale = (length_squared > 0) ? (REAL_C(1.0) / math_sqrt(length_squared)) : 0;
+		x *= scale;
+		y *= scale;
+		z *= scale;
+	}
+	normal->nx = x;
+	normal->ny = y;
+	normal->nz = z;
+}
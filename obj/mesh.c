@@ -13,6 +13,9 @@
  */
 
 #include <obj/mesh.h>
+#include <obj/optimize.h>
+#include <obj/tangent.h>
+#include <obj/internal.h>
 
 #include <mesh/mesh.h>
 #include <foundation/bucketarray.h>
@@ -25,6 +28,15 @@ obj_to_mesh(obj_t* obj) {
 	if (!obj)
 		return nullptr;
 
+	if (obj->option.mesh_flags & OBJ_MESH_OPTIMIZE_VERTEX_CACHE)
+		obj_optimize_vertex_cache(obj, nullptr);
+	if (obj->option.mesh_flags & OBJ_MESH_OPTIMIZE_OVERDRAW)
+		obj_optimize_overdraw(obj, OBJ_OVERDRAW_THRESHOLD);
+	if (obj->option.mesh_flags & OBJ_MESH_OPTIMIZE_VERTEX_FETCH)
+		obj_optimize_vertex_fetch(obj, true);
+	if (obj->option.mesh_flags & OBJ_MESH_GENERATE_TANGENTS)
+		obj_generate_tangents(obj);
+
 	size_t total_triangle_count = 0;
 	for (unsigned int igroup = 0, gsize = array_size(obj->group); igroup < gsize; ++igroup) {
 		obj_group_t* group = obj->group[igroup];
@@ -58,6 +70,8 @@ obj_to_mesh(obj_t* obj) {
 	}
 
 	// Triangle data
+	size_t done = 0;
+	size_t last_report = 0;
 	for (unsigned int igroup = 0, gsize = array_size(obj->group); igroup < gsize; ++igroup) {
 		obj_group_t* group = obj->group[igroup];
 		for (unsigned int isub = 0, sgsize = array_size(group->subgroup); isub < sgsize; ++isub) {
@@ -89,6 +103,12 @@ obj_to_mesh(obj_t* obj) {
 				bucketarray_push(&mesh->vertex, &vertex);
 
 				bucketarray_push(&mesh->triangle, &triangle);
+
+				obj_progress_update(&obj->progress, OBJ_PROGRESS_MESH, ++done, total_triangle_count, &last_report);
+				if (!(done % 1024) && obj_progress_cancelled(&obj->progress)) {
+					mesh_deallocate(mesh);
+					return nullptr;
+				}
 			}
 		}
 	}
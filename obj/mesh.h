@@ -23,9 +23,12 @@
 //! External data structure
 struct mesh_t;
 
-/*! Transcode an OBJ data structure to a mesh
+/*! Transcode an OBJ data structure to a mesh. Progress is reported through the progress
+control in the OBJ data structure. Mesh flags in the OBJ data structure options can enable
+optimization passes, which modify the triangle order of the OBJ data structure, and tangent
+generation, see obj_mesh_tangents to get the tangents of the mesh vertices.
 \param obj Source OBJ data structure
-\return New mesh */
+\return New mesh, null if cancelled */
 OBJ_API struct mesh_t*
 obj_to_mesh(obj_t* obj);
 
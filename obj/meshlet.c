@@ -0,0 +1,360 @@
+/* meshlet.c   -  OBJ library  -  Public Domain  -  2019 Mattias Jansson
+ *
+ * This library provides a cross-platform OBJ I/O library in C11 providing
+ * OBJ ascii reading and writing functionality.
+ *
+ * The latest source code maintained by Mattias Jansson is always available at
+ *
+ * https://github.com/mjansson/obj_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without any
+ * restrictions.
+ *
+ */
+
+#include "meshlet.h"
+#include "internal.h"
+
+#include <foundation/array.h>
+#include <foundation/bucketarray.h>
+#include <foundation/math.h>
+
+static unsigned int INVALID_INDEX = 0xFFFFFFFF;
+
+//! Number of triangles following the first unassigned triangle searched when restarting a meshlet
+#define MESHLET_SEARCH_WINDOW 256
+
+//! Meshlets of a single subgroup, offsets are local to the subgroup arrays
+typedef struct meshlet_subgroup_t {
+	unsigned int group;
+	unsigned int subgroup;
+	obj_meshlet_t* meshlet;
+	unsigned int* vertex;
+	uint8_t* triangle;
+} meshlet_subgroup_t;
+
+typedef struct meshlet_build_t {
+	const obj_t* obj;
+	unsigned int max_vertices;
+	unsigned int max_triangles;
+	meshlet_subgroup_t* subgroup;
+} meshlet_build_t;
+
+void
+obj_meshlets_initialize(obj_meshlets_t* meshlets) {
+	memset(meshlets, 0, sizeof(obj_meshlets_t));
+}
+
+void
+obj_meshlets_finalize(obj_meshlets_t* meshlets) {
+	array_deallocate(meshlets->meshlet);
+	array_deallocate(meshlets->vertex);
+	array_deallocate(meshlets->triangle);
+}
+
+static const obj_vertex_t*
+meshlet_position(const obj_t* obj, const obj_subgroup_t* subgroup, unsigned int corner_index) {
+	const obj_corner_t* corner = bucketarray_get(&subgroup->corner, corner_index);
+	return bucketarray_get(&obj->vertex, corner->vertex - 1);
+}
+
+static real
+meshlet_distance_squared(const obj_vertex_t* vertex, const real* point) {
+	real dx = vertex->x - point[0];
+	real dy = vertex->y - point[1];
+	real dz = vertex->z - point[2];
+	return (dx * dx) + (dy * dy) + (dz * dz);
+}
+
+//! Calculate unit normal of triangle, returns false if triangle is degenerate
+static bool
+meshlet_triangle_normal(const obj_t* obj, const obj_subgroup_t* subgroup, const unsigned int* index, real* normal) {
+	const obj_vertex_t* v0 = meshlet_position(obj, subgroup, index[0]);
+	const obj_vertex_t* v1 = meshlet_position(obj, subgroup, index[1]);
+	const obj_vertex_t* v2 = meshlet_position(obj, subgroup, index[2]);
+	real e1[3] = {v1->x - v0->x, v1->y - v0->y, v1->z - v0->z};
+	real e2[3] = {v2->x - v0->x, v2->y - v0->y, v2->z - v0->z};
+	normal[0] = (e1[1] * e2[2]) - (e1[2] * e2[1]);
+	normal[1] = (e1[2] * e2[0]) - (e1[0] * e2[2]);
+	normal[2] = (e1[0] * e2[1]) - (e1[1] * e2[0]);
+	real length = math_sqrt((normal[0] * normal[0]) + (normal[1] * normal[1]) + (normal[2] * normal[2]));
+	if (!(length > 0))
+		return false;
+	for (unsigned int iaxis = 0; iaxis < 3; ++iaxis)
+		normal[iaxis] /= length;
+	return true;
+}
+
+static void
+meshlet_bounds(const obj_t* obj, const obj_subgroup_t* subgroup, const unsigned int* vertex, const uint8_t* triangle,
+               obj_meshlet_t* meshlet) {
+	// Bounding sphere centered on the bounding box of the meshlet corners
+	const obj_vertex_t* first = meshlet_position(obj, subgroup, vertex[0]);
+	real min[3] = {first->x, first->y, first->z};
+	real max[3] = {first->x, first->y, first->z};
+	for (unsigned int ivert = 1; ivert < meshlet->vertex_count; ++ivert) {
+		const obj_vertex_t* position = meshlet_position(obj, subgroup, vertex[ivert]);
+		const real coord[3] = {position->x, position->y, position->z};
+		for (unsigned int iaxis = 0; iaxis < 3; ++iaxis) {
+			if (coord[iaxis] < min[iaxis])
+				min[iaxis] = coord[iaxis];
+			if (coord[iaxis] > max[iaxis])
+				max[iaxis] = coord[iaxis];
+		}
+	}
+	real center[3];
+	for (unsigned int iaxis = 0; iaxis < 3; ++iaxis)
+		center[iaxis] = (min[iaxis] + max[iaxis]) * REAL_C(0.5);
+	real radius = 0;
+	for (unsigned int ivert = 0; ivert < meshlet->vertex_count; ++ivert) {
+		real distance = meshlet_distance_squared(meshlet_position(obj, subgroup, vertex[ivert]), center);
+		if (distance > radius)
+			radius = distance;
+	}
+	meshlet->center.x = center[0];
+	meshlet->center.y = center[1];
+	meshlet->center.z = center[2];
+	meshlet->radius = math_sqrt(radius);
+
+	// Normal cone around the average of the unit triangle normals
+	real axis[3] = {0, 0, 0};
+	real normal[3];
+	unsigned int index[3];
+	for (unsigned int itri = 0; itri < meshlet->triangle_count; ++itri) {
+		for (unsigned int icorner = 0; icorner < 3; ++icorner)
+			index[icorner] = vertex[triangle[(itri * 3) + icorner]];
+		if (meshlet_triangle_normal(obj, subgroup, index, normal)) {
+			for (unsigned int iaxis = 0; iaxis < 3; ++iaxis)
+				axis[iaxis] += normal[iaxis];
+		}
+	}
+	real length = math_sqrt((axis[0] * axis[0]) + (axis[1] * axis[1]) + (axis[2] * axis[2]));
+	if (!(length > REAL_C(0.000001))) {
+		meshlet->cone_axis.nx = 0;
+		meshlet->cone_axis.ny = 0;
+		meshlet->cone_axis.nz = 1;
+		meshlet->cone_cutoff = -1;
+		return;
+	}
+	for (unsigned int iaxis = 0; iaxis < 3; ++iaxis)
+		axis[iaxis] /= length;
+
+	real cutoff = 1;
+	for (unsigned int itri = 0; itri < meshlet->triangle_count; ++itri) {
+		for (unsigned int icorner = 0; icorner < 3; ++icorner)
+			index[icorner] = vertex[triangle[(itri * 3) + icorner]];
+		if (meshlet_triangle_normal(obj, subgroup, index, normal)) {
+			real dot = (normal[0] * axis[0]) + (normal[1] * axis[1]) + (normal[2] * axis[2]);
+			if (dot < cutoff)
+				cutoff = dot;
+		}
+	}
+	meshlet->cone_axis.nx = axis[0];
+	meshlet->cone_axis.ny = axis[1];
+	meshlet->cone_axis.nz = axis[2];
+	meshlet->cone_cutoff = cutoff;
+}
+
+//! Count corners of triangle not yet in the current meshlet
+static unsigned int
+meshlet_new_vertices(const unsigned int* slot, const unsigned int* index) {
+	unsigned int count = (slot[index[0]] == INVALID_INDEX) ? 1 : 0;
+	if ((slot[index[1]] == INVALID_INDEX) && (index[1] != index[0]))
+		++count;
+	if ((slot[index[2]] == INVALID_INDEX) && (index[2] != index[0]) && (index[2] != index[1]))
+		++count;
+	return count;
+}
+
+static void
+meshlet_flush(const obj_t* obj, const obj_subgroup_t* subgroup, meshlet_subgroup_t* output, obj_meshlet_t* meshlet,
+              unsigned int* slot) {
+	const unsigned int* vertex = output->vertex + meshlet->vertex_offset;
+	meshlet_bounds(obj, subgroup, vertex, output->triangle + meshlet->triangle_offset, meshlet);
+	array_push(output->meshlet, *meshlet);
+	for (unsigned int ivert = 0; ivert < meshlet->vertex_count; ++ivert)
+		slot[vertex[ivert]] = INVALID_INDEX;
+	meshlet->vertex_offset += meshlet->vertex_count;
+	meshlet->triangle_offset += meshlet->triangle_count * 3;
+	meshlet->vertex_count = 0;
+	meshlet->triangle_count = 0;
+}
+
+static void
+meshlet_build_subgroup(void* context, size_t index) {
+	const meshlet_build_t* build = context;
+	meshlet_subgroup_t* output = build->subgroup + index;
+	const obj_t* obj = build->obj;
+	const obj_subgroup_t* subgroup = obj->group[output->group]->subgroup[output->subgroup];
+	size_t triangle_count = subgroup->triangle.count;
+	size_t vertex_count = subgroup->corner.count;
+
+	unsigned int* indices = obj_subgroup_triangle_indices(subgroup);
+	obj_adjacency_t adjacency;
+	obj_adjacency_initialize(&adjacency, indices, triangle_count, vertex_count);
+	obj_vertex_t* centroid = memory_allocate(HASH_OBJ, sizeof(obj_vertex_t) * triangle_count, 0, MEMORY_PERSISTENT);
+	unsigned int* slot = memory_allocate(HASH_OBJ, sizeof(unsigned int) * vertex_count, 0, MEMORY_PERSISTENT);
+	uint8_t* emitted = memory_allocate(HASH_OBJ, triangle_count, 0, MEMORY_PERSISTENT | MEMORY_ZERO_INITIALIZED);
+	memset(slot, 0xFF, sizeof(unsigned int) * vertex_count);
+
+	const real third = REAL_C(1.0) / REAL_C(3.0);
+	for (size_t itri = 0; itri < triangle_count; ++itri) {
+		const obj_vertex_t* v0 = meshlet_position(obj, subgroup, indices[(itri * 3) + 0]);
+		const obj_vertex_t* v1 = meshlet_position(obj, subgroup, indices[(itri * 3) + 1]);
+		const obj_vertex_t* v2 = meshlet_position(obj, subgroup, indices[(itri * 3) + 2]);
+		centroid[itri].x = (v0->x + v1->x + v2->x) * third;
+		centroid[itri].y = (v0->y + v1->y + v2->y) * third;
+		centroid[itri].z = (v0->z + v1->z + v2->z) * third;
+	}
+
+	obj_meshlet_t meshlet;
+	memset(&meshlet, 0, sizeof(meshlet));
+	meshlet.group = output->group;
+	meshlet.subgroup = output->subgroup;
+
+	real sum[3] = {0, 0, 0};
+	size_t first_unassigned = 0;
+	size_t remaining = triangle_count;
+	while (remaining) {
+		while (emitted[first_unassigned])
+			++first_unassigned;
+
+		unsigned int best_triangle = INVALID_INDEX;
+		if (meshlet.triangle_count) {
+			real center[3];
+			for (unsigned int iaxis = 0; iaxis < 3; ++iaxis)
+				center[iaxis] = sum[iaxis] / (real)meshlet.triangle_count;
+
+			// Grow with the connected triangle adding the fewest corners, closest to the meshlet center
+			unsigned int best_new = 4;
+			real best_distance = 0;
+			bool connected = false;
+			for (unsigned int ivert = 0; ivert < meshlet.vertex_count; ++ivert) {
+				unsigned int vertex = output->vertex[meshlet.vertex_offset + ivert];
+				const unsigned int* list = adjacency.triangle + adjacency.offset[vertex];
+				for (unsigned int iadj = 0; iadj < adjacency.live[vertex]; ++iadj) {
+					unsigned int triangle = list[iadj];
+					unsigned int new_count = meshlet_new_vertices(slot, indices + (triangle * 3));
+					connected = true;
+					if ((meshlet.vertex_count + new_count) > build->max_vertices)
+						continue;
+					real distance = meshlet_distance_squared(centroid + triangle, center);
+					if ((new_count < best_new) || ((new_count == best_new) && (distance < best_distance))) {
+						best_triangle = triangle;
+						best_new = new_count;
+						best_distance = distance;
+					}
+				}
+			}
+
+			// Connected region exhausted, restart at the nearest unassigned triangle within the window
+			if (!connected && ((meshlet.vertex_count + 3) <= build->max_vertices)) {
+				size_t end = first_unassigned + MESHLET_SEARCH_WINDOW;
+				if (end > triangle_count)
+					end = triangle_count;
+				for (size_t itri = first_unassigned; itri < end; ++itri) {
+					if (emitted[itri])
+						continue;
+					real distance = meshlet_distance_squared(centroid + itri, center);
+					if ((best_triangle == INVALID_INDEX) || (distance < best_distance)) {
+						best_triangle = (unsigned int)itri;
+						best_distance = distance;
+					}
+				}
+			}
+
+			if (best_triangle == INVALID_INDEX) {
+				meshlet_flush(obj, subgroup, output, &meshlet, slot);
+				sum[0] = sum[1] = sum[2] = 0;
+				continue;
+			}
+		} else {
+			best_triangle = (unsigned int)first_unassigned;
+		}
+
+		const unsigned int* triangle = indices + (best_triangle * 3);
+		for (unsigned int icorner = 0; icorner < 3; ++icorner) {
+			unsigned int vertex = triangle[icorner];
+			if (slot[vertex] == INVALID_INDEX) {
+				slot[vertex] = meshlet.vertex_count++;
+				array_push(output->vertex, vertex);
+			}
+			array_push(output->triangle, (uint8_t)slot[vertex]);
+		}
+		emitted[best_triangle] = 1;
+		obj_adjacency_remove(&adjacency, best_triangle, triangle);
+		sum[0] += centroid[best_triangle].x;
+		sum[1] += centroid[best_triangle].y;
+		sum[2] += centroid[best_triangle].z;
+		--remaining;
+
+		if (++meshlet.triangle_count == build->max_triangles) {
+			meshlet_flush(obj, subgroup, output, &meshlet, slot);
+			sum[0] = sum[1] = sum[2] = 0;
+		}
+	}
+	if (meshlet.triangle_count)
+		meshlet_flush(obj, subgroup, output, &meshlet, slot);
+
+	memory_deallocate(emitted);
+	memory_deallocate(slot);
+	memory_deallocate(centroid);
+	obj_adjacency_finalize(&adjacency);
+	memory_deallocate(indices);
+}
+
+bool
+obj_build_meshlets(const obj_t* obj, const obj_meshlet_limits_t* limits, obj_meshlets_t* meshlets) {
+	if (!obj || !meshlets)
+		return false;
+
+	array_clear(meshlets->meshlet);
+	array_clear(meshlets->vertex);
+	array_clear(meshlets->triangle);
+
+	meshlet_build_t build;
+	build.obj = obj;
+	build.max_vertices = (limits && limits->max_vertices) ? limits->max_vertices : OBJ_MESHLET_MAX_VERTICES;
+	build.max_triangles = (limits && limits->max_triangles) ? limits->max_triangles : OBJ_MESHLET_MAX_TRIANGLES;
+	// Local triangle indices are bytes, and any triangle must fit in an empty meshlet
+	if (build.max_vertices > 256)
+		build.max_vertices = 256;
+	if (build.max_vertices < 3)
+		build.max_vertices = 3;
+	build.subgroup = 0;
+
+	for (size_t igroup = 0, gsize = array_size(obj->group); igroup < gsize; ++igroup) {
+		obj_group_t* group = obj->group[igroup];
+		for (size_t isub = 0, sgsize = array_size(group->subgroup); isub < sgsize; ++isub) {
+			if (!group->subgroup[isub]->triangle.count)
+				continue;
+			meshlet_subgroup_t task = {(unsigned int)igroup, (unsigned int)isub, 0, 0, 0};
+			array_push(build.subgroup, task);
+		}
+	}
+
+	size_t task_count = array_size(build.subgroup);
+	obj_parallel_for(task_count, meshlet_build_subgroup, &build);
+
+	for (size_t itask = 0; itask < task_count; ++itask) {
+		meshlet_subgroup_t* task = build.subgroup + itask;
+		unsigned int vertex_base = (unsigned int)array_size(meshlets->vertex);
+		unsigned int triangle_base = (unsigned int)array_size(meshlets->triangle);
+		for (size_t imeshlet = 0, msize = array_size(task->meshlet); imeshlet < msize; ++imeshlet) {
+			obj_meshlet_t meshlet = task->meshlet[imeshlet];
+			meshlet.vertex_offset += vertex_base;
+			meshlet.triangle_offset += triangle_base;
+			array_push(meshlets->meshlet, meshlet);
+		}
+		for (size_t ivert = 0, vsize = array_size(task->vertex); ivert < vsize; ++ivert)
+			array_push(meshlets->vertex, task->vertex[ivert]);
+		for (size_t iindex = 0, isize = array_size(task->triangle); iindex < isize; ++iindex)
+			array_push(meshlets->triangle, task->triangle[iindex]);
+		array_deallocate(task->meshlet);
+		array_deallocate(task->vertex);
+		array_deallocate(task->triangle);
+	}
+	array_deallocate(build.subgroup);
+
+	return true;
+}
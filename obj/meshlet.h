@@ -0,0 +1,51 @@
+/* meshlet.h   -  OBJ library  -  Public Domain  -  2019 Mattias Jansson
+ *
+ * This library provides a cross-platform OBJ I/O library in C11 providing
+ * OBJ ascii reading and writing functionality.
+ *
+ * The latest source code maintained by Mattias Jansson is always available at
+ *
+ * https://github.com/mjansson/obj_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without any
+ * restrictions.
+ *
+ */
+
+#pragma once
+
+/*! \file meshlet.h
+    Meshlet generation */
+
+#include <obj/types.h>
+#include <obj/hashstrings.h>
+
+//! Default maximum number of unique corners per meshlet
+#define OBJ_MESHLET_MAX_VERTICES 64
+
+//! Default maximum number of triangles per meshlet
+#define OBJ_MESHLET_MAX_TRIANGLES 124
+
+/*! Initialize meshlet storage
+\param meshlets Meshlet storage */
+OBJ_API void
+obj_meshlets_initialize(obj_meshlets_t* meshlets);
+
+/*! Finalize meshlet storage, releasing all memory
+\param meshlets Meshlet storage */
+OBJ_API void
+obj_meshlets_finalize(obj_meshlets_t* meshlets);
+
+/*! Split the triangles of all subgroups into meshlets, small clusters of spatially coherent
+triangles with a bounded number of unique corners, for use with mesh shaders and cluster
+culling. Each meshlet gets a bounding sphere and a normal cone. Meshlets are built greedily
+by growing each meshlet with the connected triangle adding the fewest new corners, closest
+to the meshlet center, restarting at the nearest unassigned triangle when no connected
+triangle fits. Subgroups are processed in parallel. Subgroups must be triangulated by
+obj_triangulate. Any existing meshlets in the output are discarded.
+\param obj OBJ data structure
+\param limits Meshlet size limits, null for defaults
+\param meshlets Meshlet storage receiving meshlets in group and subgroup order
+\return true if success, false if error */
+OBJ_API bool
+obj_build_meshlets(const obj_t* obj, const obj_meshlet_limits_t* limits, obj_meshlets_t* meshlets);
@@ -0,0 +1,432 @@
+/* normal.c    -  OBJ library  -  Public Domain  -  2019 Mattias Jansson
+ *
+ * This library provides a cross-platform OBJ I/O library in C11 providing
+ * OBJ ascii reading and writing functionality.
+ *
+ * The latest source code maintained by Mattias Jansson is always available at
+ *
+ * https://github.com/mjansson/obj_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without any
+ * restrictions.
+ *
+ */
+
+#include "normal.h"
+#include "internal.h"
+
+#include <foundation/array.h>
+#include <foundation/bucketarray.h>
+#include <foundation/math.h>
+
+//! Number of faces or normals processed by each parallel task
+#define NORMAL_BLOCK_SIZE 4096
+
+typedef struct normal_key_t {
+	//! Vertex index in high bits and smoothing group in low bits, or face number for flat faces
+	uint64_t key;
+	//! Face corner number
+	size_t face_corner;
+} normal_key_t;
+
+typedef struct normal_subgroup_t {
+	obj_subgroup_t* subgroup;
+	//! Face corner number of first subgroup index
+	size_t face_corner_base;
+	//! Face number of first subgroup face
+	size_t face_base;
+} normal_subgroup_t;
+
+typedef struct normal_block_t {
+	unsigned int subgroup;
+	size_t face_begin;
+	size_t face_end;
+} normal_block_t;
+
+typedef struct normal_build_t {
+	obj_t* obj;
+	unsigned int mode;
+	normal_subgroup_t* subgroup;
+	normal_block_t* block;
+	//! Weighted face normal of each face corner, one array per axis
+	real* weighted[3];
+	//! Flag for each face corner that gets a generated normal
+	uint8_t* generate;
+	//! Smoothing key of each face corner, sorted to gather face corners sharing a normal
+	normal_key_t* key;
+	//! Offset of first key of each normal in key array, followed by key count
+	size_t* slot;
+	//! Normal index plus one of each slot, 0 if no face corner of slot gets a generated normal
+	unsigned int* slot_normal;
+	//! Normal index plus one assigned to each face corner, 0 to keep existing normal
+	unsigned int* face_corner_normal;
+} normal_build_t;
+
+static int
+normal_key_compare(const void* lhs, const void* rhs) {
+	const normal_key_t* lhs_key = lhs;
+	const normal_key_t* rhs_key = rhs;
+	if (lhs_key->key != rhs_key->key)
+		return (lhs_key->key < rhs_key->key) ? -1 : 1;
+	return (lhs_key->face_corner < rhs_key->face_corner) ? -1 : ((lhs_key->face_corner > rhs_key->face_corner) ? 1 : 0);
+}
+
+//! Compute weighted face normals and smoothing keys for a block of faces
+static void
+normal_face_block(void* context, size_t index) {
+	const normal_build_t* build = context;
+	const normal_block_t* block = build->block + index;
+	const normal_subgroup_t* normal_subgroup = build->subgroup + block->subgroup;
+	const obj_subgroup_t* subgroup = normal_subgroup->subgroup;
+	const obj_t* obj = build->obj;
+	unsigned int weight_mode = build->mode & OBJ_NORMAL_WEIGHT_MASK;
+	bool replace = (build->mode & OBJ_NORMAL_REPLACE);
+
+	real* FOUNDATION_RESTRICT weighted_x = build->weighted[0];
+	real* FOUNDATION_RESTRICT weighted_y = build->weighted[1];
+	real* FOUNDATION_RESTRICT weighted_z = build->weighted[2];
+
+	real* position = nullptr;
+	for (size_t iface = block->face_begin; iface < block->face_end; ++iface) {
+		const obj_face_t* face = bucketarray_get(&subgroup->face, iface);
+		unsigned int corner_count = face->count;
+		size_t face_corner = normal_subgroup->face_corner_base + face->offset;
+
+		// Gather positions, then Newell normal of polygon, its length is twice the polygon area
+		array_clear(position);
+		array_resize(position, corner_count * 3);
+		real* FOUNDATION_RESTRICT px = position;
+		real* FOUNDATION_RESTRICT py = position + corner_count;
+		real* FOUNDATION_RESTRICT pz = position + (corner_count * 2);
+		for (unsigned int icorner = 0; icorner < corner_count; ++icorner) {
+			unsigned int corner_index = *bucketarray_get_as(unsigned int, &subgroup->index, face->offset + icorner);
+			const obj_corner_t* corner = bucketarray_get(&subgroup->corner, corner_index);
+			const obj_vertex_t* vertex = bucketarray_get(&obj->vertex, corner->vertex - 1);
+			px[icorner] = vertex->x;
+			py[icorner] = vertex->y;
+			pz[icorner] = vertex->z;
+
+			normal_key_t* key = build->key + face_corner + icorner;
+			key->key = face->smoothing ? (((uint64_t)corner->vertex << 32) | face->smoothing) :
+			                             (uint64_t)(normal_subgroup->face_base + iface);
+			key->face_corner = face_corner + icorner;
+			build->generate[face_corner + icorner] = (replace || !corner->normal) ? 1 : 0;
+		}
+
+		real normal[3] = {0, 0, 0};
+		for (unsigned int icorner = 0; icorner < corner_count; ++icorner) {
+			unsigned int inext = (icorner + 1 < corner_count) ? icorner + 1 : 0;
+			normal[0] += (py[icorner] - py[inext]) * (pz[icorner] + pz[inext]);
+			normal[1] += (pz[icorner] - pz[inext]) * (px[icorner] + px[inext]);
+			normal[2] += (px[icorner] - px[inext]) * (py[icorner] + py[inext]);
+		}
+		real length = math_sqrt((normal[0] * normal[0]) + (normal[1] * normal[1]) + (normal[2] * normal[2]));
+		if (weight_mode == OBJ_NORMAL_WEIGHT_ANGLE) {
+			real scale = (length > 0) ? (REAL_C(1.0) / length) : 0;
+			normal[0] *= scale;
+			normal[1] *= scale;
+			normal[2] *= scale;
+		}
+
+		if (weight_mode == OBJ_NORMAL_WEIGHT_AREA) {
+			for (unsigned int icorner = 0; icorner < corner_count; ++icorner) {
+				weighted_x[face_corner + icorner] = normal[0];
+				weighted_y[face_corner + icorner] = normal[1];
+				weighted_z[face_corner + icorner] = normal[2];
+			}
+			continue;
+		}
+
+		// Scale by the angle between the edges of each corner
+		for (unsigned int icorner = 0; icorner < corner_count; ++icorner) {
+			unsigned int iprev = icorner ? icorner - 1 : corner_count - 1;
+			unsigned int inext = (icorner + 1 < corner_count) ? icorner + 1 : 0;
+			real e0[3] = {px[iprev] - px[icorner], py[iprev] - py[icorner], pz[iprev] - pz[icorner]};
+			real e1[3] = {px[inext] - px[icorner], py[inext] - py[icorner], pz[inext] - pz[icorner]};
+			real lengths = math_sqrt(((e0[0] * e0[0]) + (e0[1] * e0[1]) + (e0[2] * e0[2])) *
+			                         ((e1[0] * e1[0]) + (e1[1] * e1[1]) + (e1[2] * e1[2])));
+			real angle = 0;
+			if (lengths > 0) {
+				real cosine = ((e0[0] * e1[0]) + (e0[1] * e1[1]) + (e0[2] * e1[2])) / lengths;
+				if (cosine > 1)
+					cosine = 1;
+				else if (cosine < -1)
+					cosine = -1;
+				angle = math_acos(cosine);
+			}
+			weighted_x[face_corner + icorner] = normal[0] * angle;
+			weighted_y[face_corner + icorner] = normal[1] * angle;
+			weighted_z[face_corner + icorner] = normal[2] * angle;
+		}
+	}
+	array_deallocate(position);
+}
+
+//! Sum weighted normals of a block of slots, each slot is owned by a single task
+static void
+normal_slot_block(void* context, size_t index) {
+	const normal_build_t* build = context;
+	obj_t* obj = build->obj;
+	size_t slot_count = array_size(build->slot) - 1;
+	size_t slot_end = (index + 1) * NORMAL_BLOCK_SIZE;
+	if (slot_end > slot_count)
+		slot_end = slot_count;
+	for (size_t islot = index * NORMAL_BLOCK_SIZE; islot < slot_end; ++islot) {
+		unsigned int normal_index = build->slot_normal[islot];
+		if (!normal_index)
+			continue;
+		real normal[3] = {0, 0, 0};
+		for (size_t ikey = build->slot[islot], kend = build->slot[islot + 1]; ikey < kend; ++ikey) {
+			size_t face_corner = build->key[ikey].face_corner;
+			normal[0] += build->weighted[0][face_corner];
+			normal[1] += build->weighted[1][face_corner];
+			normal[2] += build->weighted[2][face_corner];
+			if (build->generate[face_corner])
+				build->face_corner_normal[face_corner] = normal_index;
+		}
+		real length = math_sqrt((normal[0] * normal[0]) + (normal[1] * normal[1]) + (normal[2] * normal[2]));
+		obj_normal_t* output = bucketarray_get(&obj->normal, normal_index - 1);
+		if (length > 0) {
+			output->nx = normal[0] / length;
+			output->ny = normal[1] / length;
+			output->nz = normal[2] / length;
+		} else {
+			// Degenerate faces only, any unit vector will do
+			output->nx = 0;
+			output->ny = 0;
+			output->nz = 1;
+		}
+	}
+}
+
+/*! Remap triangle corners that were split to the corner assigned to the face the triangle lies in, matching
+each triangle to the face sharing the most of its original corners. Existing triangles are kept as is, so
+changes made after triangulation are preserved
+\param subgroup Subgroup
+\param original Corner index of each face corner before splitting
+\param corner_count Number of corners before splitting */
+static void
+normal_remap_triangles(obj_subgroup_t* subgroup, const unsigned int* original, size_t corner_count) {
+	size_t index_count = subgroup->index.count;
+	unsigned int* offset = memory_allocate(HASH_OBJ, sizeof(unsigned int) * (corner_count + 1), 0,
+	                                       MEMORY_PERSISTENT | MEMORY_ZERO_INITIALIZED);
+	unsigned int* use = memory_allocate(HASH_OBJ, sizeof(unsigned int) * index_count, 0, MEMORY_PERSISTENT);
+	unsigned int* use_face = memory_allocate(HASH_OBJ, sizeof(unsigned int) * index_count, 0, MEMORY_PERSISTENT);
+
+	// Group face corners by original corner
+	for (size_t iindex = 0; iindex < index_count; ++iindex)
+		++offset[original[iindex] + 1];
+	for (size_t icorner = 0; icorner < corner_count; ++icorner)
+		offset[icorner + 1] += offset[icorner];
+	for (size_t iindex = 0; iindex < index_count; ++iindex)
+		use[offset[original[iindex]]++] = (unsigned int)iindex;
+	memmove(offset + 1, offset, sizeof(unsigned int) * corner_count);
+	offset[0] = 0;
+
+	for (size_t iface = 0, fsize = subgroup->face.count; iface < fsize; ++iface) {
+		const obj_face_t* face = bucketarray_get(&subgroup->face, iface);
+		for (unsigned int icorner = 0; icorner < face->count; ++icorner)
+			use_face[face->offset + icorner] = (unsigned int)iface;
+	}
+
+	for (size_t itri = 0, tsize = subgroup->triangle.count; itri < tsize; ++itri) {
+		obj_triangle_t* triangle = bucketarray_get(&subgroup->triangle, itri);
+		unsigned int remap[3];
+		for (unsigned int icorner = 0; icorner < 3; ++icorner) {
+			unsigned int corner = triangle->index[icorner];
+			remap[icorner] = corner;
+			if ((corner >= corner_count) || (offset[corner] == offset[corner + 1]))
+				continue;
+
+			// Corners that were not split are used by a single corner after assignment
+			unsigned int first = *bucketarray_get_as(unsigned int, &subgroup->index, use[offset[corner]]);
+			remap[icorner] = first;
+			bool single = true;
+			for (unsigned int iuse = offset[corner] + 1, uend = offset[corner + 1]; single && (iuse < uend); ++iuse)
+				single = (*bucketarray_get_as(unsigned int, &subgroup->index, use[iuse]) == first);
+			if (single)
+				continue;
+
+			unsigned int best_match = 0;
+			for (unsigned int iuse = offset[corner], uend = offset[corner + 1]; iuse < uend; ++iuse) {
+				const obj_face_t* face = bucketarray_get(&subgroup->face, use_face[use[iuse]]);
+				unsigned int match = 1;
+				for (unsigned int iface_corner = 0; iface_corner < face->count; ++iface_corner) {
+					unsigned int face_corner = original[face->offset + iface_corner];
+					if ((face_corner == triangle->index[(icorner + 1) % 3]) ||
+					    (face_corner == triangle->index[(icorner + 2) % 3]))
+						++match;
+				}
+				if (match > best_match) {
+					best_match = match;
+					remap[icorner] = *bucketarray_get_as(unsigned int, &subgroup->index, use[iuse]);
+					if (match == 3)
+						break;
+				}
+			}
+		}
+		triangle->index[0] = remap[0];
+		triangle->index[1] = remap[1];
+		triangle->index[2] = remap[2];
+	}
+
+	memory_deallocate(use_face);
+	memory_deallocate(use);
+	memory_deallocate(offset);
+}
+
+//! Assign generated normals to subgroup corners, splitting corners used by face corners with different normals
+static void
+normal_assign_subgroup(void* context, size_t index) {
+	const normal_build_t* build = context;
+	const normal_subgroup_t* normal_subgroup = build->subgroup + index;
+	obj_subgroup_t* subgroup = normal_subgroup->subgroup;
+
+	size_t corner_count = subgroup->corner.count;
+	uint8_t* assigned = nullptr;
+	array_resize(assigned, corner_count);
+	memset(assigned, 0, corner_count);
+
+	// Triangles reference corners, keep the face corners' original corners to remap triangles after splitting
+	unsigned int* original = nullptr;
+	if (subgroup->triangle.count) {
+		original =
+		    memory_allocate(HASH_OBJ, sizeof(unsigned int) * subgroup->index.count, 0, MEMORY_PERSISTENT);
+		for (size_t iindex = 0, isize = subgroup->index.count; iindex < isize; ++iindex)
+			original[iindex] = *bucketarray_get_as(unsigned int, &subgroup->index, iindex);
+	}
+
+	bool split = false;
+	for (size_t iindex = 0, isize = subgroup->index.count; iindex < isize; ++iindex) {
+		unsigned int normal = build->face_corner_normal[normal_subgroup->face_corner_base + iindex];
+		if (!normal)
+			continue;
+		unsigned int* index_value = bucketarray_get(&subgroup->index, iindex);
+		obj_corner_t* corner = bucketarray_get(&subgroup->corner, *index_value);
+		if (!assigned[*index_value]) {
+			corner->normal = normal;
+			assigned[*index_value] = 1;
+			continue;
+		}
+		if (corner->normal == normal)
+			continue;
+
+		// Generated normals are unique, any corner in the chain with the normal was assigned for the same UV
+		unsigned int uv = corner->uv;
+		unsigned int vertex = corner->vertex;
+		size_t corner_index = *index_value;
+		size_t last_corner_index = corner_index;
+		while (corner_index < subgroup->corner.count) {
+			corner = bucketarray_get(&subgroup->corner, corner_index);
+			if ((corner->normal == normal) && (corner->uv == uv))
+				break;
+			last_corner_index = corner_index;
+			corner_index = (size_t)corner->next;
+		}
+		if (corner_index >= subgroup->corner.count) {
+			obj_corner_t new_corner = {vertex, normal, uv, 0, -1};
+			corner_index = subgroup->corner.count;
+			obj_bucketarray_push(&subgroup->corner, &new_corner);
+			bucketarray_get_as(obj_corner_t, &subgroup->corner, last_corner_index)->next = (int)corner_index;
+			array_push(assigned, 1);
+			split = true;
+		}
+		*index_value = (unsigned int)corner_index;
+	}
+	array_deallocate(assigned);
+
+	if (split && original)
+		normal_remap_triangles(subgroup, original, corner_count);
+	if (original)
+		memory_deallocate(original);
+}
+
+bool
+obj_generate_normals(obj_t* obj, unsigned int mode) {
+	if (!obj)
+		return false;
+
+	normal_build_t build;
+	memset(&build, 0, sizeof(build));
+	build.obj = obj;
+	build.mode = mode;
+
+	size_t face_corner_count = 0;
+	size_t face_count = 0;
+	for (size_t igroup = 0, gsize = array_size(obj->group); igroup < gsize; ++igroup) {
+		obj_group_t* group = obj->group[igroup];
+		for (size_t isub = 0, sgsize = array_size(group->subgroup); isub < sgsize; ++isub) {
+			obj_subgroup_t* subgroup = group->subgroup[isub];
+			if (!subgroup->face.count)
+				continue;
+			normal_subgroup_t normal_subgroup = {subgroup, face_corner_count, face_count};
+			unsigned int subgroup_index = array_size(build.subgroup);
+			array_push(build.subgroup, normal_subgroup);
+			for (size_t iface = 0; iface < subgroup->face.count; iface += NORMAL_BLOCK_SIZE) {
+				size_t face_end = iface + NORMAL_BLOCK_SIZE;
+				normal_block_t block = {subgroup_index, iface,
+				                        (face_end < subgroup->face.count) ? face_end : subgroup->face.count};
+				array_push(build.block, block);
+			}
+			face_corner_count += subgroup->index.count;
+			face_count += subgroup->face.count;
+		}
+	}
+	if (!face_corner_count) {
+		array_deallocate(build.block);
+		array_deallocate(build.subgroup);
+		return true;
+	}
+
+	for (unsigned int iaxis = 0; iaxis < 3; ++iaxis)
+		build.weighted[iaxis] = memory_allocate(HASH_OBJ, sizeof(real) * face_corner_count, 0, MEMORY_PERSISTENT);
+	build.generate = memory_allocate(HASH_OBJ, face_corner_count, 0, MEMORY_PERSISTENT);
+	build.key = memory_allocate(HASH_OBJ, sizeof(normal_key_t) * face_corner_count, 0, MEMORY_PERSISTENT);
+	build.face_corner_normal = memory_allocate(HASH_OBJ, sizeof(unsigned int) * face_corner_count, 0,
+	                                           MEMORY_PERSISTENT | MEMORY_ZERO_INITIALIZED);
+
+	obj_parallel_for(array_size(build.block), normal_face_block, &build);
+
+	// Face corners sharing a vertex and smoothing group, or a flat face, are adjacent after sorting
+	qsort(build.key, face_corner_count, sizeof(normal_key_t), normal_key_compare);
+
+	size_t normal_count = obj->normal.count;
+	bool generate = false;
+	for (size_t ikey = 0; ikey < face_corner_count; ++ikey) {
+		if (!ikey || (build.key[ikey].key != build.key[ikey - 1].key)) {
+			if (generate)
+				array_push(build.slot_normal, (unsigned int)++normal_count);
+			else if (ikey)
+				array_push(build.slot_normal, 0);
+			array_push(build.slot, ikey);
+			generate = false;
+		}
+		if (build.generate[build.key[ikey].face_corner])
+			generate = true;
+	}
+	if (generate)
+		array_push(build.slot_normal, (unsigned int)++normal_count);
+	else
+		array_push(build.slot_normal, 0);
+	array_push(build.slot, face_corner_count);
+
+	if (!obj->normal.bucket_count)
+		bucketarray_reserve(&obj->normal, normal_count);
+	bucketarray_resize(&obj->normal, normal_count);
+
+	size_t slot_count = array_size(build.slot_normal);
+	obj_parallel_for((slot_count + NORMAL_BLOCK_SIZE - 1) / NORMAL_BLOCK_SIZE, normal_slot_block, &build);
+	obj_parallel_for(array_size(build.subgroup), normal_assign_subgroup, &build);
+
+	memory_deallocate(build.face_corner_normal);
+	memory_deallocate(build.key);
+	memory_deallocate(build.generate);
+	for (unsigned int iaxis = 0; iaxis < 3; ++iaxis)
+		memory_deallocate(build.weighted[iaxis]);
+	array_deallocate(build.slot_normal);
+	array_deallocate(build.slot);
+	array_deallocate(build.block);
+	array_deallocate(build.subgroup);
+
+	return true;
+}
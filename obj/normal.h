@@ -0,0 +1,34 @@
+/* normal.h    -  OBJ library  -  Public Domain  -  2019 Mattias Jansson
+ *
+ * This library provides a cross-platform OBJ I/O library in C11 providing
+ * OBJ ascii reading and writing functionality.
+ *
+ * The latest source code maintained by Mattias Jansson is always available at
+ *
+ * https://github.com/mjansson/obj_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without any
+ * restrictions.
+ *
+ */
+
+#pragma once
+
+/*! \file normal.h
+    Normal generation */
+
+#include <obj/types.h>
+#include <obj/hashstrings.h>
+
+/*! Generate vertex normals from face normals, averaging the weighted normals of faces in the
+same smoothing group sharing a vertex, across all groups and subgroups. Faces with smoothing
+off get flat face normals. Generated normals are added to the normal array, and corners used
+by faces needing different normals are split. Face normals are computed in parallel over
+faces, and the weighted normals of each vertex and smoothing group are gathered in parallel
+without locks. Existing triangles are kept and their split corners remapped to the corner of
+the face each triangle lies in, so triangle order and simplification are preserved.
+\param obj OBJ data structure
+\param mode Generation mode, combination of obj_normal_mode_t values
+\return true if success, false if error */
+OBJ_API bool
+obj_generate_normals(obj_t* obj, unsigned int mode);
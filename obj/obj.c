@@ -13,11 +13,18 @@
  */
 
 #include "obj.h"
+#include "internal.h"
 
 #include <foundation/array.h>
 #include <foundation/stream.h>
 #include <foundation/path.h>
 #include <foundation/bucketarray.h>
+#include <foundation/hashmap.h>
+#include <foundation/hash.h>
+#include <foundation/thread.h>
+#include <foundation/atomic.h>
+#include <foundation/system.h>
+#include <foundation/log.h>
 
 static unsigned int INVALID_INDEX = 0xFFFFFFFF;
 
@@ -26,6 +33,7 @@ static obj_config_t _obj_config;
 int
 obj_module_initialize(obj_config_t config) {
 	_obj_config = config;
+	obj_inflate_initialize();
 	return 0;
 }
 
@@ -54,44 +62,212 @@ obj_initialize(obj_t* obj) {
 	memset(obj, 0, sizeof(obj_t));
 }
 
+#define OBJ_STRING_BLOCK_SIZE 65536
+
 static void
-obj_finalize_groups(obj_t* obj) {
-	for (unsigned int igroup = 0, gsize = array_size(obj->group); igroup < gsize; ++igroup) {
+obj_string_pool_clear(obj_string_pool_t* pool) {
+	for (size_t iblock = 0, bsize = array_size(pool->block); iblock < bsize; ++iblock)
+		memory_deallocate(pool->block[iblock]);
+	array_clear(pool->block);
+	array_clear(pool->string);
+	if (pool->map)
+		hashmap_clear(pool->map);
+	pool->current = nullptr;
+	pool->current_used = 0;
+}
+
+static void
+obj_string_pool_finalize(obj_string_pool_t* pool) {
+	obj_string_pool_clear(pool);
+	array_deallocate(pool->block);
+	array_deallocate(pool->string);
+	hashmap_deallocate(pool->map);
+	memset(pool, 0, sizeof(obj_string_pool_t));
+}
+
+static unsigned int
+obj_string_pool_lookup(const obj_string_pool_t* pool, hash_t key, const char* str, size_t length) {
+	if (!pool->map)
+		return INVALID_INDEX;
+	uintptr_t stored = (uintptr_t)hashmap_lookup(pool->map, key);
+	if (!stored)
+		return INVALID_INDEX;
+	unsigned int index = (unsigned int)(stored - 1);
+	if (string_equal(STRING_ARGS(pool->string[index]), str, length))
+		return index;
+	// Hash collision, fall back to searching all strings
+	for (unsigned int istr = 0, ssize = array_size(pool->string); istr < ssize; ++istr) {
+		if (string_equal(STRING_ARGS(pool->string[istr]), str, length))
+			return istr;
+	}
+	return INVALID_INDEX;
+}
+
+string_const_t
+obj_string_intern(obj_t* obj, const char* str, size_t length) {
+	obj_string_pool_t* pool = &obj->string_pool;
+	hash_t key = hash(str, length);
+	unsigned int index = obj_string_pool_lookup(pool, key, str, length);
+	if (index != INVALID_INDEX)
+		return pool->string[index];
+
+	char* storage;
+	if ((length + 1) > (OBJ_STRING_BLOCK_SIZE / 4)) {
+		storage = memory_allocate(HASH_OBJ, length + 1, 0, MEMORY_PERSISTENT);
+		array_push(pool->block, storage);
+	} else {
+		if (!pool->current || ((pool->current_used + length + 1) > OBJ_STRING_BLOCK_SIZE)) {
+			pool->current = memory_allocate(HASH_OBJ, OBJ_STRING_BLOCK_SIZE, 0, MEMORY_PERSISTENT);
+			pool->current_used = 0;
+			array_push(pool->block, pool->current);
+		}
+		storage = pool->current + pool->current_used;
+		pool->current_used += length + 1;
+	}
+	if (length)
+		memcpy(storage, str, length);
+	storage[length] = 0;
+
+	string_const_t interned = string_const(storage, length);
+	array_push(pool->string, interned);
+	if (!pool->map)
+		pool->map = hashmap_allocate(1021, 8);
+	if (!hashmap_has_key(pool->map, key))
+		hashmap_insert(pool->map, key, (void*)(uintptr_t)array_size(pool->string));
+	return interned;
+}
+
+string_const_t
+obj_string_find(const obj_t* obj, const char* str, size_t length) {
+	const obj_string_pool_t* pool = &obj->string_pool;
+	unsigned int index = obj_string_pool_lookup(pool, hash(str, length), str, length);
+	if (index != INVALID_INDEX)
+		return pool->string[index];
+	return string_const(0, 0);
+}
+
+size_t
+obj_bucket_size(size_t count, size_t bucket_count) {
+	size_t bucket_size = OBJ_BUCKET_SIZE_MIN;
+	while ((bucket_size < OBJ_BUCKET_SIZE_MAX) && ((bucket_size * bucket_count) < count))
+		bucket_size <<= 1;
+	return bucket_size;
+}
+
+void
+obj_bucketarray_rebucket(bucketarray_t* array, size_t bucket_size) {
+	bucketarray_t rebucketed;
+	bucketarray_initialize(&rebucketed, array->element_size, bucket_size);
+	bucketarray_resize(&rebucketed, array->count);
+	size_t offset = 0;
+	while (offset < array->count) {
+		size_t source_left = array->bucket_size - (offset & array->bucket_mask);
+		size_t dest_left = rebucketed.bucket_size - (offset & rebucketed.bucket_mask);
+		size_t copy = (source_left < dest_left) ? source_left : dest_left;
+		if (copy > (array->count - offset))
+			copy = array->count - offset;
+		memcpy(bucketarray_get(&rebucketed, offset), bucketarray_get(array, offset), copy * array->element_size);
+		offset += copy;
+	}
+	bucketarray_finalize(array);
+	*array = rebucketed;
+}
+
+void
+obj_bucketarray_shrink(bucketarray_t* array) {
+	size_t bucket_size = obj_bucket_size(array->count, 16);
+	size_t bucket_count = (array->count + bucket_size - 1) / bucket_size;
+	if ((bucket_size != array->bucket_size) || (bucket_count < array->bucket_count))
+		obj_bucketarray_rebucket(array, bucket_size);
+}
+
+void
+obj_shrink_to_fit(obj_t* obj) {
+	for (size_t igroup = 0, gsize = array_size(obj->group); igroup < gsize; ++igroup) {
 		obj_group_t* group = obj->group[igroup];
-		for (unsigned int isub = 0, sgsize = array_size(group->subgroup); isub < sgsize; ++isub) {
+		for (size_t isub = 0, sgsize = array_size(group->subgroup); isub < sgsize; ++isub) {
 			obj_subgroup_t* subgroup = group->subgroup[isub];
-			bucketarray_finalize(&subgroup->triangle);
-			bucketarray_finalize(&subgroup->index);
-			bucketarray_finalize(&subgroup->face);
-			bucketarray_finalize(&subgroup->corner);
-			memory_deallocate(subgroup);
+			obj_bucketarray_shrink(&subgroup->corner);
+			obj_bucketarray_shrink(&subgroup->index);
+			obj_bucketarray_shrink(&subgroup->face);
+			obj_bucketarray_shrink(&subgroup->triangle);
 		}
-		array_deallocate(group->subgroup);
-		string_deallocate(group->name.str);
-		memory_deallocate(group);
 	}
-
-	array_clear(obj->group);
 }
 
+typedef struct obj_parallel_t {
+	obj_parallel_fn fn;
+	void* context;
+	size_t count;
+	atomic32_t next;
+} obj_parallel_t;
+
 static void
-obj_finalize_material(obj_material_t* material) {
-	string_deallocate(material->name.str);
-	string_deallocate(material->ambient_texture.str);
-	string_deallocate(material->diffuse_texture.str);
-	string_deallocate(material->specular_texture.str);
-	string_deallocate(material->emissive_texture.str);
-	string_deallocate(material->dissolve_texture.str);
-	string_deallocate(material->shininess_texture.str);
-	string_deallocate(material->bump_texture.str);
+obj_parallel_run(obj_parallel_t* parallel) {
+	while (true) {
+		size_t index = (size_t)(atomic_incr32(&parallel->next, memory_order_relaxed) - 1);
+		if (index >= parallel->count)
+			break;
+		parallel->fn(parallel->context, index);
+	}
+}
+
+static void*
+obj_parallel_thread(void* arg) {
+	obj_parallel_run(arg);
+	return 0;
+}
+
+void
+obj_parallel_for(size_t count, obj_parallel_fn fn, void* context) {
+	obj_parallel_t parallel;
+	parallel.fn = fn;
+	parallel.context = context;
+	parallel.count = count;
+	atomic_store32(&parallel.next, 0, memory_order_release);
+
+	size_t thread_count = system_hardware_threads();
+	if (thread_count > count)
+		thread_count = count;
+	if (thread_count > OBJ_PARALLEL_THREADS_MAX)
+		thread_count = OBJ_PARALLEL_THREADS_MAX;
+
+	// Calling thread is one of the workers
+	thread_t thread[OBJ_PARALLEL_THREADS_MAX];
+	for (size_t ithread = 1; ithread < thread_count; ++ithread) {
+		thread_initialize(&thread[ithread], obj_parallel_thread, &parallel, STRING_CONST("obj_parallel"),
+		                  THREAD_PRIORITY_NORMAL, 0);
+		thread_start(&thread[ithread]);
+	}
+	obj_parallel_run(&parallel);
+	for (size_t ithread = 1; ithread < thread_count; ++ithread) {
+		thread_join(&thread[ithread]);
+		thread_finalize(&thread[ithread]);
+	}
+}
+
+void
+obj_subgroup_deallocate(obj_subgroup_t* subgroup) {
+	bucketarray_finalize(&subgroup->triangle);
+	bucketarray_finalize(&subgroup->index);
+	bucketarray_finalize(&subgroup->face);
+	bucketarray_finalize(&subgroup->corner);
+	memory_deallocate(subgroup);
 }
 
 static void
-obj_finalize_materials(obj_t* obj) {
-	for (unsigned int imat = 0, msize = array_size(obj->material); imat < msize; ++imat)
-		obj_finalize_material(obj->material + imat);
+obj_finalize_groups(obj_t* obj) {
+	for (unsigned int igroup = 0, gsize = array_size(obj->group); igroup < gsize; ++igroup) {
+		obj_group_t* group = obj->group[igroup];
+		for (unsigned int isub = 0, sgsize = array_size(group->subgroup); isub < sgsize; ++isub)
+			obj_subgroup_deallocate(group->subgroup[isub]);
+		array_deallocate(group->subgroup);
+		memory_deallocate(group);
+	}
 
-	array_clear(obj->material);
+	array_clear(obj->group);
+	if (obj->group_map)
+		hashmap_clear(obj->group_map);
 }
 
 void
@@ -100,13 +276,15 @@ obj_finalize(obj_t* obj) {
 		return;
 
 	obj_finalize_groups(obj);
-	obj_finalize_materials(obj);
 
 	array_deallocate(obj->group);
 	array_deallocate(obj->material);
+	hashmap_deallocate(obj->group_map);
+	obj_string_pool_finalize(&obj->string_pool);
 	bucketarray_finalize(&obj->vertex);
 	bucketarray_finalize(&obj->normal);
 	bucketarray_finalize(&obj->uv);
+	bucketarray_finalize(&obj->tangent);
 
 	string_deallocate(obj->base_path.str);
 }
@@ -254,11 +432,10 @@ load_material_lib(obj_t* obj, const char* filename, size_t length) {
 			if (string_equal(STRING_ARGS(command), STRING_CONST("newmtl"))) {
 				if (material_valid)
 					array_push(obj->material, material);
-				else
-					obj_finalize_material(&material);
 				material = material_default();
-				material.name = (tokens_count && tokens[0].length) ? string_clone(STRING_ARGS(tokens[0])) :
-				                                                     string_clone(STRING_CONST("__unnamed"));
+				string_const_t name =
+				    (tokens_count && tokens[0].length) ? tokens[0] : string_const(STRING_CONST("__unnamed"));
+				material.name = obj_string_intern(obj, STRING_ARGS(name));
 				material_valid = true;
 			} else if (string_equal(STRING_ARGS(command), STRING_CONST("d")) && tokens_count) {
 				material.dissolve_factor = string_to_real(STRING_ARGS(tokens[0]));
@@ -278,19 +455,19 @@ load_material_lib(obj_t* obj, const char* filename, size_t length) {
 				material.transmission_filter = parse_color(tokens, tokens_count);
 			} else if (tokens_count && (command.str[0] == 'm')) {
 				if (string_equal(STRING_ARGS(command), STRING_CONST("map_Ka"))) {
-					material.ambient_texture = string_clone(STRING_ARGS(tokens[0]));
+					material.ambient_texture = obj_string_intern(obj, STRING_ARGS(tokens[0]));
 				} else if (string_equal(STRING_ARGS(command), STRING_CONST("map_Kd"))) {
-					material.diffuse_texture = string_clone(STRING_ARGS(tokens[0]));
+					material.diffuse_texture = obj_string_intern(obj, STRING_ARGS(tokens[0]));
 				} else if (string_equal(STRING_ARGS(command), STRING_CONST("map_Ks"))) {
-					material.specular_texture = string_clone(STRING_ARGS(tokens[0]));
+					material.specular_texture = obj_string_intern(obj, STRING_ARGS(tokens[0]));
 				} else if (string_equal(STRING_ARGS(command), STRING_CONST("map_Ke"))) {
-					material.emissive_texture = string_clone(STRING_ARGS(tokens[0]));
+					material.emissive_texture = obj_string_intern(obj, STRING_ARGS(tokens[0]));
 				} else if (string_equal(STRING_ARGS(command), STRING_CONST("map_d"))) {
-					material.dissolve_texture = string_clone(STRING_ARGS(tokens[0]));
+					material.dissolve_texture = obj_string_intern(obj, STRING_ARGS(tokens[0]));
 				} else if (string_equal(STRING_ARGS(command), STRING_CONST("map_Ns"))) {
-					material.shininess_texture = string_clone(STRING_ARGS(tokens[0]));
+					material.shininess_texture = obj_string_intern(obj, STRING_ARGS(tokens[0]));
 				} else if (string_equal(STRING_ARGS(command), STRING_CONST("map_bump"))) {
-					material.bump_texture = string_clone(STRING_ARGS(tokens[0]));
+					material.bump_texture = obj_string_intern(obj, STRING_ARGS(tokens[0]));
 				}
 			}
 
@@ -310,8 +487,6 @@ load_material_lib(obj_t* obj, const char* filename, size_t length) {
 
 	if (material_valid)
 		array_push(obj->material, material);
-	else
-		obj_finalize_material(&material);
 
 	memory_deallocate(buffer);
 	stream_deallocate(stream);
@@ -319,10 +494,199 @@ load_material_lib(obj_t* obj, const char* filename, size_t length) {
 	return true;
 }
 
-bool
-obj_read(obj_t* obj, stream_t* stream) {
-	size_t file_size = stream_size(stream);
-	size_t estimated_vertex_count = file_size / 200;
+typedef void (*obj_line_fn)(void* context, size_t offset, const string_const_t* tokens, size_t tokens_count);
+
+static size_t
+tokenize_line(const char* line, size_t length, string_const_t* tokens, size_t tokens_capacity) {
+	size_t tokens_count = 0;
+	size_t pos = 0;
+	while (pos < length) {
+		while ((pos < length) && is_whitespace(line[pos]))
+			++pos;
+		size_t start = pos;
+		while ((pos < length) && !is_whitespace(line[pos]))
+			++pos;
+		if ((pos > start) && (tokens_count < tokens_capacity))
+			tokens[tokens_count++] = string_const(line + start, pos - start);
+	}
+	return tokens_count;
+}
+
+/*! Parse all complete lines in the buffer, calling the handler for each line with the
+offset of the line start relative to the given base offset. If final is set, a trailing
+line without endline is also parsed.
+\return Number of bytes consumed */
+static size_t
+parse_lines(const char* buffer, size_t size, size_t base_offset, bool final, obj_line_fn handler, void* context) {
+	string_const_t tokens[64];
+	const size_t tokens_capacity = sizeof(tokens) / sizeof(tokens[0]);
+
+	string_const_t remain = skip_whitespace_and_endline(buffer, size);
+	while (remain.length) {
+		size_t end_line = 0;
+		while ((end_line < remain.length) && !is_endline(remain.str[end_line]))
+			++end_line;
+
+		// Check if incomplete line was read (no endline and not end of data)
+		if ((end_line == remain.length) && !final)
+			break;
+
+		size_t tokens_count = tokenize_line(remain.str, end_line, tokens, tokens_capacity);
+		if (tokens_count)
+			handler(context, base_offset + (size_t)(remain.str - buffer), tokens, tokens_count);
+
+		remain = skip_whitespace_and_endline(remain.str + end_line, remain.length - end_line);
+	}
+
+	return size - remain.length;
+}
+
+/*! Parse lines from stream, reading at most limit bytes. If progress control is given,
+progress is reported and cancellation checked each time the buffer is refilled.
+\return Number of bytes consumed */
+static size_t
+parse_stream(stream_t* stream, size_t base_offset, size_t limit, bool final, obj_line_fn handler, void* context,
+             obj_progress_t* progress) {
+	size_t buffer_capacity = 4000;
+	char* buffer = memory_allocate(HASH_OBJ, buffer_capacity, 0, MEMORY_PERSISTENT);
+	size_t buffer_size = 0;
+	size_t consumed = 0;
+	size_t total_read = 0;
+	size_t total_size = progress ? stream_size(stream) : 0;
+	size_t last_report = base_offset;
+
+	bool at_end = false;
+	while (!at_end) {
+		if (obj_progress_cancelled(progress))
+			break;
+
+		size_t want = buffer_capacity - buffer_size;
+		if (want > (limit - total_read))
+			want = limit - total_read;
+		size_t was_read = want ? stream_read(stream, buffer + buffer_size, want) : 0;
+		buffer_size += was_read;
+		total_read += was_read;
+		at_end = !was_read || (total_read >= limit) || stream_eos(stream);
+
+		size_t parsed = parse_lines(buffer, buffer_size, base_offset + consumed, at_end && final, handler, context);
+		consumed += parsed;
+		buffer_size -= parsed;
+		if (parsed && buffer_size)
+			memmove(buffer, buffer + parsed, buffer_size);
+
+		// Grow buffer if a single line does not fit
+		if (buffer_size == buffer_capacity) {
+			buffer = memory_reallocate(buffer, buffer_capacity * 2, 0, buffer_capacity, MEMORY_PERSISTENT);
+			buffer_capacity *= 2;
+		}
+
+		obj_progress_update(progress, OBJ_PROGRESS_READ, base_offset + consumed, total_size, &last_report);
+	}
+
+	memory_deallocate(buffer);
+
+	return consumed;
+}
+
+//! Sorted set of one-based attribute indices to load when reading attributes only
+typedef struct obj_read_filter_t {
+	unsigned int* index;
+	size_t cursor;
+} obj_read_filter_t;
+
+typedef struct obj_read_context_t {
+	obj_t* obj;
+	obj_read_state_t* state;
+	//! Only count attribute declarations, do not store them
+	bool skip_attributes;
+	//! Vertex, UV and normal filters for obj_read_attribute_record
+	obj_read_filter_t filter[3];
+	//! Flag indicating if the normal matrix and winding of the read transform are computed
+	bool transform_ready;
+	//! Flag indicating if faces are reversed by the read transform
+	bool transform_flip;
+	//! Normal matrix of the read transform
+	real transform_normal[3][3];
+} obj_read_context_t;
+
+//! Compute normal matrix and winding of the read transform on first use
+static void
+obj_read_transform_prepare(obj_read_context_t* context) {
+	if (context->transform_ready)
+		return;
+	const obj_read_options_t* option = &context->obj->option;
+	real determinant = obj_matrix_normal(&option->transform, context->transform_normal);
+	context->transform_flip = (option->transform_flags & OBJ_TRANSFORM_FLIP_WINDING) && (determinant < 0);
+	context->transform_ready = true;
+}
+
+//! Transform a parsed vertex by the read transform if enabled
+static void
+obj_read_transform_vertex(obj_read_context_t* context, obj_vertex_t* vertex) {
+	if (context->obj->option.flags & OBJ_READ_TRANSFORM)
+		obj_matrix_transform_vertex(&context->obj->option.transform, vertex);
+}
+
+//! Transform a parsed normal by the read transform if enabled
+static void
+obj_read_transform_normal(obj_read_context_t* context, obj_normal_t* normal) {
+	if (!(context->obj->option.flags & OBJ_READ_TRANSFORM))
+		return;
+	obj_read_transform_prepare(context);
+	obj_matrix_transform_normal((const real(*)[3])context->transform_normal, normal,
+	                            context->obj->option.transform_flags & OBJ_TRANSFORM_NORMALIZE);
+}
+
+static unsigned int
+obj_material_find(const obj_t* obj, const char* name, size_t length) {
+	string_const_t interned = obj_string_find(obj, name, length);
+	if (!interned.str)
+		return INVALID_INDEX;
+	for (unsigned int imat = 0, msize = array_size(obj->material); imat < msize; ++imat) {
+		if (obj->material[imat].name.str == interned.str)
+			return imat;
+	}
+	return INVALID_INDEX;
+}
+
+//! Parse smoothing group of s record, "off" and 0 both turn smoothing off
+static unsigned int
+obj_smoothing_group(const string_const_t* tokens, size_t tokens_count) {
+	if (!tokens_count || string_equal(STRING_ARGS(tokens[0]), STRING_CONST("off")))
+		return 0;
+	return string_to_uint(STRING_ARGS(tokens[0]), false);
+}
+
+static void
+obj_read_state_reserve(obj_read_state_t* state, size_t reserve_count) {
+	state->reserve_count = reserve_count;
+	bucketarray_finalize(&state->vertex_to_corner);
+	bucketarray_initialize(&state->vertex_to_corner, sizeof(int), reserve_count);
+	bucketarray_reserve(&state->vertex_to_corner, reserve_count);
+	hashmap_deallocate(state->corner_map);
+	state->corner_map = nullptr;
+}
+
+void
+obj_read_state_initialize(obj_read_state_t* state) {
+	memset(state, 0, sizeof(obj_read_state_t));
+	state->material = INVALID_INDEX;
+	obj_read_state_reserve(state, 1024);
+}
+
+void
+obj_read_state_finalize(obj_read_state_t* state) {
+	if (!state)
+		return;
+	bucketarray_finalize(&state->vertex_to_corner);
+	hashmap_deallocate(state->corner_map);
+	string_deallocate(state->group_name.str);
+	memset(state, 0, sizeof(obj_read_state_t));
+}
+
+static void
+obj_read_prepare(obj_t* obj, obj_read_state_t* state, size_t size, string_const_t base_path) {
+	size_t estimated_vertex_count = size / 200;
 	size_t reserve_vertex_count = estimated_vertex_count / 8;
 	if (estimated_vertex_count < 1024) {
 		estimated_vertex_count = 1024;
@@ -330,288 +694,981 @@ obj_read(obj_t* obj, stream_t* stream) {
 	}
 
 	obj_finalize_groups(obj);
-	obj_finalize_materials(obj);
+	array_clear(obj->material);
+	obj_string_pool_clear(&obj->string_pool);
 
 	bucketarray_finalize(&obj->vertex);
 	bucketarray_finalize(&obj->normal);
 	bucketarray_finalize(&obj->uv);
+	bucketarray_finalize(&obj->tangent);
 
 	bucketarray_initialize(&obj->vertex, sizeof(obj_vertex_t), reserve_vertex_count);
 	bucketarray_reserve(&obj->vertex, reserve_vertex_count);
 
 	bucketarray_initialize(&obj->normal, sizeof(obj_normal_t), reserve_vertex_count);
 	bucketarray_initialize(&obj->uv, sizeof(obj_uv_t), reserve_vertex_count);
+	bucketarray_initialize(&obj->tangent, sizeof(obj_tangent_t), reserve_vertex_count);
+	obj_bounds_clear(&obj->bounds);
+	obj->invalid_face_count = 0;
 
 	string_deallocate(obj->base_path.str);
+	obj->base_path = string_clone(STRING_ARGS(base_path));
+
+	obj_read_state_reserve(state, reserve_vertex_count);
+}
+
+static void
+obj_read_begin(obj_t* obj, stream_t* stream, obj_read_state_t* state) {
 	string_const_t path = stream_path(stream);
 	path = path_directory_name(STRING_ARGS(path));
-	obj->base_path = string_clone(STRING_ARGS(path));
+	obj_read_prepare(obj, state, stream_size(stream), path);
+}
 
-	const size_t buffer_capacity = 4000;
-	char* buffer = memory_allocate(HASH_OBJ, buffer_capacity, 0, MEMORY_PERSISTENT);
+static void
+obj_read_subgroup_begin(obj_t* obj, obj_read_state_t* state) {
+	if (state->material > array_size(obj->material)) {
+		// Unknown materials share a single unnamed default material
+		unsigned int imat = 0;
+		unsigned int msize = array_size(obj->material);
+		while ((imat < msize) && obj->material[imat].name.str)
+			++imat;
+		if (imat == msize) {
+			obj_material_t material = material_default();
+			array_push(obj->material, material);
+		}
+		state->material = imat;
+	}
 
-	string_const_t tokens_storage[64];
-	const size_t tokens_capacity = sizeof(tokens_storage) / sizeof(tokens_storage[0]);
+	if (obj->option.flags & OBJ_READ_MERGE_SUBGROUPS) {
+		if (!state->corner_map)
+			state->corner_map = hashmap_allocate(state->reserve_count, 8);
+		for (size_t isub = 0, sgsize = array_size(state->group->subgroup); isub < sgsize; ++isub) {
+			obj_subgroup_t* subgroup = state->group->subgroup[isub];
+			if (subgroup->material == state->material) {
+				// Previous triangulation is invalidated by added faces
+				bucketarray_resize(&subgroup->triangle, 0);
+				state->subgroup = subgroup;
+				state->vertex_count_since_group = 0;
+				return;
+			}
+		}
+	}
 
-	obj_group_t* current_group = nullptr;
-	obj_subgroup_t* current_subgroup = nullptr;
+	obj_subgroup_t* subgroup =
+	    memory_allocate(HASH_OBJ, sizeof(obj_subgroup_t), 0, MEMORY_PERSISTENT | MEMORY_ZERO_INITIALIZED);
+	array_push(state->group->subgroup, subgroup);
 
-	size_t vertex_count_since_group = 0;
-	string_t group_name = {0};
-	unsigned int material_index = INVALID_INDEX;
+	// Start with small buckets unless vertices declared since last subgroup indicate a larger
+	// subgroup, arrays grow geometrically through obj_bucketarray_push
+	size_t estimated_triangles = (state->vertex_count_since_group * 3) / 4;
+	size_t estimated_corners = estimated_triangles * 3;
 
-	bucketarray_t vertex_to_corner;
-	bucketarray_initialize(&vertex_to_corner, sizeof(int), reserve_vertex_count);
-	bucketarray_reserve(&vertex_to_corner, reserve_vertex_count);
+	size_t bucket_size = obj_bucket_size(estimated_triangles, 4);
+	bucketarray_initialize(&subgroup->face, sizeof(obj_face_t), bucket_size);
+	bucketarray_reserve(&subgroup->face, estimated_triangles / 2);
 
-	while (!stream_eos(stream)) {
-		size_t last_remain = 0;
-		size_t was_read = stream_read(stream, buffer, buffer_capacity);
+	bucketarray_initialize(&subgroup->triangle, sizeof(obj_triangle_t), OBJ_BUCKET_SIZE_MIN);
 
-		string_const_t remain = {buffer, was_read};
-		string_const_t* tokens = tokens_storage + 1;
+	bucket_size = obj_bucket_size(estimated_corners, 4);
+	bucketarray_initialize(&subgroup->index, sizeof(unsigned int), bucket_size);
+	bucketarray_reserve(&subgroup->index, estimated_corners / 2);
 
-		remain = skip_whitespace_and_endline(STRING_ARGS(remain));
-		while (remain.length > 3) {
-			size_t tokens_count = 0;
-			size_t offset = 1;
+	bucketarray_initialize(&subgroup->corner, sizeof(obj_corner_t), bucket_size);
+	bucketarray_reserve(&subgroup->corner, estimated_corners / 2);
 
-			while (remain.length && (offset < remain.length)) {
-				if (is_whitespace(remain.str[offset]) || is_endline(remain.str[offset])) {
-					if (offset && (tokens_count < tokens_capacity))
-						tokens_storage[tokens_count++] = string_const(remain.str, offset);
-					if (is_endline(remain.str[offset]))
-						break;
-					remain = skip_whitespace(remain.str + offset, remain.length - offset);
-					offset = 0;
-				} else {
-					++offset;
-				}
-			}
+	subgroup->material = state->material;
+	obj_bounds_clear(&subgroup->bounds);
 
-			// Check if incomplete line was read (no endline and not end of file)
-			size_t end_line = offset;
-			if (offset == remain.length) {
-				if (was_read == buffer_capacity)
-					break;
-				++end_line;
-				last_remain = 0;
-				if (tokens_count < tokens_capacity)
-					tokens_storage[tokens_count++] = remain;
-			}
-			if (!tokens_count)
-				break;
+	bucketarray_clear(&state->vertex_to_corner);
 
-			string_const_t command = tokens_storage[0];
-			--tokens_count;
+	state->subgroup = subgroup;
+	state->vertex_count_since_group = 0;
+}
 
-			if (string_equal(STRING_ARGS(command), STRING_CONST("v"))) {
-				if (tokens_count >= 2) {
-					obj_vertex_t vertex = {string_to_real(STRING_ARGS(tokens[0])),
-					                       string_to_real(STRING_ARGS(tokens[1])),
-					                       (tokens_count > 2) ? string_to_real(STRING_ARGS(tokens[2])) : 0.0f};
-					bucketarray_push(&obj->vertex, &vertex);
-				} else {
-					obj_vertex_t vertex = {0, 0, 0};
-					bucketarray_push(&obj->vertex, &vertex);
-				}
-				++vertex_count_since_group;
-			} else if (string_equal(STRING_ARGS(command), STRING_CONST("vt"))) {
-				if (!obj->uv.bucket_count)
-					bucketarray_reserve(&obj->uv, reserve_vertex_count);
-				if (tokens_count >= 2) {
-					obj_uv_t uv = {string_to_real(STRING_ARGS(tokens[0])), string_to_real(STRING_ARGS(tokens[1]))};
-					bucketarray_push(&obj->uv, &uv);
-				} else {
-					obj_uv_t uv = {0, 0};
-					bucketarray_push(&obj->uv, &uv);
+void
+obj_group_map_insert(obj_t* obj, obj_group_t* group) {
+	if (!obj->group_map)
+		obj->group_map = hashmap_allocate(4093, 8);
+	hash_t key = hash(STRING_ARGS(group->name));
+	if (!hashmap_has_key(obj->group_map, key))
+		hashmap_insert(obj->group_map, key, group);
+}
+
+obj_group_t*
+obj_group_find(obj_t* obj, const char* name, size_t length) {
+	if (!obj || !obj->group_map)
+		return nullptr;
+	string_const_t interned = obj_string_find(obj, name, length);
+	if (!interned.str)
+		return nullptr;
+	obj_group_t* group = hashmap_lookup(obj->group_map, hash(name, length));
+	if (!group || (group->name.str == interned.str))
+		return group;
+	// Hash collision, fall back to searching all groups
+	for (size_t igroup = 0, gsize = array_size(obj->group); igroup < gsize; ++igroup) {
+		if (obj->group[igroup]->name.str == interned.str)
+			return obj->group[igroup];
+	}
+	return nullptr;
+}
+
+static hash_t
+obj_corner_key(const obj_subgroup_t* subgroup, unsigned int ivert) {
+	uintptr_t key[2] = {(uintptr_t)subgroup, ivert};
+	return hash(key, sizeof(key));
+}
+
+//! Get first corner in subgroup using the vertex index, -1 if none
+static int
+obj_read_corner_lookup(obj_read_state_t* state, obj_subgroup_t* subgroup, unsigned int ivert) {
+	if (state->corner_map) {
+		uintptr_t stored = (uintptr_t)hashmap_lookup(state->corner_map, obj_corner_key(subgroup, ivert));
+		// Verify against the corner data in case of hash collision, any corner using the vertex is a valid chain start
+		if (!stored || (stored > subgroup->corner.count))
+			return -1;
+		const obj_corner_t* corner = bucketarray_get(&subgroup->corner, stored - 1);
+		return (corner->vertex == ivert) ? (int)(stored - 1) : -1;
+	}
+	if (ivert > state->vertex_to_corner.count)
+		return -1;
+	return *bucketarray_get_as(int, &state->vertex_to_corner, ivert - 1);
+}
+
+static void
+obj_read_corner_store(obj_read_state_t* state, obj_subgroup_t* subgroup, unsigned int ivert, size_t corner_index) {
+	if (state->corner_map) {
+		hashmap_insert(state->corner_map, obj_corner_key(subgroup, ivert), (void*)(uintptr_t)(corner_index + 1));
+		return;
+	}
+	if (ivert > state->vertex_to_corner.count)
+		bucketarray_resize_fill(&state->vertex_to_corner, ivert, 0xff);
+	*bucketarray_get_as(int, &state->vertex_to_corner, ivert - 1) = (int)corner_index;
+}
+
+static void
+obj_read_face(obj_t* obj, obj_read_state_t* state, const string_const_t* tokens, size_t corners_count) {
+	if (!state->group) {
+		if (obj->option.flags & OBJ_READ_MERGE_GROUPS)
+			state->group = obj_group_find(obj, STRING_ARGS(state->group_name));
+		if (!state->group) {
+			state->group =
+			    memory_allocate(HASH_OBJ, sizeof(obj_group_t), 0, MEMORY_PERSISTENT | MEMORY_ZERO_INITIALIZED);
+			array_push(obj->group, state->group);
+
+			state->group->name = obj_string_intern(obj, STRING_ARGS(state->group_name));
+			obj_bounds_clear(&state->group->bounds);
+			obj_group_map_insert(obj, state->group);
+		}
+		string_deallocate(state->group_name.str);
+		state->group_name = string(0, 0);
+
+		state->subgroup = nullptr;
+	}
+
+	if (!state->subgroup)
+		obj_read_subgroup_begin(obj, state);
+
+	obj_subgroup_t* subgroup = state->subgroup;
+
+	size_t last_index_count = subgroup->index.count;
+	obj_face_t face = {0, (unsigned int)last_index_count, state->smoothing};
+	obj_bounds_t face_bounds;
+	obj_bounds_clear(&face_bounds);
+	bool valid_face = (corners_count >= 3);
+	for (size_t icorner = 0; valid_face && (icorner < corners_count); ++icorner) {
+		string_const_t corner_token[3];
+		size_t corner_tokens_count =
+		    string_explode(STRING_ARGS(tokens[icorner]), STRING_CONST("/"), corner_token, 3, true);
+
+		int relvert = 0;
+		int reluv = 0;
+		int relnorm = 0;
+		if (corner_tokens_count)
+			relvert = string_to_int(STRING_ARGS(corner_token[0]));
+		if (corner_tokens_count > 1)
+			reluv = string_to_int(STRING_ARGS(corner_token[1]));
+		if (corner_tokens_count > 2)
+			relnorm = string_to_int(STRING_ARGS(corner_token[2]));
+
+		if (relvert < 0)
+			relvert += (int)state->vertex_count + 1;
+		if (relnorm < 0)
+			relnorm += (int)state->normal_count + 1;
+		if (reluv < 0)
+			reluv += (int)state->uv_count + 1;
+
+		if ((relvert <= 0) || (relvert > (int)state->vertex_count))
+			valid_face = false;
+		if ((relnorm <= 0) || (relnorm > (int)state->normal_count))
+			relnorm = 0;
+		if ((reluv <= 0) || (reluv > (int)state->uv_count))
+			reluv = 0;
+
+		if (valid_face) {
+			size_t corner_index;
+			unsigned int ivert = (unsigned int)relvert;
+			unsigned int inorm = (unsigned int)relnorm;
+			unsigned int iuv = (unsigned int)reluv;
+			// Vertices are not stored yet when reading selected groups, bounds are computed after loading
+			if (ivert <= obj->vertex.count)
+				obj_bounds_extend(&face_bounds, bucketarray_get(&obj->vertex, ivert - 1));
+			int first_corner = obj_read_corner_lookup(state, subgroup, ivert);
+			if (first_corner < 0) {
+				obj_corner_t corner = {ivert, inorm, iuv, 0, -1};
+				corner_index = subgroup->corner.count;
+				obj_bucketarray_push(&subgroup->corner, &corner);
+				obj_read_corner_store(state, subgroup, ivert, corner_index);
+			} else {
+				corner_index = (size_t)first_corner;
+				size_t last_corner_index = (size_t)-1;
+				while (corner_index < subgroup->corner.count) {
+					obj_corner_t* corner = bucketarray_get(&subgroup->corner, corner_index);
+					if (!corner->normal || !inorm || (corner->normal == inorm)) {
+						if (!corner->uv || !iuv || (corner->uv == iuv)) {
+							if (inorm && !corner->normal)
+								corner->normal = inorm;
+							if (iuv && !corner->uv)
+								corner->uv = iuv;
+							break;
+						}
+					}
+					last_corner_index = corner_index;
+					corner_index = (size_t)corner->next;
 				}
-			} else if (string_equal(STRING_ARGS(command), STRING_CONST("vn"))) {
-				if (!obj->normal.bucket_count)
-					bucketarray_reserve(&obj->normal, reserve_vertex_count);
-				if (tokens_count >= 3) {
-					obj_normal_t normal = {string_to_real(STRING_ARGS(tokens[0])),
-					                       string_to_real(STRING_ARGS(tokens[1])),
-					                       string_to_real(STRING_ARGS(tokens[2]))};
-					bucketarray_push(&obj->normal, &normal);
-				} else {
-					obj_normal_t normal = {0, 0, 0};
-					bucketarray_push(&obj->normal, &normal);
+				if (corner_index >= subgroup->corner.count) {
+					obj_corner_t corner = {ivert, inorm, iuv, 0, -1};
+					corner_index = subgroup->corner.count;
+					obj_bucketarray_push(&subgroup->corner, &corner);
+					if (last_corner_index < corner_index) {
+						obj_corner_t* last_corner = bucketarray_get(&subgroup->corner, last_corner_index);
+						last_corner->next = (int)corner_index;
+					}
 				}
-			} else if (string_equal(STRING_ARGS(command), STRING_CONST("f")) && (tokens_count > 2)) {
-				size_t corners_count = tokens_count;
+			}
+			unsigned int index = (unsigned int)corner_index;
+			obj_bucketarray_push(&subgroup->index, &index);
+			++face.count;
+		}
+	}
 
-				if (!current_group) {
-					current_group =
-					    memory_allocate(HASH_OBJ, sizeof(obj_group_t), 0, MEMORY_PERSISTENT | MEMORY_ZERO_INITIALIZED);
-					array_push(obj->group, current_group);
+	if (valid_face) {
+		obj_bucketarray_push(&subgroup->face, &face);
+		obj_bounds_merge(&subgroup->bounds, &face_bounds);
+		obj_bounds_merge(&state->group->bounds, &face_bounds);
+	} else {
+		bucketarray_resize(&subgroup->index, last_index_count);
+		++obj->invalid_face_count;
+	}
+}
 
-					current_group->name = group_name;
-					group_name = string(0, 0);
+static void
+obj_read_subgroup_end(obj_read_context_t* context) {
+	obj_t* obj = context->obj;
+	obj_read_state_t* state = context->state;
+	obj_subgroup_t* subgroup = state->subgroup;
+	state->subgroup = nullptr;
+
+	// Corners reference unresolved attributes when skipping attributes, and merged subgroups
+	// can be extended until the end of data
+	if (!subgroup || !subgroup->face.count || !obj->option.subgroup_complete || context->skip_attributes ||
+	    (obj->option.flags & OBJ_READ_MERGE_SUBGROUPS))
+		return;
 
-					current_subgroup = nullptr;
-				}
+	if (!subgroup->triangle.count && !obj_triangulate_subgroup(obj, subgroup, nullptr, 0, nullptr))
+		return;
+	obj->option.subgroup_complete(obj->option.context, obj, state->group, subgroup);
+}
 
-				if (!current_subgroup) {
-					if (material_index > array_size(obj->material)) {
-						obj_material_t material = material_default();
-						material_index = array_size(obj->material);
-						array_push(obj->material, material);
-					}
+static void
+obj_read_end(obj_read_context_t* context) {
+	obj_read_subgroup_end(context);
+
+	obj_t* obj = context->obj;
+	if (!(obj->option.flags & OBJ_READ_MERGE_SUBGROUPS) || !obj->option.subgroup_complete || context->skip_attributes)
+		return;
+
+	for (size_t igroup = 0, gsize = array_size(obj->group); igroup < gsize; ++igroup) {
+		obj_group_t* group = obj->group[igroup];
+		for (size_t isub = 0, sgsize = array_size(group->subgroup); isub < sgsize; ++isub) {
+			obj_subgroup_t* subgroup = group->subgroup[isub];
+			if (!subgroup->face.count)
+				continue;
+			if (!subgroup->triangle.count && !obj_triangulate_subgroup(obj, subgroup, nullptr, 0, nullptr))
+				return;
+			obj->option.subgroup_complete(obj->option.context, obj, group, subgroup);
+		}
+	}
+}
+
+static void
+obj_read_record(void* context, size_t offset, const string_const_t* tokens_storage, size_t tokens_count) {
+	FOUNDATION_UNUSED(offset);
+	obj_read_context_t* read_context = context;
+	obj_t* obj = read_context->obj;
+	obj_read_state_t* state = read_context->state;
+
+	string_const_t command = tokens_storage[0];
+	const string_const_t* tokens = tokens_storage + 1;
+	--tokens_count;
+
+	if (string_equal(STRING_ARGS(command), STRING_CONST("v"))) {
+		++state->vertex_count;
+		++state->vertex_count_since_group;
+		if (read_context->skip_attributes)
+			return;
+		obj_vertex_t vertex = {0, 0, 0};
+		if (tokens_count >= 2) {
+			vertex.x = string_to_real(STRING_ARGS(tokens[0]));
+			vertex.y = string_to_real(STRING_ARGS(tokens[1]));
+			vertex.z = (tokens_count > 2) ? string_to_real(STRING_ARGS(tokens[2])) : 0.0f;
+		}
+		obj_read_transform_vertex(read_context, &vertex);
+		bucketarray_push(&obj->vertex, &vertex);
+		obj_bounds_extend(&obj->bounds, &vertex);
+	} else if (string_equal(STRING_ARGS(command), STRING_CONST("vt"))) {
+		++state->uv_count;
+		if (read_context->skip_attributes)
+			return;
+		if (!obj->uv.bucket_count)
+			bucketarray_reserve(&obj->uv, state->reserve_count);
+		if (tokens_count >= 2) {
+			obj_uv_t uv = {string_to_real(STRING_ARGS(tokens[0])), string_to_real(STRING_ARGS(tokens[1]))};
+			bucketarray_push(&obj->uv, &uv);
+		} else {
+			obj_uv_t uv = {0, 0};
+			bucketarray_push(&obj->uv, &uv);
+		}
+	} else if (string_equal(STRING_ARGS(command), STRING_CONST("vn"))) {
+		++state->normal_count;
+		if (read_context->skip_attributes)
+			return;
+		if (!obj->normal.bucket_count)
+			bucketarray_reserve(&obj->normal, state->reserve_count);
+		obj_normal_t normal = {0, 0, 0};
+		if (tokens_count >= 3) {
+			normal.nx = string_to_real(STRING_ARGS(tokens[0]));
+			normal.ny = string_to_real(STRING_ARGS(tokens[1]));
+			normal.nz = string_to_real(STRING_ARGS(tokens[2]));
+			obj_read_transform_normal(read_context, &normal);
+		}
+		bucketarray_push(&obj->normal, &normal);
+	} else if (string_equal(STRING_ARGS(command), STRING_CONST("f")) && (tokens_count > 2)) {
+		if (obj->option.flags & OBJ_READ_TRANSFORM)
+			obj_read_transform_prepare(read_context);
+		if (read_context->transform_flip) {
+			// Mirroring transform, reverse corner order to keep faces facing outward
+			string_const_t reversed[64];
+			for (size_t itoken = 0; itoken < tokens_count; ++itoken)
+				reversed[itoken] = tokens[tokens_count - itoken - 1];
+			obj_read_face(obj, state, reversed, tokens_count);
+		} else {
+			obj_read_face(obj, state, tokens, tokens_count);
+		}
+	} else if (string_equal(STRING_ARGS(command), STRING_CONST("mtllib")) && tokens_count) {
+		load_material_lib(obj, STRING_ARGS(tokens[0]));
+	} else if (string_equal(STRING_ARGS(command), STRING_CONST("usemtl")) && tokens_count) {
+		unsigned int next_material = obj_material_find(obj, STRING_ARGS(tokens[0]));
+		if (next_material != state->material) {
+			state->material = next_material;
+			obj_read_subgroup_end(read_context);
+		}
+	} else if (string_equal(STRING_ARGS(command), STRING_CONST("s"))) {
+		state->smoothing = obj_smoothing_group(tokens, tokens_count);
+	} else if (string_equal(STRING_ARGS(command), STRING_CONST("g"))) {
+		string_deallocate(state->group_name.str);
+		state->group_name = (tokens_count && tokens[0].length) ? string_clone_string(tokens[0]) :
+		                                                         string_clone(STRING_CONST("__unnamed"));
+		obj_read_subgroup_end(read_context);
+		state->group = nullptr;
+	}
+}
 
-					current_subgroup = memory_allocate(HASH_OBJ, sizeof(obj_subgroup_t), 0,
-					                                   MEMORY_PERSISTENT | MEMORY_ZERO_INITIALIZED);
-					array_push(current_group->subgroup, current_subgroup);
+static bool
+obj_read_stream(obj_t* obj, stream_t* stream, obj_read_state_t* state, bool final) {
+	obj_read_context_t context;
+	memset(&context, 0, sizeof(context));
+	context.obj = obj;
+	context.state = state;
+	state->offset +=
+	    parse_stream(stream, state->offset, (size_t)-1, final, obj_read_record, &context, &obj->progress);
+	if (obj_progress_cancelled(&obj->progress))
+		return false;
+	if (final)
+		obj_read_end(&context);
+	return true;
+}
 
-					size_t estimated_triangles = (vertex_count_since_group * 3) / 4;
-					size_t estimated_corners = estimated_triangles * 3;
+bool
+obj_read(obj_t* obj, stream_t* stream) {
+	stream_t* inflate_stream = nullptr;
+	if (obj_stream_is_gzip(stream)) {
+		inflate_stream = obj_inflate_stream_allocate(stream, false);
+		stream = inflate_stream;
+	}
 
-					size_t min_bucket_size = 1024;
-					if ((estimated_triangles / 4) > min_bucket_size)
-						min_bucket_size = (estimated_triangles / 4);
+	obj_read_state_t state;
+	obj_read_state_initialize(&state);
+	obj_read_begin(obj, stream, &state);
 
-					bucketarray_initialize(&current_subgroup->face, sizeof(obj_face_t), min_bucket_size);
-					bucketarray_reserve(&current_subgroup->face, estimated_triangles / 2);
+	bool result = obj_read_stream(obj, stream, &state, true);
+	if (inflate_stream && obj_inflate_stream_failed(inflate_stream))
+		result = false;
 
-					bucketarray_initialize(&current_subgroup->triangle, sizeof(obj_triangle_t), min_bucket_size);
+	obj_read_state_finalize(&state);
+	stream_deallocate(inflate_stream);
 
-					min_bucket_size = 1024;
-					if ((estimated_corners / 4) > min_bucket_size)
-						min_bucket_size = (estimated_corners / 4);
+	return result;
+}
 
-					bucketarray_initialize(&current_subgroup->index, sizeof(unsigned int), min_bucket_size);
-					bucketarray_reserve(&current_subgroup->index, estimated_corners / 2);
+static bool
+obj_read_continue(obj_t* obj, stream_t* stream, obj_read_state_t* state, bool final) {
+	if (!obj || !stream || !state)
+		return false;
 
-					bucketarray_initialize(&current_subgroup->corner, sizeof(obj_corner_t), min_bucket_size);
-					bucketarray_reserve(&current_subgroup->corner, estimated_corners / 2);
+	if (!state->offset) {
+		obj_read_begin(obj, stream, state);
+		state->offset = stream_tell(stream);
+	} else {
+		stream_seek(stream, (ssize_t)state->offset, STREAM_SEEK_BEGIN);
+	}
 
-					current_subgroup->material = material_index;
+	return obj_read_stream(obj, stream, state, final);
+}
 
-					bucketarray_clear(&vertex_to_corner);
+bool
+obj_read_append(obj_t* obj, stream_t* stream, obj_read_state_t* state) {
+	return obj_read_continue(obj, stream, state, false);
+}
 
-					vertex_count_since_group = 0;
-				}
+bool
+obj_read_append_finish(obj_t* obj, stream_t* stream, obj_read_state_t* state) {
+	return obj_read_continue(obj, stream, state, true);
+}
 
-				size_t last_index_count = current_subgroup->index.count;
-				obj_face_t face = {0, (unsigned int)last_index_count};
-				bool valid_face = (corners_count >= 3);
-				for (size_t icorner = 0; valid_face && (icorner < corners_count); ++icorner) {
-					string_const_t corner_token[3];
-					size_t corner_tokens_count =
-					    string_explode(STRING_ARGS(tokens[icorner]), STRING_CONST("/"), corner_token, 3, true);
-
-					int relvert = 0;
-					int reluv = 0;
-					int relnorm = 0;
-					if (corner_tokens_count)
-						relvert = string_to_int(STRING_ARGS(corner_token[0]));
-					if (corner_tokens_count > 1)
-						reluv = string_to_int(STRING_ARGS(corner_token[1]));
-					if (corner_tokens_count > 2)
-						relnorm = string_to_int(STRING_ARGS(corner_token[2]));
-
-					if (relvert < 0)
-						relvert += (int)obj->vertex.count + 1;
-					if (relnorm < 0)
-						relnorm = (int)obj->normal.count + 1;
-					if (reluv < 0)
-						reluv = (int)obj->uv.count + 1;
-
-					if ((relvert <= 0) || (relvert > (int)obj->vertex.count))
-						valid_face = false;
-					if ((relnorm <= 0) || (relnorm > (int)obj->normal.count))
-						relnorm = 0;
-					if ((reluv <= 0) || (reluv > (int)obj->uv.count))
-						reluv = 0;
-
-					if (valid_face) {
-						size_t corner_index;
-						unsigned int ivert = (unsigned int)relvert;
-						unsigned int inorm = (unsigned int)relnorm;
-						unsigned int iuv = (unsigned int)reluv;
-						if ((ivert > vertex_to_corner.count) ||
-						    (*bucketarray_get_as(int, &vertex_to_corner, ivert - 1) < 0)) {
-							obj_corner_t corner = {ivert, inorm, iuv, -1};
-							corner_index = current_subgroup->corner.count;
-							bucketarray_push(&current_subgroup->corner, &corner);
-							if (ivert > vertex_to_corner.count)
-								bucketarray_resize_fill(&vertex_to_corner, ivert, 0xff);
-							*bucketarray_get_as(int, &vertex_to_corner, ivert - 1) = (int)corner_index;
-						} else {
-							corner_index = (size_t)*bucketarray_get_as(int, &vertex_to_corner, ivert - 1);
-							size_t last_corner_index = (size_t)-1;
-							while (corner_index < current_subgroup->corner.count) {
-								obj_corner_t* corner = bucketarray_get(&current_subgroup->corner, corner_index);
-								if (!corner->normal || !inorm || (corner->normal == inorm)) {
-									if (!corner->uv || !iuv || (corner->uv == iuv)) {
-										if (inorm && !corner->normal)
-											corner->normal = inorm;
-										if (iuv && !corner->uv)
-											corner->uv = iuv;
-										break;
-									}
-								}
-								corner_index = (size_t)corner->next;
-								last_corner_index = corner_index;
-							}
-							if (corner_index >= current_subgroup->corner.count) {
-								obj_corner_t corner = {ivert, inorm, iuv, -1};
-								corner_index = current_subgroup->corner.count;
-								bucketarray_push(&current_subgroup->corner, &corner);
-								if (last_corner_index < corner_index) {
-									obj_corner_t* last_corner =
-									    bucketarray_get(&current_subgroup->corner, last_corner_index);
-									last_corner->next = (int)corner_index;
-								}
-							}
-						}
-						bucketarray_push(&current_subgroup->index, &corner_index);
-						++face.count;
-					}
-				}
+void
+obj_parser_initialize(obj_parser_t* parser, const obj_read_options_t* option) {
+	memset(parser, 0, sizeof(obj_parser_t));
+	obj_initialize(&parser->obj);
+	if (option)
+		parser->obj.option = *option;
+	obj_read_state_initialize(&parser->state);
+	obj_read_prepare(&parser->obj, &parser->state, 0, string_const(0, 0));
+}
 
-				if (valid_face) {
-					bucketarray_push(&current_subgroup->face, &face);
-				} else {
-					bucketarray_resize(&current_subgroup->index, last_index_count);
-				}
-			} else if (string_equal(STRING_ARGS(command), STRING_CONST("mtllib")) && tokens_count) {
-				load_material_lib(obj, STRING_ARGS(tokens[0]));
-			} else if (string_equal(STRING_ARGS(command), STRING_CONST("usemtl")) && tokens_count) {
-				string_const_t name = tokens[0];
-				unsigned int next_material = INVALID_INDEX;
-				for (unsigned int imat = 0, msize = array_size(obj->material); imat < msize; ++imat) {
-					if (string_equal(STRING_ARGS(name), STRING_ARGS(obj->material[imat].name))) {
-						next_material = imat;
-						break;
-					}
-				}
-				if (next_material != material_index) {
-					material_index = next_material;
-					current_subgroup = nullptr;
-				}
-			} else if (string_equal(STRING_ARGS(command), STRING_CONST("g"))) {
-				string_deallocate(group_name.str);
-				group_name = (tokens_count && tokens[0].length) ? string_clone_string(tokens[0]) :
-				                                                  string_clone(STRING_CONST("__unnamed"));
-				current_group = nullptr;
-			}
+void
+obj_parser_finalize(obj_parser_t* parser) {
+	if (!parser)
+		return;
+	obj_finalize(&parser->obj);
+	obj_read_state_finalize(&parser->state);
+	array_deallocate(parser->pending);
+}
 
-			remain.str += end_line;
-			remain.length = (remain.length > end_line) ? (remain.length - end_line) : 0;
+bool
+obj_parser_feed(obj_parser_t* parser, const void* data, size_t size) {
+	if (!parser || (!data && size))
+		return false;
 
-			remain = skip_whitespace_and_endline(STRING_ARGS(remain));
-			last_remain = remain.length;
+	obj_read_context_t context;
+	memset(&context, 0, sizeof(context));
+	context.obj = &parser->obj;
+	context.state = &parser->state;
+
+	const char* buffer = data;
+	size_t pending_size = array_size(parser->pending);
+	size_t base_offset = parser->state.offset - pending_size;
+	if (pending_size) {
+		// Complete the pending line with data up to the first endline
+		size_t end_line = 0;
+		while ((end_line < size) && !is_endline(buffer[end_line]))
+			++end_line;
+		array_resize(parser->pending, pending_size + end_line);
+		memcpy(parser->pending + pending_size, buffer, end_line);
+		if (end_line == size) {
+			parser->state.offset += size;
+			return true;
 		}
+		parse_lines(parser->pending, array_size(parser->pending), base_offset, true, obj_read_record, &context);
+		array_clear(parser->pending);
+		base_offset += pending_size + end_line;
+		buffer += end_line;
+		size -= end_line;
+		parser->state.offset += end_line;
+	}
 
-		if (!stream_eos(stream) && last_remain)
-			stream_seek(stream, -(ssize_t)last_remain, STREAM_SEEK_CURRENT);
+	size_t consumed = parse_lines(buffer, size, base_offset, false, obj_read_record, &context);
+	if (consumed < size) {
+		array_resize(parser->pending, size - consumed);
+		memcpy(parser->pending, buffer + consumed, size - consumed);
 	}
+	parser->state.offset += size;
 
-	bucketarray_finalize(&vertex_to_corner);
+	return true;
+}
 
-	string_deallocate(group_name.str);
-	memory_deallocate(buffer);
+bool
+obj_parser_finish(obj_parser_t* parser, obj_t* obj) {
+	if (!parser || !obj)
+		return false;
+
+	obj_read_context_t context;
+	memset(&context, 0, sizeof(context));
+	context.obj = &parser->obj;
+	context.state = &parser->state;
+
+	size_t pending_size = array_size(parser->pending);
+	if (pending_size) {
+		parse_lines(parser->pending, pending_size, parser->state.offset - pending_size, true, obj_read_record,
+		            &context);
+		array_clear(parser->pending);
+	}
+	obj_read_end(&context);
+
+	obj_progress_t progress = obj->progress;
+	obj_read_options_t option = obj->option;
+	obj_progress_t parser_progress = parser->obj.progress;
+	obj_read_options_t parser_option = parser->obj.option;
+	obj_finalize(obj);
+	*obj = parser->obj;
+	obj->progress = progress;
+	obj->option = option;
+
+	obj_initialize(&parser->obj);
+	parser->obj.progress = parser_progress;
+	parser->obj.option = parser_option;
+	obj_read_state_finalize(&parser->state);
+	obj_read_state_initialize(&parser->state);
+	obj_read_prepare(&parser->obj, &parser->state, 0, string_const(0, 0));
+
+	return true;
+}
+
+void
+obj_index_initialize(obj_index_t* index) {
+	memset(index, 0, sizeof(obj_index_t));
+}
+
+void
+obj_index_finalize(obj_index_t* index) {
+	if (!index)
+		return;
+	for (size_t ientry = 0, esize = array_size(index->entry); ientry < esize; ++ientry) {
+		string_deallocate(index->entry[ientry].group.str);
+		string_deallocate(index->entry[ientry].material.str);
+	}
+	for (size_t ilib = 0, lsize = array_size(index->material_lib); ilib < lsize; ++ilib)
+		string_deallocate(index->material_lib[ilib].str);
+	array_deallocate(index->entry);
+	array_deallocate(index->material_lib);
+	memset(index, 0, sizeof(obj_index_t));
+}
+
+typedef struct obj_index_context_t {
+	obj_index_t* index;
+	//! Current smoothing group
+	unsigned int smoothing;
+} obj_index_context_t;
+
+static void
+obj_index_push_entry(obj_index_t* index, size_t offset, string_const_t group, string_const_t material,
+                     unsigned int smoothing) {
+	obj_index_entry_t entry;
+	entry.group = string_clone_string(group);
+	entry.material = string_clone_string(material);
+	entry.offset = offset;
+	entry.vertex_count = index->vertex_count;
+	entry.uv_count = index->uv_count;
+	entry.normal_count = index->normal_count;
+	entry.smoothing = smoothing;
+	array_push(index->entry, entry);
+}
+
+static void
+obj_index_record(void* context, size_t offset, const string_const_t* tokens, size_t tokens_count) {
+	obj_index_context_t* index_context = context;
+	obj_index_t* index = index_context->index;
+	string_const_t command = tokens[0];
+	if (command.str[0] == 'v') {
+		if (command.length == 1)
+			++index->vertex_count;
+		else if (string_equal(STRING_ARGS(command), STRING_CONST("vt")))
+			++index->uv_count;
+		else if (string_equal(STRING_ARGS(command), STRING_CONST("vn")))
+			++index->normal_count;
+	} else if (string_equal(STRING_ARGS(command), STRING_CONST("g"))) {
+		string_const_t group =
+		    ((tokens_count > 1) && tokens[1].length) ? tokens[1] : string_const(STRING_CONST("__unnamed"));
+		obj_index_entry_t* last = array_last(index->entry);
+		obj_index_push_entry(index, offset, group, string_to_const(last->material), index_context->smoothing);
+	} else if (string_equal(STRING_ARGS(command), STRING_CONST("usemtl")) && (tokens_count > 1)) {
+		obj_index_entry_t* last = array_last(index->entry);
+		obj_index_push_entry(index, offset, string_to_const(last->group), tokens[1], index_context->smoothing);
+	} else if (string_equal(STRING_ARGS(command), STRING_CONST("s"))) {
+		index_context->smoothing = obj_smoothing_group(tokens + 1, tokens_count - 1);
+	} else if (string_equal(STRING_ARGS(command), STRING_CONST("mtllib")) && (tokens_count > 1)) {
+		string_t lib = string_clone_string(tokens[1]);
+		array_push(index->material_lib, lib);
+	}
+}
+
+bool
+obj_index_build(obj_index_t* index, stream_t* stream) {
+	obj_index_finalize(index);
+
+	size_t base_offset = stream_tell(stream);
+	obj_index_context_t context = {index, 0};
+	obj_index_push_entry(index, base_offset, string_const(0, 0), string_const(0, 0), 0);
+	parse_stream(stream, base_offset, (size_t)-1, true, obj_index_record, &context, nullptr);
+	index->size = stream_size(stream);
+
+	return true;
+}
+
+#define OBJ_INDEX_MAGIC 0x4f424a49
+#define OBJ_INDEX_VERSION 2
+//! Size of the serialized sizes and material library count following magic and version
+#define OBJ_INDEX_HEADER_SIZE 36
+//! Size of a serialized empty string
+#define OBJ_INDEX_STRING_MIN_SIZE 4
+//! Size of a serialized entry with empty strings
+#define OBJ_INDEX_ENTRY_MIN_SIZE (36 + (2 * OBJ_INDEX_STRING_MIN_SIZE))
+
+static void
+obj_index_write_string(stream_t* stream, string_t str) {
+	stream_write_uint32(stream, (uint32_t)str.length);
+	if (str.length)
+		stream_write(stream, str.str, str.length);
+}
+
+//! Number of bytes left to read in stream, 0 if at end or size is unknown
+static size_t
+obj_index_remaining(stream_t* stream) {
+	size_t size = stream_size(stream);
+	size_t offset = stream_tell(stream);
+	return (size > offset) ? (size - offset) : 0;
+}
+
+/*! Read a string written by obj_index_write_string. The length is validated against the
+remaining stream size before allocating, as the stream is not trusted
+\param stream Source stream
+\param str Read string, empty string if error
+\return true if success, false if the string exceeds the remaining data */
+static bool
+obj_index_read_string(stream_t* stream, string_t* str) {
+	if (obj_index_remaining(stream) < OBJ_INDEX_STRING_MIN_SIZE) {
+		*str = string_clone(STRING_CONST(""));
+		return false;
+	}
+	size_t length = stream_read_uint32(stream);
+	if (!length || (length > obj_index_remaining(stream))) {
+		*str = string_clone(STRING_CONST(""));
+		return !length;
+	}
+	*str = string_allocate(length, length + 1);
+	str->length = stream_read(stream, str->str, length);
+	str->str[str->length] = 0;
+	return (str->length == length);
+}
+
+bool
+obj_index_write(const obj_index_t* index, stream_t* stream) {
+	if (!index || !stream)
+		return false;
+
+	stream_write_uint32(stream, OBJ_INDEX_MAGIC);
+	stream_write_uint32(stream, OBJ_INDEX_VERSION);
+	stream_write_uint64(stream, index->size);
+	stream_write_uint64(stream, index->vertex_count);
+	stream_write_uint64(stream, index->uv_count);
+	stream_write_uint64(stream, index->normal_count);
+
+	stream_write_uint32(stream, array_size(index->material_lib));
+	for (size_t ilib = 0, lsize = array_size(index->material_lib); ilib < lsize; ++ilib)
+		obj_index_write_string(stream, index->material_lib[ilib]);
+
+	stream_write_uint32(stream, array_size(index->entry));
+	for (size_t ientry = 0, esize = array_size(index->entry); ientry < esize; ++ientry) {
+		const obj_index_entry_t* entry = index->entry + ientry;
+		stream_write_uint64(stream, entry->offset);
+		stream_write_uint64(stream, entry->vertex_count);
+		stream_write_uint64(stream, entry->uv_count);
+		stream_write_uint64(stream, entry->normal_count);
+		stream_write_uint32(stream, entry->smoothing);
+		obj_index_write_string(stream, entry->group);
+		obj_index_write_string(stream, entry->material);
+	}
+
+	return true;
+}
+
+bool
+obj_index_read(obj_index_t* index, stream_t* stream) {
+	obj_index_finalize(index);
+	if (!stream)
+		return false;
+
+	uint32_t magic = stream_read_uint32(stream);
+	uint32_t version = stream_read_uint32(stream);
+	if ((magic != OBJ_INDEX_MAGIC) || (version != OBJ_INDEX_VERSION) ||
+	    (obj_index_remaining(stream) < OBJ_INDEX_HEADER_SIZE))
+		return false;
+
+	index->size = (size_t)stream_read_uint64(stream);
+	index->vertex_count = (size_t)stream_read_uint64(stream);
+	index->uv_count = (size_t)stream_read_uint64(stream);
+	index->normal_count = (size_t)stream_read_uint64(stream);
+
+	// Counts and string lengths come from an untrusted stream, check them against the remaining size
+	bool valid = true;
+	uint32_t lib_count = stream_read_uint32(stream);
+	if ((size_t)lib_count * OBJ_INDEX_STRING_MIN_SIZE > obj_index_remaining(stream))
+		valid = false;
+	for (uint32_t ilib = 0; valid && (ilib < lib_count) && !stream_eos(stream); ++ilib) {
+		string_t lib;
+		valid = obj_index_read_string(stream, &lib);
+		array_push(index->material_lib, lib);
+	}
+
+	if (obj_index_remaining(stream) < sizeof(uint32_t))
+		valid = false;
+	uint32_t entry_count = valid ? stream_read_uint32(stream) : 0;
+	if ((size_t)entry_count * OBJ_INDEX_ENTRY_MIN_SIZE > obj_index_remaining(stream))
+		valid = false;
+	for (uint32_t ientry = 0; valid && (ientry < entry_count) && !stream_eos(stream); ++ientry) {
+		if (obj_index_remaining(stream) < OBJ_INDEX_ENTRY_MIN_SIZE) {
+			valid = false;
+			break;
+		}
+		obj_index_entry_t entry;
+		entry.offset = (size_t)stream_read_uint64(stream);
+		entry.vertex_count = (size_t)stream_read_uint64(stream);
+		entry.uv_count = (size_t)stream_read_uint64(stream);
+		entry.normal_count = (size_t)stream_read_uint64(stream);
+		entry.smoothing = stream_read_uint32(stream);
+		valid = obj_index_read_string(stream, &entry.group);
+		valid = obj_index_read_string(stream, &entry.material) && valid;
+		array_push(index->entry, entry);
+	}
+
+	if (!valid || (array_size(index->material_lib) != lib_count) || (array_size(index->entry) != entry_count)) {
+		obj_index_finalize(index);
+		return false;
+	}
+
+	return true;
+}
+
+static void
+obj_read_attribute_record(void* context, size_t offset, const string_const_t* tokens_storage, size_t tokens_count) {
+	FOUNDATION_UNUSED(offset);
+	obj_read_context_t* read_context = context;
+	obj_t* obj = read_context->obj;
+	obj_read_state_t* state = read_context->state;
+
+	string_const_t command = tokens_storage[0];
+	const string_const_t* tokens = tokens_storage + 1;
+	--tokens_count;
+
+	if (command.str[0] != 'v')
+		return;
+
+	obj_read_filter_t* filter;
+	size_t index;
+	if (command.length == 1) {
+		filter = read_context->filter + 0;
+		index = ++state->vertex_count;
+	} else if (string_equal(STRING_ARGS(command), STRING_CONST("vt"))) {
+		filter = read_context->filter + 1;
+		index = ++state->uv_count;
+	} else if (string_equal(STRING_ARGS(command), STRING_CONST("vn"))) {
+		filter = read_context->filter + 2;
+		index = ++state->normal_count;
+	} else {
+		return;
+	}
+
+	if ((filter->cursor >= array_size(filter->index)) || (filter->index[filter->cursor] != index))
+		return;
+	++filter->cursor;
+
+	real value[3] = {0, 0, 0};
+	for (size_t itoken = 0; (itoken < tokens_count) && (itoken < 3); ++itoken)
+		value[itoken] = string_to_real(STRING_ARGS(tokens[itoken]));
+
+	if (filter == read_context->filter + 0) {
+		obj_vertex_t vertex = {value[0], value[1], value[2]};
+		obj_read_transform_vertex(read_context, &vertex);
+		bucketarray_push(&obj->vertex, &vertex);
+	} else if (filter == read_context->filter + 1) {
+		obj_uv_t uv = {value[0], value[1]};
+		bucketarray_push(&obj->uv, &uv);
+	} else {
+		obj_normal_t normal = {value[0], value[1], value[2]};
+		obj_read_transform_normal(read_context, &normal);
+		bucketarray_push(&obj->normal, &normal);
+	}
+}
+
+static int
+index_compare(const void* first, const void* second) {
+	unsigned int lhs = *(const unsigned int*)first;
+	unsigned int rhs = *(const unsigned int*)second;
+	return (lhs < rhs) ? -1 : ((lhs > rhs) ? 1 : 0);
+}
+
+static void
+index_sort_unique(unsigned int* index) {
+	size_t count = array_size(index);
+	if (count < 2)
+		return;
+	qsort(index, count, sizeof(unsigned int), index_compare);
+	size_t unique = 1;
+	for (size_t iidx = 1; iidx < count; ++iidx) {
+		if (index[iidx] != index[unique - 1])
+			index[unique++] = index[iidx];
+	}
+	array_resize(index, unique);
+}
+
+static unsigned int
+index_remap(const unsigned int* index, unsigned int value) {
+	if (!value)
+		return 0;
+	const unsigned int* found = bsearch(&value, index, array_size(index), sizeof(unsigned int), index_compare);
+	return found ? (unsigned int)(found - index) + 1 : 0;
+}
+
+static bool
+obj_index_entry_wanted(const obj_index_entry_t* entry, const string_const_t* names, size_t count) {
+	for (size_t iname = 0; iname < count; ++iname) {
+		if (string_equal(STRING_ARGS(entry->group), STRING_ARGS(names[iname])))
+			return true;
+	}
+	return false;
+}
+
+static size_t
+obj_index_entry_end(const obj_index_t* index, size_t ientry) {
+	return ((ientry + 1) < array_size(index->entry)) ? index->entry[ientry + 1].offset : index->size;
+}
+
+bool
+obj_read_groups(obj_t* obj, stream_t* stream, const obj_index_t* index, const string_const_t* names, size_t count) {
+	if (!obj || !stream || !index || !array_size(index->entry))
+		return false;
+	if (stream_size(stream) != index->size) {
+		log_warn(HASH_OBJ, WARNING_INVALID_VALUE, STRING_CONST("OBJ index does not match stream size"));
+		return false;
+	}
+
+	obj_read_state_t state;
+	obj_read_state_initialize(&state);
+	obj_read_begin(obj, stream, &state);
+
+	for (size_t ilib = 0, lsize = array_size(index->material_lib); ilib < lsize; ++ilib)
+		load_material_lib(obj, STRING_ARGS(index->material_lib[ilib]));
+
+	obj_read_context_t context;
+	memset(&context, 0, sizeof(context));
+	context.obj = obj;
+	context.state = &state;
+	context.skip_attributes = true;
+
+	// Parse records of all wanted sections, counting but not storing attributes. Corners
+	// will temporarily hold absolute attribute indices into the file
+	size_t entry_count = array_size(index->entry);
+	for (size_t ientry = 0; ientry < entry_count;) {
+		if (!obj_index_entry_wanted(index->entry + ientry, names, count)) {
+			++ientry;
+			continue;
+		}
+		const obj_index_entry_t* entry = index->entry + ientry;
+		size_t last_entry = ientry;
+		while (((last_entry + 1) < entry_count) &&
+		       obj_index_entry_wanted(index->entry + last_entry + 1, names, count))
+			++last_entry;
+
+		state.vertex_count = entry->vertex_count;
+		state.uv_count = entry->uv_count;
+		state.normal_count = entry->normal_count;
+		state.material = obj_material_find(obj, STRING_ARGS(entry->material));
+		state.smoothing = entry->smoothing;
+		state.group = nullptr;
+		state.subgroup = nullptr;
+		string_deallocate(state.group_name.str);
+		state.group_name = string_clone(STRING_ARGS(entry->group));
+
+		size_t end = obj_index_entry_end(index, last_entry);
+		stream_seek(stream, (ssize_t)entry->offset, STREAM_SEEK_BEGIN);
+		parse_stream(stream, entry->offset, end - entry->offset, true, obj_read_record, &context, nullptr);
+
+		ientry = last_entry + 1;
+	}
+
+	// Collect referenced attributes
+	for (size_t igroup = 0, gsize = array_size(obj->group); igroup < gsize; ++igroup) {
+		obj_group_t* group = obj->group[igroup];
+		for (size_t isub = 0, sgsize = array_size(group->subgroup); isub < sgsize; ++isub) {
+			obj_subgroup_t* subgroup = group->subgroup[isub];
+			for (size_t icorner = 0; icorner < subgroup->corner.count; ++icorner) {
+				obj_corner_t* corner = bucketarray_get(&subgroup->corner, icorner);
+				array_push(context.filter[0].index, corner->vertex);
+				if (corner->uv)
+					array_push(context.filter[1].index, corner->uv);
+				if (corner->normal)
+					array_push(context.filter[2].index, corner->normal);
+			}
+		}
+	}
+	for (size_t ifilter = 0; ifilter < 3; ++ifilter)
+		index_sort_unique(context.filter[ifilter].index);
+
+	// Load referenced attributes from the sections declaring them
+	for (size_t ientry = 0; ientry < entry_count; ++ientry) {
+		const obj_index_entry_t* entry = index->entry + ientry;
+		bool last = ((ientry + 1) == entry_count);
+		size_t next_count[3] = {last ? index->vertex_count : entry[1].vertex_count,
+		                        last ? index->uv_count : entry[1].uv_count,
+		                        last ? index->normal_count : entry[1].normal_count};
+		bool wanted = false;
+		for (size_t ifilter = 0; ifilter < 3; ++ifilter) {
+			obj_read_filter_t* filter = context.filter + ifilter;
+			if ((filter->cursor < array_size(filter->index)) && (filter->index[filter->cursor] <= next_count[ifilter]))
+				wanted = true;
+		}
+		if (!wanted)
+			continue;
+
+		state.vertex_count = entry->vertex_count;
+		state.uv_count = entry->uv_count;
+		state.normal_count = entry->normal_count;
+
+		size_t end = obj_index_entry_end(index, ientry);
+		stream_seek(stream, (ssize_t)entry->offset, STREAM_SEEK_BEGIN);
+		parse_stream(stream, entry->offset, end - entry->offset, true, obj_read_attribute_record, &context,
+		             nullptr);
+	}
+
+	// Remap absolute attribute indices to loaded attributes
+	for (size_t igroup = 0, gsize = array_size(obj->group); igroup < gsize; ++igroup) {
+		obj_group_t* group = obj->group[igroup];
+		for (size_t isub = 0, sgsize = array_size(group->subgroup); isub < sgsize; ++isub) {
+			obj_subgroup_t* subgroup = group->subgroup[isub];
+			for (size_t icorner = 0; icorner < subgroup->corner.count; ++icorner) {
+				obj_corner_t* corner = bucketarray_get(&subgroup->corner, icorner);
+				corner->vertex = index_remap(context.filter[0].index, corner->vertex);
+				corner->uv = index_remap(context.filter[1].index, corner->uv);
+				corner->normal = index_remap(context.filter[2].index, corner->normal);
+			}
+		}
+	}
+
+	for (size_t ifilter = 0; ifilter < 3; ++ifilter)
+		array_deallocate(context.filter[ifilter].index);
+	obj_read_state_finalize(&state);
+
+	// Face bounds could not be tracked while vertices were skipped
+	obj_compute_bounds(obj);
 
 	return true;
 }
@@ -739,8 +1796,8 @@ triangulate_convex(bucketarray_t* index, unsigned int base_offset, bucketarray_t
 	unsigned int next_index = *bucketarray_get_as(unsigned int, index, base_offset + base);
 	while (corner_count >= 3) {
 		unsigned int last_index = *bucketarray_get_as(unsigned int, index, base_offset + base + 1);
-		obj_triangle_t new_triangle = {first_index, next_index, last_index};
-		bucketarray_push(triangle, &new_triangle);
+		obj_triangle_t new_triangle = {{first_index, next_index, last_index}};
+		obj_bucketarray_push(triangle, &new_triangle);
 		++base;
 		++triangle_count;
 		--corner_count;
@@ -872,10 +1929,10 @@ triangulate_concave(bucketarray_t* index, unsigned int base_offset, bucketarray_
 				continue;
 			}
 
-			obj_triangle_t new_triangle = {*bucketarray_get_as(unsigned int, index, base_offset + i0),
-			                               *bucketarray_get_as(unsigned int, index, base_offset + i1),
-			                               *bucketarray_get_as(unsigned int, index, base_offset + i2)};
-			bucketarray_push(triangle, &new_triangle);
+			obj_triangle_t new_triangle = {{*bucketarray_get_as(unsigned int, index, base_offset + i0),
+			                                *bucketarray_get_as(unsigned int, index, base_offset + i1),
+			                                *bucketarray_get_as(unsigned int, index, base_offset + i2)}};
+			obj_bucketarray_push(triangle, &new_triangle);
 			++triangle_count;
 
 			memmove(local + base, local + base + 1, sizeof(unsigned int) * (local_count - base - 1));
@@ -891,9 +1948,14 @@ triangulate_concave(bucketarray_t* index, unsigned int base_offset, bucketarray_
 	return triangle_count;
 }
 
-static bool
-obj_triangulate_subgroup(obj_t* obj, obj_subgroup_t* subgroup) {
-	bucketarray_reserve(&subgroup->triangle, 3 * subgroup->face.count);
+bool
+obj_triangulate_subgroup(obj_t* obj, obj_subgroup_t* subgroup, size_t* done, size_t total, size_t* last_report) {
+	// Each face of n corners gives n - 2 triangles
+	size_t triangle_count = subgroup->index.count - (2 * subgroup->face.count);
+	size_t bucket_size = obj_bucket_size(triangle_count, 4);
+	if (subgroup->triangle.bucket_size != bucket_size)
+		obj_bucketarray_rebucket(&subgroup->triangle, bucket_size);
+	bucketarray_reserve(&subgroup->triangle, triangle_count);
 	bucketarray_resize(&subgroup->triangle, 0);
 
 	for (size_t iface = 0, fsize = subgroup->face.count; iface < fsize; ++iface) {
@@ -906,21 +1968,72 @@ obj_triangulate_subgroup(obj_t* obj, obj_subgroup_t* subgroup) {
 		else
 			triangulate_concave(&subgroup->index, face->offset, &subgroup->corner, &obj->vertex, face->count,
 			                    &subgroup->triangle);
+
+		if (done && obj->progress.callback)
+			obj_progress_update(&obj->progress, OBJ_PROGRESS_TRIANGULATE, ++(*done), total, last_report);
+		if (!(iface % 1024) && obj_progress_cancelled(&obj->progress)) {
+			// Leave subgroup untriangulated so it is processed again in a later call
+			bucketarray_resize(&subgroup->triangle, 0);
+			return false;
+		}
 	}
 	return true;
 }
 
+void
+obj_subgroup_pack(obj_t* obj, obj_subgroup_t* subgroup, obj_packed_vertex_t* vertices) {
+	for (size_t icorner = 0, csize = subgroup->corner.count; icorner < csize; ++icorner) {
+		obj_corner_t* corner = bucketarray_get(&subgroup->corner, icorner);
+		obj_packed_vertex_t* vertex = vertices + icorner;
+		vertex->position = *bucketarray_get_as(obj_vertex_t, &obj->vertex, corner->vertex - 1);
+		if (corner->normal) {
+			vertex->normal = *bucketarray_get_as(obj_normal_t, &obj->normal, corner->normal - 1);
+		} else {
+			vertex->normal.nx = 0;
+			vertex->normal.ny = 0;
+			vertex->normal.nz = 0;
+		}
+		if (corner->uv) {
+			vertex->uv = *bucketarray_get_as(obj_uv_t, &obj->uv, corner->uv - 1);
+		} else {
+			vertex->uv.u = 0;
+			vertex->uv.v = 0;
+		}
+		if (corner->tangent) {
+			vertex->tangent = *bucketarray_get_as(obj_tangent_t, &obj->tangent, corner->tangent - 1);
+		} else {
+			vertex->tangent.tx = 0;
+			vertex->tangent.ty = 0;
+			vertex->tangent.tz = 0;
+			vertex->tangent.sign = 1;
+		}
+	}
+}
+
 bool
 obj_triangulate(obj_t* obj) {
 	if (!obj)
 		return false;
+
+	size_t total = 0;
+	for (unsigned int igroup = 0, gsize = array_size(obj->group); igroup < gsize; ++igroup) {
+		obj_group_t* group = obj->group[igroup];
+		for (unsigned int isubgroup = 0, sgsize = array_size(group->subgroup); isubgroup < sgsize; ++isubgroup) {
+			obj_subgroup_t* subgroup = group->subgroup[isubgroup];
+			if (!subgroup->triangle.count)
+				total += subgroup->face.count;
+		}
+	}
+
+	size_t done = 0;
+	size_t last_report = 0;
 	for (unsigned int igroup = 0, gsize = array_size(obj->group); igroup < gsize; ++igroup) {
 		obj_group_t* group = obj->group[igroup];
 		for (unsigned int isubgroup = 0, sgsize = array_size(group->subgroup); isubgroup < sgsize; ++isubgroup) {
 			obj_subgroup_t* subgroup = group->subgroup[isubgroup];
 			if (subgroup->triangle.count)
 				continue;
-			if (!obj_triangulate_subgroup(obj, subgroup))
+			if (!obj_triangulate_subgroup(obj, subgroup, &done, total, &last_report))
 				return false;
 		}
 	}
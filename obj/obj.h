@@ -21,6 +21,18 @@
 #include <obj/hashstrings.h>
 
 #include <obj/mesh.h>
+#include <obj/inflate.h>
+#include <obj/optimize.h>
+#include <obj/meshlet.h>
+#include <obj/simplify.h>
+#include <obj/normal.h>
+#include <obj/tangent.h>
+#include <obj/bounds.h>
+#include <obj/bvh.h>
+#include <obj/query.h>
+#include <obj/clean.h>
+#include <obj/validate.h>
+#include <obj/transform.h>
 
 /*! Initialize OBJ library
     \return 0 if success, <0 if error */
@@ -60,13 +72,119 @@ obj_initialize(obj_t* obj);
 OBJ_API void
 obj_finalize(obj_t* obj);
 
-/*! Read OBJ data
+/*! Read OBJ data. Progress is reported through the progress control in the OBJ data
+structure, and if cancelled the data read so far is kept and can be finalized as usual.
+Gzip compressed data is detected and decompressed transparently if the stream is seekable.
+If compressed data is invalid, truncated or fails the CRC32 or size check, the data decoded
+so far is kept and false is returned.
 \param obj Target OBJ data structure
 \param stream Source stream
-\return true if success, false if error */
+\return true if success, false if error, invalid compressed data or cancelled */
 OBJ_API bool
 obj_read(obj_t* obj, stream_t* stream);
 
+/*! Initialize OBJ read state for use with obj_read_append
+\param state Target read state */
+OBJ_API void
+obj_read_state_initialize(obj_read_state_t* state);
+
+/*! Finalize OBJ read state
+\param state Read state */
+OBJ_API void
+obj_read_state_finalize(obj_read_state_t* state);
+
+/*! Read OBJ data appended to the stream since the last call, continuing from the offset,
+group, material and corner state kept in the read state. The first call with a newly
+initialized state reads from the current stream position and resets the OBJ data structure.
+A trailing line without endline is not consumed until it is completed. The current subgroup
+is left open, call obj_read_append_finish once the stream is complete to end it.
+\param obj Target OBJ data structure, must not be modified between calls
+\param stream Source stream
+\param state Read state
+\return true if success, false if error */
+OBJ_API bool
+obj_read_append(obj_t* obj, stream_t* stream, obj_read_state_t* state);
+
+/*! Read the remaining OBJ data of a complete stream, including a trailing line without
+endline, and end the read. The current group and subgroup are closed and the subgroup
+callback of the read options is called for the last subgroup, as at the end of obj_read.
+The read state must be reinitialized before it is used again.
+\param obj Target OBJ data structure
+\param stream Source stream
+\param state Read state
+\return true if success, false if error or cancelled */
+OBJ_API bool
+obj_read_append_finish(obj_t* obj, stream_t* stream, obj_read_state_t* state);
+
+/*! Initialize push based OBJ parser. The read options are kept by the parser in the option
+field of its OBJ data structure and apply to all data fed until the parser is finalized,
+including merge flags, the subgroup callback and the parse time transform.
+\param parser Target parser
+\param option Read options, null for default options */
+OBJ_API void
+obj_parser_initialize(obj_parser_t* parser, const obj_read_options_t* option);
+
+/*! Finalize push based OBJ parser
+\param parser Parser */
+OBJ_API void
+obj_parser_finalize(obj_parser_t* parser);
+
+/*! Feed OBJ data to parser. Data can be split at arbitrary positions, complete lines are
+parsed directly from the given buffer and only a trailing incomplete line is kept by the parser.
+\param parser Parser
+\param data Data buffer
+\param size Size of data buffer
+\return true if success, false if error */
+OBJ_API bool
+obj_parser_feed(obj_parser_t* parser, const void* data, size_t size);
+
+/*! Finish parsing, moving the parsed data to the target OBJ data structure. The progress
+control and read options of the target are kept. The parser is reset, keeping its own
+progress control and read options, and can be used to parse new data.
+\param parser Parser
+\param obj Target OBJ data structure
+\return true if success, false if error */
+OBJ_API bool
+obj_parser_finish(obj_parser_t* parser, obj_t* obj);
+
+/*! Read only the given groups from OBJ data, using an index built by obj_index_build
+to locate the group sections and the attributes they reference
+\param obj Target OBJ data structure
+\param stream Source stream
+\param index Index of source stream
+\param names Group names
+\param count Number of group names
+\return true if success, false if error */
+OBJ_API bool
+obj_read_groups(obj_t* obj, stream_t* stream, const obj_index_t* index, const string_const_t* names, size_t count);
+
+/*! Find group by name. With repeated group names and OBJ_READ_MERGE_GROUPS not set in the
+read flags, the first group with the name is returned.
+\param obj OBJ data structure
+\param name Group name
+\param length Length of group name
+\return Group, null if not found */
+OBJ_API obj_group_t*
+obj_group_find(obj_t* obj, const char* name, size_t length);
+
+/*! Intern a string in the string pool of the OBJ data structure. Identical strings are stored
+once and interned strings can be compared by pointer. Interned strings are valid until the
+OBJ data structure is finalized or read into again.
+\param obj OBJ data structure
+\param str String
+\param length Length of string
+\return Interned string */
+OBJ_API string_const_t
+obj_string_intern(obj_t* obj, const char* str, size_t length);
+
+/*! Find an interned string in the string pool of the OBJ data structure
+\param obj OBJ data structure
+\param str String
+\param length Length of string
+\return Interned string, null string if not interned */
+OBJ_API string_const_t
+obj_string_find(const obj_t* obj, const char* str, size_t length);
+
 /*! Write OBJ data
 \param obj Source OBJ data structure
 \param stream Target stream
@@ -74,8 +192,56 @@ obj_read(obj_t* obj, stream_t* stream);
 OBJ_API bool
 obj_write(const obj_t* obj, stream_t* stream);
 
-/*! Triangulate OBJ data
+/*! Triangulate OBJ data. Progress is reported through the progress control in the OBJ
+data structure, and if cancelled any subgroup not fully triangulated is left untriangulated.
 \param obj Source OBJ data structure
-\return true if successful, false if error */
+\return true if successful, false if error or cancelled */
 OBJ_API bool
 obj_triangulate(obj_t* obj);
+
+/*! Trim unused storage in subgroup arrays, reallocating arrays to a bucket size matching
+their element count. Useful after reading or triangulating when the OBJ data is kept around.
+\param obj OBJ data structure */
+OBJ_API void
+obj_shrink_to_fit(obj_t* obj);
+
+/*! Initialize OBJ index
+\param index Target OBJ index */
+OBJ_API void
+obj_index_initialize(obj_index_t* index);
+
+/*! Finalize OBJ index
+\param index OBJ index */
+OBJ_API void
+obj_index_finalize(obj_index_t* index);
+
+/*! Build index of group and material sections in OBJ data
+\param index Target OBJ index
+\param stream Source stream
+\return true if success, false if error */
+OBJ_API bool
+obj_index_build(obj_index_t* index, stream_t* stream);
+
+/*! Read OBJ index previously stored with obj_index_write. Record counts and string lengths
+are validated against the remaining stream size before any storage is allocated, so the
+size of the stream must be known.
+\param index Target OBJ index
+\param stream Source stream, must be binary
+\return true if success, false if error or invalid data */
+OBJ_API bool
+obj_index_read(obj_index_t* index, stream_t* stream);
+
+/*! Write OBJ index
+\param index Source OBJ index
+\param stream Target stream, must be binary
+\return true if success, false if error */
+OBJ_API bool
+obj_index_write(const obj_index_t* index, stream_t* stream);
+
+/*! Copy vertex data of all corners in a subgroup to a packed vertex array, which together
+with the subgroup triangle array forms an indexed triangle mesh
+\param obj Source OBJ data structure
+\param subgroup Source subgroup
+\param vertices Destination array, must have room for as many vertices as there are corners */
+OBJ_API void
+obj_subgroup_pack(obj_t* obj, obj_subgroup_t* subgroup, obj_packed_vertex_t* vertices);
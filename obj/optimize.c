@@ -0,0 +1,595 @@
+/* optimize.c  -  OBJ library  -  Public Domain  -  2019 Mattias Jansson
+ *
+ * This library provides a cross-platform OBJ I/O library in C11 providing
+ * OBJ ascii reading and writing functionality.
+ *
+ * The latest source code maintained by Mattias Jansson is always available at
+ *
+ * https://github.com/mjansson/obj_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without any
+ * restrictions.
+ *
+ */
+
+#include "optimize.h"
+#include "internal.h"
+
+#include <foundation/array.h>
+#include <foundation/bucketarray.h>
+#include <foundation/memory.h>
+
+#include <foundation/math.h>
+
+//! Size of vertex cache modelled by the Forsyth scoring
+#define FORSYTH_CACHE_SIZE 32
+//! Largest vertex valence with a distinct score
+#define FORSYTH_VALENCE_MAX 32
+
+static unsigned int INVALID_INDEX = 0xFFFFFFFF;
+
+unsigned int*
+obj_subgroup_triangle_indices(const obj_subgroup_t* subgroup) {
+	size_t triangle_count = subgroup->triangle.count;
+	unsigned int* indices = memory_allocate(HASH_OBJ, sizeof(unsigned int) * 3 * (triangle_count ? triangle_count : 1),
+	                                        0, MEMORY_PERSISTENT);
+	for (size_t itri = 0; itri < triangle_count; ++itri) {
+		const obj_triangle_t* triangle = bucketarray_get(&subgroup->triangle, itri);
+		memcpy(indices + (itri * 3), triangle->index, sizeof(unsigned int) * 3);
+	}
+	return indices;
+}
+
+void
+obj_adjacency_initialize(obj_adjacency_t* adjacency, const unsigned int* indices, size_t triangle_count,
+                         size_t vertex_count) {
+	adjacency->live =
+	    memory_allocate(HASH_OBJ, sizeof(unsigned int) * vertex_count, 0, MEMORY_PERSISTENT | MEMORY_ZERO_INITIALIZED);
+	adjacency->offset = memory_allocate(HASH_OBJ, sizeof(unsigned int) * vertex_count, 0, MEMORY_PERSISTENT);
+	adjacency->triangle = memory_allocate(HASH_OBJ, sizeof(unsigned int) * 3 * (triangle_count ? triangle_count : 1),
+	                                      0, MEMORY_PERSISTENT);
+
+	for (size_t iindex = 0; iindex < (triangle_count * 3); ++iindex)
+		++adjacency->live[indices[iindex]];
+
+	unsigned int total = 0;
+	for (size_t ivertex = 0; ivertex < vertex_count; ++ivertex) {
+		adjacency->offset[ivertex] = total;
+		total += adjacency->live[ivertex];
+		adjacency->live[ivertex] = 0;
+	}
+	for (size_t itri = 0; itri < triangle_count; ++itri) {
+		for (unsigned int icorner = 0; icorner < 3; ++icorner) {
+			unsigned int vertex = indices[(itri * 3) + icorner];
+			adjacency->triangle[adjacency->offset[vertex] + adjacency->live[vertex]++] = (unsigned int)itri;
+		}
+	}
+}
+
+void
+obj_adjacency_finalize(obj_adjacency_t* adjacency) {
+	memory_deallocate(adjacency->triangle);
+	memory_deallocate(adjacency->offset);
+	memory_deallocate(adjacency->live);
+	memset(adjacency, 0, sizeof(obj_adjacency_t));
+}
+
+void
+obj_adjacency_remove(obj_adjacency_t* adjacency, unsigned int triangle, const unsigned int* index) {
+	for (unsigned int icorner = 0; icorner < 3; ++icorner) {
+		unsigned int vertex = index[icorner];
+		unsigned int* list = adjacency->triangle + adjacency->offset[vertex];
+		unsigned int live = adjacency->live[vertex];
+		for (unsigned int iadj = 0; iadj < live; ++iadj) {
+			if (list[iadj] == triangle) {
+				list[iadj] = list[live - 1];
+				--adjacency->live[vertex];
+				break;
+			}
+		}
+	}
+}
+
+typedef struct forsyth_score_t {
+	float cache[FORSYTH_CACHE_SIZE];
+	float valence[FORSYTH_VALENCE_MAX + 1];
+} forsyth_score_t;
+
+static void
+forsyth_score_initialize(forsyth_score_t* score) {
+	// Last three vertices used get a fixed score to avoid favouring the triangle just emitted
+	for (unsigned int ipos = 0; ipos < FORSYTH_CACHE_SIZE; ++ipos) {
+		if (ipos < 3)
+			score->cache[ipos] = 0.75f;
+		else
+			score->cache[ipos] = powf(1.0f - ((float)(ipos - 3) / (float)(FORSYTH_CACHE_SIZE - 3)), 1.5f);
+	}
+	// Boost vertices with few remaining triangles to get rid of lone triangles
+	score->valence[0] = 0;
+	for (unsigned int ival = 1; ival <= FORSYTH_VALENCE_MAX; ++ival)
+		score->valence[ival] = 2.0f / sqrtf((float)ival);
+}
+
+static float
+forsyth_vertex_score(const forsyth_score_t* score, int position, unsigned int live) {
+	if (!live)
+		return -1.0f;
+	float value = (position >= 0) ? score->cache[position] : 0.0f;
+	return value + score->valence[(live < FORSYTH_VALENCE_MAX) ? live : FORSYTH_VALENCE_MAX];
+}
+
+//! Simulated FIFO vertex cache. A vertex is in the cache if less than cache size misses
+//! occurred since it was loaded
+typedef struct vertex_cache_t {
+	unsigned int* timestamp;
+	unsigned int time;
+	unsigned int size;
+} vertex_cache_t;
+
+static void
+vertex_cache_initialize(vertex_cache_t* cache, size_t vertex_count, unsigned int cache_size) {
+	cache->timestamp =
+	    memory_allocate(HASH_OBJ, sizeof(unsigned int) * vertex_count, 0, MEMORY_PERSISTENT | MEMORY_ZERO_INITIALIZED);
+	cache->size = cache_size;
+	cache->time = cache_size + 1;
+}
+
+static void
+vertex_cache_finalize(vertex_cache_t* cache) {
+	memory_deallocate(cache->timestamp);
+}
+
+static void
+vertex_cache_reset(vertex_cache_t* cache) {
+	cache->time += cache->size + 1;
+}
+
+static unsigned int
+vertex_cache_triangle(vertex_cache_t* cache, const unsigned int* index) {
+	unsigned int misses = 0;
+	for (unsigned int icorner = 0; icorner < 3; ++icorner) {
+		unsigned int vertex = index[icorner];
+		if ((cache->time - cache->timestamp[vertex]) > cache->size) {
+			cache->timestamp[vertex] = cache->time++;
+			++misses;
+		}
+	}
+	return misses;
+}
+
+static size_t
+obj_subgroup_cache_misses(const obj_subgroup_t* subgroup, unsigned int cache_size) {
+	if (!subgroup->triangle.count || !subgroup->corner.count)
+		return 0;
+
+	vertex_cache_t cache;
+	vertex_cache_initialize(&cache, subgroup->corner.count, cache_size);
+	size_t misses = 0;
+	for (size_t itri = 0, tsize = subgroup->triangle.count; itri < tsize; ++itri) {
+		const obj_triangle_t* triangle = bucketarray_get(&subgroup->triangle, itri);
+		misses += vertex_cache_triangle(&cache, triangle->index);
+	}
+	vertex_cache_finalize(&cache);
+	return misses;
+}
+
+real
+obj_subgroup_acmr(const obj_subgroup_t* subgroup, unsigned int cache_size) {
+	if (!subgroup || !subgroup->triangle.count)
+		return 0;
+	if (!cache_size)
+		cache_size = OBJ_VERTEX_CACHE_SIZE;
+	return (real)obj_subgroup_cache_misses(subgroup, cache_size) / (real)subgroup->triangle.count;
+}
+
+void
+obj_subgroup_optimize_vertex_cache(obj_subgroup_t* subgroup) {
+	size_t triangle_count = subgroup ? subgroup->triangle.count : 0;
+	size_t vertex_count = subgroup ? subgroup->corner.count : 0;
+	if ((triangle_count < 2) || !vertex_count)
+		return;
+
+	forsyth_score_t score;
+	forsyth_score_initialize(&score);
+
+	unsigned int* indices = obj_subgroup_triangle_indices(subgroup);
+	obj_adjacency_t adjacency;
+	obj_adjacency_initialize(&adjacency, indices, triangle_count, vertex_count);
+	unsigned int* live = adjacency.live;
+	float* vertex_score = memory_allocate(HASH_OBJ, sizeof(float) * vertex_count, 0, MEMORY_PERSISTENT);
+	float* triangle_score = memory_allocate(HASH_OBJ, sizeof(float) * triangle_count, 0, MEMORY_PERSISTENT);
+	uint8_t* emitted =
+	    memory_allocate(HASH_OBJ, sizeof(uint8_t) * triangle_count, 0, MEMORY_PERSISTENT | MEMORY_ZERO_INITIALIZED);
+
+	for (size_t ivertex = 0; ivertex < vertex_count; ++ivertex)
+		vertex_score[ivertex] = forsyth_vertex_score(&score, -1, live[ivertex]);
+
+	unsigned int best_triangle = 0;
+	float best_score = -1.0f;
+	for (size_t itri = 0; itri < triangle_count; ++itri) {
+		const unsigned int* triangle = indices + (itri * 3);
+		triangle_score[itri] = vertex_score[triangle[0]] + vertex_score[triangle[1]] + vertex_score[triangle[2]];
+		if (triangle_score[itri] > best_score) {
+			best_score = triangle_score[itri];
+			best_triangle = (unsigned int)itri;
+		}
+	}
+
+	unsigned int cache[FORSYTH_CACHE_SIZE + 3];
+	unsigned int next_cache[FORSYTH_CACHE_SIZE + 3];
+	unsigned int cache_count = 0;
+	size_t next_candidate = 0;
+
+	for (size_t iout = 0; iout < triangle_count; ++iout) {
+		if (best_triangle == INVALID_INDEX) {
+			// No triangle in cache left, continue with next triangle in input order
+			while (emitted[next_candidate])
+				++next_candidate;
+			best_triangle = (unsigned int)next_candidate;
+		}
+
+		const unsigned int* triangle = indices + (best_triangle * 3);
+		obj_triangle_t* output = bucketarray_get(&subgroup->triangle, iout);
+		output->index[0] = triangle[0];
+		output->index[1] = triangle[1];
+		output->index[2] = triangle[2];
+		emitted[best_triangle] = 1;
+		obj_adjacency_remove(&adjacency, best_triangle, triangle);
+
+		unsigned int next_count = 0;
+		for (unsigned int icorner = 0; icorner < 3; ++icorner) {
+			unsigned int vertex = triangle[icorner];
+			bool cached = false;
+			for (unsigned int inext = 0; inext < next_count; ++inext)
+				cached = cached || (next_cache[inext] == vertex);
+			if (!cached)
+				next_cache[next_count++] = vertex;
+		}
+		for (unsigned int icache = 0; icache < cache_count; ++icache) {
+			unsigned int vertex = cache[icache];
+			if ((vertex != triangle[0]) && (vertex != triangle[1]) && (vertex != triangle[2]))
+				next_cache[next_count++] = vertex;
+		}
+
+		// Update scores of vertices in cache and vertices pushed out of cache
+		for (unsigned int inext = 0; inext < next_count; ++inext) {
+			unsigned int vertex = next_cache[inext];
+			int position = (inext < FORSYTH_CACHE_SIZE) ? (int)inext : -1;
+			float vertex_score_new = forsyth_vertex_score(&score, position, live[vertex]);
+			float delta = vertex_score_new - vertex_score[vertex];
+			vertex_score[vertex] = vertex_score_new;
+			const unsigned int* list = adjacency.triangle + adjacency.offset[vertex];
+			for (unsigned int iadj = 0; iadj < live[vertex]; ++iadj)
+				triangle_score[list[iadj]] += delta;
+		}
+
+		cache_count = (next_count < FORSYTH_CACHE_SIZE) ? next_count : FORSYTH_CACHE_SIZE;
+		memcpy(cache, next_cache, sizeof(unsigned int) * cache_count);
+
+		best_triangle = INVALID_INDEX;
+		best_score = -1.0f;
+		for (unsigned int icache = 0; icache < cache_count; ++icache) {
+			unsigned int vertex = cache[icache];
+			const unsigned int* list = adjacency.triangle + adjacency.offset[vertex];
+			for (unsigned int iadj = 0; iadj < live[vertex]; ++iadj) {
+				if (triangle_score[list[iadj]] > best_score) {
+					best_score = triangle_score[list[iadj]];
+					best_triangle = list[iadj];
+				}
+			}
+		}
+	}
+
+	memory_deallocate(emitted);
+	memory_deallocate(triangle_score);
+	memory_deallocate(vertex_score);
+	obj_adjacency_finalize(&adjacency);
+	memory_deallocate(indices);
+}
+
+bool
+obj_optimize_vertex_cache(obj_t* obj, obj_vertex_cache_stats_t* stats) {
+	if (!obj)
+		return false;
+
+	unsigned int cache_size = (stats && stats->cache_size) ? stats->cache_size : OBJ_VERTEX_CACHE_SIZE;
+	size_t triangle_count = 0;
+	size_t misses_before = 0;
+	size_t misses_after = 0;
+	for (size_t igroup = 0, gsize = array_size(obj->group); igroup < gsize; ++igroup) {
+		obj_group_t* group = obj->group[igroup];
+		for (size_t isub = 0, sgsize = array_size(group->subgroup); isub < sgsize; ++isub) {
+			obj_subgroup_t* subgroup = group->subgroup[isub];
+			if (stats)
+				misses_before += obj_subgroup_cache_misses(subgroup, cache_size);
+			obj_subgroup_optimize_vertex_cache(subgroup);
+			if (stats)
+				misses_after += obj_subgroup_cache_misses(subgroup, cache_size);
+			triangle_count += subgroup->triangle.count;
+		}
+	}
+
+	if (stats) {
+		stats->acmr_before = triangle_count ? (real)misses_before / (real)triangle_count : 0;
+		stats->acmr_after = triangle_count ? (real)misses_after / (real)triangle_count : 0;
+	}
+
+	return true;
+}
+
+typedef struct overdraw_cluster_t {
+	//! First triangle in cluster
+	unsigned int start;
+	//! Number of triangles in cluster
+	unsigned int count;
+	//! Occlusion potential, clusters facing away from the subgroup center are drawn first
+	real sort_key;
+} overdraw_cluster_t;
+
+static int
+overdraw_cluster_compare(const void* lhs, const void* rhs) {
+	const overdraw_cluster_t* lhs_cluster = lhs;
+	const overdraw_cluster_t* rhs_cluster = rhs;
+	if (lhs_cluster->sort_key != rhs_cluster->sort_key)
+		return (lhs_cluster->sort_key > rhs_cluster->sort_key) ? -1 : 1;
+	return (lhs_cluster->start < rhs_cluster->start) ? -1 : 1;
+}
+
+static const obj_vertex_t*
+overdraw_position(const obj_t* obj, const obj_subgroup_t* subgroup, unsigned int corner_index) {
+	const obj_corner_t* corner = bucketarray_get(&subgroup->corner, corner_index);
+	return bucketarray_get(&obj->vertex, corner->vertex - 1);
+}
+
+//! Accumulate area weighted centroid and normal of triangles, normal length is twice the area
+static void
+overdraw_accumulate(const obj_t* obj, const obj_subgroup_t* subgroup, const unsigned int* indices, size_t start,
+                    size_t count, real* centroid, real* normal) {
+	real area_sum = 0;
+	real centroid_sum[3] = {0, 0, 0};
+	real plain_sum[3] = {0, 0, 0};
+	normal[0] = normal[1] = normal[2] = 0;
+	for (size_t itri = start; itri < (start + count); ++itri) {
+		const obj_vertex_t* v0 = overdraw_position(obj, subgroup, indices[(itri * 3) + 0]);
+		const obj_vertex_t* v1 = overdraw_position(obj, subgroup, indices[(itri * 3) + 1]);
+		const obj_vertex_t* v2 = overdraw_position(obj, subgroup, indices[(itri * 3) + 2]);
+		real e1[3] = {v1->x - v0->x, v1->y - v0->y, v1->z - v0->z};
+		real e2[3] = {v2->x - v0->x, v2->y - v0->y, v2->z - v0->z};
+		real n[3] = {(e1[1] * e2[2]) - (e1[2] * e2[1]), (e1[2] * e2[0]) - (e1[0] * e2[2]),
+		             (e1[0] * e2[1]) - (e1[1] * e2[0])};
+		real area = math_sqrt((n[0] * n[0]) + (n[1] * n[1]) + (n[2] * n[2]));
+		real center[3] = {(v0->x + v1->x + v2->x) / REAL_C(3.0), (v0->y + v1->y + v2->y) / REAL_C(3.0),
+		                  (v0->z + v1->z + v2->z) / REAL_C(3.0)};
+		for (unsigned int iaxis = 0; iaxis < 3; ++iaxis) {
+			normal[iaxis] += n[iaxis];
+			centroid_sum[iaxis] += center[iaxis] * area;
+			plain_sum[iaxis] += center[iaxis];
+		}
+		area_sum += area;
+	}
+	for (unsigned int iaxis = 0; iaxis < 3; ++iaxis) {
+		if (area_sum > 0)
+			centroid[iaxis] = centroid_sum[iaxis] / area_sum;
+		else
+			centroid[iaxis] = count ? plain_sum[iaxis] / (real)count : 0;
+	}
+}
+
+void
+obj_subgroup_optimize_overdraw(const obj_t* obj, obj_subgroup_t* subgroup, real threshold) {
+	size_t triangle_count = subgroup ? subgroup->triangle.count : 0;
+	if (!obj || (triangle_count < 2) || !subgroup->corner.count)
+		return;
+	if (threshold < 1)
+		threshold = 1;
+
+	unsigned int* indices = obj_subgroup_triangle_indices(subgroup);
+
+	vertex_cache_t cache;
+	vertex_cache_initialize(&cache, subgroup->corner.count, OBJ_VERTEX_CACHE_SIZE);
+
+	// Hard cluster boundaries where the cache order restarts with all three vertices missing
+	unsigned int* hard_boundary = nullptr;
+	for (size_t itri = 0; itri < triangle_count; ++itri) {
+		if ((vertex_cache_triangle(&cache, indices + (itri * 3)) == 3) || !itri)
+			array_push(hard_boundary, (unsigned int)itri);
+	}
+	array_push(hard_boundary, (unsigned int)triangle_count);
+
+	// Split hard clusters further where the cache miss ratio of the cluster so far is within
+	// the threshold of the miss ratio of the entire hard cluster
+	overdraw_cluster_t* cluster = nullptr;
+	for (size_t ihard = 0, hsize = array_size(hard_boundary) - 1; ihard < hsize; ++ihard) {
+		unsigned int start = hard_boundary[ihard];
+		unsigned int end = hard_boundary[ihard + 1];
+
+		vertex_cache_reset(&cache);
+		size_t misses = 0;
+		for (unsigned int itri = start; itri < end; ++itri)
+			misses += vertex_cache_triangle(&cache, indices + (itri * 3));
+		real limit = ((real)misses / (real)(end - start)) * threshold;
+
+		vertex_cache_reset(&cache);
+		misses = 0;
+		unsigned int cluster_start = start;
+		for (unsigned int itri = start; itri < end; ++itri) {
+			misses += vertex_cache_triangle(&cache, indices + (itri * 3));
+			if ((itri + 1) < end && (((real)misses / (real)(itri + 1 - cluster_start)) <= limit)) {
+				overdraw_cluster_t next = {cluster_start, itri + 1 - cluster_start, 0};
+				array_push(cluster, next);
+				cluster_start = itri + 1;
+				misses = 0;
+				vertex_cache_reset(&cache);
+			}
+		}
+		overdraw_cluster_t last = {cluster_start, end - cluster_start, 0};
+		array_push(cluster, last);
+	}
+
+	real center[3];
+	real normal[3];
+	overdraw_accumulate(obj, subgroup, indices, 0, triangle_count, center, normal);
+
+	size_t cluster_count = array_size(cluster);
+	for (size_t icluster = 0; icluster < cluster_count; ++icluster) {
+		real centroid[3];
+		overdraw_accumulate(obj, subgroup, indices, cluster[icluster].start, cluster[icluster].count, centroid, normal);
+		real length = math_sqrt((normal[0] * normal[0]) + (normal[1] * normal[1]) + (normal[2] * normal[2]));
+		real dot = 0;
+		for (unsigned int iaxis = 0; iaxis < 3; ++iaxis)
+			dot += (centroid[iaxis] - center[iaxis]) * normal[iaxis];
+		cluster[icluster].sort_key = (length > 0) ? (dot / length) : 0;
+	}
+
+	qsort(cluster, cluster_count, sizeof(overdraw_cluster_t), overdraw_cluster_compare);
+
+	size_t output = 0;
+	for (size_t icluster = 0; icluster < cluster_count; ++icluster) {
+		for (unsigned int itri = 0; itri < cluster[icluster].count; ++itri, ++output) {
+			obj_triangle_t* triangle = bucketarray_get(&subgroup->triangle, output);
+			memcpy(triangle->index, indices + ((cluster[icluster].start + itri) * 3), sizeof(unsigned int) * 3);
+		}
+	}
+
+	array_deallocate(cluster);
+	array_deallocate(hard_boundary);
+	vertex_cache_finalize(&cache);
+	memory_deallocate(indices);
+}
+
+bool
+obj_optimize_overdraw(obj_t* obj, real threshold) {
+	if (!obj)
+		return false;
+
+	for (size_t igroup = 0, gsize = array_size(obj->group); igroup < gsize; ++igroup) {
+		obj_group_t* group = obj->group[igroup];
+		for (size_t isub = 0, sgsize = array_size(group->subgroup); isub < sgsize; ++isub)
+			obj_subgroup_optimize_overdraw(obj, group->subgroup[isub], threshold);
+	}
+
+	return true;
+}
+
+//! Move element i of array to position remap[i], remap must be a permutation
+static void
+bucketarray_permute(bucketarray_t* array, const unsigned int* remap) {
+	bucketarray_t permuted;
+	bucketarray_initialize(&permuted, array->element_size, array->bucket_size);
+	bucketarray_resize(&permuted, array->count);
+	for (size_t ielement = 0, esize = array->count; ielement < esize; ++ielement)
+		memcpy(bucketarray_get(&permuted, remap[ielement]), bucketarray_get(array, ielement), array->element_size);
+	bucketarray_finalize(array);
+	*array = permuted;
+}
+
+//! Assign new indices to elements not referenced, keeping their relative order
+static unsigned int
+remap_unreferenced(unsigned int* remap, size_t count, unsigned int next) {
+	for (size_t ielement = 0; ielement < count; ++ielement) {
+		if (remap[ielement] == INVALID_INDEX)
+			remap[ielement] = next++;
+	}
+	return next;
+}
+
+void
+obj_subgroup_optimize_vertex_fetch(obj_subgroup_t* subgroup) {
+	size_t corner_count = subgroup ? subgroup->corner.count : 0;
+	if (!corner_count)
+		return;
+
+	unsigned int* remap = memory_allocate(HASH_OBJ, sizeof(unsigned int) * corner_count, 0, MEMORY_PERSISTENT);
+	memset(remap, 0xFF, sizeof(unsigned int) * corner_count);
+
+	unsigned int next = 0;
+	for (size_t itri = 0, tsize = subgroup->triangle.count; itri < tsize; ++itri) {
+		obj_triangle_t* triangle = bucketarray_get(&subgroup->triangle, itri);
+		for (unsigned int icorner = 0; icorner < 3; ++icorner) {
+			unsigned int corner = triangle->index[icorner];
+			if (remap[corner] == INVALID_INDEX)
+				remap[corner] = next++;
+			triangle->index[icorner] = remap[corner];
+		}
+	}
+	remap_unreferenced(remap, corner_count, next);
+
+	for (size_t iindex = 0, isize = subgroup->index.count; iindex < isize; ++iindex) {
+		unsigned int* index = bucketarray_get(&subgroup->index, iindex);
+		*index = remap[*index];
+	}
+	for (size_t icorner = 0; icorner < corner_count; ++icorner) {
+		obj_corner_t* corner = bucketarray_get(&subgroup->corner, icorner);
+		if (corner->next >= 0)
+			corner->next = (int)remap[corner->next];
+	}
+	bucketarray_permute(&subgroup->corner, remap);
+
+	memory_deallocate(remap);
+}
+
+//! Renumber attribute array by first use in triangle order of all subgroups
+static void
+obj_optimize_attribute_fetch(obj_t* obj, bucketarray_t* attribute, size_t corner_offset) {
+	size_t count = attribute->count;
+	if (!count)
+		return;
+
+	unsigned int* remap = memory_allocate(HASH_OBJ, sizeof(unsigned int) * count, 0, MEMORY_PERSISTENT);
+	memset(remap, 0xFF, sizeof(unsigned int) * count);
+
+	// Corner attribute indices are one-based with zero for no attribute
+	unsigned int next = 0;
+	for (size_t igroup = 0, gsize = array_size(obj->group); igroup < gsize; ++igroup) {
+		obj_group_t* group = obj->group[igroup];
+		for (size_t isub = 0, sgsize = array_size(group->subgroup); isub < sgsize; ++isub) {
+			obj_subgroup_t* subgroup = group->subgroup[isub];
+			for (size_t itri = 0, tsize = subgroup->triangle.count; itri < tsize; ++itri) {
+				const obj_triangle_t* triangle = bucketarray_get(&subgroup->triangle, itri);
+				for (unsigned int icorner = 0; icorner < 3; ++icorner) {
+					const obj_corner_t* corner = bucketarray_get(&subgroup->corner, triangle->index[icorner]);
+					unsigned int value = *(const unsigned int*)pointer_offset_const(corner, corner_offset);
+					if (value && (remap[value - 1] == INVALID_INDEX))
+						remap[value - 1] = next++;
+				}
+			}
+		}
+	}
+	remap_unreferenced(remap, count, next);
+
+	for (size_t igroup = 0, gsize = array_size(obj->group); igroup < gsize; ++igroup) {
+		obj_group_t* group = obj->group[igroup];
+		for (size_t isub = 0, sgsize = array_size(group->subgroup); isub < sgsize; ++isub) {
+			obj_subgroup_t* subgroup = group->subgroup[isub];
+			for (size_t icorner = 0, csize = subgroup->corner.count; icorner < csize; ++icorner) {
+				unsigned int* value = pointer_offset(bucketarray_get(&subgroup->corner, icorner), corner_offset);
+				if (*value)
+					*value = remap[*value - 1] + 1;
+			}
+		}
+	}
+	bucketarray_permute(attribute, remap);
+
+	memory_deallocate(remap);
+}
+
+bool
+obj_optimize_vertex_fetch(obj_t* obj, bool attributes) {
+	if (!obj)
+		return false;
+
+	for (size_t igroup = 0, gsize = array_size(obj->group); igroup < gsize; ++igroup) {
+		obj_group_t* group = obj->group[igroup];
+		for (size_t isub = 0, sgsize = array_size(group->subgroup); isub < sgsize; ++isub)
+			obj_subgroup_optimize_vertex_fetch(group->subgroup[isub]);
+	}
+
+	if (attributes) {
+		obj_optimize_attribute_fetch(obj, &obj->vertex, offsetof(obj_corner_t, vertex));
+		obj_optimize_attribute_fetch(obj, &obj->normal, offsetof(obj_corner_t, normal));
+		obj_optimize_attribute_fetch(obj, &obj->uv, offsetof(obj_corner_t, uv));
+		obj_optimize_attribute_fetch(obj, &obj->tangent, offsetof(obj_corner_t, tangent));
+	}
+
+	return true;
+}
@@ -0,0 +1,86 @@
+/* optimize.h  -  OBJ library  -  Public Domain  -  2019 Mattias Jansson
+ *
+ * This library provides a cross-platform OBJ I/O library in C11 providing
+ * OBJ ascii reading and writing functionality.
+ *
+ * The latest source code maintained by Mattias Jansson is always available at
+ *
+ * https://github.com/mjansson/obj_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without any
+ * restrictions.
+ *
+ */
+
+#pragma once
+
+/*! \file optimize.h
+    Triangle and vertex order optimization */
+
+#include <obj/types.h>
+#include <obj/hashstrings.h>
+
+//! Default size of simulated FIFO vertex cache
+#define OBJ_VERTEX_CACHE_SIZE 16
+
+//! Default cache miss ratio tolerance for overdraw optimization, relative to cache order
+#define OBJ_OVERDRAW_THRESHOLD REAL_C(1.05)
+
+/*! Calculate average cache miss ratio of subgroup triangles, the number of vertices
+transformed per triangle with a simulated FIFO vertex cache. Each corner is a vertex.
+\param subgroup Subgroup
+\param cache_size Size of simulated cache, 0 for default
+\return Average cache miss ratio, between 0.5 and 3 for non-empty subgroups */
+OBJ_API real
+obj_subgroup_acmr(const obj_subgroup_t* subgroup, unsigned int cache_size);
+
+/*! Reorder subgroup triangles to improve post-transform vertex cache hit rate, using a
+linear time implementation of the Forsyth algorithm. Triangles are not modified other than
+by order, winding is preserved.
+\param subgroup Subgroup */
+OBJ_API void
+obj_subgroup_optimize_vertex_cache(obj_subgroup_t* subgroup);
+
+/*! Reorder triangles of all subgroups to improve post-transform vertex cache hit rate.
+Subgroups must be triangulated by obj_triangulate.
+\param obj OBJ data structure
+\param stats Optional cache statistics, cache size is read and ACMR before and after
+optimization over all subgroups is written
+\return true if success, false if error */
+OBJ_API bool
+obj_optimize_vertex_cache(obj_t* obj, obj_vertex_cache_stats_t* stats);
+
+/*! Reorder subgroup triangles to reduce overdraw. The triangle order is split into clusters,
+at points where the vertex cache restarts and at points where the cache miss ratio of the
+cluster is within the threshold of the unsplit order. Clusters are then sorted by view
+independent occlusion potential, the distance of the cluster centroid from the subgroup
+centroid along the cluster normal. Run after vertex cache optimization.
+\param obj OBJ data structure owning the subgroup
+\param subgroup Subgroup
+\param threshold Tolerated cache miss ratio increase factor, 1 or greater */
+OBJ_API void
+obj_subgroup_optimize_overdraw(const obj_t* obj, obj_subgroup_t* subgroup, real threshold);
+
+/*! Reorder triangles of all subgroups to reduce overdraw, see obj_subgroup_optimize_overdraw
+\param obj OBJ data structure
+\param threshold Tolerated cache miss ratio increase factor, 1 or greater
+\return true if success, false if error */
+OBJ_API bool
+obj_optimize_overdraw(obj_t* obj, real threshold);
+
+/*! Renumber subgroup corners by first use in triangle order, rewriting triangle and face
+indices, for sequential memory access when fetching vertex data. Corners not used by any
+triangle are placed last. Must not be used on a subgroup still being read.
+\param subgroup Subgroup */
+OBJ_API void
+obj_subgroup_optimize_vertex_fetch(obj_subgroup_t* subgroup);
+
+/*! Renumber corners of all subgroups by first use in triangle order, and optionally renumber
+vertex, normal, UV and tangent arrays by first use in group, subgroup and triangle order. Attributes
+not used by any triangle are placed last. Run after any triangle order optimization. Must
+not be used on an OBJ data structure still being read.
+\param obj OBJ data structure
+\param attributes Flag indicating if attribute arrays should be renumbered
+\return true if success, false if error */
+OBJ_API bool
+obj_optimize_vertex_fetch(obj_t* obj, bool attributes);
@@ -0,0 +1,453 @@
+/* query.c   -  OBJ library  -  Public Domain  -  2019 Mattias Jansson
+ *
+ * This library provides a cross-platform OBJ I/O library in C11 providing
+ * OBJ ascii reading and writing functionality.
+ *
+ * The latest source code maintained by Mattias Jansson is always available at
+ *
+ * https://github.com/mjansson/obj_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without any
+ * restrictions.
+ *
+ */
+
+#include "query.h"
+#include "internal.h"
+
+#include <foundation/array.h>
+#include <foundation/bucketarray.h>
+#include <foundation/math.h>
+
+static unsigned int INVALID_INDEX = 0xFFFFFFFF;
+
+//! Number of node indices kept on the call stack during traversal before spilling to heap
+#define QUERY_STACK_LOCAL 64
+
+//! Number of query points in each parallel task of batched closest point queries
+#define QUERY_POINT_BATCH 64
+
+//! Traversal stack of node indices
+typedef struct query_stack_t {
+	unsigned int local[QUERY_STACK_LOCAL];
+	unsigned int* spill;
+	unsigned int size;
+} query_stack_t;
+
+//! Rays traversing the BVH together, stored per axis for vectorization
+typedef struct query_packet_t {
+	unsigned int count;
+	real origin[3][OBJ_RAY_PACKET_SIZE];
+	real direction[3][OBJ_RAY_PACKET_SIZE];
+	real inverse[3][OBJ_RAY_PACKET_SIZE];
+	real distance[OBJ_RAY_PACKET_SIZE];
+	unsigned int primitive[OBJ_RAY_PACKET_SIZE];
+	real u[OBJ_RAY_PACKET_SIZE];
+	real v[OBJ_RAY_PACKET_SIZE];
+} query_packet_t;
+
+typedef struct query_batch_t {
+	const obj_t* obj;
+	const obj_bvh_t* bvh;
+	const obj_ray_t* ray;
+	const obj_vertex_t* point;
+	size_t count;
+	obj_hit_t* hit;
+} query_batch_t;
+
+static void
+query_stack_push(query_stack_t* stack, unsigned int node) {
+	if (stack->size < QUERY_STACK_LOCAL)
+		stack->local[stack->size] = node;
+	else
+		array_push(stack->spill, node);
+	++stack->size;
+}
+
+static unsigned int
+query_stack_pop(query_stack_t* stack) {
+	--stack->size;
+	if (stack->size < QUERY_STACK_LOCAL)
+		return stack->local[stack->size];
+	unsigned int node = stack->spill[array_size(stack->spill) - 1];
+	array_pop(stack->spill);
+	return node;
+}
+
+//! Get corners and vertex coordinates of the triangle referenced by a primitive
+static void
+query_triangle(const obj_t* obj, const obj_bvh_primitive_t* primitive, unsigned int* corner, real (*coord)[3]) {
+	const obj_subgroup_t* subgroup = obj->group[primitive->group]->subgroup[primitive->subgroup];
+	const obj_triangle_t* triangle = bucketarray_get(&subgroup->triangle, primitive->triangle);
+	for (int icorner = 0; icorner < 3; ++icorner) {
+		corner[icorner] = triangle->index[icorner];
+		const obj_corner_t* source = bucketarray_get(&subgroup->corner, corner[icorner]);
+		const obj_vertex_t* vertex = bucketarray_get(&obj->vertex, source->vertex - 1);
+		coord[icorner][0] = vertex->x;
+		coord[icorner][1] = vertex->y;
+		coord[icorner][2] = vertex->z;
+	}
+}
+
+static void
+query_hit_fill(const obj_t* obj, const obj_bvh_primitive_t* primitive, real u, real v, real distance, obj_hit_t* hit) {
+	real coord[3][3];
+	query_triangle(obj, primitive, hit->corner, coord);
+	hit->group = primitive->group;
+	hit->subgroup = primitive->subgroup;
+	hit->face = primitive->face;
+	hit->triangle = primitive->triangle;
+	hit->barycentric[0] = REAL_C(1.0) - u - v;
+	hit->barycentric[1] = u;
+	hit->barycentric[2] = v;
+	hit->point.x = (hit->barycentric[0] * coord[0][0]) + (u * coord[1][0]) + (v * coord[2][0]);
+	hit->point.y = (hit->barycentric[0] * coord[0][1]) + (u * coord[1][1]) + (v * coord[2][1]);
+	hit->point.z = (hit->barycentric[0] * coord[0][2]) + (u * coord[1][2]) + (v * coord[2][2]);
+	hit->distance = distance;
+}
+
+static void
+query_hit_clear(obj_hit_t* hit) {
+	memset(hit, 0, sizeof(obj_hit_t));
+	hit->group = hit->subgroup = hit->face = hit->triangle = INVALID_INDEX;
+	hit->distance = -REAL_C(1.0);
+}
+
+/*! Test node bounds against all rays in packet
+\return true if any ray intersects the node within its current distance */
+static bool
+query_packet_node(const query_packet_t* packet, const obj_bvh_node_t* node) {
+	bool any = false;
+	for (unsigned int iray = 0; iray < packet->count; ++iray) {
+		real range_min = 0;
+		real range_max = packet->distance[iray];
+		for (int axis = 0; axis < 3; ++axis) {
+			real t0 = ((real)node->min[axis] - packet->origin[axis][iray]) * packet->inverse[axis][iray];
+			real t1 = ((real)node->max[axis] - packet->origin[axis][iray]) * packet->inverse[axis][iray];
+			real slab_near = (t0 < t1) ? t0 : t1;
+			real slab_far = (t0 < t1) ? t1 : t0;
+			range_min = (slab_near > range_min) ? slab_near : range_min;
+			range_max = (slab_far < range_max) ? slab_far : range_max;
+		}
+		any |= (range_min <= range_max);
+	}
+	return any;
+}
+
+//! Intersect triangle with all rays in packet, recording hits closer than current distance
+static void
+query_packet_triangle(query_packet_t* packet, const real (*coord)[3], unsigned int primitive) {
+	real edge1[3] = {coord[1][0] - coord[0][0], coord[1][1] - coord[0][1], coord[1][2] - coord[0][2]};
+	real edge2[3] = {coord[2][0] - coord[0][0], coord[2][1] - coord[0][1], coord[2][2] - coord[0][2]};
+	for (unsigned int iray = 0; iray < packet->count; ++iray) {
+		real dx = packet->direction[0][iray];
+		real dy = packet->direction[1][iray];
+		real dz = packet->direction[2][iray];
+		real p[3] = {(dy * edge2[2]) - (dz * edge2[1]), (dz * edge2[0]) - (dx * edge2[2]),
+		             (dx * edge2[1]) - (dy * edge2[0])};
+		real det = (edge1[0] * p[0]) + (edge1[1] * p[1]) + (edge1[2] * p[2]);
+		if (det == 0)
+			continue;
+		real inv_det = REAL_C(1.0) / det;
+		real s[3] = {packet->origin[0][iray] - coord[0][0], packet->origin[1][iray] - coord[0][1],
+		             packet->origin[2][iray] - coord[0][2]};
+		real u = ((s[0] * p[0]) + (s[1] * p[1]) + (s[2] * p[2])) * inv_det;
+		if ((u < 0) || (u > 1))
+			continue;
+		real q[3] = {(s[1] * edge1[2]) - (s[2] * edge1[1]), (s[2] * edge1[0]) - (s[0] * edge1[2]),
+		             (s[0] * edge1[1]) - (s[1] * edge1[0])};
+		real v = ((dx * q[0]) + (dy * q[1]) + (dz * q[2])) * inv_det;
+		if ((v < 0) || ((u + v) > 1))
+			continue;
+		real t = ((edge2[0] * q[0]) + (edge2[1] * q[1]) + (edge2[2] * q[2])) * inv_det;
+		if ((t < 0) || (t > packet->distance[iray]))
+			continue;
+		packet->distance[iray] = t;
+		packet->primitive[iray] = primitive;
+		packet->u[iray] = u;
+		packet->v[iray] = v;
+	}
+}
+
+static void
+query_packet_traverse(const obj_t* obj, const obj_bvh_t* bvh, query_packet_t* packet) {
+	for (unsigned int iray = 0; iray < packet->count; ++iray)
+		packet->primitive[iray] = INVALID_INDEX;
+	if (!array_size(bvh->node))
+		return;
+
+	query_stack_t stack;
+	stack.spill = nullptr;
+	stack.size = 0;
+	query_stack_push(&stack, 0);
+	while (stack.size) {
+		const obj_bvh_node_t* node = bvh->node + query_stack_pop(&stack);
+		if (!query_packet_node(packet, node))
+			continue;
+
+		if (node->count) {
+			for (unsigned int iprim = node->offset, pend = node->offset + node->count; iprim < pend; ++iprim) {
+				unsigned int corner[3];
+				real coord[3][3];
+				query_triangle(obj, bvh->primitive + iprim, corner, coord);
+				query_packet_triangle(packet, (const real(*)[3])coord, iprim);
+			}
+			continue;
+		}
+
+		// Visit the child nearer along the direction of the first ray first, along the axis
+		// separating the children the most
+		const obj_bvh_node_t* child = bvh->node + node->offset;
+		real split_magnitude = -REAL_C(1.0);
+		bool second_first = false;
+		for (int axis = 0; axis < 3; ++axis) {
+			real separation = ((real)child[1].min[axis] + (real)child[1].max[axis]) -
+			                  ((real)child[0].min[axis] + (real)child[0].max[axis]);
+			real magnitude = (separation < 0) ? -separation : separation;
+			if (magnitude > split_magnitude) {
+				split_magnitude = magnitude;
+				second_first = ((separation < 0) != (packet->direction[axis][0] < 0));
+			}
+		}
+		if (second_first) {
+			query_stack_push(&stack, node->offset);
+			query_stack_push(&stack, node->offset + 1);
+		} else {
+			query_stack_push(&stack, node->offset + 1);
+			query_stack_push(&stack, node->offset);
+		}
+	}
+	array_deallocate(stack.spill);
+}
+
+static void
+query_packet_load(query_packet_t* packet, const obj_ray_t* ray, size_t count) {
+	packet->count = (unsigned int)count;
+	for (unsigned int iray = 0; iray < packet->count; ++iray) {
+		const real origin[3] = {ray[iray].origin.x, ray[iray].origin.y, ray[iray].origin.z};
+		const real direction[3] = {ray[iray].direction.nx, ray[iray].direction.ny, ray[iray].direction.nz};
+		for (int axis = 0; axis < 3; ++axis) {
+			packet->origin[axis][iray] = origin[axis];
+			packet->direction[axis][iray] = direction[axis];
+			// Avoid infinite inverse, which gives NaN slab distances for rays starting on a slab plane
+			packet->inverse[axis][iray] = (direction[axis] != 0) ? REAL_C(1.0) / direction[axis] : REAL_MAX;
+		}
+		packet->distance[iray] = ray[iray].max_distance;
+	}
+}
+
+static void
+query_packet_store(const obj_t* obj, const obj_bvh_t* bvh, const query_packet_t* packet, obj_hit_t* hit) {
+	for (unsigned int iray = 0; iray < packet->count; ++iray) {
+		if (packet->primitive[iray] == INVALID_INDEX)
+			query_hit_clear(hit + iray);
+		else
+			query_hit_fill(obj, bvh->primitive + packet->primitive[iray], packet->u[iray], packet->v[iray],
+			               packet->distance[iray], hit + iray);
+	}
+}
+
+bool
+obj_raycast(const obj_t* obj, const obj_bvh_t* bvh, const obj_vertex_t* origin, const obj_normal_t* direction,
+            obj_hit_t* hit) {
+	if (!hit)
+		return false;
+	query_hit_clear(hit);
+	if (!obj || !bvh || !origin || !direction)
+		return false;
+
+	obj_ray_t ray = {*origin, *direction, REAL_MAX};
+	query_packet_t packet;
+	query_packet_load(&packet, &ray, 1);
+	query_packet_traverse(obj, bvh, &packet);
+	query_packet_store(obj, bvh, &packet, hit);
+	return (hit->distance >= 0);
+}
+
+static void
+query_raycast_packet(void* context, size_t index) {
+	query_batch_t* batch = context;
+	size_t offset = index * OBJ_RAY_PACKET_SIZE;
+	size_t count = batch->count - offset;
+	if (count > OBJ_RAY_PACKET_SIZE)
+		count = OBJ_RAY_PACKET_SIZE;
+
+	query_packet_t packet;
+	query_packet_load(&packet, batch->ray + offset, count);
+	query_packet_traverse(batch->obj, batch->bvh, &packet);
+	query_packet_store(batch->obj, batch->bvh, &packet, batch->hit + offset);
+}
+
+size_t
+obj_raycast_batch(const obj_t* obj, const obj_bvh_t* bvh, const obj_ray_t* ray, size_t count, obj_hit_t* hit) {
+	if (!obj || !bvh || !ray || !hit)
+		return 0;
+
+	query_batch_t batch = {obj, bvh, ray, nullptr, count, hit};
+	obj_parallel_for((count + OBJ_RAY_PACKET_SIZE - 1) / OBJ_RAY_PACKET_SIZE, query_raycast_packet, &batch);
+
+	size_t hit_count = 0;
+	for (size_t iray = 0; iray < count; ++iray) {
+		if (hit[iray].distance >= 0)
+			++hit_count;
+	}
+	return hit_count;
+}
+
+//! Squared distance from point to node bounds, zero if inside
+static real
+query_node_distance_squared(const obj_bvh_node_t* node, const real* point) {
+	real distance_squared = 0;
+	for (int axis = 0; axis < 3; ++axis) {
+		real delta = 0;
+		if (point[axis] < (real)node->min[axis])
+			delta = (real)node->min[axis] - point[axis];
+		else if (point[axis] > (real)node->max[axis])
+			delta = point[axis] - (real)node->max[axis];
+		distance_squared += delta * delta;
+	}
+	return distance_squared;
+}
+
+static real
+query_dot(const real* lhs, const real* rhs) {
+	return (lhs[0] * rhs[0]) + (lhs[1] * rhs[1]) + (lhs[2] * rhs[2]);
+}
+
+/*! Find closest point on triangle by testing the Voronoi regions of the triangle corners
+and edges before the interior
+\return Squared distance to closest point */
+static real
+query_closest_on_triangle(const real (*coord)[3], const real* point, real* barycentric) {
+	real ab[3] = {coord[1][0] - coord[0][0], coord[1][1] - coord[0][1], coord[1][2] - coord[0][2]};
+	real ac[3] = {coord[2][0] - coord[0][0], coord[2][1] - coord[0][1], coord[2][2] - coord[0][2]};
+	real ap[3] = {point[0] - coord[0][0], point[1] - coord[0][1], point[2] - coord[0][2]};
+	real bp[3] = {point[0] - coord[1][0], point[1] - coord[1][1], point[2] - coord[1][2]};
+	real cp[3] = {point[0] - coord[2][0], point[1] - coord[2][1], point[2] - coord[2][2]};
+	real d1 = query_dot(ab, ap);
+	real d2 = query_dot(ac, ap);
+	real d3 = query_dot(ab, bp);
+	real d4 = query_dot(ac, bp);
+	real d5 = query_dot(ab, cp);
+	real d6 = query_dot(ac, cp);
+	real vc = (d1 * d4) - (d3 * d2);
+	real vb = (d5 * d2) - (d1 * d6);
+	real va = (d3 * d6) - (d5 * d4);
+
+	real v = 0;
+	real w = 0;
+	if ((d1 <= 0) && (d2 <= 0)) {
+		// Corner 0
+	} else if ((d3 >= 0) && (d4 <= d3)) {
+		v = 1;
+	} else if ((d6 >= 0) && (d5 <= d6)) {
+		w = 1;
+	} else if ((vc <= 0) && (d1 >= 0) && (d3 <= 0)) {
+		v = d1 / (d1 - d3);
+	} else if ((vb <= 0) && (d2 >= 0) && (d6 <= 0)) {
+		w = d2 / (d2 - d6);
+	} else if ((va <= 0) && ((d4 - d3) >= 0) && ((d5 - d6) >= 0)) {
+		w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+		v = 1 - w;
+	} else if ((va + vb + vc) > 0) {
+		real denom = REAL_C(1.0) / (va + vb + vc);
+		v = vb * denom;
+		w = vc * denom;
+	}
+
+	barycentric[0] = REAL_C(1.0) - v - w;
+	barycentric[1] = v;
+	barycentric[2] = w;
+	real distance_squared = 0;
+	for (int axis = 0; axis < 3; ++axis) {
+		real closest = (barycentric[0] * coord[0][axis]) + (v * coord[1][axis]) + (w * coord[2][axis]);
+		distance_squared += (closest - point[axis]) * (closest - point[axis]);
+	}
+	return distance_squared;
+}
+
+bool
+obj_closest_point(const obj_t* obj, const obj_bvh_t* bvh, const obj_vertex_t* point, obj_hit_t* result) {
+	if (!result)
+		return false;
+	query_hit_clear(result);
+	if (!obj || !bvh || !point || !array_size(bvh->node))
+		return false;
+
+	const real coord_point[3] = {point->x, point->y, point->z};
+	real best_distance_squared = REAL_MAX;
+	unsigned int best_primitive = INVALID_INDEX;
+	real best_barycentric[3] = {0};
+
+	query_stack_t stack;
+	stack.spill = nullptr;
+	stack.size = 0;
+	query_stack_push(&stack, 0);
+	while (stack.size) {
+		const obj_bvh_node_t* node = bvh->node + query_stack_pop(&stack);
+		if (query_node_distance_squared(node, coord_point) >= best_distance_squared)
+			continue;
+
+		if (node->count) {
+			for (unsigned int iprim = node->offset, pend = node->offset + node->count; iprim < pend; ++iprim) {
+				unsigned int corner[3];
+				real coord[3][3];
+				real barycentric[3];
+				query_triangle(obj, bvh->primitive + iprim, corner, coord);
+				real distance_squared = query_closest_on_triangle((const real(*)[3])coord, coord_point, barycentric);
+				if (distance_squared < best_distance_squared) {
+					best_distance_squared = distance_squared;
+					best_primitive = iprim;
+					best_barycentric[1] = barycentric[1];
+					best_barycentric[2] = barycentric[2];
+				}
+			}
+			continue;
+		}
+
+		// Visit the nearer child first
+		const obj_bvh_node_t* child = bvh->node + node->offset;
+		if (query_node_distance_squared(child, coord_point) <= query_node_distance_squared(child + 1, coord_point)) {
+			query_stack_push(&stack, node->offset + 1);
+			query_stack_push(&stack, node->offset);
+		} else {
+			query_stack_push(&stack, node->offset);
+			query_stack_push(&stack, node->offset + 1);
+		}
+	}
+	array_deallocate(stack.spill);
+
+	if (best_primitive == INVALID_INDEX)
+		return false;
+	query_hit_fill(obj, bvh->primitive + best_primitive, best_barycentric[1], best_barycentric[2],
+	               math_sqrt(best_distance_squared), result);
+	return true;
+}
+
+static void
+query_closest_point_batch(void* context, size_t index) {
+	query_batch_t* batch = context;
+	size_t offset = index * QUERY_POINT_BATCH;
+	size_t end = offset + QUERY_POINT_BATCH;
+	if (end > batch->count)
+		end = batch->count;
+	for (size_t ipoint = offset; ipoint < end; ++ipoint)
+		obj_closest_point(batch->obj, batch->bvh, batch->point + ipoint, batch->hit + ipoint);
+}
+
+size_t
+obj_closest_point_batch(const obj_t* obj, const obj_bvh_t* bvh, const obj_vertex_t* point, size_t count,
+                        obj_hit_t* result) {
+	if (!obj || !bvh || !point || !result)
+		return 0;
+
+	query_batch_t batch = {obj, bvh, nullptr, point, count, result};
+	obj_parallel_for((count + QUERY_POINT_BATCH - 1) / QUERY_POINT_BATCH, query_closest_point_batch, &batch);
+
+	size_t found_count = 0;
+	for (size_t ipoint = 0; ipoint < count; ++ipoint) {
+		if (result[ipoint].distance >= 0)
+			++found_count;
+	}
+	return found_count;
+}
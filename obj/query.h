@@ -0,0 +1,70 @@
+/* query.h   -  OBJ library  -  Public Domain  -  2019 Mattias Jansson
+ *
+ * This library provides a cross-platform OBJ I/O library in C11 providing
+ * OBJ ascii reading and writing functionality.
+ *
+ * The latest source code maintained by Mattias Jansson is always available at
+ *
+ * https://github.com/mjansson/obj_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without any
+ * restrictions.
+ *
+ */
+
+#pragma once
+
+/*! \file query.h
+    Ray cast and closest point queries */
+
+#include <obj/types.h>
+#include <obj/hashstrings.h>
+
+//! Number of rays traversing the BVH together in batched ray casts
+#define OBJ_RAY_PACKET_SIZE 8
+
+/*! Find the closest triangle hit by a ray. Triangles are hit from both sides.
+\param obj OBJ data structure
+\param bvh BVH built from the OBJ data structure by obj_build_bvh
+\param origin Ray origin
+\param direction Ray direction, need not be unit length
+\param hit Hit receiving triangle, barycentric coordinates and distance along ray in units of
+direction length, distance is negative if no triangle was hit
+\return true if a triangle was hit, false if not */
+OBJ_API bool
+obj_raycast(const obj_t* obj, const obj_bvh_t* bvh, const obj_vertex_t* origin, const obj_normal_t* direction,
+            obj_hit_t* hit);
+
+/*! Find the closest triangle hit by each ray in an array. Consecutive rays are traversed
+together in packets of OBJ_RAY_PACKET_SIZE rays, so coherent rays should be adjacent in the
+array. Packets are processed in parallel.
+\param obj OBJ data structure
+\param bvh BVH built from the OBJ data structure by obj_build_bvh
+\param ray Rays
+\param count Number of rays
+\param hit Hits receiving the result of each ray, see obj_raycast
+\return Number of rays hitting a triangle */
+OBJ_API size_t
+obj_raycast_batch(const obj_t* obj, const obj_bvh_t* bvh, const obj_ray_t* ray, size_t count, obj_hit_t* hit);
+
+/*! Find the closest point on any triangle to a query point
+\param obj OBJ data structure
+\param bvh BVH built from the OBJ data structure by obj_build_bvh
+\param point Query point
+\param result Hit receiving triangle, barycentric coordinates, position and distance of the
+closest point, distance is negative if there are no triangles
+\return true if a closest point was found, false if not */
+OBJ_API bool
+obj_closest_point(const obj_t* obj, const obj_bvh_t* bvh, const obj_vertex_t* point, obj_hit_t* result);
+
+/*! Find the closest point on any triangle to each point in an array, see obj_closest_point.
+Points are processed in parallel.
+\param obj OBJ data structure
+\param bvh BVH built from the OBJ data structure by obj_build_bvh
+\param point Query points
+\param count Number of query points
+\param result Hits receiving the result of each query point
+\return Number of query points a closest point was found for */
+OBJ_API size_t
+obj_closest_point_batch(const obj_t* obj, const obj_bvh_t* bvh, const obj_vertex_t* point, size_t count,
+                        obj_hit_t* result);
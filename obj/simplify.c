@@ -0,0 +1,495 @@
+/* simplify.c  -  OBJ library  -  Public Domain  -  2019 Mattias Jansson
+ *
+ * This library provides a cross-platform OBJ I/O library in C11 providing
+ * OBJ ascii reading and writing functionality.
+ *
+ * The latest source code maintained by Mattias Jansson is always available at
+ *
+ * https://github.com/mjansson/obj_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without any
+ * restrictions.
+ *
+ */
+
+#include "simplify.h"
+#include "internal.h"
+
+#include <foundation/array.h>
+#include <foundation/bucketarray.h>
+#include <foundation/math.h>
+
+#include <float.h>
+#include <math.h>
+
+//! Error quadric, symmetric matrix A, vector b and constant c, scaled by accumulated weight
+typedef struct simplify_quadric_t {
+	double a00, a11, a22, a01, a02, a12;
+	double b0, b1, b2;
+	double c;
+	double weight;
+} simplify_quadric_t;
+
+typedef struct simplify_candidate_t {
+	//! Corner being removed
+	unsigned int from;
+	//! Corner replacing the removed corner
+	unsigned int to;
+	//! Mean squared distance of target position to planes of removed corner
+	double cost;
+} simplify_candidate_t;
+
+typedef struct simplify_edge_t {
+	//! Vertex indices of edge endpoints, lower index in high bits
+	uint64_t key;
+	unsigned int corner[2];
+} simplify_edge_t;
+
+//! Simplification state of a single subgroup
+typedef struct simplify_state_t {
+	size_t vertex_count;
+	size_t triangle_count;
+	//! Current triangles, three corner indices per triangle
+	unsigned int* indices;
+	//! Corner positions
+	double* position;
+	//! Flag for each corner that must not be removed
+	uint8_t* locked;
+	simplify_quadric_t* quadric;
+	//! Largest error of any collapse so far, as distance
+	double error;
+} simplify_state_t;
+
+//! Simplification task for a single subgroup
+typedef struct simplify_task_t {
+	const obj_subgroup_t* subgroup;
+	//! Triangles of each level
+	obj_triangle_t** triangle;
+	//! Error of each level, relative to extent
+	real* error;
+} simplify_task_t;
+
+typedef struct simplify_build_t {
+	const obj_t* obj;
+	const real* ratio;
+	size_t count;
+	//! Largest squared error as distance
+	double max_error;
+	//! Extent of OBJ data
+	double scale;
+	simplify_task_t* task;
+} simplify_build_t;
+
+static void
+simplify_quadric_add_plane(simplify_quadric_t* quadric, const double* normal, double distance, double weight) {
+	quadric->a00 += weight * normal[0] * normal[0];
+	quadric->a11 += weight * normal[1] * normal[1];
+	quadric->a22 += weight * normal[2] * normal[2];
+	quadric->a01 += weight * normal[0] * normal[1];
+	quadric->a02 += weight * normal[0] * normal[2];
+	quadric->a12 += weight * normal[1] * normal[2];
+	quadric->b0 += weight * normal[0] * distance;
+	quadric->b1 += weight * normal[1] * distance;
+	quadric->b2 += weight * normal[2] * distance;
+	quadric->c += weight * distance * distance;
+	quadric->weight += weight;
+}
+
+static void
+simplify_quadric_add(simplify_quadric_t* quadric, const simplify_quadric_t* other) {
+	quadric->a00 += other->a00;
+	quadric->a11 += other->a11;
+	quadric->a22 += other->a22;
+	quadric->a01 += other->a01;
+	quadric->a02 += other->a02;
+	quadric->a12 += other->a12;
+	quadric->b0 += other->b0;
+	quadric->b1 += other->b1;
+	quadric->b2 += other->b2;
+	quadric->c += other->c;
+	quadric->weight += other->weight;
+}
+
+//! Mean squared distance of point to the planes of the quadric
+static double
+simplify_quadric_error(const simplify_quadric_t* quadric, const double* point) {
+	double x = point[0];
+	double y = point[1];
+	double z = point[2];
+	double error = (quadric->a00 * x * x) + (quadric->a11 * y * y) + (quadric->a22 * z * z) +
+	               2 * ((quadric->a01 * x * y) + (quadric->a02 * x * z) + (quadric->a12 * y * z)) +
+	               2 * ((quadric->b0 * x) + (quadric->b1 * y) + (quadric->b2 * z)) + quadric->c;
+	if (error < 0)
+		error = 0;
+	return (quadric->weight > 0) ? (error / quadric->weight) : 0;
+}
+
+static void
+simplify_triangle_normal(const double* p0, const double* p1, const double* p2, double* normal) {
+	double e1[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+	double e2[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+	normal[0] = (e1[1] * e2[2]) - (e1[2] * e2[1]);
+	normal[1] = (e1[2] * e2[0]) - (e1[0] * e2[2]);
+	normal[2] = (e1[0] * e2[1]) - (e1[1] * e2[0]);
+}
+
+static int
+simplify_key_compare(const void* lhs, const void* rhs) {
+	uint64_t lhs_key = *(const uint64_t*)lhs;
+	uint64_t rhs_key = *(const uint64_t*)rhs;
+	return (lhs_key < rhs_key) ? -1 : ((lhs_key > rhs_key) ? 1 : 0);
+}
+
+static int
+simplify_candidate_compare(const void* lhs, const void* rhs) {
+	const simplify_candidate_t* lhs_candidate = lhs;
+	const simplify_candidate_t* rhs_candidate = rhs;
+	if (lhs_candidate->cost != rhs_candidate->cost)
+		return (lhs_candidate->cost < rhs_candidate->cost) ? -1 : 1;
+	if (lhs_candidate->from != rhs_candidate->from)
+		return (lhs_candidate->from < rhs_candidate->from) ? -1 : 1;
+	return (lhs_candidate->to < rhs_candidate->to) ? -1 : ((lhs_candidate->to > rhs_candidate->to) ? 1 : 0);
+}
+
+static void
+simplify_state_initialize(simplify_state_t* state, const obj_t* obj, const obj_subgroup_t* subgroup) {
+	size_t vertex_count = subgroup->corner.count;
+	size_t triangle_count = subgroup->triangle.count;
+	state->vertex_count = vertex_count;
+	state->triangle_count = triangle_count;
+	state->indices = obj_subgroup_triangle_indices(subgroup);
+	state->position = memory_allocate(HASH_OBJ, sizeof(double) * 3 * vertex_count, 0, MEMORY_PERSISTENT);
+	state->locked = memory_allocate(HASH_OBJ, vertex_count, 0, MEMORY_PERSISTENT | MEMORY_ZERO_INITIALIZED);
+	state->quadric = memory_allocate(HASH_OBJ, sizeof(simplify_quadric_t) * vertex_count, 0,
+	                                 MEMORY_PERSISTENT | MEMORY_ZERO_INITIALIZED);
+	state->error = 0;
+
+	// Lock corners sharing a position with other corners, these are on UV seams or normal discontinuities
+	uint64_t* key = memory_allocate(HASH_OBJ, sizeof(uint64_t) * vertex_count, 0, MEMORY_PERSISTENT);
+	unsigned int* vertex = memory_allocate(HASH_OBJ, sizeof(unsigned int) * vertex_count, 0, MEMORY_PERSISTENT);
+	for (size_t icorner = 0; icorner < vertex_count; ++icorner) {
+		const obj_corner_t* corner = bucketarray_get(&subgroup->corner, icorner);
+		const obj_vertex_t* position = bucketarray_get(&obj->vertex, corner->vertex - 1);
+		state->position[(icorner * 3) + 0] = position->x;
+		state->position[(icorner * 3) + 1] = position->y;
+		state->position[(icorner * 3) + 2] = position->z;
+		vertex[icorner] = corner->vertex;
+		key[icorner] = ((uint64_t)corner->vertex << 32) | (uint64_t)icorner;
+	}
+	qsort(key, vertex_count, sizeof(uint64_t), simplify_key_compare);
+	for (size_t ikey = 0; ikey < vertex_count;) {
+		size_t end = ikey + 1;
+		while ((end < vertex_count) && ((key[end] >> 32) == (key[ikey] >> 32)))
+			++end;
+		if ((end - ikey) > 1) {
+			for (size_t ilock = ikey; ilock < end; ++ilock)
+				state->locked[(unsigned int)key[ilock]] = 1;
+		}
+		ikey = end;
+	}
+	memory_deallocate(key);
+
+	// Lock corners on border and non-manifold edges, edges are matched by position so seams are not borders
+	simplify_edge_t* edge =
+	    memory_allocate(HASH_OBJ, sizeof(simplify_edge_t) * 3 * (triangle_count ? triangle_count : 1), 0,
+	                    MEMORY_PERSISTENT);
+	for (size_t itri = 0; itri < triangle_count; ++itri) {
+		for (unsigned int iedge = 0; iedge < 3; ++iedge) {
+			unsigned int c0 = state->indices[(itri * 3) + iedge];
+			unsigned int c1 = state->indices[(itri * 3) + ((iedge + 1) % 3)];
+			uint64_t v0 = vertex[c0];
+			uint64_t v1 = vertex[c1];
+			simplify_edge_t* current = edge + (itri * 3) + iedge;
+			current->key = (v0 < v1) ? ((v0 << 32) | v1) : ((v1 << 32) | v0);
+			current->corner[0] = c0;
+			current->corner[1] = c1;
+		}
+	}
+	// Key is the first member, compare function only reads the key
+	qsort(edge, triangle_count * 3, sizeof(simplify_edge_t), simplify_key_compare);
+	for (size_t iedge = 0, edge_count = triangle_count * 3; iedge < edge_count;) {
+		size_t end = iedge + 1;
+		while ((end < edge_count) && (edge[end].key == edge[iedge].key))
+			++end;
+		if ((end - iedge) != 2) {
+			for (size_t ilock = iedge; ilock < end; ++ilock) {
+				state->locked[edge[ilock].corner[0]] = 1;
+				state->locked[edge[ilock].corner[1]] = 1;
+			}
+		}
+		iedge = end;
+	}
+	memory_deallocate(edge);
+	memory_deallocate(vertex);
+
+	// Accumulate area weighted plane quadrics of triangles in corners
+	for (size_t itri = 0; itri < triangle_count; ++itri) {
+		const unsigned int* index = state->indices + (itri * 3);
+		const double* p0 = state->position + (index[0] * 3);
+		double normal[3];
+		simplify_triangle_normal(p0, state->position + (index[1] * 3), state->position + (index[2] * 3), normal);
+		double length = sqrt((normal[0] * normal[0]) + (normal[1] * normal[1]) + (normal[2] * normal[2]));
+		if (!(length > 0))
+			continue;
+		for (unsigned int iaxis = 0; iaxis < 3; ++iaxis)
+			normal[iaxis] /= length;
+		double distance = -((normal[0] * p0[0]) + (normal[1] * p0[1]) + (normal[2] * p0[2]));
+		double area = length * 0.5;
+		for (unsigned int icorner = 0; icorner < 3; ++icorner)
+			simplify_quadric_add_plane(state->quadric + index[icorner], normal, distance, area);
+	}
+}
+
+static void
+simplify_state_finalize(simplify_state_t* state) {
+	memory_deallocate(state->quadric);
+	memory_deallocate(state->locked);
+	memory_deallocate(state->position);
+	memory_deallocate(state->indices);
+}
+
+//! Check if moving corner to position of target flips any triangle not removed by the collapse
+static bool
+simplify_collapse_flips(const simplify_state_t* state, const obj_adjacency_t* adjacency, unsigned int from,
+                        unsigned int to) {
+	const unsigned int* list = adjacency->triangle + adjacency->offset[from];
+	for (unsigned int iadj = 0; iadj < adjacency->live[from]; ++iadj) {
+		const unsigned int* index = state->indices + (list[iadj] * 3);
+		if ((index[0] == to) || (index[1] == to) || (index[2] == to))
+			continue;
+		const double* position[3];
+		const double* moved[3];
+		for (unsigned int icorner = 0; icorner < 3; ++icorner) {
+			position[icorner] = state->position + (index[icorner] * 3);
+			moved[icorner] = (index[icorner] == from) ? (state->position + (to * 3)) : position[icorner];
+		}
+		double before[3];
+		double after[3];
+		simplify_triangle_normal(position[0], position[1], position[2], before);
+		simplify_triangle_normal(moved[0], moved[1], moved[2], after);
+		if (((before[0] * after[0]) + (before[1] * after[1]) + (before[2] * after[2])) <= 0)
+			return true;
+	}
+	return false;
+}
+
+//! Run one pass of independent collapses, returns number of collapses
+static size_t
+simplify_pass(simplify_state_t* state, size_t target, double max_error) {
+	size_t triangle_count = state->triangle_count;
+	size_t vertex_count = state->vertex_count;
+
+	simplify_candidate_t* candidate = 0;
+	for (size_t itri = 0; itri < triangle_count; ++itri) {
+		const unsigned int* index = state->indices + (itri * 3);
+		for (unsigned int iedge = 0; iedge < 6; ++iedge) {
+			unsigned int from = index[iedge % 3];
+			unsigned int to = index[(iedge + 1 + (iedge / 3)) % 3];
+			if (state->locked[from] || (from == to))
+				continue;
+			double cost = simplify_quadric_error(state->quadric + from, state->position + (to * 3));
+			if (cost > max_error)
+				continue;
+			simplify_candidate_t collapse = {from, to, cost};
+			array_push(candidate, collapse);
+		}
+	}
+	size_t candidate_count = array_size(candidate);
+	if (!candidate_count)
+		return 0;
+	qsort(candidate, candidate_count, sizeof(simplify_candidate_t), simplify_candidate_compare);
+
+	obj_adjacency_t adjacency;
+	obj_adjacency_initialize(&adjacency, state->indices, triangle_count, vertex_count);
+	unsigned int* remap = memory_allocate(HASH_OBJ, sizeof(unsigned int) * vertex_count, 0, MEMORY_PERSISTENT);
+	uint8_t* touched = memory_allocate(HASH_OBJ, vertex_count, 0, MEMORY_PERSISTENT | MEMORY_ZERO_INITIALIZED);
+	for (size_t ivertex = 0; ivertex < vertex_count; ++ivertex)
+		remap[ivertex] = (unsigned int)ivertex;
+
+	// Each interior collapse removes two triangles
+	size_t collapse_limit = (triangle_count - target + 1) / 2;
+	size_t collapse_count = 0;
+	for (size_t icand = 0; (icand < candidate_count) && (collapse_count < collapse_limit); ++icand) {
+		unsigned int from = candidate[icand].from;
+		unsigned int to = candidate[icand].to;
+		if (touched[from] || touched[to])
+			continue;
+		if (simplify_collapse_flips(state, &adjacency, from, to))
+			continue;
+
+		// Neighbours of the removed corner are not touched again this pass, keeping the flip test valid
+		const unsigned int* list = adjacency.triangle + adjacency.offset[from];
+		for (unsigned int iadj = 0; iadj < adjacency.live[from]; ++iadj) {
+			const unsigned int* index = state->indices + (list[iadj] * 3);
+			touched[index[0]] = touched[index[1]] = touched[index[2]] = 1;
+		}
+		touched[to] = 1;
+
+		remap[from] = to;
+		simplify_quadric_add(state->quadric + to, state->quadric + from);
+		double error = sqrt(candidate[icand].cost);
+		if (error > state->error)
+			state->error = error;
+		++collapse_count;
+	}
+
+	if (collapse_count) {
+		size_t output = 0;
+		for (size_t itri = 0; itri < triangle_count; ++itri) {
+			unsigned int i0 = remap[state->indices[(itri * 3) + 0]];
+			unsigned int i1 = remap[state->indices[(itri * 3) + 1]];
+			unsigned int i2 = remap[state->indices[(itri * 3) + 2]];
+			if ((i0 == i1) || (i0 == i2) || (i1 == i2))
+				continue;
+			state->indices[(output * 3) + 0] = i0;
+			state->indices[(output * 3) + 1] = i1;
+			state->indices[(output * 3) + 2] = i2;
+			++output;
+		}
+		state->triangle_count = output;
+	}
+
+	memory_deallocate(touched);
+	memory_deallocate(remap);
+	obj_adjacency_finalize(&adjacency);
+	array_deallocate(candidate);
+
+	return collapse_count;
+}
+
+static void
+simplify_subgroup(void* context, size_t index) {
+	const simplify_build_t* build = context;
+	simplify_task_t* task = build->task + index;
+	const obj_subgroup_t* subgroup = task->subgroup;
+
+	simplify_state_t state;
+	simplify_state_initialize(&state, build->obj, subgroup);
+	size_t original_count = state.triangle_count;
+	for (size_t ilevel = 0; ilevel < build->count; ++ilevel) {
+		real ratio = build->ratio[ilevel];
+		size_t target = (ratio > 0) ? (size_t)((real)original_count * ratio) : 0;
+		while ((state.triangle_count > target) && simplify_pass(&state, target, build->max_error)) {
+		}
+
+		for (size_t itri = 0; itri < state.triangle_count; ++itri) {
+			obj_triangle_t triangle;
+			memcpy(triangle.index, state.indices + (itri * 3), sizeof(unsigned int) * 3);
+			array_push(task->triangle[ilevel], triangle);
+		}
+		task->error[ilevel] = (build->scale > 0) ? (real)(state.error / build->scale) : 0;
+	}
+	simplify_state_finalize(&state);
+}
+
+//! Simplify all subgroups in parallel, storing each level in the tasks
+static simplify_task_t*
+simplify_run(const obj_t* obj, const real* ratio, size_t count, real error_limit) {
+	simplify_build_t build;
+	build.obj = obj;
+	build.ratio = ratio;
+	build.count = count;
+	build.task = 0;
+
+	double min[3] = {DBL_MAX, DBL_MAX, DBL_MAX};
+	double max[3] = {-DBL_MAX, -DBL_MAX, -DBL_MAX};
+	for (size_t ivertex = 0; ivertex < obj->vertex.count; ++ivertex) {
+		const obj_vertex_t* vertex = bucketarray_get(&obj->vertex, ivertex);
+		const double coord[3] = {vertex->x, vertex->y, vertex->z};
+		for (unsigned int iaxis = 0; iaxis < 3; ++iaxis) {
+			if (coord[iaxis] < min[iaxis])
+				min[iaxis] = coord[iaxis];
+			if (coord[iaxis] > max[iaxis])
+				max[iaxis] = coord[iaxis];
+		}
+	}
+	build.scale = 0;
+	for (unsigned int iaxis = 0; obj->vertex.count && (iaxis < 3); ++iaxis) {
+		if ((max[iaxis] - min[iaxis]) > build.scale)
+			build.scale = max[iaxis] - min[iaxis];
+	}
+	double limit = (double)error_limit * build.scale;
+	build.max_error = (error_limit > 0) ? (limit * limit) : DBL_MAX;
+
+	for (size_t igroup = 0, gsize = array_size(obj->group); igroup < gsize; ++igroup) {
+		obj_group_t* group = obj->group[igroup];
+		for (size_t isub = 0, sgsize = array_size(group->subgroup); isub < sgsize; ++isub) {
+			simplify_task_t task;
+			task.subgroup = group->subgroup[isub];
+			task.triangle = memory_allocate(HASH_OBJ, sizeof(obj_triangle_t*) * count, 0,
+			                                MEMORY_PERSISTENT | MEMORY_ZERO_INITIALIZED);
+			task.error =
+			    memory_allocate(HASH_OBJ, sizeof(real) * count, 0, MEMORY_PERSISTENT | MEMORY_ZERO_INITIALIZED);
+			array_push(build.task, task);
+		}
+	}
+
+	obj_parallel_for(array_size(build.task), simplify_subgroup, &build);
+
+	return build.task;
+}
+
+static void
+simplify_task_finalize(simplify_task_t* task, size_t count) {
+	for (size_t itask = 0, tsize = array_size(task); itask < tsize; ++itask) {
+		for (size_t ilevel = 0; ilevel < count; ++ilevel)
+			array_deallocate(task[itask].triangle[ilevel]);
+		memory_deallocate(task[itask].triangle);
+		memory_deallocate(task[itask].error);
+	}
+	array_deallocate(task);
+}
+
+bool
+obj_simplify(obj_t* obj, real target_ratio, real error_limit) {
+	if (!obj)
+		return false;
+
+	simplify_task_t* task = simplify_run(obj, &target_ratio, 1, error_limit);
+	for (size_t itask = 0, tsize = array_size(task); itask < tsize; ++itask) {
+		// Tasks only read subgroups, write back the simplified triangles once all are done
+		obj_subgroup_t* subgroup = (obj_subgroup_t*)task[itask].subgroup;
+		size_t triangle_count = array_size(task[itask].triangle[0]);
+		bucketarray_resize(&subgroup->triangle, triangle_count);
+		for (size_t itri = 0; itri < triangle_count; ++itri)
+			*bucketarray_get_as(obj_triangle_t, &subgroup->triangle, itri) = task[itask].triangle[0][itri];
+	}
+	simplify_task_finalize(task, 1);
+
+	return true;
+}
+
+bool
+obj_simplify_lod_chain(const obj_t* obj, const real* ratio, size_t count, real error_limit, obj_lod_t* lod) {
+	if (!obj || (count && (!ratio || !lod)))
+		return false;
+
+	simplify_task_t* task = simplify_run(obj, ratio, count, error_limit);
+	for (size_t ilevel = 0; ilevel < count; ++ilevel) {
+		obj_lod_t* level = lod + ilevel;
+		level->ratio = ratio[ilevel];
+		level->error = 0;
+		level->triangle = 0;
+		level->subgroup_offset = 0;
+		for (size_t itask = 0, tsize = array_size(task); itask < tsize; ++itask) {
+			unsigned int offset = (unsigned int)array_size(level->triangle);
+			array_push(level->subgroup_offset, offset);
+			const obj_triangle_t* triangle = task[itask].triangle[ilevel];
+			for (size_t itri = 0, tricount = array_size(triangle); itri < tricount; ++itri)
+				array_push(level->triangle, triangle[itri]);
+			if (task[itask].error[ilevel] > level->error)
+				level->error = task[itask].error[ilevel];
+		}
+		unsigned int total = (unsigned int)array_size(level->triangle);
+		array_push(level->subgroup_offset, total);
+	}
+	simplify_task_finalize(task, count);
+
+	return true;
+}
+
+void
+obj_lod_finalize(obj_lod_t* lod) {
+	array_deallocate(lod->triangle);
+	array_deallocate(lod->subgroup_offset);
+}
@@ -0,0 +1,52 @@
+/* simplify.h  -  OBJ library  -  Public Domain  -  2019 Mattias Jansson
+ *
+ * This library provides a cross-platform OBJ I/O library in C11 providing
+ * OBJ ascii reading and writing functionality.
+ *
+ * The latest source code maintained by Mattias Jansson is always available at
+ *
+ * https://github.com/mjansson/obj_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without any
+ * restrictions.
+ *
+ */
+
+#pragma once
+
+/*! \file simplify.h
+    Mesh simplification */
+
+#include <obj/types.h>
+#include <obj/hashstrings.h>
+
+/*! Simplify subgroups by collapsing edges in order of increasing quadric error until the
+triangle count of each subgroup is reduced to the target ratio or no collapse is within the
+error limit. Corners are never created or moved, a collapse replaces one corner with a
+neighbouring corner. Corners on UV seams and normal discontinuities (positions shared by
+several corners) and corners on subgroup borders are kept, which preserves seams and
+material boundaries without cracks. Subgroups are processed in parallel. Only the triangle
+arrays are modified, faces are kept as read. Subgroups must be triangulated by obj_triangulate.
+\param obj OBJ data structure
+\param target_ratio Target ratio of triangle count to current triangle count, in [0, 1]
+\param error_limit Maximum error relative to the extent of the OBJ data, 0 for no limit
+\return true if success, false if error */
+OBJ_API bool
+obj_simplify(obj_t* obj, real target_ratio, real error_limit);
+
+/*! Build a chain of simplified levels of detail without modifying the OBJ data. Each level
+continues simplification from the previous level, see obj_simplify. Subgroups are processed
+in parallel. Finalize each level with obj_lod_finalize.
+\param obj OBJ data structure
+\param ratio Target ratio of triangle count to original triangle count for each level, decreasing
+\param count Number of levels
+\param error_limit Maximum error relative to the extent of the OBJ data, 0 for no limit
+\param lod Levels of detail receiving triangles, array of count elements
+\return true if success, false if error */
+OBJ_API bool
+obj_simplify_lod_chain(const obj_t* obj, const real* ratio, size_t count, real error_limit, obj_lod_t* lod);
+
+/*! Finalize level of detail, releasing all memory
+\param lod Level of detail */
+OBJ_API void
+obj_lod_finalize(obj_lod_t* lod);
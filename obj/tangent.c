@@ -0,0 +1,324 @@
+/* tangent.c   -  OBJ library  -  Public Domain  -  2019 Mattias Jansson
+ *
+ * This library provides a cross-platform OBJ I/O library in C11 providing
+ * OBJ ascii reading and writing functionality.
+ *
+ * The latest source code maintained by Mattias Jansson is always available at
+ *
+ * https://github.com/mjansson/obj_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without any
+ * restrictions.
+ *
+ */
+
+#include "tangent.h"
+#include "internal.h"
+
+#include <foundation/array.h>
+#include <foundation/bucketarray.h>
+#include <foundation/math.h>
+
+//! Tangents of a single subgroup, corner tangent indices are local until merged
+typedef struct tangent_subgroup_t {
+	obj_subgroup_t* subgroup;
+	obj_tangent_t* tangent;
+} tangent_subgroup_t;
+
+typedef struct tangent_build_t {
+	const obj_t* obj;
+	tangent_subgroup_t* subgroup;
+} tangent_build_t;
+
+static real
+tangent_dot(const real* FOUNDATION_RESTRICT lhs, const real* FOUNDATION_RESTRICT rhs) {
+	return (lhs[0] * rhs[0]) + (lhs[1] * rhs[1]) + (lhs[2] * rhs[2]);
+}
+
+//! Project vector onto plane of unit normal and normalize, returns false if result is degenerate
+static bool
+tangent_project(const real* FOUNDATION_RESTRICT normal, real* FOUNDATION_RESTRICT vec) {
+	real dot = tangent_dot(normal, vec);
+	for (unsigned int iaxis = 0; iaxis < 3; ++iaxis)
+		vec[iaxis] -= normal[iaxis] * dot;
+	real length = math_sqrt(tangent_dot(vec, vec));
+	if (!(length > REAL_C(0.0000001)))
+		return false;
+	for (unsigned int iaxis = 0; iaxis < 3; ++iaxis)
+		vec[iaxis] /= length;
+	return true;
+}
+
+//! Any unit vector perpendicular to the unit normal
+static void
+tangent_perpendicular(const real* normal, real* tangent) {
+	real axis[3] = {0, 0, 0};
+	real ax = math_abs(normal[0]);
+	real ay = math_abs(normal[1]);
+	real az = math_abs(normal[2]);
+	axis[((ax <= ay) && (ax <= az)) ? 0 : ((ay <= az) ? 1 : 2)] = 1;
+	if (!tangent_project(normal, axis)) {
+		axis[0] = 1;
+		axis[1] = axis[2] = 0;
+	}
+	tangent[0] = axis[0];
+	tangent[1] = axis[1];
+	tangent[2] = axis[2];
+}
+
+static void
+tangent_generate_subgroup(void* context, size_t index) {
+	const tangent_build_t* build = context;
+	tangent_subgroup_t* output = build->subgroup + index;
+	obj_subgroup_t* subgroup = output->subgroup;
+	const obj_t* obj = build->obj;
+	size_t triangle_count = subgroup->triangle.count;
+	size_t corner_count = subgroup->corner.count;
+
+	// Corner positions, UVs and normals, explicit or area weighted average of triangle normals
+	real* position = memory_allocate(HASH_OBJ, sizeof(real) * 3 * corner_count, 0, MEMORY_PERSISTENT);
+	real* uv = memory_allocate(HASH_OBJ, sizeof(real) * 2 * corner_count, 0, MEMORY_PERSISTENT);
+	real* normal =
+	    memory_allocate(HASH_OBJ, sizeof(real) * 3 * corner_count, 0, MEMORY_PERSISTENT | MEMORY_ZERO_INITIALIZED);
+	for (size_t icorner = 0; icorner < corner_count; ++icorner) {
+		obj_corner_t* corner = bucketarray_get(&subgroup->corner, icorner);
+		const obj_vertex_t* vertex = bucketarray_get(&obj->vertex, corner->vertex - 1);
+		position[(icorner * 3) + 0] = vertex->x;
+		position[(icorner * 3) + 1] = vertex->y;
+		position[(icorner * 3) + 2] = vertex->z;
+		if (corner->uv) {
+			const obj_uv_t* corner_uv = bucketarray_get(&obj->uv, corner->uv - 1);
+			uv[(icorner * 2) + 0] = corner_uv->u;
+			uv[(icorner * 2) + 1] = corner_uv->v;
+		} else {
+			uv[(icorner * 2) + 0] = 0;
+			uv[(icorner * 2) + 1] = 0;
+		}
+		corner->tangent = 0;
+	}
+
+	unsigned int* indices = obj_subgroup_triangle_indices(subgroup);
+	for (size_t itri = 0; itri < triangle_count; ++itri) {
+		const unsigned int* tri = indices + (itri * 3);
+		const real* p0 = position + (tri[0] * 3);
+		const real* p1 = position + (tri[1] * 3);
+		const real* p2 = position + (tri[2] * 3);
+		real d1[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+		real d2[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+		real face_normal[3] = {(d1[1] * d2[2]) - (d1[2] * d2[1]), (d1[2] * d2[0]) - (d1[0] * d2[2]),
+		                       (d1[0] * d2[1]) - (d1[1] * d2[0])};
+		for (unsigned int icorner = 0; icorner < 3; ++icorner) {
+			for (unsigned int iaxis = 0; iaxis < 3; ++iaxis)
+				normal[(tri[icorner] * 3) + iaxis] += face_normal[iaxis];
+		}
+	}
+	for (size_t icorner = 0; icorner < corner_count; ++icorner) {
+		const obj_corner_t* corner = bucketarray_get(&subgroup->corner, icorner);
+		real* corner_normal = normal + (icorner * 3);
+		if (corner->normal) {
+			const obj_normal_t* explicit_normal = bucketarray_get(&obj->normal, corner->normal - 1);
+			corner_normal[0] = explicit_normal->nx;
+			corner_normal[1] = explicit_normal->ny;
+			corner_normal[2] = explicit_normal->nz;
+		}
+		real length = math_sqrt(tangent_dot(corner_normal, corner_normal));
+		if (length > 0) {
+			for (unsigned int iaxis = 0; iaxis < 3; ++iaxis)
+				corner_normal[iaxis] /= length;
+		} else {
+			corner_normal[0] = 0;
+			corner_normal[1] = 0;
+			corner_normal[2] = 1;
+		}
+	}
+
+	// Angle weighted sum of projected triangle tangents per corner, one sum for each handedness
+	real* sum =
+	    memory_allocate(HASH_OBJ, sizeof(real) * 6 * corner_count, 0, MEMORY_PERSISTENT | MEMORY_ZERO_INITIALIZED);
+	uint8_t* used = memory_allocate(HASH_OBJ, corner_count, 0, MEMORY_PERSISTENT | MEMORY_ZERO_INITIALIZED);
+	uint8_t* primary = memory_allocate(HASH_OBJ, corner_count, 0, MEMORY_PERSISTENT);
+	uint8_t* orientation = memory_allocate(HASH_OBJ, triangle_count, 0, MEMORY_PERSISTENT);
+	for (size_t itri = 0; itri < triangle_count; ++itri) {
+		const unsigned int* tri = indices + (itri * 3);
+		const real* p0 = position + (tri[0] * 3);
+		const real* p1 = position + (tri[1] * 3);
+		const real* p2 = position + (tri[2] * 3);
+		const real* uv0 = uv + (tri[0] * 2);
+		const real* uv1 = uv + (tri[1] * 2);
+		const real* uv2 = uv + (tri[2] * 2);
+		real d1[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+		real d2[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+		real t21x = uv1[0] - uv0[0];
+		real t21y = uv1[1] - uv0[1];
+		real t31x = uv2[0] - uv0[0];
+		real t31y = uv2[1] - uv0[1];
+		real signed_area = (t21x * t31y) - (t21y * t31x);
+		uint8_t orient = (signed_area > 0) ? 1 : 0;
+		real sign = orient ? REAL_C(1.0) : REAL_C(-1.0);
+		real tangent[3] = {((t31y * d1[0]) - (t21y * d2[0])) * sign, ((t31y * d1[1]) - (t21y * d2[1])) * sign,
+		                   ((t31y * d1[2]) - (t21y * d2[2])) * sign};
+		orientation[itri] = orient;
+
+		for (unsigned int icorner = 0; icorner < 3; ++icorner) {
+			unsigned int corner = tri[icorner];
+			if (!used[corner])
+				primary[corner] = orient;
+			used[corner] |= (uint8_t)(1 << orient);
+
+			const real* corner_normal = normal + (corner * 3);
+			real projected[3] = {tangent[0], tangent[1], tangent[2]};
+			if (!tangent_project(corner_normal, projected))
+				continue;
+
+			const real* p = position + (corner * 3);
+			const real* pnext = position + (tri[(icorner + 1) % 3] * 3);
+			const real* pprev = position + (tri[(icorner + 2) % 3] * 3);
+			real e0[3] = {pnext[0] - p[0], pnext[1] - p[1], pnext[2] - p[2]};
+			real e1[3] = {pprev[0] - p[0], pprev[1] - p[1], pprev[2] - p[2]};
+			if (!tangent_project(corner_normal, e0) || !tangent_project(corner_normal, e1))
+				continue;
+			real cosine = tangent_dot(e0, e1);
+			if (cosine > 1)
+				cosine = 1;
+			else if (cosine < -1)
+				cosine = -1;
+			real angle = math_acos(cosine);
+
+			real* corner_sum = sum + (corner * 6) + (orient * 3);
+			for (unsigned int iaxis = 0; iaxis < 3; ++iaxis)
+				corner_sum[iaxis] += projected[iaxis] * angle;
+		}
+	}
+
+	// Resolve tangents, splitting corners used by both handedness
+	unsigned int* split = nullptr;
+	for (size_t icorner = 0; icorner < corner_count; ++icorner) {
+		if (!used[icorner])
+			continue;
+		for (unsigned int iorient = 0; iorient < 2; ++iorient) {
+			if (!(used[icorner] & (1 << iorient)))
+				continue;
+			real* corner_sum = sum + (icorner * 6) + (iorient * 3);
+			const real* corner_normal = normal + (icorner * 3);
+			if (!tangent_project(corner_normal, corner_sum))
+				tangent_perpendicular(corner_normal, corner_sum);
+			obj_tangent_t tangent = {corner_sum[0], corner_sum[1], corner_sum[2], iorient ? REAL_C(1.0) : REAL_C(-1.0)};
+			array_push(output->tangent, tangent);
+			unsigned int tangent_index = array_size(output->tangent);
+
+			obj_corner_t* corner = bucketarray_get(&subgroup->corner, icorner);
+			if (iorient == primary[icorner]) {
+				corner->tangent = tangent_index;
+				continue;
+			}
+			obj_corner_t new_corner = *corner;
+			new_corner.tangent = tangent_index;
+			new_corner.next = corner->next;
+			unsigned int new_index = (unsigned int)subgroup->corner.count;
+			corner->next = (int)new_index;
+			obj_bucketarray_push(&subgroup->corner, &new_corner);
+			array_push(split, (unsigned int)icorner);
+			array_push(split, new_index);
+		}
+	}
+
+	// Triangles of the non-primary handedness at a split corner use the new corner
+	if (split) {
+		unsigned int* remap = memory_allocate(HASH_OBJ, sizeof(unsigned int) * corner_count, 0,
+		                                      MEMORY_PERSISTENT | MEMORY_ZERO_INITIALIZED);
+		for (size_t isplit = 0, ssize = array_size(split); isplit < ssize; isplit += 2)
+			remap[split[isplit]] = split[isplit + 1];
+		for (size_t itri = 0; itri < triangle_count; ++itri) {
+			obj_triangle_t* triangle = bucketarray_get(&subgroup->triangle, itri);
+			for (unsigned int icorner = 0; icorner < 3; ++icorner) {
+				unsigned int corner = triangle->index[icorner];
+				if (remap[corner] && (orientation[itri] != primary[corner]))
+					triangle->index[icorner] = remap[corner];
+			}
+		}
+		memory_deallocate(remap);
+		array_deallocate(split);
+	}
+
+	memory_deallocate(orientation);
+	memory_deallocate(primary);
+	memory_deallocate(used);
+	memory_deallocate(sum);
+	memory_deallocate(indices);
+	memory_deallocate(normal);
+	memory_deallocate(uv);
+	memory_deallocate(position);
+}
+
+bool
+obj_generate_tangents(obj_t* obj) {
+	if (!obj)
+		return false;
+
+	tangent_build_t build;
+	build.obj = obj;
+	build.subgroup = nullptr;
+	for (size_t igroup = 0, gsize = array_size(obj->group); igroup < gsize; ++igroup) {
+		obj_group_t* group = obj->group[igroup];
+		for (size_t isub = 0, sgsize = array_size(group->subgroup); isub < sgsize; ++isub) {
+			tangent_subgroup_t tangent_subgroup = {group->subgroup[isub], nullptr};
+			array_push(build.subgroup, tangent_subgroup);
+		}
+	}
+
+	obj_parallel_for(array_size(build.subgroup), tangent_generate_subgroup, &build);
+
+	// Merge subgroup tangents, offsetting local corner tangent indices
+	size_t total = 0;
+	for (size_t isub = 0, sgsize = array_size(build.subgroup); isub < sgsize; ++isub)
+		total += array_size(build.subgroup[isub].tangent);
+	if (!obj->tangent.element_size)
+		bucketarray_initialize(&obj->tangent, sizeof(obj_tangent_t), obj_bucket_size(total, 16));
+	bucketarray_clear(&obj->tangent);
+	bucketarray_reserve(&obj->tangent, total);
+	for (size_t isub = 0, sgsize = array_size(build.subgroup); isub < sgsize; ++isub) {
+		tangent_subgroup_t* output = build.subgroup + isub;
+		obj_subgroup_t* subgroup = output->subgroup;
+		unsigned int base = (unsigned int)obj->tangent.count;
+		for (size_t itangent = 0, tsize = array_size(output->tangent); itangent < tsize; ++itangent)
+			bucketarray_push(&obj->tangent, output->tangent + itangent);
+		for (size_t icorner = 0, csize = subgroup->corner.count; icorner < csize; ++icorner) {
+			obj_corner_t* corner = bucketarray_get(&subgroup->corner, icorner);
+			if (corner->tangent)
+				corner->tangent += base;
+		}
+		array_deallocate(output->tangent);
+	}
+	array_deallocate(build.subgroup);
+
+	return true;
+}
+
+size_t
+obj_mesh_tangents(const obj_t* obj, obj_tangent_t* tangents) {
+	if (!obj || !tangents)
+		return 0;
+
+	size_t count = 0;
+	for (size_t igroup = 0, gsize = array_size(obj->group); igroup < gsize; ++igroup) {
+		const obj_group_t* group = obj->group[igroup];
+		for (size_t isub = 0, sgsize = array_size(group->subgroup); isub < sgsize; ++isub) {
+			const obj_subgroup_t* subgroup = group->subgroup[isub];
+			for (size_t itri = 0, tsize = subgroup->triangle.count; itri < tsize; ++itri) {
+				const obj_triangle_t* triangle = bucketarray_get(&subgroup->triangle, itri);
+				for (unsigned int icorner = 0; icorner < 3; ++icorner, ++count) {
+					const obj_corner_t* corner = bucketarray_get(&subgroup->corner, triangle->index[icorner]);
+					if (corner->tangent) {
+						tangents[count] = *bucketarray_get_as(obj_tangent_t, &obj->tangent, corner->tangent - 1);
+					} else {
+						tangents[count].tx = 0;
+						tangents[count].ty = 0;
+						tangents[count].tz = 0;
+						tangents[count].sign = 1;
+					}
+				}
+			}
+		}
+	}
+	return count;
+}
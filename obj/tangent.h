@@ -0,0 +1,43 @@
+/* tangent.h   -  OBJ library  -  Public Domain  -  2019 Mattias Jansson
+ *
+ * This library provides a cross-platform OBJ I/O library in C11 providing
+ * OBJ ascii reading and writing functionality.
+ *
+ * The latest source code maintained by Mattias Jansson is always available at
+ *
+ * https://github.com/mjansson/obj_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without any
+ * restrictions.
+ *
+ */
+
+#pragma once
+
+/*! \file tangent.h
+    Tangent frame generation */
+
+#include <obj/types.h>
+#include <obj/hashstrings.h>
+
+/*! Generate tangent frames for all corners used by triangles, following the MikkTSpace
+conventions: per triangle tangents from positions and UVs are projected onto the plane of
+the corner normal and averaged weighted by corner angle, separately for triangles with
+mirrored and unmirrored UV mapping. A corner used by triangles of both handedness is split,
+and the triangles of the other handedness reference the new corner. Corners without a normal
+use the area weighted normal of their triangles. Any previously generated tangents are
+replaced. Subgroups are processed in parallel. Run after normal generation, since it can split
+the corners used by triangles. Subgroups must be triangulated by obj_triangulate.
+\param obj OBJ data structure
+\return true if success, false if error */
+OBJ_API bool
+obj_generate_tangents(obj_t* obj);
+
+/*! Copy corner tangents in the vertex order of the mesh created by obj_to_mesh, which has
+three vertices per triangle in group, subgroup and triangle order. The mesh data structure
+has no tangent channel, use this to carry tangents alongside the transcoded mesh.
+\param obj OBJ data structure
+\param tangents Destination array, must have room for three tangents per triangle
+\return Number of tangents written */
+OBJ_API size_t
+obj_mesh_tangents(const obj_t* obj, obj_tangent_t* tangents);
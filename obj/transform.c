@@ -0,0 +1,184 @@
+/* transform.c  -  OBJ library  -  Public Domain  -  2019 Mattias Jansson
+ *
+ * This library provides a cross-platform OBJ I/O library in C11 providing
+ * OBJ ascii reading and writing functionality.
+ *
+ * The latest source code maintained by Mattias Jansson is always available at
+ *
+ * https://github.com/mjansson/obj_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without any
+ * restrictions.
+ *
+ */
+
+#include "transform.h"
+#include "bounds.h"
+#include "internal.h"
+
+#include <foundation/array.h>
+#include <foundation/bucketarray.h>
+
+typedef struct transform_t {
+	obj_t* obj;
+	const obj_matrix_t* matrix;
+	//! Normal matrix, inverse transpose of the linear part of the transform
+	real normal[3][3];
+	//! Determinant of the linear part of the transform
+	real determinant;
+	unsigned int flags;
+} transform_t;
+
+real
+obj_matrix_normal(const obj_matrix_t* matrix, real normal[3][3]) {
+	const real(*m)[4] = matrix->row;
+	normal[0][0] = (m[1][1] * m[2][2]) - (m[1][2] * m[2][1]);
+	normal[0][1] = (m[1][2] * m[2][0]) - (m[1][0] * m[2][2]);
+	normal[0][2] = (m[1][0] * m[2][1]) - (m[1][1] * m[2][0]);
+	normal[1][0] = (m[0][2] * m[2][1]) - (m[0][1] * m[2][2]);
+	normal[1][1] = (m[0][0] * m[2][2]) - (m[0][2] * m[2][0]);
+	normal[1][2] = (m[0][1] * m[2][0]) - (m[0][0] * m[2][1]);
+	normal[2][0] = (m[0][1] * m[1][2]) - (m[0][2] * m[1][1]);
+	normal[2][1] = (m[0][2] * m[1][0]) - (m[0][0] * m[1][2]);
+	normal[2][2] = (m[0][0] * m[1][1]) - (m[0][1] * m[1][0]);
+	real determinant = (m[0][0] * normal[0][0]) + (m[0][1] * normal[0][1]) + (m[0][2] * normal[0][2]);
+	// Cofactor matrix is the inverse transpose scaled by the determinant
+	if (determinant != 0) {
+		real inverse = REAL_C(1.0) / determinant;
+		for (int irow = 0; irow < 3; ++irow) {
+			for (int icol = 0; icol < 3; ++icol)
+				normal[irow][icol] *= inverse;
+		}
+	}
+	return determinant;
+}
+
+//! Number of elements of a bucket, tasks transform one bucket each
+static size_t
+transform_bucket_count(const bucketarray_t* array, size_t index, size_t* offset) {
+	*offset = index * array->bucket_size;
+	size_t count = array->count - *offset;
+	return (count > array->bucket_size) ? array->bucket_size : count;
+}
+
+static void
+transform_vertex_bucket(void* context, size_t index) {
+	transform_t* transform = context;
+	size_t offset;
+	size_t count = transform_bucket_count(&transform->obj->vertex, index, &offset);
+	obj_vertex_t* FOUNDATION_RESTRICT vertex = bucketarray_get(&transform->obj->vertex, offset);
+	const obj_matrix_t matrix = *transform->matrix;
+	for (size_t ivertex = 0; ivertex < count; ++ivertex)
+		obj_matrix_transform_vertex(&matrix, vertex + ivertex);
+}
+
+static void
+transform_normal_bucket(void* context, size_t index) {
+	transform_t* transform = context;
+	size_t offset;
+	size_t count = transform_bucket_count(&transform->obj->normal, index, &offset);
+	obj_normal_t* FOUNDATION_RESTRICT normal = bucketarray_get(&transform->obj->normal, offset);
+	// Separate loops keep the normalization branch out of the vectorized loop body
+	if (transform->flags & OBJ_TRANSFORM_NORMALIZE) {
+		for (size_t inormal = 0; inormal < count; ++inormal)
+			obj_matrix_transform_normal((const real(*)[3])transform->normal, normal + inormal, true);
+	} else {
+		for (size_t inormal = 0; inormal < count; ++inormal)
+			obj_matrix_transform_normal((const real(*)[3])transform->normal, normal + inormal, false);
+	}
+}
+
+static void
+transform_tangent_bucket(void* context, size_t index) {
+	transform_t* transform = context;
+	size_t offset;
+	size_t count = transform_bucket_count(&transform->obj->tangent, index, &offset);
+	obj_tangent_t* FOUNDATION_RESTRICT tangent = bucketarray_get(&transform->obj->tangent, offset);
+	const real(*m)[4] = transform->matrix->row;
+	bool normalize = (transform->flags & OBJ_TRANSFORM_NORMALIZE);
+	// Mirroring flips the handedness of the tangent frame
+	real sign = (transform->determinant < 0) ? -REAL_C(1.0) : REAL_C(1.0);
+	for (size_t itangent = 0; itangent < count; ++itangent) {
+		real tx = tangent[itangent].tx;
+		real ty = tangent[itangent].ty;
+		real tz = tangent[itangent].tz;
+		real x = (m[0][0] * tx) + (m[0][1] * ty) + (m[0][2] * tz);
+		real y = (m[1][0] * tx) + (m[1][1] * ty) + (m[1][2] * tz);
+		real z = (m[2][0] * tx) + (m[2][1] * ty) + (m[2][2] * tz);
+		real length_squared = (x * x) + (y * y) + (z * z);
+		real scale = (normalize && (length_squared > 0)) ? (REAL_C(1.0) / math_sqrt(length_squared)) : REAL_C(1.0);
+		tangent[itangent].tx = x * scale;
+		tangent[itangent].ty = y * scale;
+		tangent[itangent].tz = z * scale;
+		tangent[itangent].sign *= sign;
+	}
+}
+
+//! Reverse corner order of faces and triangles of a subgroup
+static void
+transform_flip_subgroup(void* context, size_t index) {
+	transform_t* transform = context;
+	obj_t* obj = transform->obj;
+	obj_subgroup_t* subgroup = nullptr;
+	for (size_t igroup = 0, gsize = array_size(obj->group); igroup < gsize; ++igroup) {
+		size_t sgsize = array_size(obj->group[igroup]->subgroup);
+		if (index < sgsize) {
+			subgroup = obj->group[igroup]->subgroup[index];
+			break;
+		}
+		index -= sgsize;
+	}
+	if (!subgroup)
+		return;
+
+	for (size_t iface = 0, fsize = subgroup->face.count; iface < fsize; ++iface) {
+		const obj_face_t* face = bucketarray_get(&subgroup->face, iface);
+		if (!face->count)
+			continue;
+		for (size_t first = face->offset, last = face->offset + face->count - 1; first < last; ++first, --last) {
+			unsigned int* first_index = bucketarray_get(&subgroup->index, first);
+			unsigned int* last_index = bucketarray_get(&subgroup->index, last);
+			unsigned int swap = *first_index;
+			*first_index = *last_index;
+			*last_index = swap;
+		}
+	}
+	for (size_t itri = 0, tsize = subgroup->triangle.count; itri < tsize; ++itri) {
+		obj_triangle_t* triangle = bucketarray_get(&subgroup->triangle, itri);
+		unsigned int swap = triangle->index[1];
+		triangle->index[1] = triangle->index[2];
+		triangle->index[2] = swap;
+	}
+}
+
+bool
+obj_transform(obj_t* obj, const obj_matrix_t* matrix, unsigned int flags) {
+	if (!obj || !matrix)
+		return false;
+
+	transform_t transform;
+	transform.obj = obj;
+	transform.matrix = matrix;
+	transform.determinant = obj_matrix_normal(matrix, transform.normal);
+	transform.flags = flags;
+
+	if (obj->vertex.count)
+		obj_parallel_for((obj->vertex.count + obj->vertex.bucket_size - 1) / obj->vertex.bucket_size,
+		                 transform_vertex_bucket, &transform);
+	if (obj->normal.count)
+		obj_parallel_for((obj->normal.count + obj->normal.bucket_size - 1) / obj->normal.bucket_size,
+		                 transform_normal_bucket, &transform);
+	if (obj->tangent.count)
+		obj_parallel_for((obj->tangent.count + obj->tangent.bucket_size - 1) / obj->tangent.bucket_size,
+		                 transform_tangent_bucket, &transform);
+
+	if ((flags & OBJ_TRANSFORM_FLIP_WINDING) && (transform.determinant < 0)) {
+		size_t subgroup_count = 0;
+		for (size_t igroup = 0, gsize = array_size(obj->group); igroup < gsize; ++igroup)
+			subgroup_count += array_size(obj->group[igroup]->subgroup);
+		obj_parallel_for(subgroup_count, transform_flip_subgroup, &transform);
+	}
+
+	obj_compute_bounds(obj);
+	return true;
+}
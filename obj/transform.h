@@ -0,0 +1,37 @@
+/* transform.h  -  OBJ library  -  Public Domain  -  2019 Mattias Jansson
+ *
+ * This library provides a cross-platform OBJ I/O library in C11 providing
+ * OBJ ascii reading and writing functionality.
+ *
+ * The latest source code maintained by Mattias Jansson is always available at
+ *
+ * https://github.com/mjansson/obj_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without any
+ * restrictions.
+ *
+ */
+
+#pragma once
+
+/*! \file transform.h
+    Affine transform of OBJ data */
+
+#include <obj/types.h>
+#include <obj/hashstrings.h>
+
+/*! Transform vertices by an affine matrix and normals by the inverse transpose of its linear
+part in place, optionally normalizing normals. Generated tangents are transformed by the
+linear part with handedness flipped by mirroring transforms. Attribute arrays are transformed
+bucket by bucket in parallel with vectorizable loops. If the matrix mirrors and winding flip is
+requested, faces and triangles of all subgroups are reversed. Bounds are recomputed. Any BVH or
+meshlets built from the OBJ data must be rebuilt. To transform while parsing instead, set the
+transform in the read options and the OBJ_READ_TRANSFORM read flag, either in the option
+field of the OBJ data structure passed to obj_read or in the options given to
+obj_parser_initialize.
+\param obj OBJ data structure
+\param matrix Affine transform
+\param flags Transform flags, combination of obj_transform_flag_t values
+\return true if success, false if error */
+OBJ_API bool
+obj_transform(obj_t* obj, const obj_matrix_t* matrix, unsigned int flags);
@@ -40,20 +40,118 @@
 #endif
 #endif
 
+typedef enum {
+	//! Reading stream, work units are bytes
+	OBJ_PROGRESS_READ = 0,
+	//! Triangulating faces, work units are faces
+	OBJ_PROGRESS_TRIANGULATE,
+	//! Transcoding to mesh, work units are triangles
+	OBJ_PROGRESS_MESH
+} obj_progress_phase_t;
+
+typedef enum {
+	//! Faces of repeated group names are added to the first group with that name
+	OBJ_READ_MERGE_GROUPS = 1,
+	//! Faces are added to the existing subgroup with the same material in the group instead of
+	//! starting a new subgroup at each material switch, subgroup complete callbacks are deferred
+	//! to the end of data
+	OBJ_READ_MERGE_SUBGROUPS = 2,
+	//! Vertices and normals are transformed by the transform of the read options as they are
+	//! parsed, and faces are reversed as they are parsed if the transform flips winding. The push
+	//! parser takes its read options in obj_parser_initialize
+	OBJ_READ_TRANSFORM = 4
+} obj_read_flag_t;
+
+typedef enum {
+	//! Optimize triangle order for vertex cache with obj_optimize_vertex_cache before transcoding
+	OBJ_MESH_OPTIMIZE_VERTEX_CACHE = 1,
+	//! Optimize triangle order for overdraw with obj_optimize_overdraw before transcoding, after
+	//! any vertex cache optimization
+	OBJ_MESH_OPTIMIZE_OVERDRAW = 2,
+	//! Renumber corners and attributes by first use with obj_optimize_vertex_fetch before
+	//! transcoding, after any triangle order optimization
+	OBJ_MESH_OPTIMIZE_VERTEX_FETCH = 4,
+	//! Generate tangents with obj_generate_tangents before transcoding, after any optimization
+	OBJ_MESH_GENERATE_TANGENTS = 8
+} obj_mesh_flag_t;
+
+typedef enum {
+	//! Weight face normals by face area
+	OBJ_NORMAL_WEIGHT_AREA = 0,
+	//! Weight face normals by the angle of the face at the corner
+	OBJ_NORMAL_WEIGHT_ANGLE = 1,
+	//! Weight face normals by both face area and corner angle
+	OBJ_NORMAL_WEIGHT_AREA_ANGLE = 2,
+	//! Mask of weighting mode
+	OBJ_NORMAL_WEIGHT_MASK = 0xF,
+	//! Replace existing normals, by default only corners without a normal get a generated normal
+	OBJ_NORMAL_REPLACE = 0x10
+} obj_normal_mode_t;
+
+typedef enum {
+	//! Check vertices, normals and UVs for NaN and infinite components
+	OBJ_VALIDATE_NONFINITE = 1,
+	//! Check normals for zero length
+	OBJ_VALIDATE_ZERO_NORMAL = 2,
+	//! Check triangles for repeated vertices and zero area
+	OBJ_VALIDATE_DEGENERATE = 4,
+	//! Check subgroups for triangles with the same vertices in the same winding
+	OBJ_VALIDATE_DUPLICATE = 8,
+	//! Check subgroups for edges shared by more than two triangles
+	OBJ_VALIDATE_NONMANIFOLD = 0x10,
+	//! All checks
+	OBJ_VALIDATE_ALL = 0x1F,
+	//! Repair found problems in place
+	OBJ_VALIDATE_REPAIR = 0x100
+} obj_validate_flag_t;
+
+typedef enum {
+	//! Reverse the winding of faces and triangles if the matrix mirrors, a negative determinant
+	OBJ_TRANSFORM_FLIP_WINDING = 1,
+	//! Normalize transformed normals and tangents
+	OBJ_TRANSFORM_NORMALIZE = 2
+} obj_transform_flag_t;
+
 typedef stream_t* (*obj_stream_open)(const char*, size_t, unsigned int);
 
 typedef struct obj_config_t obj_config_t;
+typedef struct obj_progress_t obj_progress_t;
+typedef struct obj_read_options_t obj_read_options_t;
+typedef struct obj_string_pool_t obj_string_pool_t;
 typedef struct obj_t obj_t;
 typedef struct obj_material_t obj_material_t;
 typedef struct obj_color_t obj_color_t;
 typedef struct obj_vertex_t obj_vertex_t;
 typedef struct obj_normal_t obj_normal_t;
 typedef struct obj_uv_t obj_uv_t;
+typedef struct obj_tangent_t obj_tangent_t;
+typedef struct obj_bounds_t obj_bounds_t;
+typedef struct obj_matrix_t obj_matrix_t;
+typedef struct obj_packed_vertex_t obj_packed_vertex_t;
 typedef struct obj_corner_t obj_corner_t;
 typedef struct obj_face_t obj_face_t;
 typedef struct obj_triangle_t obj_triangle_t;
 typedef struct obj_subgroup_t obj_subgroup_t;
 typedef struct obj_group_t obj_group_t;
+typedef struct obj_index_entry_t obj_index_entry_t;
+typedef struct obj_index_t obj_index_t;
+typedef struct obj_read_state_t obj_read_state_t;
+typedef struct obj_vertex_cache_stats_t obj_vertex_cache_stats_t;
+typedef struct obj_parser_t obj_parser_t;
+typedef struct obj_meshlet_limits_t obj_meshlet_limits_t;
+typedef struct obj_meshlet_t obj_meshlet_t;
+typedef struct obj_meshlets_t obj_meshlets_t;
+typedef struct obj_lod_t obj_lod_t;
+typedef struct obj_bvh_options_t obj_bvh_options_t;
+typedef struct obj_bvh_node_t obj_bvh_node_t;
+typedef struct obj_bvh_primitive_t obj_bvh_primitive_t;
+typedef struct obj_bvh_t obj_bvh_t;
+typedef struct obj_ray_t obj_ray_t;
+typedef struct obj_hit_t obj_hit_t;
+typedef struct obj_validate_report_t obj_validate_report_t;
+
+typedef void (*obj_progress_fn)(void* context, obj_progress_phase_t phase, size_t done, size_t total);
+typedef void (*obj_subgroup_fn)(void* context, obj_t* obj, obj_group_t* group, obj_subgroup_t* subgroup);
 
 struct obj_config_t {
 	obj_stream_open stream_open;
@@ -61,34 +159,70 @@ struct obj_config_t {
 	size_t search_path_count;
 };
 
+struct obj_progress_t {
+	//! Progress callback, null if no progress reporting
+	obj_progress_fn callback;
+	//! Context passed to progress callback
+	void* context;
+	//! Number of work units between progress callbacks, 0 for default
+	size_t interval;
+	//! Set to non-zero from any thread to cancel the ongoing operation
+	atomic32_t cancel;
+};
+
+//! Affine transform of column vectors, v' = M * v
+struct obj_matrix_t {
+	//! Rows of the 3x4 matrix, translation in the last column
+	real row[3][4];
+};
+
+struct obj_read_options_t {
+	/*! Called on the reading thread each time a subgroup is completed by a group or material
+	switch, or the end of data. The subgroup is triangulated and its triangle and corner arrays
+	will not be modified by the remaining read. Attribute arrays of the OBJ data structure can
+	still grow, use obj_subgroup_pack to copy out vertex data for use on another thread. */
+	obj_subgroup_fn subgroup_complete;
+	//! Context passed to subgroup callback
+	void* context;
+	//! Read flags, combination of obj_read_flag_t values
+	unsigned int flags;
+	//! Mesh transcoding flags for obj_to_mesh, combination of obj_mesh_flag_t values
+	unsigned int mesh_flags;
+	//! Transform applied while parsing if flags include OBJ_READ_TRANSFORM
+	obj_matrix_t transform;
+	//! Transform flags, combination of obj_transform_flag_t values
+	unsigned int transform_flags;
+};
+
 struct obj_color_t {
 	real red;
 	real green;
 	real blue;
 };
 
+//! Material, name and texture paths are interned in the string pool of the OBJ data structure
 struct obj_material_t {
-	string_t name;
+	string_const_t name;
 
 	obj_color_t ambient_color;
-	string_t ambient_texture;
+	string_const_t ambient_texture;
 
 	obj_color_t diffuse_color;
-	string_t diffuse_texture;
+	string_const_t diffuse_texture;
 
 	obj_color_t specular_color;
-	string_t specular_texture;
+	string_const_t specular_texture;
 
 	obj_color_t emissive_color;
-	string_t emissive_texture;
+	string_const_t emissive_texture;
 
 	real dissolve_factor;
-	string_t dissolve_texture;
+	string_const_t dissolve_texture;
 
 	real shininess_exponent;
-	string_t shininess_texture;
+	string_const_t shininess_texture;
 
-	string_t bump_texture;
+	string_const_t bump_texture;
 
 	obj_color_t transmission_filter;
 };
@@ -110,6 +244,28 @@ struct obj_uv_t {
 	real v;
 };
 
+//! Tangent of a corner, bitangent is sign * cross(normal, tangent)
+struct obj_tangent_t {
+	real tx;
+	real ty;
+	real tz;
+	//! Handedness of tangent frame, 1 or -1
+	real sign;
+};
+
+//! Axis aligned bounding box, empty if min is greater than max
+struct obj_bounds_t {
+	obj_vertex_t min;
+	obj_vertex_t max;
+};
+
+struct obj_packed_vertex_t {
+	obj_vertex_t position;
+	obj_normal_t normal;
+	obj_uv_t uv;
+	obj_tangent_t tangent;
+};
+
 struct obj_corner_t {
 	//! Vertex index plus one, always greater than 0
 	unsigned int vertex;
@@ -117,6 +273,8 @@ struct obj_corner_t {
 	unsigned int normal;
 	//! UV index plus one, thus less to 0 for no/invalid UV
 	unsigned int uv;
+	//! Tangent index plus one, 0 if no tangent has been generated
+	unsigned int tangent;
 	//! Index of next corner sharing the same vertex index, less than 0 if none
 	int next;
 };
@@ -131,6 +289,8 @@ struct obj_face_t {
 	unsigned int count;
 	//! Offset in subgroup index array where face indices start
 	unsigned int offset;
+	//! Smoothing group, 0 if smoothing is off
+	unsigned int smoothing;
 };
 
 struct obj_subgroup_t {
@@ -144,18 +304,273 @@ struct obj_subgroup_t {
 	bucketarray_t face;
 	//! Triangulation by obj_triangulate (zero-based index into corner array)
 	bucketarray_t triangle;
+	//! Bounds of vertices used by faces
+	obj_bounds_t bounds;
 };
 
 struct obj_group_t {
-	string_t name;
+	//! Group name, interned in the string pool of the OBJ data structure
+	string_const_t name;
 	obj_subgroup_t** subgroup;
+	//! Bounds of vertices used by faces in all subgroups
+	obj_bounds_t bounds;
+};
+
+struct obj_string_pool_t {
+	//! Map from string hash to index in string array plus one
+	hashmap_t* map;
+	//! Interned strings
+	string_const_t* string;
+	//! Storage blocks for string data
+	char** block;
+	//! Current storage block for short strings
+	char* current;
+	//! Number of bytes used in current storage block
+	size_t current_used;
 };
 
 struct obj_t {
 	string_t base_path;
+	//! Interned group, material and texture names
+	obj_string_pool_t string_pool;
 	obj_material_t* material;
 	bucketarray_t vertex;
 	bucketarray_t normal;
 	bucketarray_t uv;
+	//! Corner tangents generated by obj_generate_tangents
+	bucketarray_t tangent;
+	//! Bounds of all vertices
+	obj_bounds_t bounds;
+	//! Number of faces dropped by the last read for referencing undeclared vertices
+	size_t invalid_face_count;
 	obj_group_t** group;
+	//! Map from group name hash to first group with that name
+	hashmap_t* group_map;
+	//! Progress reporting and cancellation for read, triangulation and mesh transcoding
+	obj_progress_t progress;
+	//! Read options
+	obj_read_options_t option;
+};
+
+struct obj_index_entry_t {
+	//! Name of group active in section
+	string_t group;
+	//! Name of material active in section
+	string_t material;
+	//! Stream offset of first record in section
+	size_t offset;
+	//! Number of vertices declared before section
+	size_t vertex_count;
+	//! Number of UVs declared before section
+	size_t uv_count;
+	//! Number of normals declared before section
+	size_t normal_count;
+	//! Smoothing group active at start of section, 0 if smoothing is off
+	unsigned int smoothing;
+};
+
+struct obj_index_t {
+	//! Size of indexed stream
+	size_t size;
+	//! Total number of vertices in stream
+	size_t vertex_count;
+	//! Total number of UVs in stream
+	size_t uv_count;
+	//! Total number of normals in stream
+	size_t normal_count;
+	//! Material libraries referenced by stream
+	string_t* material_lib;
+	//! Sections, split at each group and material switch
+	obj_index_entry_t* entry;
+};
+
+struct obj_read_state_t {
+	//! Stream offset following last consumed record
+	size_t offset;
+	//! Current group, null if next face starts a new group
+	obj_group_t* group;
+	//! Current subgroup, null if next face starts a new subgroup
+	obj_subgroup_t* subgroup;
+	//! Name of next group
+	string_t group_name;
+	//! Current material index
+	unsigned int material;
+	//! Current smoothing group, 0 if smoothing is off
+	unsigned int smoothing;
+	//! Number of vertices declared so far, used to resolve relative indices
+	size_t vertex_count;
+	//! Number of UVs declared so far
+	size_t uv_count;
+	//! Number of normals declared so far
+	size_t normal_count;
+	//! Number of vertices declared since last subgroup was started
+	size_t vertex_count_since_group;
+	//! Reserve size for attribute arrays
+	size_t reserve_count;
+	//! Map from vertex index to first corner in current subgroup using that vertex
+	bucketarray_t vertex_to_corner;
+	//! Map from subgroup and vertex index to corner using that vertex plus one, replaces
+	//! vertex_to_corner when merging subgroups
+	hashmap_t* corner_map;
+};
+
+struct obj_parser_t {
+	//! Data parsed so far
+	obj_t obj;
+	//! Read state
+	obj_read_state_t state;
+	//! Incomplete trailing line of last fed data
+	char* pending;
+};
+
+struct obj_vertex_cache_stats_t {
+	//! Size of simulated FIFO vertex cache used to measure ACMR, 0 for default
+	unsigned int cache_size;
+	//! Average cache miss ratio (transformed vertices per triangle) before optimization
+	real acmr_before;
+	//! Average cache miss ratio after optimization
+	real acmr_after;
+};
+
+struct obj_meshlet_limits_t {
+	//! Maximum number of unique corners per meshlet, 0 for default, at most 256
+	unsigned int max_vertices;
+	//! Maximum number of triangles per meshlet, 0 for default
+	unsigned int max_triangles;
+};
+
+struct obj_meshlet_t {
+	//! Group index
+	unsigned int group;
+	//! Subgroup index in group
+	unsigned int subgroup;
+	//! Offset of first corner index in meshlet vertex array
+	unsigned int vertex_offset;
+	//! Number of corners used by meshlet
+	unsigned int vertex_count;
+	//! Offset of first local index in meshlet triangle array, three local indices per triangle
+	unsigned int triangle_offset;
+	//! Number of triangles in meshlet
+	unsigned int triangle_count;
+	//! Bounding sphere center
+	obj_vertex_t center;
+	//! Bounding sphere radius
+	real radius;
+	//! Normal cone axis, unit length
+	obj_normal_t cone_axis;
+	//! Cosine of normal cone half angle, the minimum dot product of cone axis and triangle normals.
+	//! Meshlet is backfacing for all view directions d with dot(d, cone_axis) >= sqrt(1 - cutoff^2),
+	//! less than or equal to 0 if meshlet cannot be cone culled
+	real cone_cutoff;
+};
+
+struct obj_meshlets_t {
+	//! Meshlets in group and subgroup order
+	obj_meshlet_t* meshlet;
+	//! Corner indices into the subgroup corner array of each meshlet
+	unsigned int* vertex;
+	//! Local triangle indices into the meshlet vertex range
+	uint8_t* triangle;
+};
+
+struct obj_lod_t {
+	//! Target ratio of triangle count to original triangle count
+	real ratio;
+	//! Largest simplification error of any subgroup, relative to the extent of the OBJ data
+	real error;
+	//! Triangles of all subgroups in group and subgroup order, indexing the subgroup corner arrays
+	obj_triangle_t* triangle;
+	//! Offset of first triangle of each subgroup in group and subgroup order, followed by the
+	//! total number of triangles
+	unsigned int* subgroup_offset;
+};
+
+struct obj_bvh_options_t {
+	//! Maximum number of triangles in a leaf, 0 for default
+	unsigned int max_leaf_triangles;
+	//! Number of bins used to evaluate split candidates along each axis, 0 for default, at most 64
+	unsigned int bins;
+	//! Cost of traversing a node relative to intersecting a triangle, 0 for default
+	real traversal_cost;
+};
+
+//! BVH node, 32 bytes
+struct obj_bvh_node_t {
+	//! Minimum corner of node bounds
+	float32_t min[3];
+	//! Index of first child node for interior nodes, the second child follows the first. Index
+	//! of first primitive for leaf nodes
+	unsigned int offset;
+	//! Maximum corner of node bounds
+	float32_t max[3];
+	//! Number of primitives in leaf node, 0 for interior nodes
+	unsigned int count;
+};
+
+struct obj_bvh_primitive_t {
+	//! Group index
+	unsigned int group;
+	//! Subgroup index in group
+	unsigned int subgroup;
+	//! Index of face in subgroup the triangle was triangulated from, 0xFFFFFFFF if not found
+	unsigned int face;
+	//! Triangle index in subgroup
+	unsigned int triangle;
+};
+
+struct obj_bvh_t {
+	//! Nodes, root node first
+	obj_bvh_node_t* node;
+	//! Triangles referenced by leaf nodes, each leaf references a contiguous range
+	obj_bvh_primitive_t* primitive;
+	//! Bounds of the OBJ data structure the BVH was built from, used to validate a stored BVH
+	obj_bounds_t bounds;
+};
+
+struct obj_ray_t {
+	//! Ray origin
+	obj_vertex_t origin;
+	//! Ray direction, need not be unit length
+	obj_normal_t direction;
+	//! Maximum distance along ray, in units of direction length
+	real max_distance;
+};
+
+struct obj_hit_t {
+	//! Group index
+	unsigned int group;
+	//! Subgroup index in group
+	unsigned int subgroup;
+	//! Index of face in subgroup, 0xFFFFFFFF if the triangle could not be mapped to a face
+	unsigned int face;
+	//! Triangle index in subgroup
+	unsigned int triangle;
+	//! Indices into subgroup corner array of the triangle corners
+	unsigned int corner[3];
+	//! Barycentric coordinates of point, the weights of the triangle corners
+	real barycentric[3];
+	//! Position of point
+	obj_vertex_t point;
+	//! Distance along ray in units of direction length for ray casts, distance from query point
+	//! for closest point queries. Negative if nothing was found
+	real distance;
+};
+
+struct obj_validate_report_t {
+	//! Number of vertices with NaN or infinite components
+	size_t nonfinite_vertex;
+	//! Number of normals with NaN or infinite components
+	size_t nonfinite_normal;
+	//! Number of UVs with NaN or infinite components
+	size_t nonfinite_uv;
+	//! Number of finite normals with zero length
+	size_t zero_normal;
+	//! Number of triangles with repeated vertices, zero area or non-finite vertices
+	size_t degenerate_triangle;
+	//! Number of triangles repeating the vertices and winding of another triangle in the subgroup
+	size_t duplicate_triangle;
+	//! Number of edges shared by more than two triangles in a subgroup
+	size_t nonmanifold_edge;
+	//! Number of faces dropped by the last read for referencing undeclared vertices
+	size_t invalid_face;
 };
@@ -0,0 +1,501 @@
+/* validate.c  -  OBJ library  -  Public Domain  -  2019 Mattias Jansson
+ *
+ * This library provides a cross-platform OBJ I/O library in C11 providing
+ * OBJ ascii reading and writing functionality.
+ *
+ * The latest source code maintained by Mattias Jansson is always available at
+ *
+ * https://github.com/mjansson/obj_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without any
+ * restrictions.
+ *
+ */
+
+#include "validate.h"
+#include "bounds.h"
+#include "internal.h"
+
+#include <foundation/array.h>
+#include <foundation/bucketarray.h>
+#include <foundation/memory.h>
+
+static unsigned int INVALID_INDEX = 0xFFFFFFFF;
+
+#if FOUNDATION_SIZE_REAL == 8
+typedef uint64_t validate_bits_t;
+#define VALIDATE_EXPONENT_MASK 0x7FF0000000000000ULL
+#else
+typedef uint32_t validate_bits_t;
+#define VALIDATE_EXPONENT_MASK 0x7F800000U
+#endif
+
+//! Element flag for NaN or infinite components
+#define VALIDATE_FLAG_NONFINITE 1
+//! Element flag for zero length
+#define VALIDATE_FLAG_ZERO 2
+
+//! Squared length below which normals cannot be normalized
+#define VALIDATE_ZERO_LENGTH_SQUARED (REAL_EPSILON * REAL_EPSILON)
+
+typedef struct validate_attribute_t {
+	bucketarray_t* array;
+	//! Number of real components of each element
+	unsigned int components;
+	//! Flag indicating if zero length elements should be flagged
+	bool check_zero;
+	//! Flag indicating if non-finite elements should be zeroed
+	bool repair;
+	//! Problem flags of each element
+	uint8_t* flag;
+	//! Number of non-finite elements in each bucket
+	size_t* nonfinite;
+	//! Number of zero length elements in each bucket
+	size_t* zero;
+} validate_attribute_t;
+
+typedef struct validate_count_t {
+	size_t degenerate;
+	size_t duplicate;
+	size_t nonmanifold;
+} validate_count_t;
+
+typedef struct validate_t {
+	obj_t* obj;
+	unsigned int flags;
+	//! Problem flags of each vertex, null if not checked
+	const uint8_t* vertex_flag;
+	//! Problem flags of each normal, null if not checked
+	const uint8_t* normal_flag;
+	//! Normal problem flags to repair in corners
+	uint8_t normal_repair;
+	//! Problems found in each subgroup
+	validate_count_t* count;
+} validate_t;
+
+typedef struct validate_entry_t {
+	//! Second and third vertex of triangle in winding order, in high and low bits
+	uint64_t key;
+	//! Triangle index in subgroup
+	unsigned int index;
+} validate_entry_t;
+
+//! Check if a value is NaN or infinite from the exponent bits, which is unaffected by fast math
+static FOUNDATION_FORCEINLINE unsigned int
+validate_nonfinite(real value) {
+	validate_bits_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	return ((bits & VALIDATE_EXPONENT_MASK) == VALIDATE_EXPONENT_MASK) ? 1 : 0;
+}
+
+//! Flag a contiguous range of elements, written without branches for vectorization
+static FOUNDATION_FORCEINLINE void
+validate_flag_range(const real* FOUNDATION_RESTRICT value, uint8_t* FOUNDATION_RESTRICT flag, size_t count,
+                    unsigned int components, bool check_zero) {
+	for (size_t ielement = 0; ielement < count; ++ielement) {
+		unsigned int nonfinite = 0;
+		real length_squared = 0;
+		for (unsigned int icomp = 0; icomp < components; ++icomp) {
+			real component = value[(ielement * components) + icomp];
+			nonfinite |= validate_nonfinite(component);
+			length_squared += component * component;
+		}
+		unsigned int zero = (check_zero && (length_squared < VALIDATE_ZERO_LENGTH_SQUARED)) ? VALIDATE_FLAG_ZERO : 0;
+		flag[ielement] = (uint8_t)(nonfinite ? VALIDATE_FLAG_NONFINITE : zero);
+	}
+}
+
+static void
+validate_attribute_bucket(void* context, size_t index) {
+	validate_attribute_t* attribute = context;
+	bucketarray_t* array = attribute->array;
+	size_t offset = index * array->bucket_size;
+	size_t count = array->count - offset;
+	if (count > array->bucket_size)
+		count = array->bucket_size;
+
+	// Elements are tightly packed reals, constant component counts let the loop be specialized
+	real* value = bucketarray_get(array, offset);
+	uint8_t* flag = attribute->flag + offset;
+	if (attribute->components == 2)
+		validate_flag_range(value, flag, count, 2, false);
+	else if (attribute->check_zero)
+		validate_flag_range(value, flag, count, 3, true);
+	else
+		validate_flag_range(value, flag, count, 3, false);
+
+	size_t nonfinite = 0;
+	size_t zero = 0;
+	for (size_t ielement = 0; ielement < count; ++ielement) {
+		nonfinite += flag[ielement] & VALIDATE_FLAG_NONFINITE;
+		zero += flag[ielement] >> 1;
+	}
+	attribute->nonfinite[index] = nonfinite;
+	attribute->zero[index] = zero;
+
+	if (attribute->repair && nonfinite) {
+		for (size_t ielement = 0; ielement < count; ++ielement) {
+			if (flag[ielement] & VALIDATE_FLAG_NONFINITE)
+				memset(value + (ielement * attribute->components), 0, sizeof(real) * attribute->components);
+		}
+	}
+}
+
+/*! Flag non-finite and optionally zero length elements of an attribute array in parallel buckets
+\return Problem flags of each element, null if array is empty */
+static uint8_t*
+validate_attribute(bucketarray_t* array, unsigned int components, bool check_zero, bool repair, size_t* nonfinite,
+                   size_t* zero) {
+	*nonfinite = 0;
+	*zero = 0;
+	if (!array->count)
+		return nullptr;
+
+	size_t bucket_count = (array->count + array->bucket_size - 1) / array->bucket_size;
+	validate_attribute_t attribute;
+	attribute.array = array;
+	attribute.components = components;
+	attribute.check_zero = check_zero;
+	attribute.repair = repair;
+	attribute.flag = memory_allocate(HASH_OBJ, array->count, 0, MEMORY_PERSISTENT);
+	attribute.nonfinite = memory_allocate(HASH_OBJ, sizeof(size_t) * bucket_count * 2, 0, MEMORY_PERSISTENT);
+	attribute.zero = attribute.nonfinite + bucket_count;
+	obj_parallel_for(bucket_count, validate_attribute_bucket, &attribute);
+
+	for (size_t ibucket = 0; ibucket < bucket_count; ++ibucket) {
+		*nonfinite += attribute.nonfinite[ibucket];
+		*zero += attribute.zero[ibucket];
+	}
+	memory_deallocate(attribute.nonfinite);
+	return attribute.flag;
+}
+
+//! Check if triangle has repeated or non-finite vertices, or edges closer to parallel than real precision
+static bool
+validate_triangle_degenerate(const obj_t* obj, const unsigned int* vertex, const uint8_t* vertex_flag) {
+	if ((vertex[0] == vertex[1]) || (vertex[1] == vertex[2]) || (vertex[2] == vertex[0]))
+		return true;
+	if (vertex_flag && (vertex_flag[vertex[0]] || vertex_flag[vertex[1]] || vertex_flag[vertex[2]]))
+		return true;
+
+	const obj_vertex_t* v0 = bucketarray_get(&obj->vertex, vertex[0]);
+	const obj_vertex_t* v1 = bucketarray_get(&obj->vertex, vertex[1]);
+	const obj_vertex_t* v2 = bucketarray_get(&obj->vertex, vertex[2]);
+	real e0x = v1->x - v0->x;
+	real e0y = v1->y - v0->y;
+	real e0z = v1->z - v0->z;
+	real e1x = v2->x - v0->x;
+	real e1y = v2->y - v0->y;
+	real e1z = v2->z - v0->z;
+	real cx = (e0y * e1z) - (e0z * e1y);
+	real cy = (e0z * e1x) - (e0x * e1z);
+	real cz = (e0x * e1y) - (e0y * e1x);
+	real cross_squared = (cx * cx) + (cy * cy) + (cz * cz);
+	real e0_squared = (e0x * e0x) + (e0y * e0y) + (e0z * e0z);
+	real e1_squared = (e1x * e1x) + (e1y * e1y) + (e1z * e1z);
+	return cross_squared <= (REAL_EPSILON * REAL_EPSILON) * e0_squared * e1_squared;
+}
+
+/*! Map each corner to the first corner in its chain of corners sharing a vertex, giving vertex
+indices local to the subgroup
+\param subgroup Subgroup
+\param local Local vertex index of each corner */
+static void
+validate_corner_vertex(const obj_subgroup_t* subgroup, unsigned int* local) {
+	size_t corner_count = subgroup->corner.count;
+	memset(local, 0xFF, sizeof(unsigned int) * corner_count);
+	for (size_t icorner = 0; icorner < corner_count; ++icorner) {
+		if (local[icorner] != INVALID_INDEX)
+			continue;
+		int next = (int)icorner;
+		while ((next >= 0) && ((size_t)next < corner_count) && (local[next] == INVALID_INDEX)) {
+			local[next] = (unsigned int)icorner;
+			next = bucketarray_get_as(obj_corner_t, &subgroup->corner, (size_t)next)->next;
+		}
+	}
+}
+
+/*! Stable counting sort of elements by local vertex index. Inlined with constant element size
+to specialize the element copy.
+\param vertex Local vertex index of each element
+\param element Elements
+\param count Number of elements
+\param size Size of an element
+\param vertex_count Number of local vertex indices
+\param end End of the elements of each vertex in the sorted elements
+\param sorted Sorted elements */
+static FOUNDATION_FORCEINLINE void
+validate_bucket(const unsigned int* vertex, const void* element, size_t count, size_t size, size_t vertex_count,
+                unsigned int* end, void* sorted) {
+	memset(end, 0, sizeof(unsigned int) * vertex_count);
+	for (size_t ielement = 0; ielement < count; ++ielement)
+		++end[vertex[ielement]];
+	unsigned int total = 0;
+	for (size_t ivertex = 0; ivertex < vertex_count; ++ivertex) {
+		unsigned int vertex_elements = end[ivertex];
+		end[ivertex] = total;
+		total += vertex_elements;
+	}
+	for (size_t ielement = 0; ielement < count; ++ielement)
+		memcpy(pointer_offset(sorted, (end[vertex[ielement]]++) * size), pointer_offset_const(element, ielement * size),
+		       size);
+}
+
+static int
+validate_entry_compare(const void* lhs, const void* rhs) {
+	const validate_entry_t* lhs_entry = lhs;
+	const validate_entry_t* rhs_entry = rhs;
+	if (lhs_entry->key != rhs_entry->key)
+		return (lhs_entry->key < rhs_entry->key) ? -1 : 1;
+	return (lhs_entry->index < rhs_entry->index) ? -1 : ((lhs_entry->index > rhs_entry->index) ? 1 : 0);
+}
+
+static int
+validate_index_compare(const void* lhs, const void* rhs) {
+	unsigned int lhs_index = *(const unsigned int*)lhs;
+	unsigned int rhs_index = *(const unsigned int*)rhs;
+	return (lhs_index < rhs_index) ? -1 : ((lhs_index > rhs_index) ? 1 : 0);
+}
+
+//! Bucket size above which buckets are sorted instead of compared pairwise
+#define VALIDATE_SMALL_BUCKET 32
+
+/*! Mark all but the lowest indexed of identical triangles in a bucket of triangles starting
+at the same vertex, in triangle index order
+\return Number of triangles marked */
+static size_t
+validate_mark_duplicates(validate_entry_t* entry, size_t count, uint8_t* drop) {
+	size_t duplicate = 0;
+	if (count > VALIDATE_SMALL_BUCKET) {
+		qsort(entry, count, sizeof(validate_entry_t), validate_entry_compare);
+		for (size_t ientry = 1; ientry < count; ++ientry) {
+			if (entry[ientry].key == entry[ientry - 1].key) {
+				drop[entry[ientry].index] = 1;
+				++duplicate;
+			}
+		}
+		return duplicate;
+	}
+	for (size_t ientry = 1; ientry < count; ++ientry) {
+		for (size_t iprev = 0; iprev < ientry; ++iprev) {
+			if (entry[iprev].key == entry[ientry].key) {
+				drop[entry[ientry].index] = 1;
+				++duplicate;
+				break;
+			}
+		}
+	}
+	return duplicate;
+}
+
+/*! Count edges used by more than two triangles in a bucket of edges from the same vertex
+\return Number of non-manifold edges */
+static size_t
+validate_count_nonmanifold(unsigned int* other, size_t count) {
+	size_t nonmanifold = 0;
+	if (count > VALIDATE_SMALL_BUCKET) {
+		qsort(other, count, sizeof(unsigned int), validate_index_compare);
+		for (size_t iedge = 0; iedge < count;) {
+			size_t next = iedge + 1;
+			while ((next < count) && (other[next] == other[iedge]))
+				++next;
+			if ((next - iedge) > 2)
+				++nonmanifold;
+			iedge = next;
+		}
+		return nonmanifold;
+	}
+	for (size_t iedge = 0; iedge < count; ++iedge) {
+		size_t shared = 1;
+		for (size_t iother = 0; iother < count; ++iother) {
+			if ((iother != iedge) && (other[iother] == other[iedge])) {
+				// Count each edge once, at its first occurrence
+				if (iother < iedge) {
+					shared = 0;
+					break;
+				}
+				++shared;
+			}
+		}
+		if (shared > 2)
+			++nonmanifold;
+	}
+	return nonmanifold;
+}
+
+static void
+validate_subgroup(void* context, size_t index) {
+	validate_t* validate = context;
+	obj_t* obj = validate->obj;
+	validate_count_t* count = validate->count + index;
+	obj_subgroup_t* subgroup = nullptr;
+	for (size_t igroup = 0, gsize = array_size(obj->group); igroup < gsize; ++igroup) {
+		size_t sgsize = array_size(obj->group[igroup]->subgroup);
+		if (index < sgsize) {
+			subgroup = obj->group[igroup]->subgroup[index];
+			break;
+		}
+		index -= sgsize;
+	}
+	if (!subgroup)
+		return;
+
+	bool repair = (validate->flags & OBJ_VALIDATE_REPAIR);
+	if (repair && validate->normal_repair) {
+		for (size_t icorner = 0, csize = subgroup->corner.count; icorner < csize; ++icorner) {
+			obj_corner_t* corner = bucketarray_get(&subgroup->corner, icorner);
+			if (corner->normal && (validate->normal_flag[corner->normal - 1] & validate->normal_repair))
+				corner->normal = 0;
+		}
+	}
+
+	size_t triangle_count = subgroup->triangle.count;
+	if (!triangle_count || !(validate->flags & (OBJ_VALIDATE_DEGENERATE | OBJ_VALIDATE_DUPLICATE |
+	                                            OBJ_VALIDATE_NONMANIFOLD)))
+		return;
+
+	// Triangles and edges are bucketed by lowest vertex with counting sorts over local vertex indices
+	size_t corner_count = subgroup->corner.count;
+	unsigned int* local = memory_allocate(HASH_OBJ, sizeof(unsigned int) * corner_count * 2, 0, MEMORY_PERSISTENT);
+	unsigned int* end = local + corner_count;
+	validate_corner_vertex(subgroup, local);
+
+	unsigned int* first = memory_allocate(HASH_OBJ, sizeof(unsigned int) * triangle_count, 0, MEMORY_PERSISTENT);
+	validate_entry_t* entry =
+	    memory_allocate(HASH_OBJ, sizeof(validate_entry_t) * triangle_count * 2, 0, MEMORY_PERSISTENT);
+	uint8_t* drop = memory_allocate(HASH_OBJ, triangle_count, 0, MEMORY_PERSISTENT | MEMORY_ZERO_INITIALIZED);
+	size_t entry_count = 0;
+	for (size_t itri = 0; itri < triangle_count; ++itri) {
+		const obj_triangle_t* triangle = bucketarray_get(&subgroup->triangle, itri);
+		unsigned int vertex[3];
+		for (int icorner = 0; icorner < 3; ++icorner)
+			vertex[icorner] = bucketarray_get_as(obj_corner_t, &subgroup->corner, triangle->index[icorner])->vertex - 1;
+		if ((validate->flags & OBJ_VALIDATE_DEGENERATE) &&
+		    validate_triangle_degenerate(obj, vertex, validate->vertex_flag)) {
+			++count->degenerate;
+			drop[itri] = 1;
+			continue;
+		}
+		// Rotate to start with the lowest local vertex index, preserving winding
+		unsigned int corner_vertex[3] = {local[triangle->index[0]], local[triangle->index[1]],
+		                                 local[triangle->index[2]]};
+		int lowest = (corner_vertex[1] < corner_vertex[0]) ? 1 : 0;
+		if (corner_vertex[2] < corner_vertex[lowest])
+			lowest = 2;
+		first[entry_count] = corner_vertex[lowest];
+		entry[entry_count].key =
+		    ((uint64_t)corner_vertex[(lowest + 1) % 3] << 32) | corner_vertex[(lowest + 2) % 3];
+		entry[entry_count++].index = (unsigned int)itri;
+	}
+
+	if ((validate->flags & OBJ_VALIDATE_DUPLICATE) && (entry_count > 1)) {
+		validate_entry_t* sorted = entry + triangle_count;
+		validate_bucket(first, entry, entry_count, sizeof(validate_entry_t), corner_count, end, sorted);
+		for (size_t ivertex = 0, begin = 0; ivertex < corner_count; begin = end[ivertex++])
+			count->duplicate += validate_mark_duplicates(sorted + begin, end[ivertex] - begin, drop);
+	}
+
+	if (validate->flags & OBJ_VALIDATE_NONMANIFOLD) {
+		unsigned int* edge = memory_allocate(HASH_OBJ, sizeof(unsigned int) * entry_count * 9, 0, MEMORY_PERSISTENT);
+		unsigned int* other = edge + (entry_count * 3);
+		unsigned int* sorted = other + (entry_count * 3);
+		size_t edge_count = 0;
+		for (size_t ientry = 0; ientry < entry_count; ++ientry) {
+			if (drop[entry[ientry].index])
+				continue;
+			unsigned int vertex[3] = {first[ientry], (unsigned int)(entry[ientry].key >> 32),
+			                          (unsigned int)(entry[ientry].key & 0xFFFFFFFF)};
+			for (int icorner = 0; icorner < 3; ++icorner) {
+				unsigned int from = vertex[icorner];
+				unsigned int to = vertex[(icorner + 1) % 3];
+				edge[edge_count] = (from < to) ? from : to;
+				other[edge_count++] = (from < to) ? to : from;
+			}
+		}
+		validate_bucket(edge, other, edge_count, sizeof(unsigned int), corner_count, end, sorted);
+		for (size_t ivertex = 0, begin = 0; ivertex < corner_count; begin = end[ivertex++])
+			count->nonmanifold += validate_count_nonmanifold(sorted + begin, end[ivertex] - begin);
+		memory_deallocate(edge);
+	}
+
+	if (repair && (count->degenerate || count->duplicate)) {
+		size_t kept = 0;
+		for (size_t itri = 0; itri < triangle_count; ++itri) {
+			if (drop[itri])
+				continue;
+			if (kept != itri)
+				memcpy(bucketarray_get(&subgroup->triangle, kept), bucketarray_get(&subgroup->triangle, itri),
+				       sizeof(obj_triangle_t));
+			++kept;
+		}
+		bucketarray_resize(&subgroup->triangle, kept);
+	}
+
+	memory_deallocate(drop);
+	memory_deallocate(entry);
+	memory_deallocate(first);
+	memory_deallocate(local);
+}
+
+bool
+obj_validate(obj_t* obj, unsigned int flags, obj_validate_report_t* report) {
+	obj_validate_report_t local_report;
+	if (!report)
+		report = &local_report;
+	memset(report, 0, sizeof(obj_validate_report_t));
+	if (!obj)
+		return false;
+
+	bool repair = (flags & OBJ_VALIDATE_REPAIR);
+	bool nonfinite = (flags & OBJ_VALIDATE_NONFINITE);
+	size_t zero = 0;
+
+	// Degenerate triangle checks need non-finite vertices flagged, but only repair them if asked to
+	uint8_t* vertex_flag = nullptr;
+	if (flags & (OBJ_VALIDATE_NONFINITE | OBJ_VALIDATE_DEGENERATE))
+		vertex_flag = validate_attribute(&obj->vertex, 3, false, repair && nonfinite, &report->nonfinite_vertex, &zero);
+	uint8_t* normal_flag = nullptr;
+	if (flags & (OBJ_VALIDATE_NONFINITE | OBJ_VALIDATE_ZERO_NORMAL)) {
+		normal_flag = validate_attribute(&obj->normal, 3, (flags & OBJ_VALIDATE_ZERO_NORMAL), repair && nonfinite,
+		                                 &report->nonfinite_normal, &report->zero_normal);
+	}
+	if (nonfinite) {
+		uint8_t* uv_flag = validate_attribute(&obj->uv, 2, false, repair, &report->nonfinite_uv, &zero);
+		memory_deallocate(uv_flag);
+	} else {
+		report->nonfinite_vertex = 0;
+		report->nonfinite_normal = 0;
+	}
+
+	size_t subgroup_count = 0;
+	for (size_t igroup = 0, gsize = array_size(obj->group); igroup < gsize; ++igroup)
+		subgroup_count += array_size(obj->group[igroup]->subgroup);
+
+	validate_t validate;
+	validate.obj = obj;
+	validate.flags = flags;
+	validate.vertex_flag = vertex_flag;
+	validate.normal_flag = normal_flag;
+	validate.normal_repair = (uint8_t)((report->nonfinite_normal ? VALIDATE_FLAG_NONFINITE : 0) |
+	                                   (report->zero_normal ? VALIDATE_FLAG_ZERO : 0));
+	validate.count = memory_allocate(HASH_OBJ, sizeof(validate_count_t) * (subgroup_count + 1), 0,
+	                                 MEMORY_PERSISTENT | MEMORY_ZERO_INITIALIZED);
+	obj_parallel_for(subgroup_count, validate_subgroup, &validate);
+	for (size_t isub = 0; isub < subgroup_count; ++isub) {
+		report->degenerate_triangle += validate.count[isub].degenerate;
+		report->duplicate_triangle += validate.count[isub].duplicate;
+		report->nonmanifold_edge += validate.count[isub].nonmanifold;
+	}
+	report->invalid_face = obj->invalid_face_count;
+
+	if (repair && report->nonfinite_vertex)
+		obj_compute_bounds(obj);
+
+	memory_deallocate(validate.count);
+	memory_deallocate(normal_flag);
+	memory_deallocate(vertex_flag);
+
+	return !(report->nonfinite_vertex || report->nonfinite_normal || report->nonfinite_uv || report->zero_normal ||
+	         report->degenerate_triangle || report->duplicate_triangle || report->nonmanifold_edge ||
+	         report->invalid_face);
+}
@@ -0,0 +1,37 @@
+/* validate.h  -  OBJ library  -  Public Domain  -  2019 Mattias Jansson
+ *
+ * This library provides a cross-platform OBJ I/O library in C11 providing
+ * OBJ ascii reading and writing functionality.
+ *
+ * The latest source code maintained by Mattias Jansson is always available at
+ *
+ * https://github.com/mjansson/obj_lib
+ *
+ * This library is put in the public domain; you can redistribute it and/or modify it without any
+ * restrictions.
+ *
+ */
+
+#pragma once
+
+/*! \file validate.h
+    Validation and repair of OBJ data */
+
+#include <obj/types.h>
+#include <obj/hashstrings.h>
+
+/*! Check OBJ data for non-finite attributes, zero length normals, degenerate and duplicate
+triangles and non-manifold edges, and optionally repair them in place. Attribute arrays are
+checked bucket by bucket in parallel with vectorizable loops, and triangles are checked by
+subgroups in parallel. Triangle checks only cover subgroups triangulated by obj_triangulate,
+and faces are never modified. Repair zeroes non-finite attributes, removes non-finite and zero
+length normals from corners and drops degenerate and duplicate triangles, including triangles
+with non-finite vertices. Non-manifold edges are only reported. Any BVH built from the OBJ data
+must be rebuilt after repair.
+\param obj OBJ data structure
+\param flags Checks to run, combination of obj_validate_flag_t values
+\param report Optional report receiving the number of problems found by each check, and the
+number of faces dropped by the last read
+\return true if no problems were found, false if problems were found or error */
+OBJ_API bool
+obj_validate(obj_t* obj, unsigned int flags, obj_validate_report_t* report);
@@ -14,6 +14,7 @@
 
 #include <obj/obj.h>
 
+#include <mesh/mesh.h>
 #include <foundation/foundation.h>
 #include <test/test.h>
 
@@ -41,10 +42,624 @@ test_obj_foundation_config(void) {
 	return config;
 }
 
+static const char test_obj_sample[] = "# test\n"
+                                      "v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\n"
+                                      "vt 0 0\nvt 1 0\nvt 1 1\nvt 0 1\n"
+                                      "vn 0 0 1\n"
+                                      "g first\n"
+                                      "usemtl red\n"
+                                      "f 1/1/1 2/2/1 3/3/1 4/4/1\n"
+                                      "usemtl blue\n"
+                                      "f -4/-4/-1 -3/-3/-1 -2/-2/-1\n"
+                                      "g second\n"
+                                      "v 0 0 1\nv 1 0 1\nv 1 1 1\n"
+                                      "f 5 6 7\n"
+                                      "f -3 -2 -1\n"
+                                      "g third\n"
+                                      "v 2 2 2\nv 3 2 2\nv 3 3 2\n"
+                                      "usemtl red\n"
+                                      "f 8 9 10\n"
+                                      "f 1 2 10";
+
+//! Sample data compressed with gzip, using dynamic and fixed Huffman codes
+static const uint8_t test_obj_sample_dynamic[] = {
+    0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x55, 0x8e, 0xdd, 0x0a, 0xc3, 0x20, 0x0c, 0x85, 0xef,
+    0x7d, 0x8a, 0xc0, 0xae, 0x4b, 0x8c, 0xba, 0xbf, 0xd7, 0xd9, 0x6a, 0xb7, 0x42, 0xd7, 0x41, 0xb5, 0x7d, 0xfe, 0x9d,
+    0xa8, 0x2d, 0x8c, 0x84, 0x7c, 0x31, 0xe6, 0x84, 0x73, 0xa2, 0x1c, 0x53, 0x36, 0x1b, 0x59, 0x0d, 0x50, 0x0e, 0x4a,
+    0xa1, 0xad, 0xcc, 0x75, 0x9c, 0xf7, 0x17, 0xbe, 0xeb, 0x10, 0x98, 0x8b, 0x58, 0xcc, 0x8b, 0x86, 0x71, 0xc1, 0xb1,
+    0x35, 0xc5, 0x4f, 0x9e, 0x68, 0x89, 0xbd, 0x19, 0x48, 0x18, 0x41, 0x8e, 0x1d, 0xaa, 0x67, 0x8f, 0x1a, 0x38, 0xb0,
+    0xec, 0x4b, 0x8f, 0x69, 0x8d, 0xd8, 0xea, 0x02, 0x6b, 0x0a, 0x75, 0x9e, 0x35, 0xd1, 0x38, 0xd6, 0xd4, 0xab, 0x29,
+    0x3e, 0xbf, 0x73, 0xdf, 0x3c, 0x4a, 0xf3, 0x28, 0xcd, 0xa3, 0x40, 0x7d, 0xa6, 0x0b, 0x5d, 0xf5, 0x8a, 0x87, 0x8c,
+    0x8a, 0x26, 0xbf, 0xc7, 0x45, 0x25, 0x4e, 0x03, 0xf4, 0x07, 0xd1, 0xfd, 0x3b, 0xbc, 0xd1, 0x9d, 0xc4, 0xaa, 0x55,
+    0xec, 0x88, 0xfd, 0x01, 0x78, 0x12, 0x9f, 0x0e, 0x12, 0x01, 0x00, 0x00};
+
+static const uint8_t test_obj_sample_fixed[] = {
+    0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x53, 0x56, 0x28, 0x49, 0x2d, 0x2e, 0xe1, 0x2a, 0x53,
+    0x30, 0x00, 0x41, 0x20, 0x6d, 0x08, 0xa7, 0x0d, 0xc1, 0xb4, 0x01, 0x84, 0x2e, 0x81, 0x08, 0x97, 0xc0, 0x78, 0x40,
+    0x69, 0x88, 0x20, 0x90, 0xca, 0x03, 0x6b, 0x36, 0xe4, 0x4a, 0x57, 0x48, 0xcb, 0x2c, 0x02, 0x1a, 0x56, 0x5a, 0x9c,
+    0x9a, 0x5b, 0x92, 0xa3, 0x50, 0x94, 0x9a, 0xc2, 0x95, 0xa6, 0x60, 0xa8, 0x0f, 0x84, 0x0a, 0x46, 0xfa, 0x46, 0x40,
+    0xd2, 0x58, 0xdf, 0x18, 0x48, 0x9a, 0xe8, 0x9b, 0xe8, 0x1b, 0xc2, 0x14, 0x25, 0xe5, 0x94, 0xa6, 0x02, 0x55, 0xe9,
+    0x9a, 0xe8, 0x83, 0x90, 0xa1, 0x82, 0xae, 0xb1, 0x3e, 0x08, 0x01, 0x19, 0x46, 0xfa, 0x20, 0x04, 0x32, 0xb5, 0x38,
+    0x35, 0x39, 0x3f, 0x2f, 0x05, 0xea, 0x46, 0x43, 0xa8, 0x1b, 0x0d, 0xa1, 0x6e, 0x34, 0x04, 0xea, 0x36, 0x55, 0x30,
+    0x53, 0x30, 0x07, 0x99, 0x62, 0x0c, 0xd4, 0xa6, 0x00, 0xd6, 0x53, 0x92, 0x91, 0x59, 0x04, 0xd2, 0x62, 0x04, 0x82,
+    0x40, 0xda, 0x18, 0x4e, 0x03, 0x59, 0xa8, 0x2e, 0xb4, 0x50, 0xb0, 0x54, 0x30, 0x34, 0x00, 0x39, 0x15, 0xa8, 0xc6,
+    0xd0, 0x00, 0x00, 0x78, 0x12, 0x9f, 0x0e, 0x12, 0x01, 0x00, 0x00};
+
+static const char test_obj_material_lib[] = "newmtl red\n"
+                                            "Kd 1 0 0\n"
+                                            "map_Kd tex/shared.png\n"
+                                            "newmtl blue\n"
+                                            "Kd 0 0 1\n"
+                                            "map_Kd tex/shared.png\n"
+                                            "map_bump tex/bump.png\n"
+                                            "newmtl last\n";
+
+//! Cube centered at origin with faces wound counter clockwise seen from outside
+#define TEST_OBJ_CUBE_VERTICES "v -1 -1 -1\nv 1 -1 -1\nv 1 1 -1\nv -1 1 -1\nv -1 -1 1\nv 1 -1 1\nv 1 1 1\nv -1 1 1\n"
+#define TEST_OBJ_CUBE_FACES "f 1 4 3 2\nf 5 6 7 8\nf 1 2 6 5\nf 4 8 7 3\nf 1 5 8 4\nf 2 3 7 6\n"
+
+static stream_t*
+test_obj_stream(const char* data, size_t size) {
+	return buffer_stream_allocate((void*)(uintptr_t)data, STREAM_IN | STREAM_BINARY, size, size, false, false);
+}
+
+//! Open material libraries from memory instead of files
+static stream_t*
+test_obj_open_material_lib(const char* path, size_t length, unsigned int mode) {
+	FOUNDATION_UNUSED(mode);
+	if (string_equal(path, length, STRING_CONST("test.mtl")))
+		return test_obj_stream(STRING_CONST(test_obj_material_lib));
+	return nullptr;
+}
+
+static void
+test_obj_count_subgroup(void* context, obj_t* obj, obj_group_t* group, obj_subgroup_t* subgroup) {
+	FOUNDATION_UNUSED(obj);
+	FOUNDATION_UNUSED(group);
+	FOUNDATION_UNUSED(subgroup);
+	++*(size_t*)context;
+}
+
+static size_t
+test_obj_subgroup_count(const obj_t* obj) {
+	size_t count = 0;
+	for (size_t igroup = 0, gsize = array_size(obj->group); igroup < gsize; ++igroup)
+		count += array_size(obj->group[igroup]->subgroup);
+	return count;
+}
+
+/*! Generate OBJ data for a grid of quads in the XY plane with a bump in Z
+\param size Number of quads along each axis
+\return Generated data, deallocate with memory_deallocate */
+static string_t
+test_obj_grid(unsigned int size) {
+	size_t capacity = ((size_t)(size + 1) * (size + 1) * 48) + ((size_t)size * size * 48);
+	char* buffer = memory_allocate(HASH_OBJ, capacity, 0, MEMORY_PERSISTENT);
+	size_t length = 0;
+	for (unsigned int y = 0; y <= size; ++y) {
+		for (unsigned int x = 0; x <= size; ++x) {
+			real dx = (real)x - ((real)size / 2);
+			real dy = (real)y - ((real)size / 2);
+			real z = (real)size / (REAL_C(1.0) + ((dx * dx) + (dy * dy)) / (real)size);
+			length += string_format(buffer + length, capacity - length, STRING_CONST("v %u %u %.4f\n"), x, y,
+			                        (double)z)
+			              .length;
+		}
+	}
+	for (unsigned int y = 0; y < size; ++y) {
+		for (unsigned int x = 0; x < size; ++x) {
+			unsigned int base = (y * (size + 1)) + x + 1;
+			length += string_format(buffer + length, capacity - length, STRING_CONST("f %u %u %u %u\n"), base,
+			                        base + 1, base + size + 2, base + size + 1)
+			              .length;
+		}
+	}
+	return string(buffer, length);
+}
+
+/*! Generate OBJ data for a closed UV sphere of unit radius made of quads
+\param columns Number of quads around the sphere
+\param rows Number of quads from pole to pole
+\return Generated data, deallocate with memory_deallocate */
+static string_t
+test_obj_sphere(unsigned int columns, unsigned int rows) {
+	size_t capacity = ((size_t)(rows + 1) * columns * 40) + ((size_t)rows * columns * 32);
+	char* buffer = memory_allocate(HASH_OBJ, capacity, 0, MEMORY_PERSISTENT);
+	size_t length = 0;
+	for (unsigned int row = 0; row <= rows; ++row) {
+		for (unsigned int column = 0; column < columns; ++column) {
+			real theta = (REAL_PI * (real)row) / (real)rows;
+			real phi = (REAL_C(2.0) * REAL_PI * (real)column) / (real)columns;
+			length += string_format(buffer + length, capacity - length, STRING_CONST("v %.5f %.5f %.5f\n"),
+			                        (double)(math_sin(theta) * math_cos(phi)), (double)math_cos(theta),
+			                        (double)(math_sin(theta) * math_sin(phi)))
+			              .length;
+		}
+	}
+	for (unsigned int row = 0; row < rows; ++row) {
+		for (unsigned int column = 0; column < columns; ++column) {
+			unsigned int base = (row * columns) + column + 1;
+			unsigned int next = (row * columns) + ((column + 1) % columns) + 1;
+			length += string_format(buffer + length, capacity - length, STRING_CONST("f %u %u %u %u\n"), base, next,
+			                        next + columns, base + columns)
+			              .length;
+		}
+	}
+	return string(buffer, length);
+}
+
+static size_t
+test_obj_face_count(const obj_t* obj) {
+	size_t count = 0;
+	for (size_t igroup = 0, gsize = array_size(obj->group); igroup < gsize; ++igroup) {
+		for (size_t isub = 0, sgsize = array_size(obj->group[igroup]->subgroup); isub < sgsize; ++isub)
+			count += obj->group[igroup]->subgroup[isub]->face.count;
+	}
+	return count;
+}
+
+static size_t
+test_obj_triangle_count(const obj_t* obj) {
+	size_t count = 0;
+	for (size_t igroup = 0, gsize = array_size(obj->group); igroup < gsize; ++igroup) {
+		for (size_t isub = 0, sgsize = array_size(obj->group[igroup]->subgroup); isub < sgsize; ++isub)
+			count += obj->group[igroup]->subgroup[isub]->triangle.count;
+	}
+	return count;
+}
+
+static bool
+test_obj_read_text(obj_t* obj, const char* text, size_t length) {
+	stream_t* stream = test_obj_stream(text, length);
+	bool result = obj_read(obj, stream);
+	stream_deallocate(stream);
+	return result;
+}
+
+//! Read and triangulate a grid generated by test_obj_grid
+static bool
+test_obj_read_grid(obj_t* obj, unsigned int size) {
+	string_t text = test_obj_grid(size);
+	stream_t* stream = test_obj_stream(STRING_ARGS(text));
+	bool result = obj_read(obj, stream) && obj_triangulate(obj);
+	stream_deallocate(stream);
+	memory_deallocate(text.str);
+	return result;
+}
+
+//! Signature term of a triangle, independent of first corner but not of winding
+static double
+test_obj_triangle_term(const obj_vertex_t* const vertex[3]) {
+	double weight[3][2];
+	for (unsigned int icorner = 0; icorner < 3; ++icorner) {
+		weight[icorner][0] =
+		    (double)vertex[icorner]->x + (3.0 * (double)vertex[icorner]->y) + (7.0 * (double)vertex[icorner]->z);
+		weight[icorner][1] = (5.0 * (double)vertex[icorner]->x) + (11.0 * (double)vertex[icorner]->y) +
+		                     (13.0 * (double)vertex[icorner]->z);
+	}
+	return (weight[0][0] * weight[1][1]) + (weight[1][0] * weight[2][1]) + (weight[2][0] * weight[0][1]);
+}
+
+static const obj_vertex_t*
+test_obj_corner_vertex(const obj_t* obj, const obj_subgroup_t* subgroup, unsigned int index) {
+	const obj_corner_t* corner = bucketarray_get(&subgroup->corner, index);
+	return bucketarray_get(&obj->vertex, corner->vertex - 1);
+}
+
+/*! Calculate a signature of subgroup triangle positions independent of triangle order, corner
+numbering and first corner, but not of winding
+\param obj OBJ data structure
+\param subgroup Subgroup
+\return Signature */
+static double
+test_obj_triangle_signature(const obj_t* obj, const obj_subgroup_t* subgroup) {
+	double signature = 0;
+	for (size_t itri = 0; itri < subgroup->triangle.count; ++itri) {
+		const obj_triangle_t* triangle = bucketarray_get(&subgroup->triangle, itri);
+		const obj_vertex_t* vertex[3];
+		for (unsigned int icorner = 0; icorner < 3; ++icorner)
+			vertex[icorner] = test_obj_corner_vertex(obj, subgroup, triangle->index[icorner]);
+		signature += test_obj_triangle_term(vertex);
+	}
+	return signature;
+}
+
+static bool
+test_obj_signature_equal(double first, double second) {
+	double tolerance = 1e-9 * ((first < 0) ? -first : first);
+	return ((first - second) <= tolerance) && ((second - first) <= tolerance);
+}
+
+/*! Check meshlet limits, that every triangle is in exactly one meshlet, and that bounding
+spheres and normal cones contain the meshlet corners and triangle normals
+\param obj OBJ data structure
+\param meshlets Meshlets
+\param limits Limits used to build the meshlets
+\return true if meshlets are valid, false if not */
+static bool
+test_obj_meshlets_valid(const obj_t* obj, const obj_meshlets_t* meshlets, const obj_meshlet_limits_t* limits) {
+	size_t meshlet_count = array_size(meshlets->meshlet);
+	for (size_t igroup = 0, gsize = array_size(obj->group); igroup < gsize; ++igroup) {
+		for (size_t isub = 0, sgsize = array_size(obj->group[igroup]->subgroup); isub < sgsize; ++isub) {
+			const obj_subgroup_t* subgroup = obj->group[igroup]->subgroup[isub];
+			size_t triangle_count = 0;
+			double signature = 0;
+			for (size_t imeshlet = 0; imeshlet < meshlet_count; ++imeshlet) {
+				const obj_meshlet_t* meshlet = meshlets->meshlet + imeshlet;
+				if ((meshlet->group != igroup) || (meshlet->subgroup != isub))
+					continue;
+				if (!meshlet->triangle_count || (meshlet->triangle_count > limits->max_triangles) ||
+				    (meshlet->vertex_count > limits->max_vertices))
+					return false;
+				const unsigned int* corner = meshlets->vertex + meshlet->vertex_offset;
+				for (unsigned int ivertex = 0; ivertex < meshlet->vertex_count; ++ivertex) {
+					if (corner[ivertex] >= subgroup->corner.count)
+						return false;
+					const obj_vertex_t* vertex = test_obj_corner_vertex(obj, subgroup, corner[ivertex]);
+					real dx = vertex->x - meshlet->center.x;
+					real dy = vertex->y - meshlet->center.y;
+					real dz = vertex->z - meshlet->center.z;
+					if (math_sqrt((dx * dx) + (dy * dy) + (dz * dz)) > meshlet->radius + REAL_C(0.0001))
+						return false;
+				}
+				const uint8_t* local = meshlets->triangle + meshlet->triangle_offset;
+				for (unsigned int itri = 0; itri < meshlet->triangle_count; ++itri, local += 3) {
+					const obj_vertex_t* vertex[3];
+					for (unsigned int icorner = 0; icorner < 3; ++icorner) {
+						if (local[icorner] >= meshlet->vertex_count)
+							return false;
+						vertex[icorner] = test_obj_corner_vertex(obj, subgroup, corner[local[icorner]]);
+					}
+					signature += test_obj_triangle_term(vertex);
+					real ex = vertex[1]->x - vertex[0]->x, ey = vertex[1]->y - vertex[0]->y;
+					real ez = vertex[1]->z - vertex[0]->z;
+					real fx = vertex[2]->x - vertex[0]->x, fy = vertex[2]->y - vertex[0]->y;
+					real fz = vertex[2]->z - vertex[0]->z;
+					real nx = (ey * fz) - (ez * fy);
+					real ny = (ez * fx) - (ex * fz);
+					real nz = (ex * fy) - (ey * fx);
+					real length = math_sqrt((nx * nx) + (ny * ny) + (nz * nz));
+					real dot =
+					    (nx * meshlet->cone_axis.nx) + (ny * meshlet->cone_axis.ny) + (nz * meshlet->cone_axis.nz);
+					if ((length > REAL_C(0.0)) && (dot < (meshlet->cone_cutoff - REAL_C(0.001)) * length))
+						return false;
+				}
+				triangle_count += meshlet->triangle_count;
+			}
+			if ((triangle_count != subgroup->triangle.count) ||
+			    !test_obj_signature_equal(signature, test_obj_triangle_signature(obj, subgroup)))
+				return false;
+		}
+	}
+	return true;
+}
+
+//! Check that all triangles index existing corners and are not collapsed to a line or point
+static bool
+test_obj_triangles_valid(const obj_t* obj) {
+	for (size_t igroup = 0, gsize = array_size(obj->group); igroup < gsize; ++igroup) {
+		for (size_t isub = 0, sgsize = array_size(obj->group[igroup]->subgroup); isub < sgsize; ++isub) {
+			const obj_subgroup_t* subgroup = obj->group[igroup]->subgroup[isub];
+			for (size_t itri = 0; itri < subgroup->triangle.count; ++itri) {
+				const obj_triangle_t* triangle = bucketarray_get(&subgroup->triangle, itri);
+				if ((triangle->index[0] >= subgroup->corner.count) || (triangle->index[1] >= subgroup->corner.count) ||
+				    (triangle->index[2] >= subgroup->corner.count) || (triangle->index[0] == triangle->index[1]) ||
+				    (triangle->index[1] == triangle->index[2]) || (triangle->index[0] == triangle->index[2]))
+					return false;
+			}
+		}
+	}
+	return true;
+}
+
+static size_t
+test_obj_corner_count(const obj_t* obj) {
+	size_t count = 0;
+	for (size_t igroup = 0, gsize = array_size(obj->group); igroup < gsize; ++igroup) {
+		for (size_t isub = 0, sgsize = array_size(obj->group[igroup]->subgroup); isub < sgsize; ++isub)
+			count += obj->group[igroup]->subgroup[isub]->corner.count;
+	}
+	return count;
+}
+
+/*! Check that all corners have unit length normals pointing away from the origin
+\param obj OBJ data structure centered at origin
+\param min_dot Minimum dot product of normal and normalized position
+\return true if all normals are valid, false if not */
+static bool
+test_obj_normals_outward(const obj_t* obj, real min_dot) {
+	for (size_t igroup = 0, gsize = array_size(obj->group); igroup < gsize; ++igroup) {
+		for (size_t isub = 0, sgsize = array_size(obj->group[igroup]->subgroup); isub < sgsize; ++isub) {
+			const obj_subgroup_t* subgroup = obj->group[igroup]->subgroup[isub];
+			for (size_t icorner = 0; icorner < subgroup->corner.count; ++icorner) {
+				const obj_corner_t* corner = bucketarray_get(&subgroup->corner, icorner);
+				if (!corner->normal || (corner->normal > obj->normal.count))
+					return false;
+				const obj_vertex_t* vertex = bucketarray_get(&obj->vertex, corner->vertex - 1);
+				const obj_normal_t* normal = bucketarray_get(&obj->normal, corner->normal - 1);
+				real length =
+				    math_sqrt((normal->nx * normal->nx) + (normal->ny * normal->ny) + (normal->nz * normal->nz));
+				real distance = math_sqrt((vertex->x * vertex->x) + (vertex->y * vertex->y) + (vertex->z * vertex->z));
+				real dot = (vertex->x * normal->nx) + (vertex->y * normal->ny) + (vertex->z * normal->nz);
+				if ((math_abs(length - REAL_C(1.0)) > REAL_C(0.0001)) || (dot < min_dot * distance))
+					return false;
+			}
+		}
+	}
+	return true;
+}
+
+static bool
+test_obj_bvh_node_contains(const obj_bvh_node_t* node, const float32_t* min, const float32_t* max) {
+	for (unsigned int axis = 0; axis < 3; ++axis) {
+		if ((min[axis] < node->min[axis]) || (max[axis] > node->max[axis]))
+			return false;
+	}
+	return true;
+}
+
+/*! Check that BVH child nodes are inside their parent, leaves contain their triangles and
+are within the size limit, and every triangle is referenced by exactly one leaf
+\param obj OBJ data structure
+\param bvh BVH
+\param max_leaf_triangles Maximum number of triangles in a leaf
+\return true if BVH is valid, false if not */
+static bool
+test_obj_bvh_valid(const obj_t* obj, const obj_bvh_t* bvh, unsigned int max_leaf_triangles) {
+	size_t node_count = array_size(bvh->node);
+	size_t primitive_count = array_size(bvh->primitive);
+	if (primitive_count != test_obj_triangle_count(obj))
+		return false;
+	unsigned int* referenced = memory_allocate(HASH_OBJ, sizeof(unsigned int) * (primitive_count + 1), 0,
+	                                           MEMORY_PERSISTENT | MEMORY_ZERO_INITIALIZED);
+	bool valid = true;
+	for (size_t inode = 0; valid && (inode < node_count); ++inode) {
+		const obj_bvh_node_t* node = bvh->node + inode;
+		if (!node->count) {
+			valid = (node->offset > inode) && ((node->offset + 1) < node_count) &&
+			        test_obj_bvh_node_contains(node, bvh->node[node->offset].min, bvh->node[node->offset].max) &&
+			        test_obj_bvh_node_contains(node, bvh->node[node->offset + 1].min, bvh->node[node->offset + 1].max);
+			continue;
+		}
+		if ((node->count > max_leaf_triangles) || ((node->offset + node->count) > primitive_count)) {
+			valid = false;
+			break;
+		}
+		for (unsigned int iprim = node->offset; iprim < node->offset + node->count; ++iprim) {
+			const obj_bvh_primitive_t* primitive = bvh->primitive + iprim;
+			const obj_subgroup_t* subgroup = obj->group[primitive->group]->subgroup[primitive->subgroup];
+			const obj_triangle_t* triangle = bucketarray_get(&subgroup->triangle, primitive->triangle);
+			++referenced[iprim];
+			for (unsigned int icorner = 0; icorner < 3; ++icorner) {
+				const obj_vertex_t* vertex = test_obj_corner_vertex(obj, subgroup, triangle->index[icorner]);
+				float32_t point[3] = {(float32_t)vertex->x, (float32_t)vertex->y, (float32_t)vertex->z};
+				if (!test_obj_bvh_node_contains(node, point, point))
+					valid = false;
+			}
+		}
+	}
+	for (size_t iprim = 0; valid && (iprim < primitive_count); ++iprim)
+		valid = (referenced[iprim] == 1);
+	memory_deallocate(referenced);
+	return valid;
+}
+
+//! Deterministic pseudo random number in [0, 1]
+static real
+test_obj_random(unsigned int* state) {
+	*state = (*state * 1103515245U) + 12345U;
+	return (real)((*state >> 8) & 0xFFFF) / REAL_C(65535.0);
+}
+
+/*! Generate OBJ data for a grid of quads with separate vertices for each quad corner, with
+positions moved by a deterministic jitter
+\param size Number of quads along each axis
+\param jitter Maximum jitter offset
+\param attributes Flag indicating if each vertex should have a UV and a normal
+\return Generated data, deallocate with memory_deallocate */
+static string_t
+test_obj_soup(unsigned int size, real jitter, bool attributes) {
+	size_t capacity = ((size_t)size * size * 4 * 96) + 64;
+	char* buffer = memory_allocate(HASH_OBJ, capacity, 0, MEMORY_PERSISTENT);
+	size_t length = 0;
+	unsigned int random = 1;
+	unsigned int base = 1;
+	for (unsigned int y = 0; y < size; ++y) {
+		for (unsigned int x = 0; x < size; ++x, base += 4) {
+			unsigned int corner_x[4] = {x, x + 1, x + 1, x};
+			unsigned int corner_y[4] = {y, y, y + 1, y + 1};
+			for (unsigned int icorner = 0; icorner < 4; ++icorner) {
+				real offset = jitter * (test_obj_random(&random) - REAL_C(0.5));
+				length += string_format(buffer + length, capacity - length, STRING_CONST("v %.7f %.7f 0\n"),
+				                        (double)(((real)corner_x[icorner] * REAL_C(0.1)) + offset),
+				                        (double)(((real)corner_y[icorner] * REAL_C(0.1)) - offset))
+				              .length;
+				if (attributes)
+					length += string_format(buffer + length, capacity - length, STRING_CONST("vt %u %u\nvn 0 0 1\n"),
+					                        corner_x[icorner], corner_y[icorner])
+					              .length;
+			}
+			if (attributes)
+				length += string_format(buffer + length, capacity - length,
+				                        STRING_CONST("f %u/%u/%u %u/%u/%u %u/%u/%u %u/%u/%u\n"), base, base, base,
+				                        base + 1, base + 1, base + 1, base + 2, base + 2, base + 2, base + 3, base + 3,
+				                        base + 3)
+				              .length;
+			else
+				length += string_format(buffer + length, capacity - length, STRING_CONST("f %u %u %u %u\n"), base,
+				                        base + 1, base + 2, base + 3)
+				              .length;
+		}
+	}
+	return string(buffer, length);
+}
+
+/*! Intersect a ray with every triangle, both sides
+\param obj OBJ data structure
+\param origin Ray origin
+\param direction Ray direction
+\return Distance to closest hit in units of direction length, negative if no hit */
+static double
+test_obj_raycast_brute(const obj_t* obj, const double* origin, const double* direction) {
+	double closest = -1;
+	for (size_t igroup = 0, gsize = array_size(obj->group); igroup < gsize; ++igroup) {
+		for (size_t isub = 0, sgsize = array_size(obj->group[igroup]->subgroup); isub < sgsize; ++isub) {
+			const obj_subgroup_t* subgroup = obj->group[igroup]->subgroup[isub];
+			for (size_t itri = 0; itri < subgroup->triangle.count; ++itri) {
+				const obj_triangle_t* triangle = bucketarray_get(&subgroup->triangle, itri);
+				double v[3][3];
+				for (unsigned int icorner = 0; icorner < 3; ++icorner) {
+					const obj_vertex_t* vertex = test_obj_corner_vertex(obj, subgroup, triangle->index[icorner]);
+					v[icorner][0] = (double)vertex->x;
+					v[icorner][1] = (double)vertex->y;
+					v[icorner][2] = (double)vertex->z;
+				}
+				double e1[3], e2[3], offset[3];
+				for (unsigned int axis = 0; axis < 3; ++axis) {
+					e1[axis] = v[1][axis] - v[0][axis];
+					e2[axis] = v[2][axis] - v[0][axis];
+					offset[axis] = origin[axis] - v[0][axis];
+				}
+				double p[3] = {(direction[1] * e2[2]) - (direction[2] * e2[1]),
+				               (direction[2] * e2[0]) - (direction[0] * e2[2]),
+				               (direction[0] * e2[1]) - (direction[1] * e2[0])};
+				double det = (e1[0] * p[0]) + (e1[1] * p[1]) + (e1[2] * p[2]);
+				if (det == 0)
+					continue;
+				double u = ((offset[0] * p[0]) + (offset[1] * p[1]) + (offset[2] * p[2])) / det;
+				if ((u < 0) || (u > 1))
+					continue;
+				double q[3] = {(offset[1] * e1[2]) - (offset[2] * e1[1]), (offset[2] * e1[0]) - (offset[0] * e1[2]),
+				               (offset[0] * e1[1]) - (offset[1] * e1[0])};
+				double w = ((direction[0] * q[0]) + (direction[1] * q[1]) + (direction[2] * q[2])) / det;
+				if ((w < 0) || ((u + w) > 1))
+					continue;
+				double distance = ((e2[0] * q[0]) + (e2[1] * q[1]) + (e2[2] * q[2])) / det;
+				if ((distance >= 0) && ((closest < 0) || (distance < closest)))
+					closest = distance;
+			}
+		}
+	}
+	return closest;
+}
+
+/*! Find the smallest distance from a point to a dense barycentric sampling of every triangle,
+an upper bound of the distance to the closest point
+\param obj OBJ data structure
+\param point Query point
+\return Distance to closest sample */
+static double
+test_obj_closest_point_brute(const obj_t* obj, const double* point) {
+	double closest = 1e30;
+	for (size_t igroup = 0, gsize = array_size(obj->group); igroup < gsize; ++igroup) {
+		for (size_t isub = 0, sgsize = array_size(obj->group[igroup]->subgroup); isub < sgsize; ++isub) {
+			const obj_subgroup_t* subgroup = obj->group[igroup]->subgroup[isub];
+			for (size_t itri = 0; itri < subgroup->triangle.count; ++itri) {
+				const obj_triangle_t* triangle = bucketarray_get(&subgroup->triangle, itri);
+				const obj_vertex_t* vertex[3];
+				for (unsigned int icorner = 0; icorner < 3; ++icorner)
+					vertex[icorner] = test_obj_corner_vertex(obj, subgroup, triangle->index[icorner]);
+				for (unsigned int first = 0; first <= 20; ++first) {
+					for (unsigned int second = 0; (first + second) <= 20; ++second) {
+						double w1 = (double)first / 20.0;
+						double w2 = (double)second / 20.0;
+						double w0 = 1.0 - w1 - w2;
+						double dx = (w0 * (double)vertex[0]->x) + (w1 * (double)vertex[1]->x) +
+						            (w2 * (double)vertex[2]->x) - point[0];
+						double dy = (w0 * (double)vertex[0]->y) + (w1 * (double)vertex[1]->y) +
+						            (w2 * (double)vertex[2]->y) - point[1];
+						double dz = (w0 * (double)vertex[0]->z) + (w1 * (double)vertex[1]->z) +
+						            (w2 * (double)vertex[2]->z) - point[2];
+						double distance = (dx * dx) + (dy * dy) + (dz * dz);
+						if (distance < closest)
+							closest = distance;
+					}
+				}
+			}
+		}
+	}
+	return (double)math_sqrt((real)closest);
+}
+
+//! Geometric normal of a subgroup triangle from its winding, not normalized
+static void
+test_obj_triangle_normal(const obj_t* obj, const obj_subgroup_t* subgroup, size_t itri, real* normal) {
+	const obj_triangle_t* triangle = bucketarray_get(&subgroup->triangle, itri);
+	const obj_vertex_t* v0 = test_obj_corner_vertex(obj, subgroup, triangle->index[0]);
+	const obj_vertex_t* v1 = test_obj_corner_vertex(obj, subgroup, triangle->index[1]);
+	const obj_vertex_t* v2 = test_obj_corner_vertex(obj, subgroup, triangle->index[2]);
+	real e0[3] = {v1->x - v0->x, v1->y - v0->y, v1->z - v0->z};
+	real e1[3] = {v2->x - v0->x, v2->y - v0->y, v2->z - v0->z};
+	normal[0] = (e0[1] * e1[2]) - (e0[2] * e1[1]);
+	normal[1] = (e0[2] * e1[0]) - (e0[0] * e1[2]);
+	normal[2] = (e0[0] * e1[1]) - (e0[1] * e1[0]);
+}
+
+static bool
+test_obj_near(real first, real second) {
+	return math_abs(first - second) < REAL_C(0.00001);
+}
+
+typedef struct test_obj_completion_t {
+	size_t subgroup_count;
+	size_t triangle_count;
+	bool valid;
+} test_obj_completion_t;
+
+static void
+test_obj_check_subgroup(void* context, obj_t* obj, obj_group_t* group, obj_subgroup_t* subgroup) {
+	test_obj_completion_t* completion = context;
+	++completion->subgroup_count;
+	completion->triangle_count += subgroup->triangle.count;
+	if (!group || !subgroup->triangle.count)
+		completion->valid = false;
+
+	// Subgroup is triangulated and can be packed to an indexed mesh while reading continues
+	obj_packed_vertex_t* vertices =
+	    memory_allocate(HASH_OBJ, sizeof(obj_packed_vertex_t) * subgroup->corner.count, 0, MEMORY_PERSISTENT);
+	obj_subgroup_pack(obj, subgroup, vertices);
+	for (size_t itri = 0; itri < subgroup->triangle.count; ++itri) {
+		const obj_triangle_t* triangle = bucketarray_get(&subgroup->triangle, itri);
+		for (unsigned int icorner = 0; icorner < 3; ++icorner) {
+			unsigned int index = triangle->index[icorner];
+			if (index >= subgroup->corner.count) {
+				completion->valid = false;
+				continue;
+			}
+			const obj_corner_t* corner = bucketarray_get(&subgroup->corner, index);
+			const obj_vertex_t* vertex = bucketarray_get(&obj->vertex, corner->vertex - 1);
+			if ((vertices[index].position.x != vertex->x) || (vertices[index].position.y != vertex->y) ||
+			    (vertices[index].position.z != vertex->z))
+				completion->valid = false;
+		}
+	}
+	memory_deallocate(vertices);
+}
+
+typedef struct test_obj_progress_state_t {
+	obj_t* obj;
+	size_t calls[OBJ_PROGRESS_MESH + 1];
+	size_t done[OBJ_PROGRESS_MESH + 1];
+	size_t cancel_at;
+	bool ordered;
+} test_obj_progress_state_t;
+
+static void
+test_obj_report_progress(void* context, obj_progress_phase_t phase, size_t done, size_t total) {
+	test_obj_progress_state_t* progress = context;
+	if ((done < progress->done[phase]) || (total && (done > total)))
+		progress->ordered = false;
+	++progress->calls[phase];
+	progress->done[phase] = done;
+	if (progress->cancel_at && (done >= progress->cancel_at))
+		atomic_store32(&progress->obj->progress.cancel, 1, memory_order_release);
+}
+
 static int
 test_obj_initialize(void) {
 	obj_config_t config;
 	memset(&config, 0, sizeof(config));
+	config.stream_open = test_obj_open_material_lib;
 	log_set_suppress(HASH_OBJ, ERRORLEVEL_INFO);
 	return obj_module_initialize(config);
 }
@@ -54,8 +669,1793 @@ test_obj_finalize(void) {
 	obj_module_finalize();
 }
 
+DECLARE_TEST(obj, corners) {
+	// Relative indices count back from the last declared attribute, and corners sharing a vertex
+	// but differing in normal or UV are linked in a chain in order of creation
+	const char text[] = "v 0 0 0\nv 1 0 0\nv 0 1 0\nv 1 1 0\nvt 0 0\nvt 1 0\nvt 0 1\nvn 0 0 1\nvn 0 0 -1\n"
+	                    "f -4/-3/-2 -3/-2/-2 -2/-1/-2\nf 1/1/2 3/3/2 2/2/2\nf 1/2/1 2/2/1 4/3/1\n";
+	const int expected[8][4] = {{1, 1, 1, 3},  {2, 1, 2, 5}, {3, 1, 3, 4},  {1, 2, 1, 6},
+	                            {3, 2, 3, -1}, {2, 2, 2, -1}, {1, 1, 2, -1}, {4, 1, 3, -1}};
+	const unsigned int expected_index[9] = {0, 1, 2, 3, 4, 5, 6, 1, 7};
+
+	obj_t obj;
+	obj_initialize(&obj);
+	stream_t* stream = buffer_stream_allocate((void*)(uintptr_t)text, STREAM_IN | STREAM_BINARY, sizeof(text) - 1,
+	                                          sizeof(text) - 1, false, false);
+	EXPECT_TRUE(obj_read(&obj, stream));
+	stream_deallocate(stream);
+
+	EXPECT_SIZEEQ(array_size(obj.group), 1);
+	obj_subgroup_t* subgroup = obj.group[0]->subgroup[0];
+	EXPECT_SIZEEQ(subgroup->face.count, 3);
+	EXPECT_SIZEEQ(subgroup->corner.count, 8);
+	EXPECT_SIZEEQ(subgroup->index.count, 9);
+	for (size_t icorner = 0; icorner < 8; ++icorner) {
+		const obj_corner_t* corner = bucketarray_get(&subgroup->corner, icorner);
+		EXPECT_UINTEQ(corner->vertex, (unsigned int)expected[icorner][0]);
+		EXPECT_UINTEQ(corner->normal, (unsigned int)expected[icorner][1]);
+		EXPECT_UINTEQ(corner->uv, (unsigned int)expected[icorner][2]);
+		EXPECT_INTEQ(corner->next, expected[icorner][3]);
+	}
+	for (size_t iindex = 0; iindex < 9; ++iindex)
+		EXPECT_UINTEQ(*(const unsigned int*)bucketarray_get(&subgroup->index, iindex), expected_index[iindex]);
+	obj_finalize(&obj);
+
+	return 0;
+}
+
+DECLARE_TEST(obj, index) {
+	obj_index_t index;
+	obj_index_t read_index;
+	obj_index_initialize(&index);
+	obj_index_initialize(&read_index);
+
+	stream_t* stream = test_obj_stream(STRING_CONST(test_obj_sample));
+	EXPECT_TRUE(obj_index_build(&index, stream));
+	EXPECT_SIZEEQ(index.vertex_count, 10);
+	EXPECT_SIZEEQ(index.uv_count, 4);
+	EXPECT_SIZEEQ(index.normal_count, 1);
+	EXPECT_SIZEEQ(array_size(index.entry), 7);
+	EXPECT_STRINGEQ(index.entry[1].group, string_const(STRING_CONST("first")));
+	EXPECT_STRINGEQ(index.entry[2].material, string_const(STRING_CONST("red")));
+	EXPECT_SIZEEQ(index.entry[6].vertex_count, 10);
+
+	stream_t* storage = buffer_stream_allocate(nullptr, STREAM_IN | STREAM_OUT | STREAM_BINARY, 0, 0, true, true);
+	EXPECT_TRUE(obj_index_write(&index, storage));
+	size_t size = stream_tell(storage);
+	stream_seek(storage, 0, STREAM_SEEK_BEGIN);
+	EXPECT_TRUE(obj_index_read(&read_index, storage));
+	EXPECT_SIZEEQ(read_index.size, index.size);
+	EXPECT_SIZEEQ(array_size(read_index.entry), array_size(index.entry));
+	for (size_t ientry = 0; ientry < array_size(index.entry); ++ientry) {
+		EXPECT_SIZEEQ(read_index.entry[ientry].offset, index.entry[ientry].offset);
+		EXPECT_SIZEEQ(read_index.entry[ientry].vertex_count, index.entry[ientry].vertex_count);
+		EXPECT_STRINGEQ(read_index.entry[ientry].group, index.entry[ientry].group);
+		EXPECT_STRINGEQ(read_index.entry[ientry].material, index.entry[ientry].material);
+	}
+
+	// Truncated and corrupted data must be rejected without reading past the end
+	char* data = memory_allocate(HASH_OBJ, size, 0, MEMORY_PERSISTENT);
+	stream_seek(storage, 0, STREAM_SEEK_BEGIN);
+	EXPECT_SIZEEQ(stream_read(storage, data, size), size);
+	for (size_t truncated = 0; truncated < size; ++truncated) {
+		stream_t* partial = test_obj_stream(data, truncated);
+		EXPECT_FALSE(obj_index_read(&read_index, partial));
+		EXPECT_SIZEEQ(array_size(read_index.entry), 0);
+		stream_deallocate(partial);
+	}
+	// Length of first group name is stored after header, material library count, entry count and entry values
+	uint32_t length = 0x7fffffff;
+	memcpy(data + 48 + 36, &length, sizeof(length));
+	stream_t* corrupt = test_obj_stream(data, size);
+	EXPECT_FALSE(obj_index_read(&read_index, corrupt));
+	stream_deallocate(corrupt);
+
+	memory_deallocate(data);
+	stream_deallocate(storage);
+	stream_deallocate(stream);
+	obj_index_finalize(&read_index);
+	obj_index_finalize(&index);
+	return 0;
+}
+
+DECLARE_TEST(obj, read_groups) {
+	obj_t obj;
+	obj_index_t index;
+	obj_initialize(&obj);
+	obj_index_initialize(&index);
+
+	stream_t* stream = test_obj_stream(STRING_CONST(test_obj_sample));
+	EXPECT_TRUE(obj_index_build(&index, stream));
+
+	string_const_t third = string_const(STRING_CONST("third"));
+	EXPECT_TRUE(obj_read_groups(&obj, stream, &index, &third, 1));
+	EXPECT_SIZEEQ(array_size(obj.group), 1);
+	EXPECT_STRINGEQ(obj.group[0]->name, third);
+	EXPECT_SIZEEQ(test_obj_face_count(&obj), 2);
+	// Only vertices referenced by the group are loaded
+	EXPECT_SIZEEQ(obj.vertex.count, 5);
+	const obj_corner_t* corner = bucketarray_get(&obj.group[0]->subgroup[0]->corner, 0);
+	const obj_vertex_t* vertex = bucketarray_get(&obj.vertex, corner->vertex - 1);
+	EXPECT_REALEQ(vertex->x, REAL_C(2.0));
+	EXPECT_REALEQ(vertex->y, REAL_C(2.0));
+
+	string_const_t first = string_const(STRING_CONST("first"));
+	EXPECT_TRUE(obj_read_groups(&obj, stream, &index, &first, 1));
+	EXPECT_SIZEEQ(array_size(obj.group), 1);
+	EXPECT_SIZEEQ(array_size(obj.group[0]->subgroup), 2);
+	EXPECT_SIZEEQ(obj.vertex.count, 4);
+	EXPECT_SIZEEQ(obj.uv.count, 4);
+	EXPECT_SIZEEQ(obj.normal.count, 1);
+
+	string_const_t missing = string_const(STRING_CONST("missing"));
+	EXPECT_TRUE(obj_read_groups(&obj, stream, &index, &missing, 1));
+	EXPECT_SIZEEQ(array_size(obj.group), 0);
+
+	stream_deallocate(stream);
+	obj_index_finalize(&index);
+	obj_finalize(&obj);
+	return 0;
+}
+
+DECLARE_TEST(obj, read_append) {
+	obj_t obj;
+	obj_t reference;
+	obj_read_state_t state;
+	obj_initialize(&obj);
+	obj_initialize(&reference);
+	obj_read_state_initialize(&state);
+
+	size_t completed = 0;
+	obj.option.subgroup_complete = test_obj_count_subgroup;
+	obj.option.context = &completed;
+
+	// Simulate a growing file by reading increasing prefixes of the data, splitting lines
+	size_t size = sizeof(test_obj_sample) - 1;
+	size_t prefix[] = {10, 100, 130, 200, 260};
+	for (size_t istep = 0; istep < sizeof(prefix) / sizeof(prefix[0]); ++istep) {
+		stream_t* stream = test_obj_stream(test_obj_sample, prefix[istep]);
+		EXPECT_TRUE(obj_read_append(&obj, stream, &state));
+		EXPECT_TRUE(state.offset <= prefix[istep]);
+		stream_deallocate(stream);
+	}
+	EXPECT_SIZEEQ(obj.vertex.count, 10);
+
+	// The last line has no endline and is only consumed when finishing
+	stream_t* stream = test_obj_stream(test_obj_sample, size);
+	EXPECT_TRUE(obj_read_append(&obj, stream, &state));
+	EXPECT_TRUE(state.offset < size);
+	size_t face_count = test_obj_face_count(&obj);
+	EXPECT_TRUE(obj_read_append_finish(&obj, stream, &state));
+	EXPECT_SIZEEQ(test_obj_face_count(&obj), face_count + 1);
+	stream_deallocate(stream);
+
+	stream = test_obj_stream(test_obj_sample, size);
+	EXPECT_TRUE(obj_read(&reference, stream));
+	stream_deallocate(stream);
+
+	EXPECT_SIZEEQ(array_size(obj.group), array_size(reference.group));
+	EXPECT_SIZEEQ(test_obj_subgroup_count(&obj), test_obj_subgroup_count(&reference));
+	EXPECT_SIZEEQ(test_obj_face_count(&obj), test_obj_face_count(&reference));
+	EXPECT_SIZEEQ(obj.vertex.count, reference.vertex.count);
+	EXPECT_SIZEEQ(obj.uv.count, reference.uv.count);
+	// Every subgroup including the last is reported
+	EXPECT_SIZEEQ(completed, test_obj_subgroup_count(&obj));
+
+	obj_read_state_finalize(&state);
+	obj_finalize(&reference);
+	obj_finalize(&obj);
+	return 0;
+}
+
+DECLARE_TEST(obj, parser_feed) {
+	obj_t obj;
+	obj_t reference;
+	obj_initialize(&obj);
+	obj_initialize(&reference);
+
+	size_t size = sizeof(test_obj_sample) - 1;
+	stream_t* stream = test_obj_stream(test_obj_sample, size);
+	EXPECT_TRUE(obj_read(&reference, stream));
+	stream_deallocate(stream);
+
+	size_t completed = 0;
+	obj_read_options_t option;
+	memset(&option, 0, sizeof(option));
+	option.subgroup_complete = test_obj_count_subgroup;
+	option.context = &completed;
+
+	obj_parser_t parser;
+	obj_parser_initialize(&parser, &option);
+	// Feed in chunks of every size to split records at all byte offsets, the parser is reused after finish
+	for (size_t chunk = 1; chunk <= size; ++chunk) {
+		completed = 0;
+		for (size_t offset = 0; offset < size; offset += chunk) {
+			size_t length = (offset + chunk > size) ? (size - offset) : chunk;
+			EXPECT_TRUE(obj_parser_feed(&parser, test_obj_sample + offset, length));
+		}
+		EXPECT_TRUE(obj_parser_finish(&parser, &obj));
+		EXPECT_SIZEEQ(array_size(obj.group), array_size(reference.group));
+		EXPECT_SIZEEQ(test_obj_subgroup_count(&obj), test_obj_subgroup_count(&reference));
+		EXPECT_SIZEEQ(test_obj_face_count(&obj), test_obj_face_count(&reference));
+		EXPECT_SIZEEQ(obj.vertex.count, reference.vertex.count);
+		EXPECT_SIZEEQ(obj.uv.count, reference.uv.count);
+		EXPECT_SIZEEQ(obj.normal.count, reference.normal.count);
+		EXPECT_SIZEEQ(completed, test_obj_subgroup_count(&obj));
+		const obj_vertex_t* vertex = bucketarray_get(&obj.vertex, obj.vertex.count - 1);
+		EXPECT_REALEQ(vertex->x, REAL_C(3.0));
+		EXPECT_REALEQ(vertex->y, REAL_C(3.0));
+	}
+	obj_parser_finalize(&parser);
+
+	// Options are applied to parsed data
+	option.subgroup_complete = nullptr;
+	option.flags = OBJ_READ_MERGE_GROUPS;
+	obj_parser_initialize(&parser, &option);
+	EXPECT_TRUE(obj_parser_feed(&parser, STRING_CONST("g a\nv 0 0 0\nv 1 0 0\nv 0 1 0\nf 1 2 3\ng b\nf 1 2 3\n")));
+	EXPECT_TRUE(obj_parser_feed(&parser, STRING_CONST("g a\nf 1 2 3\n")));
+	EXPECT_TRUE(obj_parser_finish(&parser, &obj));
+	EXPECT_SIZEEQ(array_size(obj.group), 2);
+	EXPECT_SIZEEQ(test_obj_face_count(&obj), 3);
+	obj_parser_finalize(&parser);
+
+	obj_finalize(&reference);
+	obj_finalize(&obj);
+	return 0;
+}
+
+DECLARE_TEST(obj, progress) {
+	obj_t obj;
+	obj_initialize(&obj);
+
+	string_t text = test_obj_grid(80);
+	test_obj_progress_state_t progress;
+	memset(&progress, 0, sizeof(progress));
+	progress.obj = &obj;
+	progress.ordered = true;
+	progress.cancel_at = text.length / 4;
+	obj.progress.callback = test_obj_report_progress;
+	obj.progress.context = &progress;
+	obj.progress.interval = 4096;
+
+	// Cancelled read stops early and keeps the data read so far
+	stream_t* stream = test_obj_stream(STRING_ARGS(text));
+	EXPECT_FALSE(obj_read(&obj, stream));
+	EXPECT_TRUE(progress.calls[OBJ_PROGRESS_READ] > 0);
+	EXPECT_TRUE(progress.done[OBJ_PROGRESS_READ] < text.length);
+	EXPECT_TRUE(obj.vertex.count < (81 * 81));
+
+	atomic_store32(&obj.progress.cancel, 0, memory_order_release);
+	memset(&progress, 0, sizeof(progress));
+	progress.obj = &obj;
+	progress.ordered = true;
+	stream_seek(stream, 0, STREAM_SEEK_BEGIN);
+	EXPECT_TRUE(obj_read(&obj, stream));
+	EXPECT_SIZEEQ(test_obj_face_count(&obj), 80 * 80);
+	// Reports are rate limited by interval and the completed work is always reported
+	EXPECT_TRUE(progress.calls[OBJ_PROGRESS_READ] <= (text.length / 4096) + 2);
+	EXPECT_SIZEEQ(progress.done[OBJ_PROGRESS_READ], text.length);
+
+	obj.progress.interval = 100;
+	EXPECT_TRUE(obj_triangulate(&obj));
+	EXPECT_TRUE(progress.calls[OBJ_PROGRESS_TRIANGULATE] >= (80 * 80) / 100);
+	EXPECT_SIZEEQ(progress.done[OBJ_PROGRESS_TRIANGULATE], 80 * 80);
+
+	mesh_t* mesh = obj_to_mesh(&obj);
+	EXPECT_NE(mesh, nullptr);
+	EXPECT_TRUE(progress.calls[OBJ_PROGRESS_MESH] > 0);
+	EXPECT_TRUE(progress.ordered);
+	mesh_deallocate(mesh);
+
+	atomic_store32(&obj.progress.cancel, 1, memory_order_release);
+	EXPECT_EQ(obj_to_mesh(&obj), nullptr);
+
+	stream_deallocate(stream);
+	memory_deallocate(text.str);
+	obj_finalize(&obj);
+	return 0;
+}
+
+DECLARE_TEST(obj, subgroup_complete) {
+	obj_t obj;
+	obj_initialize(&obj);
+
+	test_obj_completion_t completion;
+	memset(&completion, 0, sizeof(completion));
+	completion.valid = true;
+	obj.option.subgroup_complete = test_obj_check_subgroup;
+	obj.option.context = &completion;
+
+	stream_t* stream = test_obj_stream(STRING_CONST(test_obj_sample));
+	EXPECT_TRUE(obj_read(&obj, stream));
+	EXPECT_SIZEEQ(completion.subgroup_count, test_obj_subgroup_count(&obj));
+	EXPECT_SIZEEQ(completion.triangle_count, 7);
+	EXPECT_TRUE(completion.valid);
+
+	// Merged subgroups are reported once complete at end of data
+	memset(&completion, 0, sizeof(completion));
+	completion.valid = true;
+	obj.option.flags = OBJ_READ_MERGE_SUBGROUPS;
+	stream_seek(stream, 0, STREAM_SEEK_BEGIN);
+	EXPECT_TRUE(obj_read(&obj, stream));
+	EXPECT_SIZEEQ(completion.subgroup_count, test_obj_subgroup_count(&obj));
+	EXPECT_SIZEEQ(completion.triangle_count, 7);
+	EXPECT_TRUE(completion.valid);
+
+	stream_deallocate(stream);
+	obj_finalize(&obj);
+	return 0;
+}
+
+DECLARE_TEST(obj, inflate) {
+	const uint8_t* compressed[] = {test_obj_sample_dynamic, test_obj_sample_fixed};
+	size_t compressed_size[] = {sizeof(test_obj_sample_dynamic), sizeof(test_obj_sample_fixed)};
+	size_t size = sizeof(test_obj_sample) - 1;
+	char buffer[sizeof(test_obj_sample) + 64];
+
+	stream_t* plain = test_obj_stream(test_obj_sample, size);
+	EXPECT_FALSE(obj_stream_is_gzip(plain));
+	obj_t reference;
+	obj_initialize(&reference);
+	EXPECT_TRUE(obj_read(&reference, plain));
+	stream_deallocate(plain);
+
+	for (size_t idata = 0; idata < sizeof(compressed) / sizeof(compressed[0]); ++idata) {
+		stream_t* source = test_obj_stream((const char*)compressed[idata], compressed_size[idata]);
+		EXPECT_TRUE(obj_stream_is_gzip(source));
+		EXPECT_SIZEEQ(stream_tell(source), 0);
+
+		// Read in odd sized chunks across block boundaries
+		stream_t* stream = obj_inflate_stream_allocate(source, true);
+		size_t total = 0;
+		size_t read;
+		while ((read = stream_read(stream, buffer + total, 7)) > 0)
+			total += read;
+		EXPECT_SIZEEQ(total, size);
+		EXPECT_INTEQ(memcmp(buffer, test_obj_sample, size), 0);
+		EXPECT_TRUE(stream_eos(stream));
+		stream_deallocate(stream);
+
+		// Compressed data is detected and decompressed by obj_read
+		obj_t obj;
+		obj_initialize(&obj);
+		source = test_obj_stream((const char*)compressed[idata], compressed_size[idata]);
+		EXPECT_TRUE(obj_read(&obj, source));
+		EXPECT_SIZEEQ(obj.vertex.count, reference.vertex.count);
+		EXPECT_SIZEEQ(test_obj_face_count(&obj), test_obj_face_count(&reference));
+		stream_deallocate(source);
+
+		// Truncated data ends the stream early without reading past the input
+		for (size_t truncated = 10; truncated < compressed_size[idata]; truncated += 5) {
+			source = test_obj_stream((const char*)compressed[idata], truncated);
+			stream = obj_inflate_stream_allocate(source, true);
+			total = 0;
+			while ((total < sizeof(buffer)) && ((read = stream_read(stream, buffer + total, 64)) > 0))
+				total += read;
+			EXPECT_TRUE(total <= size);
+			EXPECT_INTEQ(memcmp(buffer, test_obj_sample, total), 0);
+			stream_deallocate(stream);
+
+			source = test_obj_stream((const char*)compressed[idata], truncated);
+			EXPECT_FALSE(obj_read(&obj, source));
+			EXPECT_TRUE(test_obj_face_count(&obj) <= test_obj_face_count(&reference));
+			stream_deallocate(source);
+		}
+
+		// Complete data failing the CRC32 or size check in the trailer is rejected
+		uint8_t corrupt[sizeof(test_obj_sample_dynamic) + sizeof(test_obj_sample_fixed)];
+		for (size_t offset = 8; offset > 0; offset -= 4) {
+			memcpy(corrupt, compressed[idata], compressed_size[idata]);
+			corrupt[compressed_size[idata] - offset] ^= 0x01;
+			source = test_obj_stream((const char*)corrupt, compressed_size[idata]);
+			EXPECT_FALSE(obj_read(&obj, source));
+			EXPECT_SIZEEQ(obj.vertex.count, reference.vertex.count);
+			stream_deallocate(source);
+		}
+		obj_finalize(&obj);
+	}
+
+	obj_finalize(&reference);
+	return 0;
+}
+
+DECLARE_TEST(obj, group_find) {
+	obj_t obj;
+	obj_initialize(&obj);
+
+	const char text[] = "v 0 0 0\nv 1 0 0\nv 1 1 0\nf 1 2 3\ng a\nf 1 2 3\ng b\nf 1 2 3\n"
+	                    "g a\nf 3 2 1\ng c\ng a\nf 1 3 2\n";
+	stream_t* stream = test_obj_stream(STRING_CONST(text));
+	EXPECT_TRUE(obj_read(&obj, stream));
+	EXPECT_SIZEEQ(array_size(obj.group), 5);
+	// First group with the name is found, groups without faces are not created
+	EXPECT_EQ(obj_group_find(&obj, STRING_CONST("a")), obj.group[1]);
+	EXPECT_EQ(obj_group_find(&obj, STRING_CONST("b")), obj.group[2]);
+	EXPECT_EQ(obj_group_find(&obj, STRING_CONST("c")), nullptr);
+	EXPECT_EQ(obj_group_find(&obj, "", 0), obj.group[0]);
+
+	obj.option.flags = OBJ_READ_MERGE_GROUPS;
+	stream_seek(stream, 0, STREAM_SEEK_BEGIN);
+	EXPECT_TRUE(obj_read(&obj, stream));
+	EXPECT_SIZEEQ(array_size(obj.group), 3);
+	obj_group_t* group = obj_group_find(&obj, STRING_CONST("a"));
+	EXPECT_NE(group, nullptr);
+	EXPECT_SIZEEQ(array_size(group->subgroup), 3);
+	EXPECT_SIZEEQ(test_obj_face_count(&obj), 5);
+
+	stream_deallocate(stream);
+	obj_finalize(&obj);
+	return 0;
+}
+
+DECLARE_TEST(obj, string_pool) {
+	obj_t obj;
+	obj_initialize(&obj);
+
+	const char text[] = "mtllib test.mtl\nv 0 0 0\nv 1 0 0\nv 1 1 0\ng a\nusemtl red\nf 1 2 3\nusemtl blue\n"
+	                    "f 1 2 3\ng red\nusemtl missing\nf 1 2 3\n";
+	stream_t* stream = test_obj_stream(STRING_CONST(text));
+	for (int pass = 0; pass < 2; ++pass) {
+		// Reading again clears and refills the pool
+		stream_seek(stream, 0, STREAM_SEEK_BEGIN);
+		EXPECT_TRUE(obj_read(&obj, stream));
+		EXPECT_EQ(obj_string_find(&obj, STRING_CONST("extra")).str, nullptr);
+		EXPECT_SIZEEQ(array_size(obj.material), 4);
+		EXPECT_STRINGEQ(obj.material[2].name, string_const(STRING_CONST("last")));
+		EXPECT_STRINGEQ(obj.material[1].bump_texture, string_const(STRING_CONST("tex/bump.png")));
+		EXPECT_UINTEQ(obj.group[0]->subgroup[0]->material, 0);
+		EXPECT_UINTEQ(obj.group[0]->subgroup[1]->material, 1);
+		// Equal names share storage across groups, materials and textures
+		EXPECT_EQ(obj.material[0].diffuse_texture.str, obj.material[1].diffuse_texture.str);
+		EXPECT_EQ(obj.group[1]->name.str, obj.material[0].name.str);
+		EXPECT_EQ(obj_string_intern(&obj, STRING_CONST("tex/shared.png")).str, obj.material[0].diffuse_texture.str);
+		EXPECT_EQ(obj_string_find(&obj, STRING_CONST("a")).str, obj.group[0]->name.str);
+		EXPECT_EQ(obj_group_find(&obj, STRING_CONST("red")), obj.group[1]);
+		obj_string_intern(&obj, STRING_CONST("extra"));
+	}
+
+	// Long strings get separate storage, interned strings stay valid as the pool grows
+	char long_string[20000];
+	memset(long_string, 'x', sizeof(long_string));
+	string_const_t interned_long = obj_string_intern(&obj, long_string, sizeof(long_string));
+	string_const_t interned_first = obj_string_intern(&obj, STRING_CONST("name0"));
+	for (unsigned int iname = 0; iname < 5000; ++iname) {
+		char name[32];
+		string_t name_string = string_format(name, sizeof(name), STRING_CONST("name%u"), iname);
+		string_const_t interned = obj_string_intern(&obj, STRING_ARGS(name_string));
+		EXPECT_STRINGEQ(interned, string_to_const(name_string));
+	}
+	EXPECT_EQ(obj_string_intern(&obj, long_string, sizeof(long_string)).str, interned_long.str);
+	EXPECT_EQ(obj_string_find(&obj, STRING_CONST("name0")).str, interned_first.str);
+	EXPECT_STRINGEQ(obj_string_find(&obj, STRING_CONST("name4999")), string_const(STRING_CONST("name4999")));
+	EXPECT_STRINGEQ(interned_first, string_const(STRING_CONST("name0")));
+
+	stream_deallocate(stream);
+	obj_finalize(&obj);
+	return 0;
+}
+
+DECLARE_TEST(obj, merge_subgroups) {
+	size_t capacity = 128 * 1024;
+	char* buffer = memory_allocate(HASH_OBJ, capacity, 0, MEMORY_PERSISTENT);
+	size_t length = string_format(buffer, capacity, STRING_CONST("mtllib test.mtl\n")).length;
+	for (unsigned int ivertex = 0; ivertex < 100; ++ivertex)
+		length += string_format(buffer + length, capacity - length, STRING_CONST("v %u 0 0\nv %u 1 0\nv %u 1 1\n"),
+		                        ivertex, ivertex, ivertex)
+		              .length;
+	length += string_format(buffer + length, capacity - length, STRING_CONST("g one\n")).length;
+	// Alternate materials on every face, each material uses every other triangle of vertices
+	for (unsigned int iface = 0; iface < 2000; ++iface) {
+		unsigned int base = ((iface % 100) * 3) + 1;
+		length += string_format(buffer + length, capacity - length, STRING_CONST("usemtl %s\nf %u %u %u\n"),
+		                        (iface & 1) ? "blue" : "red", base, base + 1, base + 2)
+		              .length;
+	}
+	length += string_format(buffer + length, capacity - length,
+	                        STRING_CONST("g two\nusemtl red\nf 1 2 3\nusemtl missing\nf 1 2 3\n"
+	                                     "usemtl missing\nf 2 3 4\n"))
+	              .length;
+
+	obj_t plain;
+	obj_t merged;
+	obj_initialize(&plain);
+	obj_initialize(&merged);
+	stream_t* stream = test_obj_stream(buffer, length);
+	EXPECT_TRUE(obj_read(&plain, stream));
+
+	size_t completed = 0;
+	merged.option.flags = OBJ_READ_MERGE_SUBGROUPS;
+	merged.option.subgroup_complete = test_obj_count_subgroup;
+	merged.option.context = &completed;
+	stream_seek(stream, 0, STREAM_SEEK_BEGIN);
+	EXPECT_TRUE(obj_read(&merged, stream));
+
+	EXPECT_TRUE(test_obj_subgroup_count(&plain) >= 2000);
+	EXPECT_SIZEEQ(test_obj_subgroup_count(&merged), 4);
+	EXPECT_SIZEEQ(completed, 4);
+	EXPECT_SIZEEQ(test_obj_face_count(&plain), test_obj_face_count(&merged));
+	obj_triangulate(&plain);
+	EXPECT_SIZEEQ(test_obj_triangle_count(&plain), test_obj_triangle_count(&merged));
+
+	// Corners are shared within the merged subgroup, 50 distinct triangles of vertices per material
+	obj_subgroup_t* subgroup = merged.group[0]->subgroup[0];
+	EXPECT_UINTEQ(subgroup->material, 0);
+	EXPECT_SIZEEQ(subgroup->face.count, 1000);
+	EXPECT_SIZEEQ(subgroup->corner.count, 150);
+	for (size_t iface = 0; iface < subgroup->face.count; ++iface) {
+		const obj_face_t* face = bucketarray_get(&subgroup->face, iface);
+		const unsigned int* index = bucketarray_get(&subgroup->index, face->offset);
+		const obj_corner_t* first = bucketarray_get(&subgroup->corner, index[0]);
+		index = bucketarray_get(&subgroup->index, face->offset + 1);
+		const obj_corner_t* second = bucketarray_get(&subgroup->corner, *index);
+		EXPECT_UINTEQ(second->vertex, first->vertex + 1);
+	}
+	EXPECT_UINTEQ(merged.group[0]->subgroup[1]->material, 1);
+	EXPECT_SIZEEQ(merged.group[1]->subgroup[1]->face.count, 2);
+
+	stream_deallocate(stream);
+	obj_finalize(&plain);
+	obj_finalize(&merged);
+	memory_deallocate(buffer);
+	return 0;
+}
+
+DECLARE_TEST(obj, bucket_growth) {
+	const unsigned int quad_count = 20000;
+	const unsigned int tiny_count = 500;
+	size_t capacity = 4 * 1024 * 1024;
+	char* buffer = memory_allocate(HASH_OBJ, capacity, 0, MEMORY_PERSISTENT);
+	size_t length = 0;
+	for (unsigned int iquad = 0; iquad < quad_count; ++iquad)
+		length += string_format(buffer + length, capacity - length,
+		                        STRING_CONST("v %u 0 0\nv %u 1 0\nv %u 1 1\nv %u 0 1\n"), iquad, iquad, iquad, iquad)
+		              .length;
+	for (unsigned int igroup = 0; igroup < tiny_count; ++igroup)
+		length += string_format(buffer + length, capacity - length, STRING_CONST("g tiny%u\nf %u %u %u\n"), igroup,
+		                        (igroup * 4) + 1, (igroup * 4) + 2, (igroup * 4) + 3)
+		              .length;
+	length += string_format(buffer + length, capacity - length, STRING_CONST("g big\n")).length;
+	for (unsigned int iquad = 0; iquad < quad_count; ++iquad)
+		length += string_format(buffer + length, capacity - length, STRING_CONST("f %u %u %u %u\n"), (iquad * 4) + 1,
+		                        (iquad * 4) + 2, (iquad * 4) + 3, (iquad * 4) + 4)
+		              .length;
+
+	obj_t obj;
+	obj_initialize(&obj);
+	stream_t* stream = test_obj_stream(buffer, length);
+	EXPECT_TRUE(obj_read(&obj, stream));
+	obj_triangulate(&obj);
+	EXPECT_SIZEEQ(test_obj_triangle_count(&obj), tiny_count + (quad_count * 2));
+
+	// The first subgroup after the vertex block is sized for them, following small subgroups keep
+	// the smallest buckets and large subgroups grow their buckets while reading
+	const obj_subgroup_t* first = obj_group_find(&obj, STRING_CONST("tiny0"))->subgroup[0];
+	const obj_subgroup_t* tiny = obj_group_find(&obj, STRING_CONST("tiny1"))->subgroup[0];
+	obj_subgroup_t* big = obj_group_find(&obj, STRING_CONST("big"))->subgroup[0];
+	EXPECT_TRUE(first->corner.bucket_size > 16);
+	EXPECT_SIZEEQ(tiny->corner.bucket_size, 16);
+	EXPECT_SIZEEQ(big->corner.count, quad_count * 4);
+	EXPECT_TRUE(big->corner.bucket_size > 16);
+	EXPECT_TRUE(big->triangle.bucket_size > 16);
+
+	obj_shrink_to_fit(&obj);
+	EXPECT_SIZEEQ(first->corner.bucket_size, 16);
+	EXPECT_SIZEEQ(first->corner.bucket_count, 1);
+	EXPECT_SIZEEQ(tiny->corner.bucket_size, 16);
+	EXPECT_TRUE(big->corner.bucket_count <= 16);
+	EXPECT_TRUE(big->corner.bucket_size * big->corner.bucket_count >= big->corner.count);
+	EXPECT_TRUE(big->corner.bucket_size * (big->corner.bucket_count - 1) < big->corner.count);
+	EXPECT_TRUE(big->triangle.bucket_size * (big->triangle.bucket_count - 1) < big->triangle.count);
+	EXPECT_SIZEEQ(big->corner.count, quad_count * 4);
+	EXPECT_SIZEEQ(big->triangle.count, quad_count * 2);
+
+	// Content is preserved across re-bucketing
+	for (size_t itri = 0; itri < big->triangle.count; ++itri) {
+		const obj_triangle_t* triangle = bucketarray_get(&big->triangle, itri);
+		for (unsigned int icorner = 0; icorner < 3; ++icorner) {
+			const obj_corner_t* corner = bucketarray_get(&big->corner, triangle->index[icorner]);
+			EXPECT_SIZEEQ((corner->vertex - 1) / 4, itri / 2);
+		}
+	}
+
+	stream_deallocate(stream);
+	obj_finalize(&obj);
+	memory_deallocate(buffer);
+	return 0;
+}
+
+DECLARE_TEST(obj, vertex_cache) {
+	obj_t obj;
+	obj_initialize(&obj);
+	EXPECT_TRUE(test_obj_read_grid(&obj, 60));
+
+	obj_subgroup_t* subgroup = obj.group[0]->subgroup[0];
+	size_t triangle_count = subgroup->triangle.count;
+	double signature = test_obj_triangle_signature(&obj, subgroup);
+	// Grid rows are longer than the cache, every quad misses both a new and a previous row vertex
+	real acmr = obj_subgroup_acmr(subgroup, 0);
+	EXPECT_TRUE(acmr > REAL_C(0.95));
+	EXPECT_TRUE(acmr < REAL_C(1.1));
+
+	obj_vertex_cache_stats_t stats;
+	memset(&stats, 0, sizeof(stats));
+	EXPECT_TRUE(obj_optimize_vertex_cache(&obj, &stats));
+	EXPECT_REALEQ(stats.acmr_before, acmr);
+	EXPECT_REALEQ(stats.acmr_after, obj_subgroup_acmr(subgroup, 0));
+	EXPECT_TRUE(stats.acmr_after < REAL_C(0.8));
+	EXPECT_TRUE(obj_subgroup_acmr(subgroup, 32) <= stats.acmr_after);
+
+	// Triangles are only reordered
+	EXPECT_SIZEEQ(subgroup->triangle.count, triangle_count);
+	EXPECT_TRUE(test_obj_signature_equal(test_obj_triangle_signature(&obj, subgroup), signature));
+
+	// Already optimized order is not made worse
+	EXPECT_TRUE(obj_optimize_vertex_cache(&obj, &stats));
+	EXPECT_TRUE(stats.acmr_after <= stats.acmr_before);
+
+	obj_finalize(&obj);
+	return 0;
+}
+
+DECLARE_TEST(obj, overdraw) {
+	obj_t obj;
+	obj_initialize(&obj);
+	string_t text = test_obj_sphere(120, 60);
+	stream_t* stream = test_obj_stream(STRING_ARGS(text));
+	EXPECT_TRUE(obj_read(&obj, stream));
+	EXPECT_TRUE(obj_triangulate(&obj));
+	EXPECT_TRUE(obj_optimize_vertex_cache(&obj, nullptr));
+
+	obj_subgroup_t* subgroup = obj.group[0]->subgroup[0];
+	size_t triangle_count = subgroup->triangle.count;
+	double signature = test_obj_triangle_signature(&obj, subgroup);
+	real acmr = obj_subgroup_acmr(subgroup, 0);
+
+	// Cluster reordering keeps the cache efficiency close to the cache optimized order
+	EXPECT_TRUE(obj_optimize_overdraw(&obj, OBJ_OVERDRAW_THRESHOLD));
+	real acmr_overdraw = obj_subgroup_acmr(subgroup, 0);
+	EXPECT_TRUE(acmr_overdraw <= acmr * REAL_C(1.15));
+	EXPECT_SIZEEQ(subgroup->triangle.count, triangle_count);
+	EXPECT_TRUE(test_obj_signature_equal(test_obj_triangle_signature(&obj, subgroup), signature));
+
+	// Larger threshold gives longer clusters and reordering again keeps all triangles
+	obj_subgroup_optimize_overdraw(&obj, subgroup, REAL_C(2.0));
+	EXPECT_TRUE(obj_subgroup_acmr(subgroup, 0) <= acmr * REAL_C(2.0));
+	EXPECT_SIZEEQ(subgroup->triangle.count, triangle_count);
+	EXPECT_TRUE(test_obj_signature_equal(test_obj_triangle_signature(&obj, subgroup), signature));
+
+	stream_deallocate(stream);
+	memory_deallocate(text.str);
+	obj_finalize(&obj);
+	return 0;
+}
+
+DECLARE_TEST(obj, vertex_fetch) {
+	obj_t obj;
+	obj_initialize(&obj);
+	EXPECT_TRUE(test_obj_read_grid(&obj, 80));
+	EXPECT_TRUE(obj_optimize_vertex_cache(&obj, nullptr));
+
+	obj_subgroup_t* subgroup = obj.group[0]->subgroup[0];
+	size_t vertex_count = obj.vertex.count;
+	size_t corner_count = subgroup->corner.count;
+	double signature = test_obj_triangle_signature(&obj, subgroup);
+	real acmr = obj_subgroup_acmr(subgroup, 0);
+
+	EXPECT_TRUE(obj_optimize_vertex_fetch(&obj, true));
+	EXPECT_SIZEEQ(obj.vertex.count, vertex_count);
+	EXPECT_SIZEEQ(subgroup->corner.count, corner_count);
+	EXPECT_REALEQ(obj_subgroup_acmr(subgroup, 0), acmr);
+	EXPECT_TRUE(test_obj_signature_equal(test_obj_triangle_signature(&obj, subgroup), signature));
+
+	// Corners and vertices are numbered by first use in triangle order
+	unsigned int next_corner = 0;
+	unsigned int next_vertex = 1;
+	for (size_t itri = 0; itri < subgroup->triangle.count; ++itri) {
+		const obj_triangle_t* triangle = bucketarray_get(&subgroup->triangle, itri);
+		for (unsigned int icorner = 0; icorner < 3; ++icorner) {
+			unsigned int index = triangle->index[icorner];
+			EXPECT_TRUE(index <= next_corner);
+			if (index == next_corner)
+				++next_corner;
+			const obj_corner_t* corner = bucketarray_get(&subgroup->corner, index);
+			EXPECT_TRUE(corner->vertex <= next_vertex);
+			if (corner->vertex == next_vertex)
+				++next_vertex;
+		}
+	}
+	EXPECT_UINTEQ(next_corner, corner_count);
+	EXPECT_UINTEQ(next_vertex, vertex_count + 1);
+
+	// Face indices are rewritten to the new corner numbers, triangulating again gives the same triangles
+	bucketarray_resize(&subgroup->triangle, 0);
+	EXPECT_TRUE(obj_triangulate(&obj));
+	EXPECT_SIZEEQ(subgroup->triangle.count, 80 * 80 * 2);
+	EXPECT_TRUE(test_obj_signature_equal(test_obj_triangle_signature(&obj, subgroup), signature));
+
+	obj_finalize(&obj);
+	return 0;
+}
+
+DECLARE_TEST(obj, meshlets) {
+	obj_t obj;
+	obj_initialize(&obj);
+	string_t text = test_obj_sphere(48, 32);
+	stream_t* stream = test_obj_stream(STRING_ARGS(text));
+	EXPECT_TRUE(obj_read(&obj, stream));
+	EXPECT_TRUE(obj_triangulate(&obj));
+
+	obj_meshlets_t meshlets;
+	obj_meshlets_initialize(&meshlets);
+	obj_meshlet_limits_t limits = {OBJ_MESHLET_MAX_VERTICES, OBJ_MESHLET_MAX_TRIANGLES};
+	EXPECT_TRUE(obj_build_meshlets(&obj, nullptr, &meshlets));
+	EXPECT_TRUE(test_obj_meshlets_valid(&obj, &meshlets, &limits));
+	size_t meshlet_count = array_size(meshlets.meshlet);
+	EXPECT_TRUE(meshlet_count >= (48 * 32 * 2) / OBJ_MESHLET_MAX_TRIANGLES);
+
+	// Smaller limits give more meshlets, existing meshlets are discarded
+	limits.max_vertices = 32;
+	limits.max_triangles = 40;
+	EXPECT_TRUE(obj_build_meshlets(&obj, &limits, &meshlets));
+	EXPECT_TRUE(test_obj_meshlets_valid(&obj, &meshlets, &limits));
+	EXPECT_TRUE(array_size(meshlets.meshlet) > meshlet_count);
+
+	// Meshlets on a sphere are small enough patches to be cone culled
+	for (size_t imeshlet = 0; imeshlet < array_size(meshlets.meshlet); ++imeshlet)
+		EXPECT_TRUE(meshlets.meshlet[imeshlet].cone_cutoff > REAL_C(0.0));
+
+	stream_deallocate(stream);
+	memory_deallocate(text.str);
+	obj_finalize(&obj);
+
+	// Open surface with a single boundary
+	obj_initialize(&obj);
+	text = test_obj_grid(40);
+	stream = test_obj_stream(STRING_ARGS(text));
+	EXPECT_TRUE(obj_read(&obj, stream));
+	EXPECT_TRUE(obj_triangulate(&obj));
+	EXPECT_TRUE(obj_build_meshlets(&obj, &limits, &meshlets));
+	EXPECT_TRUE(test_obj_meshlets_valid(&obj, &meshlets, &limits));
+
+	EXPECT_FALSE(obj_build_meshlets(nullptr, nullptr, &meshlets));
+
+	obj_meshlets_finalize(&meshlets);
+	stream_deallocate(stream);
+	memory_deallocate(text.str);
+	obj_finalize(&obj);
+	return 0;
+}
+
+DECLARE_TEST(obj, simplify) {
+	obj_t obj;
+	obj_initialize(&obj);
+	string_t text = test_obj_sphere(64, 48);
+	stream_t* stream = test_obj_stream(STRING_ARGS(text));
+	EXPECT_TRUE(obj_read(&obj, stream));
+	EXPECT_TRUE(obj_triangulate(&obj));
+	size_t triangle_count = test_obj_triangle_count(&obj);
+
+	// Levels reach the target triangle count with small error and leave the OBJ data unmodified
+	real ratio[3] = {REAL_C(0.5), REAL_C(0.25), REAL_C(0.1)};
+	obj_lod_t lod[3];
+	EXPECT_TRUE(obj_simplify_lod_chain(&obj, ratio, 3, 0, lod));
+	size_t previous_count = triangle_count;
+	for (size_t ilod = 0; ilod < 3; ++ilod) {
+		size_t count = array_size(lod[ilod].triangle);
+		EXPECT_SIZEEQ(array_size(lod[ilod].subgroup_offset), test_obj_subgroup_count(&obj) + 1);
+		EXPECT_SIZEEQ(lod[ilod].subgroup_offset[array_size(lod[ilod].subgroup_offset) - 1], count);
+		EXPECT_TRUE((real)count <= ((real)triangle_count * ratio[ilod]) + REAL_C(2.0));
+		EXPECT_TRUE(count < previous_count);
+		EXPECT_TRUE(lod[ilod].error < REAL_C(0.1));
+		previous_count = count;
+	}
+	EXPECT_TRUE(lod[2].error >= lod[0].error);
+	for (size_t ilod = 0; ilod < 3; ++ilod)
+		obj_lod_finalize(lod + ilod);
+	EXPECT_SIZEEQ(test_obj_triangle_count(&obj), triangle_count);
+
+	// Error limit stops simplification before the target count
+	EXPECT_TRUE(obj_simplify(&obj, REAL_C(0.25), REAL_C(0.001)));
+	size_t limited_count = test_obj_triangle_count(&obj);
+	EXPECT_TRUE(limited_count > triangle_count / 4);
+	EXPECT_TRUE(test_obj_triangles_valid(&obj));
+
+	EXPECT_TRUE(obj_simplify(&obj, REAL_C(0.25), 0));
+	EXPECT_TRUE((real)test_obj_triangle_count(&obj) <= ((real)limited_count * REAL_C(0.25)) + REAL_C(2.0));
+	EXPECT_TRUE(test_obj_triangles_valid(&obj));
+
+	stream_deallocate(stream);
+	memory_deallocate(text.str);
+	obj_finalize(&obj);
+
+	// Corners of a cube with face normals are all on normal discontinuities and are kept
+	const char cube[] = "v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\nv 0 0 1\nv 1 0 1\nv 1 1 1\nv 0 1 1\n"
+	                    "vn 0 0 -1\nvn 0 0 1\nvn 0 -1 0\nvn 0 1 0\nvn -1 0 0\nvn 1 0 0\n"
+	                    "f 1//1 4//1 3//1 2//1\nf 5//2 6//2 7//2 8//2\nf 1//3 2//3 6//3 5//3\n"
+	                    "f 4//4 8//4 7//4 3//4\nf 1//5 5//5 8//5 4//5\nf 2//6 3//6 7//6 6//6\n";
+	obj_initialize(&obj);
+	stream = test_obj_stream(STRING_CONST(cube));
+	EXPECT_TRUE(obj_read(&obj, stream));
+	EXPECT_TRUE(obj_triangulate(&obj));
+	EXPECT_TRUE(obj_simplify(&obj, 0, 0));
+	EXPECT_SIZEEQ(test_obj_triangle_count(&obj), 12);
+
+	stream_deallocate(stream);
+	obj_finalize(&obj);
+	return 0;
+}
+
+DECLARE_TEST(obj, normals) {
+	obj_t obj;
+
+	// Flat shaded cube splits corners to one normal per face
+	const char flat[] = TEST_OBJ_CUBE_VERTICES "s off\n" TEST_OBJ_CUBE_FACES;
+	obj_initialize(&obj);
+	EXPECT_TRUE(test_obj_read_text(&obj, STRING_CONST(flat)));
+	EXPECT_TRUE(obj_triangulate(&obj));
+	EXPECT_SIZEEQ(test_obj_corner_count(&obj), 8);
+	EXPECT_TRUE(obj_generate_normals(&obj, OBJ_NORMAL_WEIGHT_AREA));
+	EXPECT_SIZEEQ(test_obj_corner_count(&obj), 24);
+	EXPECT_SIZEEQ(obj.normal.count, 6);
+	EXPECT_SIZEEQ(test_obj_triangle_count(&obj), 12);
+	EXPECT_TRUE(test_obj_normals_outward(&obj, REAL_C(0.5)));
+	obj_finalize(&obj);
+
+	// Triangle order set before generation is kept and each triangle uses the normal of its face
+	obj_initialize(&obj);
+	EXPECT_TRUE(test_obj_read_text(&obj, STRING_CONST(flat)));
+	EXPECT_TRUE(obj_triangulate(&obj));
+	obj_subgroup_t* subgroup = obj.group[0]->subgroup[0];
+	size_t triangle_count = subgroup->triangle.count;
+	unsigned int vertex[12][3];
+	for (size_t itri = 0; itri < triangle_count / 2; ++itri) {
+		obj_triangle_t* first = bucketarray_get(&subgroup->triangle, itri);
+		obj_triangle_t* last = bucketarray_get(&subgroup->triangle, triangle_count - itri - 1);
+		obj_triangle_t swap = *first;
+		*first = *last;
+		*last = swap;
+	}
+	for (size_t itri = 0; itri < triangle_count; ++itri) {
+		const obj_triangle_t* triangle = bucketarray_get(&subgroup->triangle, itri);
+		for (unsigned int icorner = 0; icorner < 3; ++icorner)
+			vertex[itri][icorner] =
+			    ((const obj_corner_t*)bucketarray_get(&subgroup->corner, triangle->index[icorner]))->vertex;
+	}
+	EXPECT_TRUE(obj_generate_normals(&obj, OBJ_NORMAL_WEIGHT_AREA));
+	EXPECT_SIZEEQ(subgroup->triangle.count, triangle_count);
+	for (size_t itri = 0; itri < triangle_count; ++itri) {
+		const obj_triangle_t* triangle = bucketarray_get(&subgroup->triangle, itri);
+		const obj_corner_t* corner[3];
+		for (unsigned int icorner = 0; icorner < 3; ++icorner) {
+			corner[icorner] = bucketarray_get(&subgroup->corner, triangle->index[icorner]);
+			EXPECT_UINTEQ(corner[icorner]->vertex, vertex[itri][icorner]);
+		}
+		EXPECT_UINTEQ(corner[0]->normal, corner[1]->normal);
+		EXPECT_UINTEQ(corner[0]->normal, corner[2]->normal);
+		// Cube face normals are axis aligned and the triangle centroid lies on the face
+		const obj_normal_t* normal = bucketarray_get(&obj.normal, corner[0]->normal - 1);
+		real centroid[3] = {0, 0, 0};
+		for (unsigned int icorner = 0; icorner < 3; ++icorner) {
+			const obj_vertex_t* position = bucketarray_get(&obj.vertex, corner[icorner]->vertex - 1);
+			centroid[0] += position->x / REAL_C(3.0);
+			centroid[1] += position->y / REAL_C(3.0);
+			centroid[2] += position->z / REAL_C(3.0);
+		}
+		real dot = (centroid[0] * normal->nx) + (centroid[1] * normal->ny) + (centroid[2] * normal->nz);
+		EXPECT_TRUE(dot > REAL_C(0.999));
+	}
+	obj_finalize(&obj);
+
+	// Smooth cube shares one normal per vertex along the diagonal
+	const char smooth[] = TEST_OBJ_CUBE_VERTICES "s 1\n" TEST_OBJ_CUBE_FACES;
+	obj_initialize(&obj);
+	EXPECT_TRUE(test_obj_read_text(&obj, STRING_CONST(smooth)));
+	EXPECT_UINTEQ(((const obj_face_t*)bucketarray_get(&obj.group[0]->subgroup[0]->face, 0))->smoothing, 1);
+	EXPECT_TRUE(obj_generate_normals(&obj, OBJ_NORMAL_WEIGHT_ANGLE));
+	EXPECT_SIZEEQ(test_obj_corner_count(&obj), 8);
+	EXPECT_SIZEEQ(obj.normal.count, 8);
+	EXPECT_TRUE(test_obj_normals_outward(&obj, REAL_C(0.999)));
+	obj_finalize(&obj);
+
+	// Sides and caps in different smoothing groups and materials get separate normals
+	const char mixed[] = TEST_OBJ_CUBE_VERTICES "s 1\nf 1 2 6 5\nf 4 8 7 3\nf 1 5 8 4\nf 2 3 7 6\n"
+	                                            "usemtl other\ns 2\nf 1 4 3 2\nf 5 6 7 8\n";
+	obj_initialize(&obj);
+	EXPECT_TRUE(test_obj_read_text(&obj, STRING_CONST(mixed)));
+	EXPECT_TRUE(obj_triangulate(&obj));
+	EXPECT_TRUE(obj_generate_normals(&obj, OBJ_NORMAL_WEIGHT_AREA_ANGLE));
+	EXPECT_SIZEEQ(obj.normal.count, 16);
+	EXPECT_TRUE(test_obj_normals_outward(&obj, REAL_C(0.5)));
+	obj_finalize(&obj);
+
+	// Explicit normals are kept unless replaced
+	const char partial[] = TEST_OBJ_CUBE_VERTICES "vn 0 0 -1\ns 1\nf 1//1 4//1 3//1 2//1\nf 5 6 7 8\n";
+	obj_initialize(&obj);
+	EXPECT_TRUE(test_obj_read_text(&obj, STRING_CONST(partial)));
+	EXPECT_TRUE(obj_generate_normals(&obj, 0));
+	EXPECT_UINTEQ(((const obj_corner_t*)bucketarray_get(&obj.group[0]->subgroup[0]->corner, 0))->normal, 1);
+	EXPECT_SIZEEQ(obj.normal.count, 5);
+	EXPECT_TRUE(obj_generate_normals(&obj, OBJ_NORMAL_REPLACE));
+	EXPECT_SIZEEQ(obj.normal.count, 5 + 8);
+	obj_finalize(&obj);
+
+	return 0;
+}
+
+DECLARE_TEST(obj, tangents) {
+	obj_t obj;
+
+	// Each cube face maps U along its first edge and V along its last edge
+	const char cube[] = TEST_OBJ_CUBE_VERTICES "vt 0 0\nvt 1 0\nvt 1 1\nvt 0 1\ns off\n"
+	                                           "f 1/1 4/2 3/3 2/4\nf 5/1 6/2 7/3 8/4\nf 1/1 2/2 6/3 5/4\n"
+	                                           "f 4/1 8/2 7/3 3/4\nf 1/1 5/2 8/3 4/4\nf 2/1 3/2 7/3 6/4\n";
+	obj_initialize(&obj);
+	EXPECT_TRUE(test_obj_read_text(&obj, STRING_CONST(cube)));
+	EXPECT_TRUE(obj_triangulate(&obj));
+	EXPECT_TRUE(obj_generate_normals(&obj, OBJ_NORMAL_WEIGHT_AREA));
+	EXPECT_TRUE(obj_generate_tangents(&obj));
+	obj_subgroup_t* subgroup = obj.group[0]->subgroup[0];
+	EXPECT_SIZEEQ(subgroup->corner.count, 24);
+	for (size_t itri = 0; itri < subgroup->triangle.count; ++itri) {
+		const obj_triangle_t* triangle = bucketarray_get(&subgroup->triangle, itri);
+		const obj_corner_t* corner[3];
+		const obj_vertex_t* position[3];
+		const obj_uv_t* uv[3];
+		for (unsigned int icorner = 0; icorner < 3; ++icorner) {
+			corner[icorner] = bucketarray_get(&subgroup->corner, triangle->index[icorner]);
+			position[icorner] = bucketarray_get(&obj.vertex, corner[icorner]->vertex - 1);
+			uv[icorner] = bucketarray_get(&obj.uv, corner[icorner]->uv - 1);
+		}
+		// Direction of increasing U over the triangle, unit length since the cube has edge length 2
+		real du1 = uv[1]->u - uv[0]->u, dv1 = uv[1]->v - uv[0]->v;
+		real du2 = uv[2]->u - uv[0]->u, dv2 = uv[2]->v - uv[0]->v;
+		real det = (du1 * dv2) - (du2 * dv1);
+		real expect[3] = {
+		    (((position[1]->x - position[0]->x) * dv2) - ((position[2]->x - position[0]->x) * dv1)) / (det * 2),
+		    (((position[1]->y - position[0]->y) * dv2) - ((position[2]->y - position[0]->y) * dv1)) / (det * 2),
+		    (((position[1]->z - position[0]->z) * dv2) - ((position[2]->z - position[0]->z) * dv1)) / (det * 2)};
+		for (unsigned int icorner = 0; icorner < 3; ++icorner) {
+			EXPECT_NE(corner[icorner]->tangent, 0);
+			const obj_tangent_t* tangent = bucketarray_get(&obj.tangent, corner[icorner]->tangent - 1);
+			const obj_normal_t* normal = bucketarray_get(&obj.normal, corner[icorner]->normal - 1);
+			EXPECT_TRUE(math_abs(tangent->tx - expect[0]) < REAL_C(0.0001));
+			EXPECT_TRUE(math_abs(tangent->ty - expect[1]) < REAL_C(0.0001));
+			EXPECT_TRUE(math_abs(tangent->tz - expect[2]) < REAL_C(0.0001));
+			EXPECT_TRUE(math_abs((tangent->tx * normal->nx) + (tangent->ty * normal->ny) + (tangent->tz * normal->nz)) <
+			            REAL_C(0.0001));
+			EXPECT_REALEQ(tangent->sign, REAL_C(1.0));
+		}
+	}
+
+	// Tangents are copied out in mesh vertex order and by packing
+	obj_tangent_t tangents[36];
+	EXPECT_SIZEEQ(obj_mesh_tangents(&obj, tangents), 36);
+	const obj_triangle_t* first = bucketarray_get(&subgroup->triangle, 0);
+	const obj_corner_t* first_corner = bucketarray_get(&subgroup->corner, first->index[0]);
+	const obj_tangent_t* first_tangent = bucketarray_get(&obj.tangent, first_corner->tangent - 1);
+	EXPECT_REALEQ(tangents[0].tx, first_tangent->tx);
+	EXPECT_REALEQ(tangents[0].ty, first_tangent->ty);
+	EXPECT_REALEQ(tangents[0].tz, first_tangent->tz);
+	obj_packed_vertex_t packed[24];
+	obj_subgroup_pack(&obj, subgroup, packed);
+	EXPECT_REALEQ(packed[first->index[0]].tangent.tx, first_tangent->tx);
+	EXPECT_REALEQ(packed[first->index[0]].tangent.sign, first_tangent->sign);
+	obj_finalize(&obj);
+
+	// Mirrored UV mapping on the right quad splits the shared corners and flips handedness
+	const char mirror[] = "v 0 0 0\nv 1 0 0\nv 2 0 0\nv 0 1 0\nv 1 1 0\nv 2 1 0\n"
+	                      "vt 0 0\nvt 1 0\nvt 0 1\nvt 1 1\nf 1/1 2/2 5/4 4/3\nf 2/2 3/1 6/3 5/4\n";
+	obj_initialize(&obj);
+	EXPECT_TRUE(test_obj_read_text(&obj, STRING_CONST(mirror)));
+	EXPECT_TRUE(obj_triangulate(&obj));
+	subgroup = obj.group[0]->subgroup[0];
+	EXPECT_SIZEEQ(subgroup->corner.count, 6);
+	EXPECT_TRUE(obj_generate_tangents(&obj));
+	EXPECT_SIZEEQ(subgroup->corner.count, 8);
+	for (size_t itri = 0; itri < subgroup->triangle.count; ++itri) {
+		const obj_triangle_t* triangle = bucketarray_get(&subgroup->triangle, itri);
+		real center = 0;
+		for (unsigned int icorner = 0; icorner < 3; ++icorner) {
+			const obj_corner_t* corner = bucketarray_get(&subgroup->corner, triangle->index[icorner]);
+			center += ((const obj_vertex_t*)bucketarray_get(&obj.vertex, corner->vertex - 1))->x / REAL_C(3.0);
+		}
+		real expect = (center > REAL_C(1.0)) ? REAL_C(-1.0) : REAL_C(1.0);
+		for (unsigned int icorner = 0; icorner < 3; ++icorner) {
+			const obj_corner_t* corner = bucketarray_get(&subgroup->corner, triangle->index[icorner]);
+			const obj_tangent_t* tangent = bucketarray_get(&obj.tangent, corner->tangent - 1);
+			EXPECT_TRUE(math_abs(tangent->tx - expect) < REAL_C(0.0001));
+			EXPECT_TRUE(math_abs(tangent->ty) < REAL_C(0.0001));
+			EXPECT_REALEQ(tangent->sign, expect);
+		}
+	}
+
+	// Generating again replaces tangents without further splits
+	EXPECT_TRUE(obj_generate_tangents(&obj));
+	EXPECT_SIZEEQ(subgroup->corner.count, 8);
+	EXPECT_SIZEEQ(obj.tangent.count, 8);
+	obj_finalize(&obj);
+
+	return 0;
+}
+
+DECLARE_TEST(obj, bounds) {
+	obj_t obj;
+	obj_initialize(&obj);
+
+	// Unused vertex 4 extends only the bounds of the OBJ data
+	const char text[] = "v 0 0 0\nv 1 0 0\nv 1 1 0\nv 5 5 5\nv -2 3 1\nv -2 4 1\nv -3 3 2\n"
+	                    "g a\nf 1 2 3\ng b\nusemtl m\nf 5 6 7\nf 1 2 3\n";
+	EXPECT_TRUE(test_obj_read_text(&obj, STRING_CONST(text)));
+	EXPECT_REALEQ(obj.bounds.min.x, REAL_C(-3.0));
+	EXPECT_REALEQ(obj.bounds.max.x, REAL_C(5.0));
+	EXPECT_REALEQ(obj.bounds.max.z, REAL_C(5.0));
+
+	const obj_group_t* first = obj_group_find(&obj, STRING_CONST("a"));
+	EXPECT_REALEQ(first->bounds.min.x, REAL_C(0.0));
+	EXPECT_REALEQ(first->bounds.max.x, REAL_C(1.0));
+	EXPECT_REALEQ(first->bounds.max.y, REAL_C(1.0));
+	EXPECT_REALEQ(first->bounds.max.z, REAL_C(0.0));
+
+	obj_group_t* second = obj_group_find(&obj, STRING_CONST("b"));
+	EXPECT_REALEQ(second->bounds.min.x, REAL_C(-3.0));
+	EXPECT_REALEQ(second->bounds.min.y, REAL_C(0.0));
+	EXPECT_REALEQ(second->bounds.max.x, REAL_C(1.0));
+	EXPECT_REALEQ(second->bounds.max.y, REAL_C(4.0));
+	EXPECT_REALEQ(second->bounds.max.z, REAL_C(2.0));
+	EXPECT_REALEQ(second->subgroup[0]->bounds.max.x, REAL_C(1.0));
+	EXPECT_REALEQ(second->subgroup[0]->bounds.min.y, REAL_C(0.0));
+
+	// Recomputing gives the bounds tracked while reading
+	obj_bounds_t bounds = obj.bounds;
+	obj_bounds_t group_bounds = second->bounds;
+	EXPECT_TRUE(obj_compute_bounds(&obj));
+	EXPECT_EQ(memcmp(&bounds, &obj.bounds, sizeof(bounds)), 0);
+	EXPECT_EQ(memcmp(&group_bounds, &second->bounds, sizeof(group_bounds)), 0);
+
+	// Recomputing after modification picks up moved vertices
+	obj_vertex_t* vertex = bucketarray_get(&obj.vertex, 6);
+	vertex->x = REAL_C(-10.0);
+	EXPECT_TRUE(obj_compute_bounds(&obj));
+	EXPECT_REALEQ(obj.bounds.min.x, REAL_C(-10.0));
+	EXPECT_REALEQ(second->bounds.min.x, REAL_C(-10.0));
+	EXPECT_REALEQ(first->bounds.min.x, REAL_C(0.0));
+	obj_finalize(&obj);
+
+	obj_initialize(&obj);
+	string_t grid = test_obj_grid(60);
+	EXPECT_TRUE(test_obj_read_text(&obj, STRING_ARGS(grid)));
+	bounds = obj.bounds;
+	obj_bounds_t subgroup_bounds = obj.group[0]->subgroup[0]->bounds;
+	EXPECT_REALEQ(bounds.min.x, REAL_C(0.0));
+	EXPECT_REALEQ(bounds.max.y, REAL_C(60.0));
+	EXPECT_TRUE(obj_compute_bounds(&obj));
+	EXPECT_EQ(memcmp(&bounds, &obj.bounds, sizeof(bounds)), 0);
+	EXPECT_EQ(memcmp(&subgroup_bounds, &obj.group[0]->subgroup[0]->bounds, sizeof(subgroup_bounds)), 0);
+	memory_deallocate(grid.str);
+	obj_finalize(&obj);
+
+	return 0;
+}
+
+DECLARE_TEST(obj, bvh) {
+	obj_t obj;
+	obj_bvh_t bvh;
+	obj_bvh_t loaded;
+	obj_initialize(&obj);
+	obj_bvh_initialize(&bvh);
+	obj_bvh_initialize(&loaded);
+	EXPECT_SIZEEQ(sizeof(obj_bvh_node_t), 32);
+
+	EXPECT_TRUE(test_obj_read_grid(&obj, 30));
+	EXPECT_TRUE(obj_build_bvh(&obj, nullptr, &bvh));
+	EXPECT_TRUE(test_obj_bvh_valid(&obj, &bvh, OBJ_BVH_MAX_LEAF_TRIANGLES));
+
+	// Stored BVH reads back identical
+	stream_t* storage = buffer_stream_allocate(nullptr, STREAM_IN | STREAM_OUT | STREAM_BINARY, 0, 0, true, true);
+	EXPECT_TRUE(obj_bvh_write(&bvh, storage));
+	size_t size = stream_tell(storage);
+	stream_seek(storage, 0, STREAM_SEEK_BEGIN);
+	EXPECT_TRUE(obj_bvh_read(&loaded, &obj, storage));
+	EXPECT_SIZEEQ(array_size(loaded.node), array_size(bvh.node));
+	EXPECT_SIZEEQ(array_size(loaded.primitive), array_size(bvh.primitive));
+	EXPECT_EQ(memcmp(loaded.node, bvh.node, sizeof(obj_bvh_node_t) * array_size(bvh.node)), 0);
+	EXPECT_EQ(memcmp(loaded.primitive, bvh.primitive, sizeof(obj_bvh_primitive_t) * array_size(bvh.primitive)), 0);
+
+	// Truncated data is rejected
+	void* buffer = memory_allocate(HASH_OBJ, size, 0, MEMORY_PERSISTENT);
+	stream_seek(storage, 0, STREAM_SEEK_BEGIN);
+	EXPECT_SIZEEQ(stream_read(storage, buffer, size), size);
+	stream_t* truncated = test_obj_stream(buffer, size - 20);
+	EXPECT_FALSE(obj_bvh_read(&loaded, &obj, truncated));
+	stream_deallocate(truncated);
+	memory_deallocate(buffer);
+
+	// BVH is rejected for modified OBJ data
+	obj_vertex_t* vertex = bucketarray_get(&obj.vertex, 0);
+	vertex->x = REAL_C(100.0);
+	EXPECT_TRUE(obj_compute_bounds(&obj));
+	stream_seek(storage, 0, STREAM_SEEK_BEGIN);
+	EXPECT_FALSE(obj_bvh_read(&loaded, &obj, storage));
+	EXPECT_SIZEEQ(array_size(loaded.node), 0);
+	stream_deallocate(storage);
+	obj_finalize(&obj);
+
+	// Larger data builds subtrees in parallel, options control leaf size
+	obj_initialize(&obj);
+	string_t text = test_obj_sphere(200, 150);
+	EXPECT_TRUE(test_obj_read_text(&obj, STRING_ARGS(text)));
+	memory_deallocate(text.str);
+	EXPECT_TRUE(obj_triangulate(&obj));
+	EXPECT_TRUE(obj_build_bvh(&obj, nullptr, &bvh));
+	EXPECT_TRUE(test_obj_bvh_valid(&obj, &bvh, OBJ_BVH_MAX_LEAF_TRIANGLES));
+	obj_bvh_options_t options = {2, 8, REAL_C(0.5)};
+	EXPECT_TRUE(obj_build_bvh(&obj, &options, &bvh));
+	EXPECT_TRUE(test_obj_bvh_valid(&obj, &bvh, 2));
+	obj_finalize(&obj);
+
+	// No triangles gives an empty BVH
+	obj_initialize(&obj);
+	EXPECT_TRUE(test_obj_read_text(&obj, STRING_CONST("v 0 0 0\n")));
+	EXPECT_TRUE(obj_build_bvh(&obj, nullptr, &bvh));
+	EXPECT_SIZEEQ(array_size(bvh.node), 0);
+	obj_finalize(&obj);
+
+	obj_bvh_finalize(&loaded);
+	obj_bvh_finalize(&bvh);
+	return 0;
+}
+
+DECLARE_TEST(obj, query) {
+	obj_t obj;
+	obj_bvh_t bvh;
+	obj_initialize(&obj);
+	obj_bvh_initialize(&bvh);
+	string_t text = test_obj_sphere(20, 30);
+	EXPECT_TRUE(test_obj_read_text(&obj, STRING_ARGS(text)));
+	memory_deallocate(text.str);
+	EXPECT_TRUE(obj_triangulate(&obj));
+	EXPECT_TRUE(obj_optimize_vertex_cache(&obj, nullptr));
+	EXPECT_TRUE(obj_build_bvh(&obj, nullptr, &bvh));
+
+	// Ray casts match intersecting every triangle, a third of the rays aim at the sphere
+	unsigned int random = 12345;
+	obj_ray_t ray[203];
+	obj_hit_t batch_hit[203];
+	size_t hit_count = 0;
+	for (unsigned int iray = 0; iray < 203; ++iray) {
+		double origin[3], direction[3];
+		for (unsigned int axis = 0; axis < 3; ++axis)
+			origin[axis] = (double)((test_obj_random(&random) * REAL_C(4.0)) - REAL_C(2.0));
+		for (unsigned int axis = 0; axis < 3; ++axis)
+			direction[axis] = (double)((test_obj_random(&random) * REAL_C(2.0)) - REAL_C(1.0));
+		if (!(iray % 3)) {
+			direction[0] = -origin[0] + (double)((test_obj_random(&random) - REAL_C(0.5)) * REAL_C(0.5));
+			direction[1] = -origin[1];
+			direction[2] = -origin[2];
+		}
+		ray[iray].origin = (obj_vertex_t){(real)origin[0], (real)origin[1], (real)origin[2]};
+		ray[iray].direction = (obj_normal_t){(real)direction[0], (real)direction[1], (real)direction[2]};
+		ray[iray].max_distance = REAL_MAX;
+		// Reference uses the same rounded ray
+		origin[0] = (double)ray[iray].origin.x;
+		origin[1] = (double)ray[iray].origin.y;
+		origin[2] = (double)ray[iray].origin.z;
+		direction[0] = (double)ray[iray].direction.nx;
+		direction[1] = (double)ray[iray].direction.ny;
+		direction[2] = (double)ray[iray].direction.nz;
+
+		obj_hit_t hit;
+		bool found = obj_raycast(&obj, &bvh, &ray[iray].origin, &ray[iray].direction, &hit);
+		double reference = test_obj_raycast_brute(&obj, origin, direction);
+		EXPECT_EQ(found, reference >= 0);
+		if (!found) {
+			EXPECT_TRUE(hit.distance < 0);
+			continue;
+		}
+		++hit_count;
+		EXPECT_TRUE(math_abs(hit.distance - (real)reference) < REAL_C(0.0001) * (REAL_C(1.0) + (real)reference));
+		EXPECT_TRUE(math_abs((ray[iray].origin.x + (ray[iray].direction.nx * hit.distance)) - hit.point.x) <
+		            REAL_C(0.001));
+		EXPECT_TRUE(math_abs(hit.barycentric[0] + hit.barycentric[1] + hit.barycentric[2] - REAL_C(1.0)) <
+		            REAL_C(0.00001));
+		// Hit triangle is mapped to the face it was triangulated from
+		const obj_subgroup_t* subgroup = obj.group[hit.group]->subgroup[hit.subgroup];
+		EXPECT_NE(hit.face, 0xFFFFFFFF);
+		const obj_face_t* face = bucketarray_get(&subgroup->face, hit.face);
+		unsigned int shared = 0;
+		for (unsigned int iindex = 0; iindex < face->count; ++iindex) {
+			const unsigned int* index = bucketarray_get(&subgroup->index, face->offset + iindex);
+			for (unsigned int icorner = 0; icorner < 3; ++icorner)
+				shared += (*index == hit.corner[icorner]) ? 1 : 0;
+		}
+		EXPECT_UINTEQ(shared, 3);
+	}
+	EXPECT_TRUE(hit_count > 203 / 3);
+
+	// Batched ray casts give the same hits as single rays
+	EXPECT_SIZEEQ(obj_raycast_batch(&obj, &bvh, ray, 203, batch_hit), hit_count);
+	for (unsigned int iray = 0; iray < 203; ++iray) {
+		obj_hit_t hit;
+		obj_raycast(&obj, &bvh, &ray[iray].origin, &ray[iray].direction, &hit);
+		EXPECT_UINTEQ(hit.triangle, batch_hit[iray].triangle);
+		EXPECT_TRUE(math_abs(hit.distance - batch_hit[iray].distance) < REAL_C(0.000001));
+	}
+
+	// Closest points are within sampling distance of the closest sample of every triangle
+	obj_vertex_t point[100];
+	obj_hit_t batch_result[100];
+	for (unsigned int ipoint = 0; ipoint < 100; ++ipoint) {
+		real coord[3];
+		for (unsigned int axis = 0; axis < 3; ++axis)
+			coord[axis] = (test_obj_random(&random) * REAL_C(4.0)) - REAL_C(2.0);
+		point[ipoint] = (obj_vertex_t){coord[0], coord[1], coord[2]};
+		double query[3] = {(double)coord[0], (double)coord[1], (double)coord[2]};
+
+		obj_hit_t result;
+		EXPECT_TRUE(obj_closest_point(&obj, &bvh, point + ipoint, &result));
+		real reference = (real)test_obj_closest_point_brute(&obj, query);
+		EXPECT_TRUE(result.distance <= reference + REAL_C(0.00001));
+		EXPECT_TRUE(result.distance >= reference - REAL_C(0.05));
+		real dx = result.point.x - coord[0];
+		real dy = result.point.y - coord[1];
+		real dz = result.point.z - coord[2];
+		EXPECT_TRUE(math_abs(math_sqrt((dx * dx) + (dy * dy) + (dz * dz)) - result.distance) < REAL_C(0.0001));
+	}
+	EXPECT_SIZEEQ(obj_closest_point_batch(&obj, &bvh, point, 100, batch_result), 100);
+	for (unsigned int ipoint = 0; ipoint < 100; ++ipoint) {
+		obj_hit_t result;
+		obj_closest_point(&obj, &bvh, point + ipoint, &result);
+		EXPECT_UINTEQ(result.triangle, batch_result[ipoint].triangle);
+		EXPECT_REALEQ(result.distance, batch_result[ipoint].distance);
+	}
+	obj_finalize(&obj);
+
+	// No triangles gives no hits
+	obj_initialize(&obj);
+	EXPECT_TRUE(test_obj_read_text(&obj, STRING_CONST("v 0 0 0\n")));
+	EXPECT_TRUE(obj_build_bvh(&obj, nullptr, &bvh));
+	obj_vertex_t origin = {0, 0, 0};
+	obj_normal_t direction = {0, 0, 1};
+	obj_hit_t hit;
+	EXPECT_FALSE(obj_raycast(&obj, &bvh, &origin, &direction, &hit));
+	EXPECT_TRUE(hit.distance < 0);
+	EXPECT_FALSE(obj_closest_point(&obj, &bvh, &origin, &hit));
+	obj_finalize(&obj);
+
+	obj_bvh_finalize(&bvh);
+	return 0;
+}
+
+DECLARE_TEST(obj, weld) {
+	obj_t obj;
+	obj_initialize(&obj);
+
+	// Jittered quad corners are welded to a shared grid of vertices
+	string_t text = test_obj_soup(40, REAL_C(0.00001), false);
+	EXPECT_TRUE(test_obj_read_text(&obj, STRING_ARGS(text)));
+	memory_deallocate(text.str);
+	EXPECT_TRUE(obj_triangulate(&obj));
+	obj_subgroup_t* subgroup = obj.group[0]->subgroup[0];
+	size_t triangle_count = subgroup->triangle.count;
+	EXPECT_SIZEEQ(obj.vertex.count, 40 * 40 * 4);
+	EXPECT_TRUE(obj_weld_positions(&obj, REAL_C(0.001)));
+	EXPECT_SIZEEQ(obj.vertex.count, 41 * 41);
+	EXPECT_SIZEEQ(subgroup->corner.count, 41 * 41);
+	EXPECT_SIZEEQ(subgroup->triangle.count, triangle_count);
+	for (size_t icorner = 0; icorner < subgroup->corner.count; ++icorner) {
+		const obj_corner_t* corner = bucketarray_get(&subgroup->corner, icorner);
+		EXPECT_TRUE((corner->vertex >= 1) && (corner->vertex <= obj.vertex.count));
+		EXPECT_TRUE(corner->next < 0);
+	}
+	for (size_t iindex = 0; iindex < subgroup->index.count; ++iindex)
+		EXPECT_TRUE(*(const unsigned int*)bucketarray_get(&subgroup->index, iindex) < subgroup->corner.count);
+	obj_finalize(&obj);
+
+	// Exact weld keeps jittered positions apart and merges identical positions
+	obj_initialize(&obj);
+	text = test_obj_soup(10, REAL_C(0.001), false);
+	EXPECT_TRUE(test_obj_read_text(&obj, STRING_ARGS(text)));
+	memory_deallocate(text.str);
+	EXPECT_TRUE(obj_weld_positions(&obj, 0));
+	EXPECT_TRUE(obj.vertex.count > 300);
+	obj_finalize(&obj);
+
+	obj_initialize(&obj);
+	text = test_obj_soup(10, 0, false);
+	EXPECT_TRUE(test_obj_read_text(&obj, STRING_ARGS(text)));
+	memory_deallocate(text.str);
+	EXPECT_TRUE(obj_weld_positions(&obj, 0));
+	EXPECT_SIZEEQ(obj.vertex.count, 11 * 11);
+	obj_finalize(&obj);
+
+	// Triangle collapsed onto a line is removed, differing normals keep welded corners apart
+	const char collapse[] = "v 0 0 0\nv 1 0 0\nv 1.0001 0 0\nv 0 1 0\nvn 0 0 1\nvn 0 0 -1\n"
+	                        "f 1//1 2//1 4//1\nf 1//1 3//2 4//1\nf 1 2 3\n";
+	obj_initialize(&obj);
+	EXPECT_TRUE(test_obj_read_text(&obj, STRING_CONST(collapse)));
+	EXPECT_TRUE(obj_triangulate(&obj));
+	subgroup = obj.group[0]->subgroup[0];
+	EXPECT_SIZEEQ(subgroup->triangle.count, 3);
+	EXPECT_TRUE(obj_weld_positions(&obj, REAL_C(0.01)));
+	EXPECT_SIZEEQ(obj.vertex.count, 3);
+	EXPECT_SIZEEQ(subgroup->triangle.count, 2);
+	EXPECT_SIZEEQ(subgroup->face.count, 2);
+	EXPECT_SIZEEQ(subgroup->index.count, 6);
+	size_t chained = 0;
+	for (size_t icorner = 0; icorner < subgroup->corner.count; ++icorner) {
+		const obj_corner_t* corner = bucketarray_get(&subgroup->corner, icorner);
+		if (corner->next < 0)
+			continue;
+		++chained;
+		EXPECT_TRUE((size_t)corner->next > icorner);
+		EXPECT_UINTEQ(((const obj_corner_t*)bucketarray_get(&subgroup->corner, (size_t)corner->next))->vertex,
+		              corner->vertex);
+	}
+	EXPECT_TRUE(chained > 0);
+	obj_finalize(&obj);
+
+	// Quad with two corners merged becomes a triangle, faces collapsed to a line are dropped
+	const char faces[] = "v 0 0 0\nv 1 0 0\nv 1.0001 0 0\nv 0 1 0\nv 0 2 0\n"
+	                     "f 1 2 3 4\nf 2 3 4 5\nf 1 2 3\nf 4 5 1\n";
+	obj_initialize(&obj);
+	EXPECT_TRUE(test_obj_read_text(&obj, STRING_CONST(faces)));
+	subgroup = obj.group[0]->subgroup[0];
+	EXPECT_SIZEEQ(subgroup->face.count, 4);
+	EXPECT_TRUE(obj_weld_positions(&obj, REAL_C(0.01)));
+	EXPECT_SIZEEQ(subgroup->face.count, 3);
+	EXPECT_SIZEEQ(subgroup->index.count, 9);
+	unsigned int offset = 0;
+	for (size_t iface = 0; iface < subgroup->face.count; ++iface) {
+		const obj_face_t* face = bucketarray_get(&subgroup->face, iface);
+		EXPECT_UINTEQ(face->count, 3);
+		EXPECT_UINTEQ(face->offset, offset);
+		offset += face->count;
+		for (unsigned int iindex = 0; iindex < face->count; ++iindex) {
+			unsigned int first = *(const unsigned int*)bucketarray_get(&subgroup->index, face->offset + iindex);
+			unsigned int second =
+			    *(const unsigned int*)bucketarray_get(&subgroup->index, face->offset + ((iindex + 1) % face->count));
+			EXPECT_NE(((const obj_corner_t*)bucketarray_get(&subgroup->corner, first))->vertex,
+			          ((const obj_corner_t*)bucketarray_get(&subgroup->corner, second))->vertex);
+		}
+	}
+	obj_finalize(&obj);
+
+	// Non-finite vertices are kept apart, huge coordinates with a tiny distance are welded exactly
+	const char special[] = "v 0 0 0\nv 1 0 0\nv 0 1 0\nv 0 0 1\nv 3e30 0 0\nv 3e30 0 0\nv 1 1 1\n"
+	                       "f 1 2 3\nf 1 3 4\nf 2 5 3\nf 4 6 7\n";
+	obj_initialize(&obj);
+	EXPECT_TRUE(test_obj_read_text(&obj, STRING_CONST(special)));
+	((obj_vertex_t*)bucketarray_get(&obj.vertex, 2))->y = NAN;
+	((obj_vertex_t*)bucketarray_get(&obj.vertex, 3))->y = NAN;
+	((obj_vertex_t*)bucketarray_get(&obj.vertex, 6))->x = INFINITY;
+	EXPECT_TRUE(obj_weld_positions(&obj, REAL_C(1e-20)));
+	EXPECT_SIZEEQ(obj.vertex.count, 6);
+	EXPECT_TRUE(math_real_is_nan(((const obj_vertex_t*)bucketarray_get(&obj.vertex, 2))->y));
+	EXPECT_TRUE(math_real_is_nan(((const obj_vertex_t*)bucketarray_get(&obj.vertex, 3))->y));
+	EXPECT_TRUE(obj_weld_positions(&obj, 0));
+	EXPECT_TRUE(obj_weld_positions(&obj, REAL_C(0.01)));
+	EXPECT_SIZEEQ(obj.vertex.count, 6);
+	obj_finalize(&obj);
+
+	return 0;
+}
+
+DECLARE_TEST(obj, dedup) {
+	obj_t obj;
+	obj_initialize(&obj);
+
+	string_t text = test_obj_soup(30, 0, true);
+	EXPECT_TRUE(test_obj_read_text(&obj, STRING_ARGS(text)));
+	memory_deallocate(text.str);
+	EXPECT_TRUE(obj_triangulate(&obj));
+	obj_subgroup_t* subgroup = obj.group[0]->subgroup[0];
+	size_t triangle_count = subgroup->triangle.count;
+	size_t index_count = subgroup->index.count;
+	EXPECT_SIZEEQ(obj.vertex.count, 30 * 30 * 4);
+	EXPECT_SIZEEQ(obj.normal.count, 30 * 30 * 4);
+	obj_packed_vertex_t* before =
+	    memory_allocate(HASH_OBJ, sizeof(obj_packed_vertex_t) * subgroup->corner.count, 0, MEMORY_PERSISTENT);
+	unsigned int* before_index = memory_allocate(HASH_OBJ, sizeof(unsigned int) * index_count, 0, MEMORY_PERSISTENT);
+	obj_subgroup_pack(&obj, subgroup, before);
+	for (size_t iindex = 0; iindex < index_count; ++iindex)
+		before_index[iindex] = *(const unsigned int*)bucketarray_get(&subgroup->index, iindex);
+
+	EXPECT_TRUE(obj_dedup_attributes(&obj));
+	EXPECT_SIZEEQ(obj.vertex.count, 31 * 31);
+	EXPECT_SIZEEQ(obj.uv.count, 31 * 31);
+	EXPECT_SIZEEQ(obj.normal.count, 1);
+	EXPECT_SIZEEQ(subgroup->corner.count, 31 * 31);
+	EXPECT_SIZEEQ(subgroup->triangle.count, triangle_count);
+	EXPECT_SIZEEQ(subgroup->index.count, index_count);
+
+	// Face corners keep their attribute values
+	obj_packed_vertex_t* after =
+	    memory_allocate(HASH_OBJ, sizeof(obj_packed_vertex_t) * subgroup->corner.count, 0, MEMORY_PERSISTENT);
+	obj_subgroup_pack(&obj, subgroup, after);
+	for (size_t iindex = 0; iindex < index_count; ++iindex) {
+		const obj_packed_vertex_t* expect = before + before_index[iindex];
+		const obj_packed_vertex_t* vertex = after + *(const unsigned int*)bucketarray_get(&subgroup->index, iindex);
+		EXPECT_EQ(memcmp(&expect->position, &vertex->position, sizeof(obj_vertex_t)), 0);
+		EXPECT_EQ(memcmp(&expect->normal, &vertex->normal, sizeof(obj_normal_t)), 0);
+		EXPECT_EQ(memcmp(&expect->uv, &vertex->uv, sizeof(obj_uv_t)), 0);
+	}
+	memory_deallocate(before);
+	memory_deallocate(before_index);
+	memory_deallocate(after);
+
+	EXPECT_TRUE(obj_dedup_attributes(&obj));
+	EXPECT_SIZEEQ(obj.vertex.count, 31 * 31);
+	obj_finalize(&obj);
+
+	// Negative and positive zero differ bitwise, distinct UVs keep corners apart
+	const char zero[] = "v 0 0 0\nv -0 0 0\nv 1 0 0\nv 1 0 0\nv 0 1 0\nvt 0 0\nvt 1 1\n"
+	                    "f 1/1 3/1 5/1\nf 2/2 4/1 5/1\n";
+	obj_initialize(&obj);
+	EXPECT_TRUE(test_obj_read_text(&obj, STRING_CONST(zero)));
+	EXPECT_TRUE(obj_dedup_attributes(&obj));
+	EXPECT_SIZEEQ(obj.vertex.count, 4);
+	EXPECT_SIZEEQ(obj.group[0]->subgroup[0]->corner.count, 4);
+	obj_finalize(&obj);
+
+	return 0;
+}
+
+DECLARE_TEST(obj, compact) {
+	obj_t obj;
+	obj_initialize(&obj);
+
+	// Vertex 1 is unused, vertex 6, UV 2 and normal 2 are only used by the last face of group a, which is removed
+	const char text[] = "v 9 9 9\nv 0 0 0\nv 1 0 0\nv 0 1 0\nv 1 1 0\nv 5 5 5\nvt 0 0\nvt 7 7\nvt 1 1\n"
+	                    "vn 0 0 1\nvn 1 0 0\ng empty\ng a\nf 2/1/1 3/3/1 4/1/1\nf 3/3/1 5/1/1 4/3/1\n"
+	                    "f 6/2/2 2/1/1 3/2/2\ng b\ng c\nf 2/1 3/1 5/1\n";
+	EXPECT_TRUE(test_obj_read_text(&obj, STRING_CONST(text)));
+	obj_group_t* group = obj_group_find(&obj, STRING_CONST("a"));
+	EXPECT_NE(group, nullptr);
+	obj_subgroup_t* subgroup = group->subgroup[0];
+	const obj_face_t* last = bucketarray_get(&subgroup->face, subgroup->face.count - 1);
+	bucketarray_resize(&subgroup->index, last->offset);
+	bucketarray_resize(&subgroup->face, subgroup->face.count - 1);
+	EXPECT_TRUE(obj_triangulate(&obj));
+	// Group c is emptied
+	obj_subgroup_t* emptied = obj_group_find(&obj, STRING_CONST("c"))->subgroup[0];
+	bucketarray_resize(&emptied->face, 0);
+	bucketarray_resize(&emptied->index, 0);
+	bucketarray_resize(&emptied->triangle, 0);
+
+	size_t triangle_count = test_obj_triangle_count(&obj);
+	size_t index_count = subgroup->index.count;
+	obj_packed_vertex_t before[16];
+	unsigned int before_index[16];
+	EXPECT_TRUE(subgroup->corner.count <= 16);
+	obj_subgroup_pack(&obj, subgroup, before);
+	for (size_t iindex = 0; iindex < index_count; ++iindex)
+		before_index[iindex] = *(const unsigned int*)bucketarray_get(&subgroup->index, iindex);
+
+	EXPECT_TRUE(obj_compact_unused(&obj));
+	EXPECT_SIZEEQ(array_size(obj.group), 1);
+	EXPECT_EQ(obj_group_find(&obj, STRING_CONST("a")), group);
+	EXPECT_EQ(obj_group_find(&obj, STRING_CONST("c")), nullptr);
+	EXPECT_EQ(obj_group_find(&obj, STRING_CONST("empty")), nullptr);
+	EXPECT_SIZEEQ(obj.vertex.count, 4);
+	EXPECT_SIZEEQ(obj.uv.count, 2);
+	EXPECT_SIZEEQ(obj.normal.count, 1);
+	EXPECT_SIZEEQ(subgroup->corner.count, 5);
+	EXPECT_SIZEEQ(test_obj_triangle_count(&obj), triangle_count);
+	EXPECT_REALEQ(obj.bounds.min.x, REAL_C(0.0));
+	EXPECT_REALEQ(obj.bounds.max.x, REAL_C(1.0));
+
+	// Face corners keep their attribute values and corner chains stay within the subgroup
+	obj_packed_vertex_t after[16];
+	obj_subgroup_pack(&obj, subgroup, after);
+	for (size_t iindex = 0; iindex < index_count; ++iindex) {
+		const obj_packed_vertex_t* expect = before + before_index[iindex];
+		const obj_packed_vertex_t* vertex = after + *(const unsigned int*)bucketarray_get(&subgroup->index, iindex);
+		EXPECT_EQ(memcmp(&expect->position, &vertex->position, sizeof(obj_vertex_t)), 0);
+		EXPECT_EQ(memcmp(&expect->normal, &vertex->normal, sizeof(obj_normal_t)), 0);
+		EXPECT_EQ(memcmp(&expect->uv, &vertex->uv, sizeof(obj_uv_t)), 0);
+	}
+	EXPECT_TRUE(test_obj_triangles_valid(&obj));
+	for (size_t icorner = 0; icorner < subgroup->corner.count; ++icorner) {
+		const obj_corner_t* corner = bucketarray_get(&subgroup->corner, icorner);
+		if (corner->next < 0)
+			continue;
+		EXPECT_TRUE((size_t)corner->next < subgroup->corner.count);
+		EXPECT_UINTEQ(((const obj_corner_t*)bucketarray_get(&subgroup->corner, (size_t)corner->next))->vertex,
+		              corner->vertex);
+	}
+
+	EXPECT_TRUE(obj_compact_unused(&obj));
+	EXPECT_SIZEEQ(obj.vertex.count, 4);
+	obj_finalize(&obj);
+
+	// Every other vertex unused over a large array keeps the used vertices in order
+	const unsigned int size = 200;
+	size_t capacity = ((size_t)(size + 1) * (size + 1) * 40) + ((size_t)size * size * 40);
+	char* buffer = memory_allocate(HASH_OBJ, capacity, 0, MEMORY_PERSISTENT);
+	size_t length = 0;
+	for (unsigned int y = 0; y <= size; ++y) {
+		for (unsigned int x = 0; x <= size; ++x)
+			length += string_format(buffer + length, capacity - length, STRING_CONST("v %u %u 0\nv 1000 1000 1000\n"),
+			                        x, y)
+			              .length;
+	}
+	for (unsigned int y = 0; y < size; ++y) {
+		for (unsigned int x = 0; x < size; ++x) {
+			unsigned int base = (2 * ((y * (size + 1)) + x)) + 1;
+			unsigned int above = base + (2 * (size + 1));
+			length += string_format(buffer + length, capacity - length, STRING_CONST("f %u %u %u %u\n"), base,
+			                        base + 2, above + 2, above)
+			              .length;
+		}
+	}
+	obj_initialize(&obj);
+	EXPECT_TRUE(test_obj_read_text(&obj, buffer, length));
+	memory_deallocate(buffer);
+	EXPECT_TRUE(obj_triangulate(&obj));
+	EXPECT_TRUE(obj_compact_unused(&obj));
+	EXPECT_SIZEEQ(obj.vertex.count, (size + 1) * (size + 1));
+	EXPECT_REALEQ(obj.bounds.max.x, (real)size);
+	EXPECT_REALEQ(obj.bounds.max.z, REAL_C(0.0));
+	for (size_t ivertex = 0; ivertex < obj.vertex.count; ++ivertex) {
+		const obj_vertex_t* vertex = bucketarray_get(&obj.vertex, ivertex);
+		EXPECT_REALEQ(vertex->x, (real)(ivertex % (size + 1)));
+		EXPECT_REALEQ(vertex->y, (real)(ivertex / (size + 1)));
+	}
+	subgroup = obj.group[0]->subgroup[0];
+	for (size_t icorner = 0; icorner < subgroup->corner.count; ++icorner) {
+		const obj_corner_t* corner = bucketarray_get(&subgroup->corner, icorner);
+		EXPECT_TRUE((corner->vertex >= 1) && (corner->vertex <= obj.vertex.count));
+	}
+	obj_finalize(&obj);
+
+	return 0;
+}
+
+DECLARE_TEST(obj, validate) {
+	obj_t obj;
+	obj_validate_report_t report;
+	obj_initialize(&obj);
+
+	const char text[] = "v 0 0 0\nv 1 0 0\nv 0 1 0\nv 2 0 0\nv nan 0 0\nv 0 0 1\nv 0 0 -1\nv 1e999 0 0\n"
+	                    "vt 0 0\nvt nan 1\nvn 0 0 1\nvn 0 0 0\nvn inf 0 0\n"
+	                    // Valid triangle, then duplicates with new corners from other normals and rotated
+	                    "f 1/1/1 2/1/1 3/1/1\nf 1/1/2 2/1/3 3/1/1\nf 2/1/1 3/1/1 1/1/1\n"
+	                    // Reversed winding is not a duplicate
+	                    "f 1 3 2\n"
+	                    // Colinear, repeated vertex and non-finite vertex triangles are degenerate
+	                    "f 1 2 4\nf 1 1 3\nf 1 5 3\n"
+	                    // Edge 1-2 shared by more than two triangles
+	                    "f 1 2 6\nf 1 2 7\n"
+	                    // Undeclared vertex drops the face
+	                    "f 1 2 99\nf 2/2 3/2 6/2\n";
+	EXPECT_TRUE(test_obj_read_text(&obj, STRING_CONST(text)));
+	EXPECT_TRUE(obj_triangulate(&obj));
+	EXPECT_FALSE(obj_validate(&obj, OBJ_VALIDATE_ALL, &report));
+	EXPECT_SIZEEQ(report.nonfinite_vertex, 2);
+	EXPECT_SIZEEQ(report.nonfinite_normal, 1);
+	EXPECT_SIZEEQ(report.nonfinite_uv, 1);
+	EXPECT_SIZEEQ(report.zero_normal, 1);
+	EXPECT_SIZEEQ(report.degenerate_triangle, 3);
+	EXPECT_SIZEEQ(report.duplicate_triangle, 2);
+	EXPECT_SIZEEQ(report.nonmanifold_edge, 2);
+	EXPECT_SIZEEQ(report.invalid_face, 1);
+
+	// Repair drops degenerate and duplicate triangles and removes invalid normals from corners
+	size_t triangle_count = test_obj_triangle_count(&obj);
+	EXPECT_FALSE(obj_validate(&obj, OBJ_VALIDATE_ALL | OBJ_VALIDATE_REPAIR, &report));
+	EXPECT_SIZEEQ(test_obj_triangle_count(&obj), triangle_count - 5);
+	EXPECT_FALSE(obj_validate(&obj, OBJ_VALIDATE_ALL, &report));
+	EXPECT_SIZEEQ(report.nonfinite_vertex, 0);
+	EXPECT_SIZEEQ(report.nonfinite_normal, 0);
+	EXPECT_SIZEEQ(report.nonfinite_uv, 0);
+	EXPECT_SIZEEQ(report.degenerate_triangle, 0);
+	EXPECT_SIZEEQ(report.duplicate_triangle, 0);
+	EXPECT_SIZEEQ(report.nonmanifold_edge, 2);
+	// Repaired infinite normal is zeroed and no longer referenced by any corner
+	EXPECT_SIZEEQ(report.zero_normal, 2);
+	const obj_subgroup_t* subgroup = obj.group[0]->subgroup[0];
+	for (size_t icorner = 0; icorner < subgroup->corner.count; ++icorner) {
+		const obj_corner_t* corner = bucketarray_get(&subgroup->corner, icorner);
+		EXPECT_TRUE(corner->normal <= 1);
+	}
+	EXPECT_REALEQ(obj.bounds.max.x, REAL_C(2.0));
+	// Faces dropped while reading are still reported
+	EXPECT_FALSE(obj_validate(&obj, OBJ_VALIDATE_DEGENERATE, &report));
+	EXPECT_SIZEEQ(report.invalid_face, 1);
+	obj_finalize(&obj);
+
+	// Fan of triangles around a single vertex with duplicates and extra triangles on shared edges
+	char fan[4096];
+	size_t length = string_format(fan, sizeof(fan), STRING_CONST("v 0 0 0\n")).length;
+	for (unsigned int ivertex = 0; ivertex < 40; ++ivertex) {
+		real angle = (real)ivertex * REAL_C(0.157);
+		length += string_format(fan + length, sizeof(fan) - length, STRING_CONST("v %.5f %.5f 0\n"),
+		                        (double)math_cos(angle), (double)math_sin(angle))
+		              .length;
+	}
+	for (unsigned int itri = 0; itri < 39; ++itri)
+		length +=
+		    string_format(fan + length, sizeof(fan) - length, STRING_CONST("f 1 %u %u\n"), itri + 2, itri + 3).length;
+	length += string_format(fan + length, sizeof(fan) - length,
+	                        STRING_CONST("f 1 2 3\nf 3 1 2\nf 1 10 11\nf 1 2 20\nf 1 2 30\n"))
+	              .length;
+	obj_initialize(&obj);
+	EXPECT_TRUE(test_obj_read_text(&obj, fan, length));
+	EXPECT_TRUE(obj_triangulate(&obj));
+	EXPECT_FALSE(obj_validate(&obj, OBJ_VALIDATE_ALL | OBJ_VALIDATE_REPAIR, &report));
+	EXPECT_SIZEEQ(report.duplicate_triangle, 3);
+	EXPECT_SIZEEQ(report.nonmanifold_edge, 3);
+	EXPECT_SIZEEQ(report.degenerate_triangle, 0);
+	EXPECT_SIZEEQ(test_obj_triangle_count(&obj), 41);
+	obj_finalize(&obj);
+
+	// Clean data passes all checks
+	obj_initialize(&obj);
+	EXPECT_TRUE(test_obj_read_grid(&obj, 60));
+	EXPECT_TRUE(obj_validate(&obj, OBJ_VALIDATE_ALL, &report));
+	EXPECT_SIZEEQ(report.degenerate_triangle, 0);
+	EXPECT_SIZEEQ(report.nonmanifold_edge, 0);
+	EXPECT_TRUE(obj_validate(&obj, OBJ_VALIDATE_ALL, nullptr));
+	obj_finalize(&obj);
+
+	return 0;
+}
+
+DECLARE_TEST(obj, transform) {
+	obj_t obj;
+	const char text[] = "v 0 0 0\nv 1 0 0\nv 0 1 0\nv 1 1 1\nvn 0 0 1\nvn 0 0 2\nvn 0 0 0\n"
+	                    "f 1//1 2//1 3//2\nf 2//3 4//3 3//3\n";
+	const unsigned int flags = OBJ_TRANSFORM_NORMALIZE | OBJ_TRANSFORM_FLIP_WINDING;
+	real normal[3];
+
+	// Non-uniform scale, rotation about Z by 90 degrees and translation
+	obj_matrix_t matrix = {{{0, -3, 0, 10}, {2, 0, 0, 20}, {0, 0, 4, 30}}};
+	obj_initialize(&obj);
+	EXPECT_TRUE(test_obj_read_text(&obj, STRING_CONST(text)));
+	EXPECT_TRUE(obj_triangulate(&obj));
+	EXPECT_TRUE(obj_transform(&obj, &matrix, flags));
+	const obj_vertex_t* vertex = bucketarray_get(&obj.vertex, 3);
+	EXPECT_TRUE(test_obj_near(vertex->x, REAL_C(7.0)));
+	EXPECT_TRUE(test_obj_near(vertex->y, REAL_C(22.0)));
+	EXPECT_TRUE(test_obj_near(vertex->z, REAL_C(34.0)));
+	const obj_normal_t* transformed = bucketarray_get(&obj.normal, 0);
+	EXPECT_TRUE(test_obj_near(transformed->nx, 0));
+	EXPECT_TRUE(test_obj_near(transformed->ny, 0));
+	EXPECT_TRUE(test_obj_near(transformed->nz, REAL_C(1.0)));
+	transformed = bucketarray_get(&obj.normal, 1);
+	EXPECT_TRUE(test_obj_near(transformed->nz, REAL_C(1.0)));
+	// Zero length normal stays zero when normalized
+	transformed = bucketarray_get(&obj.normal, 2);
+	EXPECT_REALEQ(transformed->nx, 0);
+	EXPECT_REALEQ(transformed->ny, 0);
+	EXPECT_REALEQ(transformed->nz, 0);
+	EXPECT_TRUE(test_obj_near(obj.bounds.min.x, REAL_C(7.0)));
+	EXPECT_TRUE(test_obj_near(obj.bounds.max.z, REAL_C(34.0)));
+	test_obj_triangle_normal(&obj, obj.group[0]->subgroup[0], 0, normal);
+	EXPECT_TRUE(normal[2] > 0);
+	obj_finalize(&obj);
+
+	// Normals stay perpendicular to surfaces under shear
+	obj_matrix_t shear = {{{1, 2, REAL_C(0.5), 0}, {0, 1, 0, 0}, {REAL_C(0.3), 0, 1, 0}}};
+	obj_initialize(&obj);
+	EXPECT_TRUE(test_obj_read_text(&obj, STRING_CONST("v 0 0 0\nv 1 0 0\nv 0 1 0\nvn 0 0 1\nf 1//1 2//1 3//1\n")));
+	EXPECT_TRUE(obj_triangulate(&obj));
+	EXPECT_TRUE(obj_transform(&obj, &shear, 0));
+	const obj_vertex_t* origin = bucketarray_get(&obj.vertex, 0);
+	transformed = bucketarray_get(&obj.normal, 0);
+	for (size_t ivertex = 1; ivertex < 3; ++ivertex) {
+		vertex = bucketarray_get(&obj.vertex, ivertex);
+		real dot = ((vertex->x - origin->x) * transformed->nx) + ((vertex->y - origin->y) * transformed->ny) +
+		           ((vertex->z - origin->z) * transformed->nz);
+		EXPECT_TRUE(test_obj_near(dot, 0));
+	}
+	obj_finalize(&obj);
+
+	// Mirroring flips winding unless flip is requested, and flips tangent handedness
+	obj_matrix_t mirror = {{{-1, 0, 0, 0}, {0, 1, 0, 0}, {0, 0, 1, 0}}};
+	for (unsigned int flip = 0; flip < 2; ++flip) {
+		obj_initialize(&obj);
+		EXPECT_TRUE(test_obj_read_text(&obj, STRING_CONST(text)));
+		EXPECT_TRUE(obj_triangulate(&obj));
+		EXPECT_TRUE(obj_generate_tangents(&obj));
+		obj_tangent_t before = *(const obj_tangent_t*)bucketarray_get(&obj.tangent, 0);
+		EXPECT_TRUE(obj_transform(&obj, &mirror, flip ? OBJ_TRANSFORM_FLIP_WINDING : 0));
+		test_obj_triangle_normal(&obj, obj.group[0]->subgroup[0], 0, normal);
+		EXPECT_TRUE(flip ? (normal[2] > 0) : (normal[2] < 0));
+		const obj_tangent_t* after = bucketarray_get(&obj.tangent, 0);
+		EXPECT_REALEQ(after->sign, -before.sign);
+		EXPECT_TRUE(test_obj_near(after->tx, -before.tx));
+		obj_finalize(&obj);
+	}
+
+	// Transform while parsing with obj_read and the push parser matches transform after read
+	obj_matrix_t scale = {{{-2, 0, 0, 1}, {0, 1, 0, 0}, {0, 0, 1, 0}}};
+	for (unsigned int mode = 0; mode < 3; ++mode) {
+		const obj_matrix_t* transform = (mode == 1) ? &scale : &matrix;
+		obj_t reference;
+		obj_initialize(&reference);
+		EXPECT_TRUE(test_obj_read_text(&reference, STRING_CONST(text)));
+		EXPECT_TRUE(obj_transform(&reference, transform, flags));
+		EXPECT_TRUE(obj_triangulate(&reference));
+
+		obj_initialize(&obj);
+		obj.option.flags = OBJ_READ_TRANSFORM;
+		obj.option.transform = *transform;
+		obj.option.transform_flags = flags;
+		if (mode < 2) {
+			EXPECT_TRUE(test_obj_read_text(&obj, STRING_CONST(text)));
+		} else {
+			obj_parser_t parser;
+			obj_parser_initialize(&parser, &obj.option);
+			EXPECT_TRUE(obj_parser_feed(&parser, text, sizeof(text) - 1));
+			EXPECT_TRUE(obj_parser_finish(&parser, &obj));
+			obj_parser_finalize(&parser);
+		}
+		EXPECT_TRUE(obj_triangulate(&obj));
+
+		EXPECT_SIZEEQ(obj.vertex.count, reference.vertex.count);
+		EXPECT_SIZEEQ(obj.normal.count, reference.normal.count);
+		for (size_t ivertex = 0; ivertex < reference.vertex.count; ++ivertex)
+			EXPECT_EQ(memcmp(bucketarray_get(&reference.vertex, ivertex), bucketarray_get(&obj.vertex, ivertex),
+			                 sizeof(obj_vertex_t)),
+			          0);
+		for (size_t inormal = 0; inormal < reference.normal.count; ++inormal) {
+			const obj_normal_t* expect = bucketarray_get(&reference.normal, inormal);
+			transformed = bucketarray_get(&obj.normal, inormal);
+			EXPECT_TRUE(test_obj_near(expect->nx, transformed->nx));
+			EXPECT_TRUE(test_obj_near(expect->ny, transformed->ny));
+			EXPECT_TRUE(test_obj_near(expect->nz, transformed->nz));
+		}
+		const obj_subgroup_t* expect_subgroup = reference.group[0]->subgroup[0];
+		const obj_subgroup_t* subgroup = obj.group[0]->subgroup[0];
+		EXPECT_SIZEEQ(subgroup->triangle.count, expect_subgroup->triangle.count);
+		for (size_t itri = 0; itri < subgroup->triangle.count; ++itri) {
+			real expect_normal[3];
+			test_obj_triangle_normal(&reference, expect_subgroup, itri, expect_normal);
+			test_obj_triangle_normal(&obj, subgroup, itri, normal);
+			EXPECT_TRUE(test_obj_near(normal[0], expect_normal[0]));
+			EXPECT_TRUE(test_obj_near(normal[1], expect_normal[1]));
+			EXPECT_TRUE(test_obj_near(normal[2], expect_normal[2]));
+		}
+		EXPECT_TRUE(test_obj_near(obj.bounds.min.x, reference.bounds.min.x));
+		EXPECT_TRUE(test_obj_near(obj.bounds.max.y, reference.bounds.max.y));
+
+		obj_finalize(&reference);
+		obj_finalize(&obj);
+	}
+
+	return 0;
+}
+
 static void
 test_obj_declare(void) {
+	ADD_TEST(obj, corners);
+	ADD_TEST(obj, index);
+	ADD_TEST(obj, read_groups);
+	ADD_TEST(obj, read_append);
+	ADD_TEST(obj, parser_feed);
+	ADD_TEST(obj, progress);
+	ADD_TEST(obj, subgroup_complete);
+	ADD_TEST(obj, inflate);
+	ADD_TEST(obj, group_find);
+	ADD_TEST(obj, string_pool);
+	ADD_TEST(obj, merge_subgroups);
+	ADD_TEST(obj, bucket_growth);
+	ADD_TEST(obj, vertex_cache);
+	ADD_TEST(obj, overdraw);
+	ADD_TEST(obj, vertex_fetch);
+	ADD_TEST(obj, meshlets);
+	ADD_TEST(obj, simplify);
+	ADD_TEST(obj, normals);
+	ADD_TEST(obj, tangents);
+	ADD_TEST(obj, bounds);
+	ADD_TEST(obj, bvh);
+	ADD_TEST(obj, query);
+	ADD_TEST(obj, weld);
+	ADD_TEST(obj, dedup);
+	ADD_TEST(obj, compact);
+	ADD_TEST(obj, validate);
+	ADD_TEST(obj, transform);
 }
 
 static test_suite_t test_obj_suite = {test_obj_application,